@@ -8,6 +8,7 @@ using System.IO;
 using System.Collections;
 using System.Collections.Generic;
 using System.Runtime.InteropServices;
+using System.Threading;
 using AOT;
 
 namespace UnityForCpp
@@ -38,12 +39,50 @@ public class UnityAdapter : MonoBehaviour
         return _s_sharedArrays[id].GetArray();
     }
 
+    //Calls onDirtyItem for each item marked as dirty on the dirty bitmap of a C++ TrackedUnityArray (check UnityArray.h),
+    //which you get by GetSharedArray<uint>(dirtyBitmapId). The bitmap is cleared, so the next call only gets the items written
+    //by the C++ code after this one. Returns the number of dirty items.
+    public static int ConsumeDirtyItems(uint[] dirtyBitmap, Action<int> onDirtyItem)
+    {
+        //position 0 is a flag set by the C++ code when any item is dirty, so we avoid going over the bitmap when nothing changed
+        if (dirtyBitmap[0] == 0)
+            return 0;
+
+        int nOfDirtyItems = 0;
+        for (int word = 1; word < dirtyBitmap.Length; ++word)
+        {
+            uint bits = dirtyBitmap[word];
+            if (bits == 0)
+                continue;
+
+            dirtyBitmap[word] = 0;
+            for (int bit = 0; bits != 0; ++bit, bits >>= 1)
+            {
+                if ((bits & 1) != 0)
+                {
+                    onDirtyItem(((word - 1) << 5) + bit);
+                    ++nOfDirtyItems;
+                }
+            }
+        }
+
+        dirtyBitmap[0] = 0;
+        return nOfDirtyItems;
+    }
+
     private static UnityAdapter _s_instance = null;
 
     //Usually fields have to be static since methods to be called from C++ must be static
     private static Dictionary<int, SharedArrayHolder> _s_sharedArrays = null;
     private static int _s_lastSharedArrayId = -1;
 
+    //Asynchronous file reads requested by the C++ code, check RequestFileContentAsync. The bundle files being loaded are only
+    //touched by the main thread, while the completed reads are added by the thread pool threads too, so they are locked.
+    private static List<FileReadRequest> _s_pendingResourceLoads = new List<FileReadRequest>();
+    private static List<FileReadRequest> _s_completedFileReads = new List<FileReadRequest>();
+    private static List<FileReadRequest> _s_deliveringFileReads = new List<FileReadRequest>();
+    private static readonly object _s_fileReadsLock = new object();
+
     //WARNING: the C++ DLL state is not reset when the game is reset on the Unity Editor
     //So, ideally, DLL initialization functions should support redundant calls with no side effects 
     private void Awake()
@@ -67,11 +106,18 @@ public class UnityAdapter : MonoBehaviour
         //Provide C# function pointers to cpp, making Unity features available from cpp code
         UnityAdapterDLL.UA_SetOutputDebugStrFcPtr(OutputDebugStr);
         UnityAdapterDLL.UA_SetFileFcPtrs(RequestFileContent, SaveTextFile);
+        UnityAdapterDLL.UA_SetFileReadAsyncFcPtrs(RequestFileContentAsync, RequestFileRangeAsync);
         UnityAdapterDLL.UA_SetArrayFcPtrs(RequestManagedArray, ReleaseManagedArray);
 
         Debug.Log("[UnityAdapter] UnityForCpp DLL was loaded and UnityAdapter was initialized at the C++ and C# sides.");
     }
 
+    //The asynchronous file reads finished since the previous frame are delivered to the C++ code here
+    private void Update()
+    {
+        DeliverCompletedFileReads();
+    }
+
     //Provides Unity Debug.Log feature to the cpp code
     [MonoPInvokeCallback(typeof(UnityAdapterDLL.OutputDebugStrDelegate))]
     private static void OutputDebugStr(int logType, string str)
@@ -104,13 +150,7 @@ public class UnityAdapter : MonoBehaviour
             fileData = File.ReadAllBytes(finalFilePath);
         else
         {
-            //Remove the file extension as requested by Resources.Load
-            string directoryPath = Path.GetDirectoryName(fullFilePath);
-            if (directoryPath != null && directoryPath.Length > 0)
-                finalFilePath = directoryPath + "/" + Path.GetFileNameWithoutExtension(fullFilePath);
-            else
-                finalFilePath = Path.GetFileNameWithoutExtension(fullFilePath);
-
+            finalFilePath = GetResourcePath(fullFilePath);
             TextAsset fileAsAsset = (TextAsset)Resources.Load(finalFilePath) as TextAsset;
             if (fileAsAsset)
                 fileData = fileAsAsset.bytes;
@@ -129,6 +169,148 @@ public class UnityAdapter : MonoBehaviour
             Debug.Log("[UnityAdapter] Warning: Could NOT provide the file " + finalFilePath + ", requested from the C++ code");
     }
 
+    //Starts an asynchronous read for the C++ code (check UnityAdapter::ReadFileContentAsync), looking for the file in the same
+    //way of RequestFileContent. Saved files are read on a thread pool thread, while bundle files are loaded by Resources.LoadAsync,
+    //both being delivered to the C++ code by the first Update after they finish, check DeliverCompletedFileReads.
+    [MonoPInvokeCallback(typeof(UnityAdapterDLL.RequestFileContentAsyncDelegate))]
+    private static void RequestFileContentAsync(int requestId, string fullFilePath)
+    {
+        FileReadRequest request = new FileReadRequest(requestId, Application.persistentDataPath + "/" + fullFilePath);
+        if (File.Exists(request.FilePath))
+        {
+            ThreadPool.QueueUserWorkItem(delegate(object state)
+            {
+                try
+                {
+                    request.Data = File.ReadAllBytes(request.FilePath);
+                }
+                catch (Exception) //deleted or locked after the File.Exists check, so it is delivered as not found
+                {
+                    request.Data = null;
+                }
+
+                lock (_s_fileReadsLock)
+                    _s_completedFileReads.Add(request);
+            });
+        }
+        else
+        {
+            request.FilePath = GetResourcePath(fullFilePath);
+            request.ResourceLoad = Resources.LoadAsync(request.FilePath);
+            _s_pendingResourceLoads.Add(request);
+        }
+    }
+
+    //Starts an asynchronous read of a range of a file for the C++ code (check UnityAdapter::ReadFileRangeAsync), which is written
+    //to an existing shared array on a thread pool thread, without allocating any array. The file is looked for at the persistent
+    //data folder and then at the StreamingAssets folder, bundle files are not supported since they are only loaded whole.
+    [MonoPInvokeCallback(typeof(UnityAdapterDLL.RequestFileRangeAsyncDelegate))]
+    private static void RequestFileRangeAsync(int requestId, string fullFilePath, long fileOffset, int length, int destArrayId, int destOffset)
+    {
+        FileReadRequest request = new FileReadRequest(requestId, Application.persistentDataPath + "/" + fullFilePath);
+        request.IsRangeRead = true;
+        if (!File.Exists(request.FilePath))
+            request.FilePath = Application.streamingAssetsPath + "/" + fullFilePath;
+
+        //the array is got here, since the shared arrays are only touched by the main thread. It is written by the managed
+        //reference, so it is safe even if the C++ code releases it before the read completes.
+        byte[] destArray = _s_sharedArrays[destArrayId].GetArray() as byte[];
+        ThreadPool.QueueUserWorkItem(delegate(object state)
+        {
+            try
+            {
+                using (FileStream stream = new FileStream(request.FilePath, FileMode.Open, FileAccess.Read, FileShare.Read))
+                {
+                    request.FileLength = stream.Length;
+                    stream.Seek(Math.Min(fileOffset, stream.Length), SeekOrigin.Begin);
+
+                    int nOfBytesRead = 0;
+                    int count;
+                    while (nOfBytesRead < length && (count = stream.Read(destArray, destOffset + nOfBytesRead, length - nOfBytesRead)) > 0)
+                        nOfBytesRead += count;
+
+                    request.NOfBytesRead = nOfBytesRead;
+                }
+            }
+            catch (Exception) //not found or not readable, delivered as -1
+            {
+                request.NOfBytesRead = -1;
+                request.FileLength = -1;
+            }
+
+            lock (_s_fileReadsLock)
+                _s_completedFileReads.Add(request);
+        });
+    }
+
+    //Delivers the asynchronous file reads finished so far to the C++ code, on the order they have finished. The C++ completion
+    //callbacks are called from here, so they may request new reads, which are delivered by the next calls.
+    private static void DeliverCompletedFileReads()
+    {
+        int nOfPendingLoads = 0;
+        for (int i = 0; i < _s_pendingResourceLoads.Count; ++i)
+        {
+            FileReadRequest request = _s_pendingResourceLoads[i];
+            if (!request.ResourceLoad.isDone)
+            {
+                _s_pendingResourceLoads[nOfPendingLoads++] = request;
+                continue;
+            }
+
+            TextAsset fileAsAsset = request.ResourceLoad.asset as TextAsset;
+            request.Data = fileAsAsset ? fileAsAsset.bytes : null;
+            lock (_s_fileReadsLock)
+                _s_completedFileReads.Add(request);
+        }
+
+        _s_pendingResourceLoads.RemoveRange(nOfPendingLoads, _s_pendingResourceLoads.Count - nOfPendingLoads);
+
+        lock (_s_fileReadsLock)
+        {
+            if (_s_completedFileReads.Count == 0)
+                return;
+
+            List<FileReadRequest> completedFileReads = _s_completedFileReads;
+            _s_completedFileReads = _s_deliveringFileReads;
+            _s_deliveringFileReads = completedFileReads;
+        }
+
+        foreach (FileReadRequest request in _s_deliveringFileReads)
+        {
+            if (request.IsRangeRead)
+            {
+                if (request.NOfBytesRead < 0)
+                    Debug.Log("[UnityAdapter] Warning: Could NOT read the file " + request.FilePath + ", requested from the C++ code");
+
+                UnityAdapterDLL.UA_DeliverFileRangeRead(request.RequestId, request.NOfBytesRead, request.FileLength);
+            }
+            else if (request.Data != null)
+            {
+                int arrayId = ++_s_lastSharedArrayId;
+                SharedArrayHolder sharedArrayHolder = new SharedArrayHolder(request.Data);
+                _s_sharedArrays.Add(arrayId, sharedArrayHolder);
+                UnityAdapterDLL.UA_DeliverFileReadContent(request.RequestId, arrayId, sharedArrayHolder.GetArrayPtr(), request.Data.Length);
+            }
+            else
+            {
+                Debug.Log("[UnityAdapter] Warning: Could NOT provide the file " + request.FilePath + ", requested from the C++ code");
+                UnityAdapterDLL.UA_DeliverFileReadContent(request.RequestId, -1, IntPtr.Zero, 0);
+            }
+        }
+
+        _s_deliveringFileReads.Clear();
+    }
+
+    //Path of a bundle file for Resources.Load, which is relative to the "Resources" folder and has no file extension
+    private static string GetResourcePath(string fullFilePath)
+    {
+        string directoryPath = Path.GetDirectoryName(fullFilePath);
+        if (directoryPath != null && directoryPath.Length > 0)
+            return directoryPath + "/" + Path.GetFileNameWithoutExtension(fullFilePath);
+        else
+            return Path.GetFileNameWithoutExtension(fullFilePath);
+    }
+
     //Provides the Unity multiplatform file saving feature to the C++ code
     //Save the "textContent" to a new file created based on the provided path (the directory is also created if needed)
     //The persistent data folder for the platform will be the path root. An existing file for this path will be overwriten.
@@ -177,6 +359,26 @@ public class UnityAdapter : MonoBehaviour
         _s_sharedArrays.Remove(arrayId);
     }
 
+    //Asynchronous file read requested by the C++ code, check RequestFileContentAsync
+    private class FileReadRequest
+    {
+        public FileReadRequest(int requestId, string filePath)
+        {
+            RequestId = requestId;
+            FilePath = filePath;
+        }
+
+        public int RequestId;
+        public string FilePath; //the Resources.LoadAsync path for the bundle files
+        public ResourceRequest ResourceLoad = null; //set only for the bundle files
+        public byte[] Data = null; //null if the file could not be read
+
+        //range reads write to an existing shared array instead, check RequestFileRangeAsync
+        public bool IsRangeRead = false;
+        public int NOfBytesRead = 0; //-1 if the file could not be read
+        public long FileLength = -1;
+    }
+
     //Class to hold the arrays currently allocated and shared with the C++ code
     private class SharedArrayHolder
     {
@@ -224,6 +426,13 @@ public class UnityAdapter : MonoBehaviour
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
         public delegate void RequestFileContentDelegate(string fullFilePath);
 
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        public delegate void RequestFileContentAsyncDelegate(int requestId, string fullFilePath);
+
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        public delegate void RequestFileRangeAsyncDelegate(int requestId, string fullFilePath, long fileOffset, int length, 
+                                                           int destArrayId, int destOffset);
+
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
         public delegate void SaveTextFileDelegate(string fullFilePath, string textContent);
 
@@ -241,11 +450,21 @@ public class UnityAdapter : MonoBehaviour
         [DllImport(DLL_NAME)]
         public static extern void UA_SetFileFcPtrs(RequestFileContentDelegate requestFileDlg, SaveTextFileDelegate saveTextFileDelegate);
 
+        [DllImport(DLL_NAME)]
+        public static extern void UA_SetFileReadAsyncFcPtrs(RequestFileContentAsyncDelegate requestFileAsyncDlg,
+                                                            RequestFileRangeAsyncDelegate requestFileRangeAsyncDlg);
+
         [DllImport(DLL_NAME)]
         public static extern void UA_SetArrayFcPtrs(RequestManagedArrayDelegate requestDlg, ReleaseManagedArrayDelegate releaseDlg);
 
         [DllImport(DLL_NAME)]
         public static extern void UA_DeliverManagedArray(int id, System.IntPtr array, int length);
+
+        [DllImport(DLL_NAME)]
+        public static extern void UA_DeliverFileReadContent(int requestId, int id, System.IntPtr array, int length);
+
+        [DllImport(DLL_NAME)]
+        public static extern void UA_DeliverFileRangeRead(int requestId, int nOfBytesRead, long fileLength);
     }; //UnityAdapterDLL class
 
 } // UnityAdapter class
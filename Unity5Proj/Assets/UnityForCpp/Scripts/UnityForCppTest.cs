@@ -46,10 +46,12 @@ public class UnityForCppTest : MonoBehaviour, UnityMessager.IMessageReceiver {
     }
 
     //Called from C++ through a message only to the initalization process of this singleton UnityForCppTest C# instance
-    //this informs the shared array we should look into at each Update() call in order to update the position of each game object
-    private void SetPositionsArray(int arrayId)
+    //this informs the shared array we should look into at each Update() call in order to update the position of each game object,
+    //together with its dirty bitmap telling which positions were changed since the last Update() call
+    private void SetPositionsArray(int arrayId, int dirtyBitmapId)
     {
         _gameObjectPositions = UnityAdapter.Instance.GetSharedArray<Vec2>(arrayId);
+        _gameObjectPositionsDirtyBitmap = UnityAdapter.Instance.GetSharedArray<uint>(dirtyBitmapId);
     }
 
     //This method is a mere representation of C# method you would use to create instances following order from the C++ code.
@@ -129,6 +131,15 @@ public class UnityForCppTest : MonoBehaviour, UnityMessager.IMessageReceiver {
     //shared array with the object positions. Coordinates vary from -1 to 1, being -1 the left, botton of the screen and 1 the right, top
     private Vec2[] _gameObjectPositions = null;
 
+    //dirty bitmap of the shared positions array, check UnityAdapter.ConsumeDirtyItems
+    private uint[] _gameObjectPositionsDirtyBitmap = null;
+
+    //delegate given to UnityAdapter.ConsumeDirtyItems, created once so no garbage is generated on each Update() call
+    private Action<int> _updateGameObjectPosition = null;
+
+    //receiver id of this instance, also used by the C++ test case for receiving the messages we send to it
+    private int _receiverId = -1;
+
     //holder to the singleton instance reference
     private static UnityForCppTest _s_instance = null;
  
@@ -146,6 +157,7 @@ public class UnityForCppTest : MonoBehaviour, UnityMessager.IMessageReceiver {
         }
 
         _gameObjectTransfoms = new Transform[numberOfGameObjects];
+        _updateGameObjectPosition = UpdateGameObjectPosition;
     }
 
 	private void Start() 
@@ -163,6 +175,7 @@ public class UnityForCppTest : MonoBehaviour, UnityMessager.IMessageReceiver {
         //Requests a new received id to be informed to the C++ code. This operation is suitable to be done here since this receiver
         //object is a singleton that will exist, if it was created by an order from the C++ code the receiver id should be requested there.
         int thisId = UnityMessager.Instance.NewReceiverId();
+        _receiverId = thisId;
 
         //bounds the MessagerReceiver internal instance to the receiver id given above.
         UnityMessager.Instance.SetReceiverObject(thisId, this.gameObject, this);
@@ -176,6 +189,10 @@ public class UnityForCppTest : MonoBehaviour, UnityMessager.IMessageReceiver {
 
     private void Update()
     {
+        //Input events are written to the UnityMessager inbox, being read by the C++ code at the start of its update bellow
+        if (Input.GetMouseButtonDown(0))
+            UnityMessager.Instance.SendMessageToCpp(_receiverId, 0, CppCoordsFromScreenCoords(Input.mousePosition)); //TIM_POINTER_DOWN = 0
+
         //Call the C++ code to update the logic side of our test case there, so we can render its "view" side here
         TestDLL.T_UpdateTest(Time.deltaTime);
 
@@ -200,11 +217,15 @@ public class UnityForCppTest : MonoBehaviour, UnityMessager.IMessageReceiver {
         TestDLL.T_TerminateTest();
     }
 
-    //just go over the shared positions array updating the position for each object
+    //updates the position only for the objects whose position was changed by the C++ code since the last call
     private void UpdateGameObjectPositions()
     {
-        for (int i = 0; i < numberOfGameObjects; ++i)
-            _gameObjectTransfoms[i].position = ScreenCoordsFromCppCoords(_gameObjectPositions[i]);
+        UnityAdapter.ConsumeDirtyItems(_gameObjectPositionsDirtyBitmap, _updateGameObjectPosition);
+    }
+
+    private void UpdateGameObjectPosition(int gameObjectId)
+    {
+        _gameObjectTransfoms[gameObjectId].position = ScreenCoordsFromCppCoords(_gameObjectPositions[gameObjectId]);
     }
 
     //For simplicity of this test case the Cpp coords considers the screen coords going from -1 to 1. 
@@ -215,6 +236,15 @@ public class UnityForCppTest : MonoBehaviour, UnityMessager.IMessageReceiver {
         return new Vector3(0.5f * Screen.width * vec2.x, 0.5f * Screen.height * vec2.y, 0.0f);
     }
 
+    //The opposite of ScreenCoordsFromCppCoords, for pixel coordinates as the ones of Input.mousePosition
+    private static Vec2 CppCoordsFromScreenCoords(Vector3 screenPos)
+    {
+        Vec2 vec2;
+        vec2.x = 2.0f * screenPos.x / Screen.width - 1.0f;
+        vec2.y = 2.0f * screenPos.y / Screen.height - 1.0f;
+        return vec2;
+    }
+
     //Here we "unpack" the message routing it to the destination method by the message id value
     public void ReceiveMessage(ref UnityMessager.Message msg)
     {
@@ -252,7 +282,8 @@ public class UnityForCppTest : MonoBehaviour, UnityMessager.IMessageReceiver {
                 }
             case 2: //TRM_SET_POSITIONS_ARRAY = 2,
                 {
-                    UnityForCppTest.Instance.SetPositionsArray(msg.ReadNextParamAndAdvance<int>()); //arrayId
+                    UnityForCppTest.Instance.SetPositionsArray(msg.ReadNextParamAndAdvance<int>(), //arrayId
+                                                               msg.ReadNextParamAndAdvance<int>()); //dirtyBitmapId
                     break;
                 }
             case 3: //TRM_INSTANCE_GAME_OBJECT = 3,
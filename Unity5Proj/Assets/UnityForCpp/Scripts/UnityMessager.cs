@@ -9,69 +9,141 @@ using System.Collections;
 using System.Collections.Generic;
 using System.Runtime.InteropServices;
 using System.Reflection;
+using System.Threading;
 
 namespace UnityForCpp
 {
 
 public class UnityMessager : MonoBehaviour
 {
-    //Max number of simultaneous message receiver instances bound to the UnityMessager and so able to receive messages. Min value is 16.
-    public int maxNumberOfReceiverIds = 16;
+    //Number of receiver ids available from the start, so receiver instances may be bound to the UnityMessager to receive messages. 
+    //More ids are added when needed, by chunks of 1024 ids (up to 1048576 ids), this is only the initial capacity. Min value is 16.
+    [UnityEngine.Serialization.FormerlySerializedAs("maxNumberOfReceiverIds")]
+    public int initialNumberOfReceiverIds = 16;
     
     //Max size in bytes of the memory blocks used by UnityMessager. Min value is 512, 1024 or 2048 are usually good values.
+    //Bigger array parameters are still accepted, the C++ side sends each one on a spill array of its own.
     public int maxQueueArraysSizeInBytes = 512;
 
-    //SINGLETON access point 
-    public static UnityMessager Instance { get { return _s_instance; } }
+    //When set each message queue uses two sets of memory blocks, so the C++ code can keep sending messages (to the other set) while
+    //the messages already sent are delivered, e.g. from C++ code called by your message handlers. It doubles the memory used.
+    public bool doubleBufferedQueues = false;
+
+    //When set the control queue (describing the messages and their parameters) uses a variable length byte format instead of one int 
+    //per value, which usually makes it 3 to 4 times smaller for the cost of decoding it. Check UnityMessagerCompact.h for details.
+    public bool compactControlQueue = false;
+
+    //When set all the parameters of a message are packed together into a single byte queue instead of one queue per parameter
+    //type, so less memory blocks are kept and reading a message touches less memory. Array parameters get copied when read.
+    public bool interleavedParams = false;
+
+    //When set the C++ side counts the messages sent, the bytes written to each queue and the queue arrays allocated, publishing
+    //them at each DeliverMessages call on a shared array, which is read by GetStatistic. Use it for sizing the queues and for
+    //finding the code sending more messages, also on release builds.
+    public bool collectStatistics = false;
+
+    //Channel of this instance, from 0 to 7. Each channel is an independent UnityMessager, paired with the C++ instance of the same
+    //channel (check UnityMessager::GetInstance on C++), with its own queues, receiver ids and DeliverMessages call, so the messages
+    //of a channel may be delivered at its own rate or point of the frame. Only one instance per channel may exist.
+    public int channel = 0;
+
+    //Access point to the instance of the default channel (0)
+    public static UnityMessager Instance { get { return _s_instances[_defaultChannel]; } }
+
+    //Access point to the instance of a channel, null if there is no instance for it
+    public static UnityMessager GetChannel(int channelId) { return _s_instances[channelId]; }
 
     //Provides an available receiver id, in such way you can bound your receiver instance (IMessageReceiver) to it using
     //SetReceiverObject. By requesting it from the C# code you should pass it to the C++ code so it can be used there.
+    //Ids are handles carrying the generation of their slot, so an id released is never valid again, check UnityMessager::NewReceiverId.
     public int NewReceiverId()
     {
-        int nextFreeId = _receiverIdsSharedArray[0]; //Position 0 holder the next free id
-        if (nextFreeId == 0) //0 means there is no more available receive ids, THIS CAN NEVER HAPPEN, set a bigger value on the inspector
+        int index = PopFreeReceiverIdSlot();
+        if (index == 0) //the free list is empty, the C++ side adds a chunk of ids to the table
         {
-            Debug.LogError("[UnityMessager] Not enough receiver ids set to your application!!");
-            return -1;
+            UnityMessagerDLL.UM_ReserveReceiverIds(channel, 1);
+            index = PopFreeReceiverIdSlot();
         }
 
-        //The receiver id shared array controls the free ids by implementing a single linked list where a given position
-        //has the id of the next free position. So here we are removing the "nextFreeId" from this list by setting the head
-        //of the list (position 0) to the position indicated by the nextFreeId position.
-        _receiverIdsSharedArray[0] = _receiverIdsSharedArray[nextFreeId];
-        _receiverIdsSharedArray[nextFreeId] = -1; //this indicates the id is not free, but also wasn't bound to a receiver yet.
+        if (index == 0) //THIS CAN NEVER HAPPEN, all the 1048576 ids are in use
+        {
+            Debug.LogError("[UnityMessager] Not enough receiver ids for your application!!");
+            return -1;
+        }
 
-        return nextFreeId;
+        int[] chunk = GetReceiverIdsChunk(index);
+        int slotPos = (index % _receiverIdsChunkLength) * _receiverIdSlotLength;
+        return (Thread.VolatileRead(ref chunk[slotPos + _receiverIdSlotGeneration]) << _receiverIdIndexBits) | index;
     }
 
     //This method releases a receiver id setting null to the reference of the receiver instance bound to it.
     public void ReleaseReceiverId(int receiverId)
     {
-        if (_receiverIdsSharedArray[receiverId] != -1) //this indicates the id is not in use, being in the free ids linked list.
+        if (!IsReceiverIdInUse(receiverId) || receiverId == 0) //released before, or it has never been given
+        {
+            Debug.LogWarning("[UnityMessager] Attempt to release a receiver id not being used!");
+            return;
+        }
+
+        //claims the slot, so a concurrent release of the same id (by the C++ side, for instance) can't push it twice to the list.
+        //The same claim is done by the C++ side, check UnityMessager::ReleaseReceiverId
+        int index = receiverId & _receiverIdIndexMask;
+        int[] chunk = GetReceiverIdsChunk(index);
+        int slotPos = (index % _receiverIdsChunkLength) * _receiverIdSlotLength;
+        int previousNext;
+        while ((previousNext = Interlocked.CompareExchange(ref chunk[slotPos + _receiverIdSlotNext], _receiverIdReleasing, 
+                                                           _receiverIdInUse)) != _receiverIdInUse)
+        {
+            if (previousNext != _receiverIdReleasing)
+            {
+                Debug.LogWarning("[UnityMessager] Attempt to release a receiver id not being used!");
+                return;
+            }
+
+            Thread.Sleep(0); //claimed by another release for a few instructions, it may be a stale one giving the slot back to us
+        }
+
+        //the slot may have been released and given again since the check above, as a new id, which is not ours to release
+        int generation = Thread.VolatileRead(ref chunk[slotPos + _receiverIdSlotGeneration]);
+        if (generation != (receiverId >> _receiverIdIndexBits))
         {
+            Interlocked.Exchange(ref chunk[slotPos + _receiverIdSlotNext], _receiverIdInUse);
             Debug.LogWarning("[UnityMessager] Attempt to release a receiver id not being used!");
             return;
         }
 
-        _receivers[receiverId] = null;
-        _receiverGameObjects[receiverId] = null;
+        if (index < _receivers.Length && _boundReceiverIds[index] == receiverId)
+        {
+            _receivers[index] = null;
+            _receiverGameObjects[index] = null;
+            _boundReceiverIds[index] = -1;
+        }
+
+        Interlocked.Exchange(ref chunk[slotPos + _receiverIdSlotGeneration], (generation + 1) & _receiverIdGenerationMask);
+
+        //reinserts the slot to the front of the free list, the same lock free push done by the C++ side (worker threads included)
+        long previousHead;
+        do
+        {
+            previousHead = Interlocked.Read(ref _receiverIdsHeader[_receiverIdsHeadPos]);
+            Interlocked.Exchange(ref chunk[slotPos + _receiverIdSlotNext], (int)(uint)previousHead);
+        } while (Interlocked.CompareExchange(ref _receiverIdsHeader[_receiverIdsHeadPos], NewReceiverIdsListHead(previousHead, index),
+                                             previousHead) != previousHead);
 
-        //reinserts the id to the front of the single linked list, remembering the position 0 is always the head of the list.
-        _receiverIdsSharedArray[receiverId] = _receiverIdsSharedArray[0];
-        _receiverIdsSharedArray[0] = receiverId;
+        Interlocked.Increment(ref _receiverIdsHeader[_receiverIdsNOfFreePos]);
     }
 
     //Set a C# object as receiver (it may be any C# object, including a game object component if you want make it special, beyond the default)
     public void SetReceiverObject(int receiverId, IMessageReceiver receiver)
     {
         //Check this id was really delivered to you via NewReceiverId(), which may be called from C# or from C++
-        if (_receiverIdsSharedArray[receiverId] != -1) 
+        if (!IsReceiverIdInUse(receiverId)) 
         {
             Debug.LogError("[UnityMessager] Attempt to set an object to a 'free' Receiver id!. Use NewReceiverId for requesting an id before setting an object to it.");
             return;
         }
 
-        _receivers[receiverId] = receiver;
+        _receivers[BindReceiverId(receiverId)] = receiver;
     }
 
     //Set a game object as receiver and (optionally) specify the default receiver component
@@ -79,32 +151,72 @@ public class UnityMessager : MonoBehaviour
     public void SetReceiverObject(int receiverId, GameObject gameObject, IMessageReceiver defaultReceiverComponent = null)
     {
         //Check this id was really delivered to you via NewReceiverId(), which may be called from C# or from C++
-        if (_receiverIdsSharedArray[receiverId] != -1)
+        if (!IsReceiverIdInUse(receiverId))
         {
             Debug.LogError("[UnityMessager] Attempt to set an object to a 'free' Receiver id!. Use NewReceiverId for requesting an id before setting an object to it.");
             return;
         }
 
-        _receiverGameObjects[receiverId] = gameObject;
-        _receivers[receiverId] = defaultReceiverComponent != null? defaultReceiverComponent
+        int index = BindReceiverId(receiverId);
+        _receiverGameObjects[index] = gameObject;
+        _receivers[index] = defaultReceiverComponent != null? defaultReceiverComponent
                                         : gameObject.GetComponent(typeof(IMessageReceiver)) as IMessageReceiver;
     }
 
+    //Positions for GetStatistic, corresponding to the UM_STATISTIC_* values on C++ (check their comments on UnityMessager.h)
+    public static class Statistic
+    {
+        public const int DeliveringSerial = 0; 
+        public const int NumberOfMessages = 1;
+        public const int NumberOfControlMessages = 2;
+        public const int NumberOfArrayAdvances = 3;
+        public const int NumberOfArrayAllocs = 4;
+        public const int NumberOfSpilledParams = 5;
+        public const int NumberOfSpillArrayAllocs = 6;
+        public const int FirstTopQueue = 8; //(queueId, bytes written) pairs
+        public const int NumberOfTopQueues = 16;
+        public const int FirstTopMessageId = FirstTopQueue + 2 * NumberOfTopQueues; //(msgId, number of messages) pairs
+        public const int NumberOfTopMessageIds = 8;
+        public const int Length = FirstTopMessageId + 2 * NumberOfTopMessageIds;
+    }
+
+    //Returns a statistic (a Statistic position) for the messages delivered by the last DeliverMessages call, 0 if collectStatistics 
+    //is not set. The statistics are published when the delivering starts, so you can read them from your message handlers too.
+    public long GetStatistic(int statisticPos)
+    {
+        return _statistics != null ? _statistics[statisticPos] : 0;
+    }
+
+    //Starts capturing the messages sent from C++ to a binary trace file, which is created or overwritten. Each delivering is 
+    //written as a frame, which Tools/UnityMessagerTraceTool.cpp (at the plugin folder) replays and analyzes. Use a full path,
+    //as one under Application.persistentDataPath. Returns false if the file cannot be created.
+    public bool StartCapture(string traceFilePath)
+    {
+        return UnityMessagerDLL.UM_StartCapture(channel, traceFilePath) != 0;
+    }
+
+    //Stops capturing, closing the trace file. Capturing is also stopped when the UnityMessager is destroyed.
+    public void StopCapture()
+    {
+        UnityMessagerDLL.UM_StopCapture(channel);
+    }
+
     //If true you usually should call DeliverMessagers right way. 
     public bool HasMessagesToDeliver
-    {
-        get { return _controlQueue.HasMessagesToBeDelivered; }
+    {   //messages sent from C++ worker threads only get to the control queue when the delivering process starts
+        get { return _controlQueue.HasMessagesToBeDelivered || UnityMessagerDLL.UM_HasStagedMessages(channel) != 0; }
     }
 
     //Deliver ALL the received messages to the respective receivers. Handlers that call C++ code when handling messages MUST BE
-    //SURE this C++ code will not send messages during the delivering process
+    //SURE this C++ code will not send messages during the delivering process, unless doubleBufferedQueues is set, in which case
+    //these messages are delivered on the next call.
     public void DeliverMessages()
     {
         if (!HasMessagesToDeliver)
             return;
 
         //This sets an end message so the delivering process doesn't continue forever and reset things on C++ side
-        UnityMessagerDLL.UM_OnStartMessageDelivering();
+        UnityMessagerDLL.UM_OnStartMessageDelivering(channel);
 
         try
         {
@@ -118,23 +230,33 @@ public class UnityMessager : MonoBehaviour
 
                 if (_internalMessageInstance.ComponentId >= 0) //is this message addressed to an specific game object component?
                 {
+                    //names sent by C++ are replaced by a routing binding after its first message, check RoutingBinding
+                    RoutingBinding binding = _controlQueue.CurrentRoutingBinding;
+
                     GameObject receiverGameObject = null;
-                    if (_internalMessageInstance.ReceiverId >= 0) //was the receiver specified by an id?
-                        receiverGameObject = _receiverGameObjects[_internalMessageInstance.ReceiverId];
+                    if (binding != null && binding.ObjectName != null)
+                        receiverGameObject = binding.FindGameObject();
+                    else if (_internalMessageInstance.ReceiverId >= 0) //was the receiver specified by an id?
+                        receiverGameObject = GetReceiverGameObject(_internalMessageInstance.ReceiverId);
                     else
                     {   //else we have a name to look for with GameObject.Find
                         int objectNameLength = -_internalMessageInstance.ReceiverId;
-                        string objectName = GetParamQueue<Byte>().ReadNextAsString(objectNameLength);
+                        string objectName = ReadName(objectNameLength);
                         receiverGameObject = GameObject.Find(objectName);
                     }
 
                     if (receiverGameObject != null) //if we have found the receiver game object
                     {   
                         //Get the component based on its type, indexed by the component id
-                        Component component = receiverGameObject.GetComponent(_componentTypes[_internalMessageInstance.ComponentId]);
+                        Type componentType = _componentTypes[_internalMessageInstance.ComponentId];
+                        Component component = binding != null ? binding.GetComponent(receiverGameObject, componentType)
+                                                              : receiverGameObject.GetComponent(componentType);
                         if (component != null)
                         {
-                            if (_internalMessageInstance.MessageId >= 0) //if this is a message to an IMessageReceiver component
+                            if (binding != null && binding.MethodName != null)
+                                DeliverMessageWithReflection(component, binding.GetMethod(component.GetType()), 
+                                                             binding.ParamInfos, ref _internalMessageInstance);
+                            else if (_internalMessageInstance.MessageId >= 0) //if this is a message to an IMessageReceiver component
                             {
                                 IMessageReceiver receiverComponent = component as IMessageReceiver;
                                 if (receiverComponent != null)
@@ -153,7 +275,7 @@ public class UnityMessager : MonoBehaviour
                 }
                 else //the message is addressed to a C# object (which may also be the default receiver component of game object receiver).
                 {
-                    IMessageReceiver receiver = _receivers[_internalMessageInstance.ReceiverId];
+                    IMessageReceiver receiver = GetReceiver(_internalMessageInstance.ReceiverId);
                     if (receiver != null)
                         receiver.ReceiveMessage(ref _internalMessageInstance);
                     else
@@ -163,8 +285,7 @@ public class UnityMessager : MonoBehaviour
                 //If the message receiver has not read all the parameters we need to advance manually until getting to the start of the next message
                 while (_controlQueue.NumberOfParamsBeforeNextMessage > 0)
                 {
-                    ParamInfo paramInfo = _controlQueue.CurrentParamInfo;
-                    _messageQueues[paramInfo.QueueId].AdvanceToPos(paramInfo.ArrayLength >= 0 ? paramInfo.ArrayLength : 1);
+                    SkipParam(_controlQueue.CurrentParamInfo);
                     _controlQueue.AdvanceToNextParam();
                 }
             }
@@ -179,6 +300,9 @@ public class UnityMessager : MonoBehaviour
             //Reset Message Queues so they get ready for next usage when delivering messages again.
             for (int i = 0; i < _messageQueues.Length; ++i)
                 _messageQueues[i].Reset();
+
+            //The UnityArrays referenced by the delivered messages may be released by the C++ side now
+            UnityMessagerDLL.UM_OnFinishMessageDelivering(channel);
         }
     }
 
@@ -187,7 +311,89 @@ public class UnityMessager : MonoBehaviour
     //If needed, the arrays released by this method will be allocated again in the future.
     public void ReleasePossibleQueueArrays()
     {
-        UnityMessagerDLL.UM_ReleasePossibleQueueArrays();
+        UnityMessagerDLL.UM_ReleasePossibleQueueArrays(channel);
+    }
+
+    //Starts a message to the C++ side of this channel, which reads it by UnityMessagerInbox::DrainMessages (check UnityMessagerInbox.h),
+    //so input, physics or UI events get to C++ without a plugin call per event. The messages are written to shared arrays owned by
+    //the C++ side, only calling it when the current array gets full, being all of them read by a single drain call on the C++ update.
+    //The receiver id is the one of the C++ UnityMessagerInbox::Receiver, having nothing to do with the ids given by NewReceiverId.
+    //Push the parameters by the Push*ToCpp methods and finish the message by EndMessageToCpp, or use a SendMessageToCpp version.
+    public void StartMessageToCpp(int receiverId, int msgId)
+    {
+        _inboxWriter.StartMessage(receiverId, msgId);
+    }
+
+    //Pushes a single value parameter of any type supported by UnityArray on C++ (check UA_SUPPORTED_TYPE), read there by GetParam
+    public void PushParamToCpp<T>(T value)
+    {
+        _inboxWriter.PushParam<T>(value);
+    }
+
+    //Pushes the items of an array as an array parameter, read on C++ by GetArrayParam (pointing to the inbox array, so no copy)
+    public void PushArrayParamToCpp<T>(T[] array)
+    {
+        _inboxWriter.PushArrayParam<T>(array, 0, array.Length);
+    }
+
+    public void PushArrayParamToCpp<T>(T[] array, int startIdx, int length)
+    {
+        _inboxWriter.PushArrayParam<T>(array, startIdx, length);
+    }
+
+    //Pushes the chars of a string (as ASCII), read on C++ by GetStringParam
+    public void PushStringParamToCpp(string str)
+    {
+        _inboxWriter.PushString(str);
+    }
+
+    //Finishes the message started by StartMessageToCpp, it is only seen by the C++ side from now
+    public void EndMessageToCpp()
+    {
+        _inboxWriter.EndMessage();
+    }
+
+    //Shortcuts for messages to C++ with up to three single value parameters, check StartMessageToCpp
+    public void SendMessageToCpp(int receiverId, int msgId)
+    {
+        _inboxWriter.StartMessage(receiverId, msgId);
+        _inboxWriter.EndMessage();
+    }
+
+    public void SendMessageToCpp<T1>(int receiverId, int msgId, T1 param1)
+    {
+        _inboxWriter.StartMessage(receiverId, msgId);
+        _inboxWriter.PushParam<T1>(param1);
+        _inboxWriter.EndMessage();
+    }
+
+    public void SendMessageToCpp<T1, T2>(int receiverId, int msgId, T1 param1, T2 param2)
+    {
+        _inboxWriter.StartMessage(receiverId, msgId);
+        _inboxWriter.PushParam<T1>(param1);
+        _inboxWriter.PushParam<T2>(param2);
+        _inboxWriter.EndMessage();
+    }
+
+    public void SendMessageToCpp<T1, T2, T3>(int receiverId, int msgId, T1 param1, T2 param2, T3 param3)
+    {
+        _inboxWriter.StartMessage(receiverId, msgId);
+        _inboxWriter.PushParam<T1>(param1);
+        _inboxWriter.PushParam<T2>(param2);
+        _inboxWriter.PushParam<T3>(param3);
+        _inboxWriter.EndMessage();
+    }
+
+    //Returns the reader of the ring of this channel, where a C++ thread writes messages by UnityMessagerRing::TryWriteMessage
+    //(check UnityMessagerRing.h) for them to be read while it keeps writing, instead of waiting for DeliverMessages. Get it on
+    //the main thread, then read the messages from a single thread of yours, as a job thread running along the frame.
+    //Stop reading before this UnityMessager is destroyed, since the ring array is released by the C++ side together with it.
+    public RingReader GetRingReader()
+    {
+        if (_ringReader == null) //the C++ ring is created by the first call if the C++ side hasn't done it yet
+            _ringReader = new RingReader(UnityAdapter.Instance.GetSharedArray<long>(UnityMessagerDLL.UM_GetRingArrayId(channel)));
+
+        return _ringReader;
     }
 
     //IMPLEMENT this interface in order to make your class objects capable of receiving and handling messages.
@@ -221,10 +427,13 @@ public class UnityMessager : MonoBehaviour
             get
             {
                 //safety to check to be sure this call is not coming from a copy of an old Message instance.
-                if (_uniqueId < _s_currentUniqueId)
+                if (_uniqueId < _unityMessager._lastMessageUniqueId)
                     return 0;
 
-                return UnityMessager.Instance._controlQueue.NumberOfParamsBeforeNextMessage;
+                if (_batchRowIdx >= 0) //the parameters of a batch message item are its columns, check SendBatchMessage on C++
+                    return NumberOfParams - _batchColumnIdx;
+
+                return _unityMessager._controlQueue.NumberOfParamsBeforeNextMessage;
             }
         }
 
@@ -233,10 +442,13 @@ public class UnityMessager : MonoBehaviour
         {
             get
             {
+                if (_batchRowIdx >= 0)
+                    return _unityMessager.GetBatchColumnType(_batchColumnIdx);
+
                 if (_paramInfo.QueueId < 0)
                     return null;
 
-                return UnityMessager.Instance._messageQueues[_paramInfo.QueueId].QueueType;
+                return _unityMessager.GetParamType(_paramInfo.QueueId);
             }
         }
 
@@ -245,32 +457,41 @@ public class UnityMessager : MonoBehaviour
         {
             get
             {
-                if (_paramInfo.QueueId < 0)
+                if (_batchRowIdx >= 0 || _paramInfo.QueueId < 0)
                     return false;
 
                 return _paramInfo.ArrayLength >= 0;
             }
         }
 
-        //A parameter can be read as string if it has Byte as type and is an array. This method performs this check for you.
+        //A parameter can be read as string if it has Byte as type and is an array, or if it is an interned string sent by
+        //UnityMessager::InternedString on C++ (its type is given as string). This method performs this check for you.
         public bool CanNextParamBeReadAsString
         {
             get
             {
-                if (_paramInfo.QueueId < 0)
+                if (_batchRowIdx >= 0 || _paramInfo.QueueId < 0)
                     return false;
 
-                return _paramInfo.ArrayLength >= 0
-                        && UnityMessager.Instance._messageQueues[_paramInfo.QueueId].QueueType == typeof(Byte);
+                return IsNextParamAnInternedString || (_paramInfo.ArrayLength >= 0
+                        && _unityMessager.GetParamType(_paramInfo.QueueId) == typeof(Byte));
             }
         }
 
+        private bool IsNextParamAnInternedString
+        {
+            get { return _batchRowIdx < 0 && _paramInfo.QueueId >= 0 && _paramInfo.QueueId == _unityMessager._internedStringQueueId; }
+        }
+
         //Reads the next parameter as a single value and advance to the next parameter if any. 
         public T ReadNextParamAndAdvance<T>()
         {
             Assert.IsTrue(CheckParamRequest(typeof(T), false)); //When assertions get compiled relevant additional checks are made          
 
-            T param = UnityMessager.Instance.GetParamQueue<T>(_paramInfo.QueueId).ReadNext();
+            if (_batchRowIdx >= 0)
+                return (_unityMessager._batchColumns[_batchColumnIdx++] as T[])[_batchRowIdx];
+
+            T param = _unityMessager.ReadParam<T>(_paramInfo);
             Advance();
             return param;
         }
@@ -282,17 +503,18 @@ public class UnityMessager : MonoBehaviour
         {
             Assert.IsTrue(CheckParamRequest(typeof(T), true)); //When assertions get compiled relevant additional checks are made          
 
-            ArrayParam<T> param = UnityMessager.Instance.GetParamQueue<T>(_paramInfo.QueueId).ReadNextAsArray(_paramInfo.ArrayLength);
+            ArrayParam<T> param = _unityMessager.ReadParamAsArray<T>(_paramInfo);
             Advance();
             return param;
         }
 
-        //Reads the next parameter as an string and advance to the next parameter if any.
+        //Reads the next parameter as an string and advance to the next parameter if any. Interned strings don't allocate.
         public string ReadNextParamAsStringAndAdvance()
         {
-            Assert.IsTrue(CheckParamRequest(typeof(Byte), true)); //When assertions get compiled relevant additional checks are made          
+            //When assertions get compiled relevant additional checks are made          
+            Assert.IsTrue(IsNextParamAnInternedString ? CheckParamRequest(typeof(string), false) : CheckParamRequest(typeof(Byte), true));
 
-            string param = UnityMessager.Instance.GetParamQueue<Byte>(_paramInfo.QueueId).ReadNextAsString(_paramInfo.ArrayLength);
+            string param = _unityMessager.ReadParamAsString(_paramInfo);
             Advance();
             return param;
         }
@@ -304,9 +526,10 @@ public class UnityMessager : MonoBehaviour
             bool isArray = IsNextParamAnArray;
             Assert.IsTrue(CheckParamRequest(null, isArray)); //When assertions get compiled relevant additional checks are made          
 
-            object param = isArray ?
-                            UnityMessager.Instance._messageQueues[_paramInfo.QueueId].ReadNextAsArrayBase(_paramInfo.ArrayLength)
-                            : UnityMessager.Instance._messageQueues[_paramInfo.QueueId].ReadNextAsObject();
+            if (_batchRowIdx >= 0)
+                return _unityMessager._batchColumns[_batchColumnIdx++].GetValue(_batchRowIdx);
+
+            object param = _unityMessager.ReadParamAsObject(_paramInfo);
             Advance();
             return param;
         }
@@ -314,18 +537,23 @@ public class UnityMessager : MonoBehaviour
         //Skip the next parameter and advance to the next parameter after that if any.
         public void SkipNextParamAndAdvance()
         {
-            UnityMessager.Instance._controlQueue.AdvanceToNextParam();
-            _paramInfo = UnityMessager.Instance._controlQueue.CurrentParamInfo;
+            if (_batchRowIdx >= 0)
+            {
+                ++_batchColumnIdx;
+                return;
+            }
+
+            _unityMessager._controlQueue.AdvanceToNextParam();
+            _paramInfo = _unityMessager._controlQueue.CurrentParamInfo;
         }
 
         //FOR INTERNAL USAGE ONLY!! This method fills the data from the next message to be handled directly into
         //the internal Message instance of the UnityMessager, avoiding the need of exposing a public constructor or factory method
-        public static void FillUnityMessagerInternalMessageInstance(int rcvId, int rtnId, int msgId, int nOfParams) 
+        public static void FillUnityMessagerInternalMessageInstance(UnityMessager unityMessager, int rcvId, int rtnId, int msgId, 
+                                                                    int nOfParams) 
         {
-            UnityMessager unityMessager = UnityMessager.Instance;
-            
             //Check there was no forbidden calls made to this method
-            Assert.IsTrue(_s_currentUniqueId < unityMessager._currentUniqueId,
+            Assert.IsTrue(unityMessager._lastMessageUniqueId < unityMessager._currentUniqueId,
                           "[UnityMessager] NOT ALLOWED CALL TO FillUnityMessagerInternalMessageInstance, RESTART THE GAME!!");
 
             unityMessager._internalMessageInstance.ReceiverId = rcvId;
@@ -335,42 +563,56 @@ public class UnityMessager : MonoBehaviour
 
             //gives this message an uniqueId in such way it will not be able to request parameters anymore 
             //after the ReceiveMessage method has advanced to the next message
-            unityMessager._internalMessageInstance._uniqueId = ++_s_currentUniqueId;
+            unityMessager._internalMessageInstance._uniqueId = ++unityMessager._lastMessageUniqueId;
+            unityMessager._internalMessageInstance._unityMessager = unityMessager;
             //reads the current parameter to be delivered as "NextParam" on the methods of this struct
-            unityMessager._internalMessageInstance._paramInfo = UnityMessager.Instance._controlQueue.CurrentParamInfo;
+            unityMessager._internalMessageInstance._paramInfo = unityMessager._controlQueue.CurrentParamInfo;
+            unityMessager._internalMessageInstance._batchRowIdx = -1;
+        }
+
+        //FOR INTERNAL USAGE ONLY!! The same as FillUnityMessagerInternalMessageInstance, but for the item at rowIdx of the batch 
+        //message being delivered, being its parameters the items at rowIdx of the batch columns, check DeliverBatchMessage
+        public static void FillUnityMessagerInternalBatchMessageInstance(UnityMessager unityMessager, int rcvId, int msgId, 
+                                                                         int nOfColumns, int rowIdx)
+        {
+            Assert.IsTrue(++unityMessager._currentUniqueId > 0); //each batch item is a message of its own for the checks above
+
+            FillUnityMessagerInternalMessageInstance(unityMessager, rcvId, -1, msgId, nOfColumns);
+            unityMessager._internalMessageInstance._batchRowIdx = rowIdx;
+            unityMessager._internalMessageInstance._batchColumnIdx = 0;
         }
 
         //Advance to the next parameter (actually the one that comes after the one said as "next" on method titles
         private void Advance()
         {
             //Now we are advancing to the parameter the comes after the one we calling "Next Parameter" by this method name.
-            UnityMessager.Instance._controlQueue.AdvanceToNextParam();
+            _unityMessager._controlQueue.AdvanceToNextParam();
             //so now we have it ready to the next request of -1 set to the _paramInfo.QueueId if there is no other params for this message
-            _paramInfo = UnityMessager.Instance._controlQueue.CurrentParamInfo;
+            _paramInfo = _unityMessager._controlQueue.CurrentParamInfo;
         }
 
         //Perform additional checks to log errors to the user when parameters are being requested in a wrong way for this message instance
         private bool CheckParamRequest(Type requestedType, bool wasRequestedAsArray)
         {
-            if (_uniqueId < _s_currentUniqueId) 
+            if (_uniqueId < _unityMessager._lastMessageUniqueId) 
             {
                 Debug.LogError("[UnityMessager] ReadNextParamAndAdvance called for an old Message which parameters were already read.");
                 return false;
             }
 
-            if (_paramInfo.QueueId < 0)
+            if (_batchRowIdx >= 0 ? _batchColumnIdx >= NumberOfParams : _paramInfo.QueueId < 0)
             {
                 Debug.LogError("[UnityMessager] Attempt to read a parameter beyond the ones of available for the message!");
                 return false;
             }
 
-            if (requestedType != null && UnityMessager.Instance._messageQueues[_paramInfo.QueueId].QueueType != requestedType)
+            if (requestedType != null && NextParamType != requestedType)
             {
                 Debug.LogError("[UnityMessager] Parameter of wrong type being requested!");
                 return false;
             }
 
-            if ((_paramInfo.ArrayLength >= 0) != wasRequestedAsArray)
+            if (IsNextParamAnArray != wasRequestedAsArray)
             {
                 if (wasRequestedAsArray)
                     Debug.LogError("[UnityMessager] Single parameter value requested as array!");
@@ -385,8 +627,11 @@ public class UnityMessager : MonoBehaviour
 
         private ParamInfo _paramInfo;
         private ulong _uniqueId;
+        private UnityMessager _unityMessager; //instance delivering the message
 
-        private static ulong _s_currentUniqueId = 0; //gets increamented at each new message, providing always an unique id.
+        //row of the batch columns read by this message, -1 when it is not an item of a batch message
+        private int _batchRowIdx;
+        private int _batchColumnIdx; //next column to read when it is a batch message item
     };
 
     //Use this class for receiving and handling array parameters. It usually avoids the need of creating a C# native array instance,
@@ -430,41 +675,319 @@ public class UnityMessager : MonoBehaviour
         private int _firstIdx;
     }
 
+    //IMPLEMENT this interface for reading the ring messages, it is called on the thread reading them, not on the main thread
+    public interface IRingMessageHandler
+    {
+        void ReceiveRingMessage(RingMessage msg);
+    }
+
+    //A message read from the ring, it is the same instance for all the messages of a reader, being valid only during the
+    //ReceiveRingMessage call. Parameters are read in the order they were written on C++, checking only their item size.
+    public class RingMessage
+    {
+        public int ReceiverId { get; private set; }
+        public int MessageId { get; private set; }
+        public int NumberOfParameters { get; private set; }
+
+        //Length of the next parameter if it is an array (or a string), -1 for single parameters
+        public int GetNextParamLength()
+        {
+            Assert.IsTrue(_paramIdx < NumberOfParameters, "[UnityMessager] No more parameters on the ring message!");
+            return _reader.ReadInt(_pos + 4);
+        }
+
+        public T ReadNextParam<T>()
+        {
+            PayloadType type = GetPayloadType(typeof(T));
+            int dataPos = ReadNextParamHeader(type, false);
+            if (dataPos < 0)
+                return default(T);
+
+            T[] scratch = type.Scratch as T[];
+            if (type.IsPrimitive)
+                Buffer.BlockCopy(_reader.SharedArray, dataPos, scratch, 0, type.Size);
+            else
+                scratch[0] = (T)Marshal.PtrToStructure(_reader.GetPtr(dataPos), type.Type);
+
+            return scratch[0];
+        }
+
+        //Copies the items of an array parameter to destArray, returning their number, or -1 if they don't fit it
+        public int ReadNextArrayParam<T>(T[] destArray, int destStartIdx)
+        {
+            PayloadType type = GetPayloadType(typeof(T));
+            int length = GetNextParamLength();
+            int dataPos = ReadNextParamHeader(type, true);
+            if (dataPos < 0 || length > destArray.Length - destStartIdx)
+                return -1;
+
+            if (type.IsPrimitive)
+                Buffer.BlockCopy(_reader.SharedArray, dataPos, destArray, destStartIdx * type.Size, length * type.Size);
+            else
+            {
+                for (int i = 0; i < length; ++i)
+                    destArray[destStartIdx + i] = (T)Marshal.PtrToStructure(_reader.GetPtr(dataPos + i * type.Size), type.Type);
+            }
+
+            return length;
+        }
+
+        //Version allocating the array, better to avoid it on performance sensitive code
+        public T[] ReadNextArrayParam<T>()
+        {
+            T[] array = new T[Math.Max(GetNextParamLength(), 0)];
+            return ReadNextArrayParam<T>(array, 0) >= 0 ? array : null;
+        }
+
+        //Reads C strings (as ASCII) sent by C++
+        public string ReadNextStringParam()
+        {
+            int length = GetNextParamLength();
+            int dataPos = ReadNextParamHeader(GetPayloadType(typeof(Byte)), true);
+            if (dataPos < 0)
+                return null;
+
+            if (_chars.Length < length)
+                _chars = new Byte[Math.Max(length, 2 * _chars.Length)];
+
+            Buffer.BlockCopy(_reader.SharedArray, dataPos, _chars, 0, length);
+            return System.Text.Encoding.ASCII.GetString(_chars, 0, length);
+        }
+
+        internal RingMessage(RingReader reader)
+        {
+            _reader = reader;
+        }
+
+        internal void Set(int recordPos, int recordLength, int receiverId, int msgId, int nOfParams)
+        {
+            ReceiverId = receiverId;
+            MessageId = msgId;
+            NumberOfParameters = nOfParams;
+            _pos = recordPos + _ringRecordHeaderSize;
+            _endPos = recordPos + recordLength;
+            _paramIdx = 0;
+        }
+
+        //Moves to the next parameter, returning the position of its items, or -1 (logging an error) if it isn't of the given type
+        private int ReadNextParamHeader(PayloadType type, bool isArray)
+        {
+            Assert.IsTrue(_paramIdx < NumberOfParameters, "[UnityMessager] No more parameters on the ring message!");
+
+            int itemSize = _reader.ReadInt(_pos);
+            int length = _reader.ReadInt(_pos + 4);
+            int alignment = Math.Min(itemSize & -itemSize, _ringMaxItemAlignment); //as GetItemAlignment on C++ (UnityMessagerWire.h)
+            int dataPos = (_pos + _ringParamHeaderSize + alignment - 1) & ~(alignment - 1);
+            _pos = dataPos + itemSize * (length >= 0 ? length : 1);
+            ++_paramIdx;
+
+            if (itemSize != type.Size || (length >= 0) != isArray || _pos > _endPos)
+            {
+                Debug.LogError("[UnityMessager] Parameter " + (_paramIdx - 1) + " of the ring message " + MessageId 
+                               + " is not a " + type.Type.Name + (isArray ? " array!" : "!"));
+                return -1;
+            }
+
+            return dataPos;
+        }
+
+        //The scratch arrays of the types are only used by the thread reading the ring, so they aren't shared with the queues
+        private PayloadType GetPayloadType(Type type)
+        {
+            PayloadType payloadType;
+            if (!_types.TryGetValue(type, out payloadType))
+            {
+                payloadType = new PayloadType(type, 1); //the alignment is given by the item size on each parameter header
+                _types.Add(type, payloadType);
+            }
+
+            return payloadType;
+        }
+
+        private RingReader _reader;
+        private int _pos; //byte position of the next parameter header on the ring array
+        private int _endPos;
+        private int _paramIdx;
+        private Dictionary<Type, PayloadType> _types = new Dictionary<Type, PayloadType>();
+        private Byte[] _chars = new Byte[64]; //chars of the string being read
+    }
+
+    //Reads the messages written by the C++ UnityMessagerRing of a channel, check GetRingReader. The C++ side writes the messages
+    //while this is reading them, the head (written by C++) and the tail (written here) are the only synchronization between them.
+    //Use it from a SINGLE THREAD AT A TIME, which doesn't need to be the main thread.
+    public class RingReader
+    {
+        //Reads the messages written so far (up to maxNOfMessages), calling the handler for each, returns their number. The space
+        //of each message is given back to the C++ side right after the handler returns, so it may write new messages there.
+        public int ReadMessages(IRingMessageHandler handler, int maxNOfMessages)
+        {
+            long head = Interlocked.Read(ref SharedArray[_ringHeadIdx]); //also makes the records written before it visible
+            int nOfMessages = 0;
+            while (_tail < head && nOfMessages < maxNOfMessages)
+            {
+                int ringPos = (int)(_tail & (_capacityInBytes - 1));
+                int recordPos = _ringDataStartIdx * 8 + ringPos;
+                int recordLength = ReadInt(recordPos);
+                int nOfParams = ReadInt(recordPos + 12);
+                if (recordLength < _ringRecordHeaderSize || (recordLength & (_ringRecordAlignment - 1)) != 0 
+                    || ringPos + recordLength > _capacityInBytes || _tail + recordLength > head)
+                {
+                    Debug.LogError("[UnityMessager] Invalid message written to the ring, the remaining messages were discarded!");
+                    _tail = head;
+                    Interlocked.Exchange(ref SharedArray[_ringTailIdx], _tail);
+                    break;
+                }
+
+                if (nOfParams != _ringPaddingRecord)
+                {
+                    _message.Set(recordPos, recordLength, ReadInt(recordPos + 4), ReadInt(recordPos + 8), nOfParams);
+                    handler.ReceiveRingMessage(_message);
+                    ++nOfMessages;
+                }
+
+                //the exchange is a full barrier, so the C++ side only reuses the record bytes after they were read
+                _tail += recordLength;
+                Interlocked.Exchange(ref SharedArray[_ringTailIdx], _tail);
+            }
+
+            return nOfMessages;
+        }
+
+        public int ReadMessages(IRingMessageHandler handler)
+        {
+            return ReadMessages(handler, int.MaxValue);
+        }
+
+        public bool HasMessages()
+        {
+            return Interlocked.Read(ref SharedArray[_ringHeadIdx]) > _tail;
+        }
+
+        internal RingReader(long[] sharedArray)
+        {
+            SharedArray = sharedArray;
+            _capacityInBytes = (sharedArray.Length - _ringDataStartIdx) * 8;
+            _tail = Interlocked.Read(ref sharedArray[_ringTailIdx]);
+            _message = new RingMessage(this);
+        }
+
+        internal long[] SharedArray { get; private set; }
+
+        //records and parameter headers are aligned to 4 bytes, so each int is within a single long (little endian)
+        internal int ReadInt(int pos)
+        {
+            return (int)(SharedArray[pos >> 3] >> ((pos & 7) * 8));
+        }
+
+        //the shared arrays are pinned by the UnityAdapter
+        internal IntPtr GetPtr(int pos)
+        {
+            return new IntPtr(Marshal.UnsafeAddrOfPinnedArrayElement(SharedArray, 0).ToInt64() + pos);
+        }
+
+        private int _capacityInBytes;
+        private long _tail; //bytes read since the ring creation, published to the shared array after each message
+        private RingMessage _message;
+    }
+
     //This is only used on debug code to make sure no invalid calls to FillUnityMessagerInternalMessageInstance are being made
     private ulong _currentUniqueId = 0;
 
+    //gets increamented at each new message, providing always an unique id among the messages of this instance
+    private ulong _lastMessageUniqueId = 0;
+
     //Point of return for the method Message.FillUnityMessagerInternalMessageInstance. Once it is filled it is delivered to its receiver.
     private Message _internalMessageInstance;
 
-    //shared array for controling the available receiver ids, keep them in synch between the C++ code and the C# code.
-    private int[] _receiverIdsSharedArray = null;
+    //header of the receiver ids table shared with the C++ code, keeping the available receiver ids in synch between the C++ code
+    //and the C# code, and its chunks, got from the header when first needed (check UM_RECEIVER_IDS_HEAD_POS on C++)
+    private long[] _receiverIdsHeader = null;
+    private int[][] _receiverIdsChunks = null;
 
-    //message receiver instances (OR default component instances) accordingly to their receiverIds. 
+    //message receiver instances (OR default component instances) indexed by the slot index of their receiverIds. 
     private IMessageReceiver[] _receivers = null;
 
-    //message receiver game object instances accordingly to their receiverIds
+    //message receiver game object instances indexed by the slot index of their receiverIds
     private GameObject[] _receiverGameObjects = null;
 
+    //receiver id the objects at each slot index were set for, -1 if none, so messages to stale ids don't get to them
+    private int[] _boundReceiverIds = null;
+
     //component types, this is indexed by the unique internal component id for the component type
     private List<Type> _componentTypes = null;
 
-    //Message queues arrays, where the 0 position is the control queue and the next ones are the ParamQueue instances, one per param type
+    //interned strings indexed by their ids, their parameters come on the queue (or payload type) _internedStringQueueId
+    private List<string> _internedStrings = null;
+    private int _internedStringQueueId = -1;
+    private byte[] _internedStringBytes = null; //chars of the interned string being registered
+
+    //shared array where the C++ side publishes the statistics, null if collectStatistics is not set, check GetStatistic
+    private long[] _statistics = null;
+
+    //writer of the messages sent to C++, check StartMessageToCpp
+    private InboxWriter _inboxWriter = null;
+
+    //reader of the ring of this channel, created by the first GetRingReader call
+    private RingReader _ringReader = null;
+
+    //columns of the batch message being delivered, check DeliverBatchMessage
+    private List<Array> _batchColumns = new List<Array>();
+
+    //routing bindings for the messages sent by C++ using names, indexed by their binding ids
+    private List<RoutingBinding> _routingBindings = null;
+
+    //Message queues array, where the 0 position is the control queue and the next ones are the ParamQueue instances, one per param type.
+    //It grows as the C++ side registers new queues, indexed by the queue ids (check UnityMessager::Registry on C++)
     private MessageQueueBase[] _messageQueues = null;
     private ControlQueue _controlQueue = null;
 
-    private const int _controlQueueId = 0; //MUST BE 0, corresponds to UM_CONTROL_QUEUE_ID on C++
-    private const int _maxNOfMessageQueues = 32; //corresponds to UM_MAX_N_OF_MESSAGE_QUEUES on C++, check comments for this. 
+    //Only used when interleavedParams is set, the types are indexed by their payload type ids (the 0 is never used)
+    private PayloadQueue _payloadQueue = null;
+    private List<PayloadType> _payloadTypes = null;
 
-    private static UnityMessager _s_instance = null; //singleton reference holder
+    private const int _defaultChannel = 0; //corresponds to UM_DEFAULT_CHANNEL on C++
+    private const int _maxNOfChannels = 8; //corresponds to UM_MAX_N_OF_CHANNELS on C++
+    private const int _controlQueueId = 0; //MUST BE 0, corresponds to UM_CONTROL_QUEUE_ID on C++
+    private const int _initialNOfMessageQueues = 8; //length of _messageQueues until more queues are registered, check GrowMessageQueues
+    private const int _initFlagDoubleBuffered = 1; //corresponds to UM_INIT_FLAG_DOUBLE_BUFFERED on C++
+    private const int _initFlagCompactControlQueue = 2; //corresponds to UM_INIT_FLAG_COMPACT_CONTROL_QUEUE on C++
+    private const int _initFlagInterleavedParams = 4; //corresponds to UM_INIT_FLAG_INTERLEAVED_PARAMS on C++
+    private const int _initFlagStatistics = 8; //corresponds to UM_INIT_FLAG_STATISTICS on C++
+    private const int _payloadQueueId = 1; //corresponds to UM_PAYLOAD_QUEUE_ID on C++
+    private const int _maxNOfControlMessageParams = 64; //corresponds to UM_MAX_N_OF_CONTROL_MESSAGE_PARAMS on C++
+    private const int _firstRoutingBindingSlot = -2; //component id for the binding 0, corresponds to UM_ROUTING_BINDING_COMPONENT_SLOT on C++
+    private const int _receiverIdIndexBits = 20; //corresponds to UM_RECEIVER_ID_INDEX_BITS on C++
+    private const int _receiverIdIndexMask = (1 << _receiverIdIndexBits) - 1; //corresponds to UM_RECEIVER_ID_INDEX_MASK on C++
+    private const int _receiverIdGenerationMask = (1 << (31 - _receiverIdIndexBits)) - 1; //corresponds to UM_RECEIVER_ID_GENERATION_MASK on C++
+    private const int _receiverIdsChunkLength = 1024; //corresponds to UM_RECEIVER_IDS_CHUNK_LENGTH on C++
+    private const int _receiverIdsHeadPos = 0; //corresponds to UM_RECEIVER_IDS_HEAD_POS on C++
+    private const int _receiverIdsNOfFreePos = 1; //corresponds to UM_RECEIVER_IDS_N_OF_FREE_POS on C++
+    private const int _receiverIdsNOfChunksPos = 2; //corresponds to UM_RECEIVER_IDS_N_OF_CHUNKS_POS on C++
+    private const int _receiverIdsFirstChunkPos = 3; //corresponds to UM_RECEIVER_IDS_FIRST_CHUNK_POS on C++
+    private const int _receiverIdSlotLength = 2; //corresponds to UM_RECEIVER_ID_SLOT_LENGTH on C++
+    private const int _receiverIdSlotGeneration = 0; //corresponds to UM_RECEIVER_ID_SLOT_GENERATION on C++
+    private const int _receiverIdSlotNext = 1; //corresponds to UM_RECEIVER_ID_SLOT_NEXT on C++
+    private const int _receiverIdInUse = -1; //corresponds to UM_RECEIVER_ID_IN_USE on C++
+    private const int _receiverIdReleasing = -2; //corresponds to UM_RECEIVER_ID_RELEASING on C++
+    private const int _ringHeadIdx = 0; //corresponds to UMR_HEAD_IDX on C++
+    private const int _ringTailIdx = 8; //corresponds to UMR_TAIL_IDX on C++
+    private const int _ringDataStartIdx = 16; //corresponds to UMR_DATA_START_IDX on C++
+    private const int _ringRecordHeaderSize = 16; //corresponds to UMR_RECORD_HEADER_SIZE on C++
+    private const int _ringRecordAlignment = 16; //corresponds to UMR_RECORD_ALIGNMENT on C++
+    private const int _ringPaddingRecord = -1; //corresponds to UMR_PADDING_RECORD on C++
+    private const int _ringParamHeaderSize = 8; //corresponds to UMR_PARAM_HEADER_SIZE on C++
+    private const int _ringMaxItemAlignment = 8; //corresponds to UM_MAX_ITEM_ALIGNMENT on C++, check GetItemAlignment at UnityMessagerWire.h
+
+    private static UnityMessager[] _s_instances = new UnityMessager[_maxNOfChannels]; //instance reference holder of each channel
 
 #if UNITY_EDITOR
     //Check min value requirement are met for the inspector settings for this class 
     void OnValidate()
     {
-        if (maxNumberOfReceiverIds < 16)
+        if (initialNumberOfReceiverIds < 16)
         {
-            Debug.LogWarning("Max Number Of Receiver Ids cannot be less than 16!!");
-            maxNumberOfReceiverIds = 16;
+            Debug.LogWarning("Initial Number Of Receiver Ids cannot be less than 16!!");
+            initialNumberOfReceiverIds = 16;
         }
 
         if (maxQueueArraysSizeInBytes < 512)
@@ -472,50 +995,72 @@ public class UnityMessager : MonoBehaviour
             Debug.LogWarning("Max Queue Arrays' Size In Bytes Cannot Be Less Than 512!!");
             maxQueueArraysSizeInBytes = 512;
         }
+
+        if (channel < 0 || channel >= _maxNOfChannels)
+        {
+            Debug.LogWarning("Channel must be from 0 to " + (_maxNOfChannels - 1) + "!!");
+            channel = Math.Min(Math.Max(channel, 0), _maxNOfChannels - 1);
+        }
     }
 #endif
 
     private void Awake()
     {
-        if (_s_instance != null && _s_instance != this)
+        if (_s_instances[channel] != null && _s_instances[channel] != this)
         {
             Destroy(this.gameObject);
-            throw new Exception("[UnityMessager] More than one instance of UnityMessager being created!!");
+            throw new Exception("[UnityMessager] More than one instance of UnityMessager being created for the channel " + channel + "!!");
         }
         
-        if (_s_instance == null)
+        if (_s_instances[channel] == null)
         {
-            _s_instance = this;
+            _s_instances[channel] = this;
             DontDestroyOnLoad(this.gameObject);
         }
 
-        int firstArrayId = UnityMessagerDLL.UM_InitUnityMessagerAndGetControlQueueId(maxNumberOfReceiverIds, maxQueueArraysSizeInBytes);
-        _controlQueue = new ControlQueue(firstArrayId);
+        int initFlags = (doubleBufferedQueues ? _initFlagDoubleBuffered : 0) | (compactControlQueue ? _initFlagCompactControlQueue : 0)
+                        | (interleavedParams ? _initFlagInterleavedParams : 0) | (collectStatistics ? _initFlagStatistics : 0);
+        int firstArrayId = UnityMessagerDLL.UM_InitUnityMessagerAndGetControlQueueId(channel, initialNumberOfReceiverIds, 
+                                                                                     maxQueueArraysSizeInBytes, initFlags);
+        _controlQueue = new ControlQueue(this, firstArrayId, compactControlQueue);
 
-        _messageQueues = new MessageQueueBase[_maxNOfMessageQueues];
-        _messageQueues[0] = _controlQueue;
+        _messageQueues = new MessageQueueBase[] { _controlQueue };
+        GrowMessageQueues(_initialNOfMessageQueues);
 
-        //We create instance of MessageQueueBase so they can hold received ids for the first and current queue arrays
-        //until the user's code requests the corresponding parameter using a generic method for the first time, what will
-        //cause the real ParamQueue to be instanced and replace this placeholder instance we set here.
-        for (int i = 1; i < _messageQueues.Length; ++i)
-            _messageQueues[i] = new MessageQueueBase(i);
+        //the receiver objects arrays grow as the ids of more slots get bound, check BindReceiverId
+        _receivers = new IMessageReceiver[_receiverIdsChunkLength];
+        _receiverGameObjects = new GameObject[_receiverIdsChunkLength];
+        _boundReceiverIds = new int[_receiverIdsChunkLength];
+        for (int i = 0; i < _boundReceiverIds.Length; ++i)
+            _boundReceiverIds[i] = -1;
 
-        _receivers = new IMessageReceiver[maxNumberOfReceiverIds];
         //Internal MessageReceiver class, handle messages sent to the UnityMessager itself. The receiver Id 0 is known as being its receiver id by default.
-        _receivers[0] = new MessageReceiver();
-
-        _receiverGameObjects = new GameObject[maxNumberOfReceiverIds];
+        _receivers[0] = new MessageReceiver(this);
+        _boundReceiverIds[0] = 0;
 
         _componentTypes = new List<Type>();
+        _routingBindings = new List<RoutingBinding>();
+
+        _internedStrings = new List<string>();
+        _internedStringQueueId = -1;
+
+        _payloadQueue = null;
+        _payloadTypes = interleavedParams ? new List<PayloadType>() { null } : null;
+
+        _inboxWriter = new InboxWriter(channel);
 
         DeliverMessages(); //Deliver the first messages, expected to be only control messages to finish with the intialization process
     }
 
     private void OnDestroy()
     {
-        //This will delete the singleton instance on C++ and release all the shared arrays allocated by the UnityMessager
-        UnityMessagerDLL.UM_OnDestroy();
+        if (_s_instances[channel] != this)
+            return; //a duplicate instance destroyed by Awake, the C++ instance belongs to the one registered for the channel
+
+        _s_instances[channel] = null;
+
+        //This will delete the C++ instance of the channel and release all the shared arrays allocated by it
+        UnityMessagerDLL.UM_OnDestroy(channel);
     }
 
     //Registers a new component type being used by the C++ code as receiver component for game object receivers
@@ -529,91 +1074,445 @@ public class UnityMessager : MonoBehaviour
         _componentTypes.Add(componentType);
     }
 
+    //Registers the names of a routing binding, an empty name means the binding does not replace the receiver id or message id
+    private void RegisterRoutingBinding(int id, int componentId, string objectName, string methodName)
+    {
+        Assert.IsTrue(_routingBindings.Count == id); //the id is the index, as it happens to the component ids
+
+        _routingBindings.Add(new RoutingBinding(componentId, objectName.Length > 0 ? objectName : null,
+                                                methodName.Length > 0 ? methodName : null));
+    }
+
+    //Makes the _messageQueues array have at least nOfQueues, doubling its length so it is indexed by the queue ids with no maximum.
+    //We create instance of MessageQueueBase so they can hold received ids for the first and current queue arrays
+    //until the user's code requests the corresponding parameter using a generic method for the first time, what will
+    //cause the real ParamQueue to be instanced and replace this placeholder instance we set here.
+    private void GrowMessageQueues(int nOfQueues)
+    {
+        int previousLength = _messageQueues.Length;
+        Array.Resize(ref _messageQueues, Math.Max(nOfQueues, previousLength * 2));
+        for (int i = previousLength; i < _messageQueues.Length; ++i)
+            _messageQueues[i] = new MessageQueueBase(i);
+    }
+
     //helper method for getting the Parameter Queue created at the first time its accessed for an specific type
     private ParamQueue<T> GetParamQueue<T>(int queueId = -1) 
     {
-        //If this is the first time we are reading a parameter of the type T we need to create the ParamQueue for it.
-        if (ParamQueue<T>.Instance == null)
+        if (queueId < 0)
         {
-            if (queueId < 0)
+            for (queueId = 0; queueId < _messageQueues.Length; ++queueId)
             {
-                for (queueId = 0; queueId < _maxNOfMessageQueues; ++queueId)
-                {
-                    if (_messageQueues[queueId].QueueType == typeof(T))
-                        break;
-                }
-
-                if (queueId == _maxNOfMessageQueues)
-                    return null;
+                if (_messageQueues[queueId].QueueType == typeof(T))
+                    break;
             }
+
+            if (queueId == _messageQueues.Length)
+                return null;
+        }
+
+        //If this is the first time we are reading a parameter of the type T we need to create the ParamQueue for it.
+        ParamQueue<T> paramQueue = _messageQueues[queueId] as ParamQueue<T>;
+        if (paramQueue == null)
+        {
             //We do that using the existing instance to MessageQueueBase for the respective queueId.
             //This base class instance has held for us the ids provided in the past for this queueId. 
-            ParamQueue<T>.CreateInstance(UnityMessager.Instance._messageQueues[queueId]);
+            paramQueue = new ParamQueue<T>(_messageQueues[queueId]);
             //Saves the new ParamQueue instance replacing the base class instance we don't need anymore
-            _messageQueues[queueId] = ParamQueue<T>.Instance;
+            _messageQueues[queueId] = paramQueue;
         }
 
-        return ParamQueue<T>.Instance;
+        return paramQueue;
     }
 
-    //helper method to get a message based on reflection delivered with the message parameters extracted
-    private void DeliverMessageWithReflection(object component, ref Message message)
+    //helper methods for reading parameters from their ParamQueue, or from the payload queue when interleavedParams is set
+    private Type GetParamType(int queueId)
     {
-        int methodNameLength = -message.MessageId; //messageId, when negative, is the length of the method name string
-        string methodName = GetParamQueue<Byte>().ReadNextAsString(methodNameLength);
+        if (queueId == _internedStringQueueId)
+            return typeof(string);
 
-        MethodInfo methodInfo = component.GetType().GetMethod(methodName);
+        return _payloadTypes != null ? _payloadTypes[queueId].Type : _messageQueues[queueId].QueueType;
+    }
+
+    private T ReadParam<T>(ParamInfo paramInfo)
+    {
+        T param = _payloadTypes != null ? GetPayloadQueue().ReadNext<T>(_payloadTypes[paramInfo.QueueId])
+                                        : GetParamQueue<T>(paramInfo.QueueId).ReadNext();
+        EndSingleParamArrayIfAny(paramInfo.QueueId);
+        return param;
+    }
 
-        ParameterInfo[] paramInfos = methodInfo.GetParameters();
+    private ArrayParam<T> ReadParamAsArray<T>(ParamInfo paramInfo)
+    {
+        ArrayParam<T> arrayParam = _payloadTypes != null 
+                                    ? GetPayloadQueue().ReadNextAsArray<T>(_payloadTypes[paramInfo.QueueId], paramInfo.ArrayLength)
+                                    : GetParamQueue<T>(paramInfo.QueueId).ReadNextAsArray(paramInfo.ArrayLength);
+        EndSingleParamArrayIfAny(paramInfo.QueueId);
+        return arrayParam;
+    }
 
-        Assert.IsTrue(message.NumberOfParams == paramInfos.Length);
-        object[] parameters = null;
+    private string ReadParamAsString(ParamInfo paramInfo)
+    {
+        if (paramInfo.QueueId == _internedStringQueueId)
+            return _internedStrings[ReadParam<InternedStringRef>(paramInfo).Id];
 
-        if (paramInfos.Length > 0) //is there any parameter to read
+        string param = _payloadTypes != null ? GetPayloadQueue().ReadNextAsString(paramInfo.ArrayLength)
+                                             : GetParamQueue<Byte>(paramInfo.QueueId).ReadNextAsString(paramInfo.ArrayLength);
+        EndSingleParamArrayIfAny(paramInfo.QueueId);
+        return param;
+    }
+
+    //if it is an array, the object will be a c# native array of the parameter type
+    private object ReadParamAsObject(ParamInfo paramInfo)
+    {
+        if (paramInfo.QueueId == _internedStringQueueId)
+            return ReadParamAsString(paramInfo);
+
+        object param;
+        if (_payloadTypes != null)
         {
-            parameters = new object[paramInfos.Length];
-            int i = -1;
-            while (message.NumberOfParamsToBeRead > 0)
-                parameters[++i] = paramInfos[i].ParameterType == typeof(string) ? //read a string as a string, so we don't get a byte array
-                                  message.ReadNextParamAsStringAndAdvance()
-                                  : message.ReadNextParamAndAdvance();
+            PayloadType payloadType = _payloadTypes[paramInfo.QueueId];
+            param = paramInfo.ArrayLength >= 0 ? GetPayloadQueue().ReadNextAsArrayBase(payloadType, paramInfo.ArrayLength)
+                                               : GetPayloadQueue().ReadNextAsObject(payloadType);
+        }
+        else
+        {
+            param = paramInfo.ArrayLength >= 0 ? _messageQueues[paramInfo.QueueId].ReadNextAsArrayBase(paramInfo.ArrayLength)
+                                               : _messageQueues[paramInfo.QueueId].ReadNextAsObject();
         }
 
-        methodInfo.Invoke(component, parameters);
+        EndSingleParamArrayIfAny(paramInfo.QueueId);
+        return param;
     }
 
-    //Control messages are specific to setup or control the message delivering process itself  
-    private void HandleControlMessage(int messageId, ArrayParam<int> arrayParam)
+    private void SkipParam(ParamInfo paramInfo)
     {
-        switch (messageId)
-        {
-            case 0: //UMM_SET_QUEUE_ARRAY = 0, used when the current array in use is close to its end, so a new one is needed
-                {   
-                    Assert.IsTrue(arrayParam.Length == 2);
+        int nOfItems = paramInfo.ArrayLength >= 0 ? paramInfo.ArrayLength : 1;
+        if (_payloadTypes != null)
+            GetPayloadQueue().Skip(_payloadTypes[paramInfo.QueueId], nOfItems);
+        else
+            _messageQueues[paramInfo.QueueId].AdvanceToPos(nOfItems);
 
-                    int queueId = arrayParam[0];
-                    int arrayId = arrayParam[1];
+        EndSingleParamArrayIfAny(paramInfo.QueueId);
+    }
 
-                    _messageQueues[queueId].SetCurrentArray(arrayId);
-                    break;
+    //object and method names are pushed to the Byte ParamQueue, or to the payload queue, without being registered as parameters
+    private string ReadName(int length)
+    {
+        if (_payloadTypes != null)
+        {
+            string payloadName = GetPayloadQueue().ReadNextAsString(length);
+            EndSingleParamArrayIfAny(_payloadQueueId);
+            return payloadName;
+        }
+
+        ParamQueue<Byte> byteQueue = GetParamQueue<Byte>();
+        string name = byteQueue.ReadNextAsString(length);
+        EndSingleParamArrayIfAny(byteQueue.QueueId);
+        return name;
+    }
+
+    //Spill arrays and referenced UnityArrays hold a single parameter (or name), so the queue returns to its usual array after reading it
+    private void EndSingleParamArrayIfAny(int queueId)
+    {
+        _messageQueues[_payloadTypes != null ? _payloadQueueId : queueId].EndSingleParamArrayIfAny();
+    }
+
+    //the same done by GetParamQueue, the PayloadQueue replaces the MessageQueueBase instance holding its array ids
+    private PayloadQueue GetPayloadQueue()
+    {
+        if (_payloadQueue == null)
+        {
+            _payloadQueue = new PayloadQueue(_messageQueues[_payloadQueueId]);
+            _messageQueues[_payloadQueueId] = _payloadQueue;
+        }
+
+        return _payloadQueue;
+    }
+
+    //Registers a type used by parameters on the payload queue, its name comes packed as little endian on the int parameters
+    private void RegisterPayloadType(int typeId, int alignment, int nameLength, ArrayParam<int> packedName, int firstNameParamIdx)
+    {
+        Assert.IsTrue(_payloadTypes.Count == typeId); //the id is the index, it would be strange if this assertion fails
+
+        char[] typeName = new char[nameLength];
+        for (int i = 0; i < nameLength; ++i)
+            typeName[i] = (char)((packedName[firstNameParamIdx + i / 4] >> (8 * (i % 4))) & 0xFF);
+
+        Type type = Type.GetType(new string(typeName));
+        Assert.IsTrue(type != null, "[UnityMessager] Invalid parameter type being used from C++");
+
+        _payloadTypes.Add(new PayloadType(type, alignment));
+    }
+
+    //Registers a chunk of the chars of an interned string packed as little endian on the int parameters, as done for the payload
+    //types. Strings longer than a control message come on several chunks, the string replaces the previous one for the id on the last.
+    private void RegisterInternedStringChunk(int id, int length, int offset, ArrayParam<int> packedChars, int firstCharParamIdx)
+    {
+        if (_internedStringBytes == null || _internedStringBytes.Length < length)
+            _internedStringBytes = new byte[Math.Max(length, 256)];
+
+        int chunkLength = Math.Min(length - offset, (packedChars.Length - firstCharParamIdx) * 4);
+        for (int i = 0; i < chunkLength; ++i)
+            _internedStringBytes[offset + i] = (byte)((packedChars[firstCharParamIdx + i / 4] >> (8 * (i % 4))) & 0xFF);
+
+        if (offset + chunkLength < length)
+            return;
+
+        string str = System.Text.ASCIIEncoding.ASCII.GetString(_internedStringBytes, 0, length);
+        if (id == _internedStrings.Count)
+            _internedStrings.Add(str);
+        else
+            _internedStrings[id] = str; //evicted on the C++ side, messages read before have already got the previous string
+    }
+
+    //Receiver object set for the receiver id, null if there is none or if the id is stale (its slot was set for a newer id)
+    private IMessageReceiver GetReceiver(int receiverId)
+    {
+        int index = receiverId & _receiverIdIndexMask;
+        return index < _receivers.Length && _boundReceiverIds[index] == receiverId ? _receivers[index] : null;
+    }
+
+    //The same for the receiver game objects
+    private GameObject GetReceiverGameObject(int receiverId)
+    {
+        int index = receiverId & _receiverIdIndexMask;
+        return index < _receiverGameObjects.Length && _boundReceiverIds[index] == receiverId ? _receiverGameObjects[index] : null;
+    }
+
+    //Sets the receiver id as the one bound to its slot, growing the receiver objects arrays if needed, returns the slot index.
+    //The objects set for a previous id of the slot are removed, they are not the receivers of the new id.
+    private int BindReceiverId(int receiverId)
+    {
+        int index = receiverId & _receiverIdIndexMask;
+        if (index >= _receivers.Length)
+        {
+            int previousLength = _receivers.Length;
+            int length = Math.Max(previousLength * 2, (index / _receiverIdsChunkLength + 1) * _receiverIdsChunkLength);
+            Array.Resize(ref _receivers, length);
+            Array.Resize(ref _receiverGameObjects, length);
+            Array.Resize(ref _boundReceiverIds, length);
+            for (int i = previousLength; i < length; ++i)
+                _boundReceiverIds[i] = -1;
+        }
+
+        if (_boundReceiverIds[index] != receiverId)
+        {
+            _receivers[index] = null;
+            _receiverGameObjects[index] = null;
+            _boundReceiverIds[index] = receiverId;
+        }
+
+        return index;
+    }
+
+    //Returns true if the id was given by NewReceiverId (on C++ or C#) and it was not released yet
+    private bool IsReceiverIdInUse(int receiverId)
+    {
+        int index = receiverId & _receiverIdIndexMask;
+        if (receiverId < 0 || index / _receiverIdsChunkLength >= Interlocked.Read(ref _receiverIdsHeader[_receiverIdsNOfChunksPos]))
+            return false;
+
+        int[] chunk = GetReceiverIdsChunk(index);
+        int slotPos = (index % _receiverIdsChunkLength) * _receiverIdSlotLength;
+        int next = Thread.VolatileRead(ref chunk[slotPos + _receiverIdSlotNext]); //a slot claimed by a release is still in use
+        return (next == _receiverIdInUse || next == _receiverIdReleasing)
+            && Thread.VolatileRead(ref chunk[slotPos + _receiverIdSlotGeneration]) == (receiverId >> _receiverIdIndexBits);
+    }
+
+    //Takes the first slot of the free list of the receiver ids table, returning its index, 0 if the list is empty. It is the same
+    //lock free pop done by the C++ side, which may be doing it at the same time from worker threads, check UnityMessager::NewReceiverId
+    private int PopFreeReceiverIdSlot()
+    {
+        int index;
+        do
+        {
+            long previousHead = Interlocked.Read(ref _receiverIdsHeader[_receiverIdsHeadPos]);
+            index = (int)(uint)previousHead;
+            if (index == 0)
+                return 0;
+
+            //it may be stale when another thread has changed the list, but then the head tag has changed too, so it is never used
+            int next = Thread.VolatileRead(ref GetReceiverIdsChunk(index)[(index % _receiverIdsChunkLength) * _receiverIdSlotLength + _receiverIdSlotNext]);
+            if (Interlocked.CompareExchange(ref _receiverIdsHeader[_receiverIdsHeadPos], NewReceiverIdsListHead(previousHead, next),
+                                            previousHead) == previousHead)
+                break;
+        } while (true);
+
+        //-1 means this slot is in use, not being free anymore, but also wasn't bound to a receiver yet.
+        int[] chunk = GetReceiverIdsChunk(index);
+        Interlocked.Exchange(ref chunk[(index % _receiverIdsChunkLength) * _receiverIdSlotLength + _receiverIdSlotNext], _receiverIdInUse);
+        Interlocked.Decrement(ref _receiverIdsHeader[_receiverIdsNOfFreePos]);
+        return index;
+    }
+
+    //Chunk of the receiver ids table having the slot at the index, which the C++ side has published before the slot got to the list
+    private int[] GetReceiverIdsChunk(int index)
+    {
+        int chunkIdx = index / _receiverIdsChunkLength;
+        if (_receiverIdsChunks[chunkIdx] == null)
+        {
+            int arrayId = (int)Interlocked.Read(ref _receiverIdsHeader[_receiverIdsFirstChunkPos + chunkIdx]);
+            _receiverIdsChunks[chunkIdx] = UnityAdapter.Instance.GetSharedArray<int>(arrayId);
+        }
+
+        return _receiverIdsChunks[chunkIdx];
+    }
+
+    //Head of the free list pointing to the slot at index, with the tag of the previous head incremented (as done on C++)
+    private static long NewReceiverIdsListHead(long previousHead, int index)
+    {
+        return (long)(((((ulong)previousHead >> 32) + 1) << 32) | (uint)index);
+    }
+
+    //Delivers a batch message sent by UnityMessager::SendBatchMessage on C++, msg is the UMM_BATCH_MESSAGE after reading its msgId 
+    //and receiver ids. Its remaining parameters are the columns, which are read once and then delivered as a message per receiver.
+    private void DeliverBatchMessage(int msgId, ArrayParam<int> receiverIds, ref Message msg)
+    {
+        _batchColumns.Clear();
+        while (msg.NumberOfParamsToBeRead > 0)
+        {
+            Assert.IsTrue(msg.IsNextParamAnArray && !msg.CanNextParamBeReadAsString);
+            _batchColumns.Add(msg.ReadNextParamAndAdvance() as Array);
+        }
+
+        for (int i = 0; i < receiverIds.Length; ++i)
+        {
+            Message.FillUnityMessagerInternalBatchMessageInstance(this, receiverIds[i], msgId, _batchColumns.Count, i);
+
+            IMessageReceiver receiver = GetReceiver(receiverIds[i]);
+            if (receiver != null)
+                receiver.ReceiveMessage(ref _internalMessageInstance);
+            else
+                Debug.LogError("[UnityMessager] Batch message sent to an invalid receiver object!!");
+        }
+
+        _batchColumns.Clear();
+    }
+
+    private Type GetBatchColumnType(int columnIdx)
+    {
+        return columnIdx < _batchColumns.Count ? _batchColumns[columnIdx].GetType().GetElementType() : null;
+    }
+
+    //helper method to get a message based on reflection delivered with the message parameters extracted
+    private void DeliverMessageWithReflection(object component, ref Message message)
+    {
+        int methodNameLength = -message.MessageId; //messageId, when negative, is the length of the method name string
+        string methodName = ReadName(methodNameLength);
+
+        MethodInfo methodInfo = component.GetType().GetMethod(methodName);
+        DeliverMessageWithReflection(component, methodInfo, methodInfo.GetParameters(), ref message);
+    }
+
+    private void DeliverMessageWithReflection(object component, MethodInfo methodInfo, ParameterInfo[] paramInfos, ref Message message)
+    {
+        Assert.IsTrue(message.NumberOfParams == paramInfos.Length);
+        object[] parameters = null;
+
+        if (paramInfos.Length > 0) //is there any parameter to read
+        {
+            parameters = new object[paramInfos.Length];
+            int i = -1;
+            while (message.NumberOfParamsToBeRead > 0)
+                parameters[++i] = paramInfos[i].ParameterType == typeof(string) ? //read a string as a string, so we don't get a byte array
+                                  message.ReadNextParamAsStringAndAdvance()
+                                  : message.ReadNextParamAndAdvance();
+        }
+
+        methodInfo.Invoke(component, parameters);
+    }
+
+    //Control messages are specific to setup or control the message delivering process itself  
+    private void HandleControlMessage(int messageId, ArrayParam<int> arrayParam)
+    {
+        switch (messageId)
+        {
+            case 0: //UMM_SET_QUEUE_ARRAY = 0, used when the current array in use is close to its end, so a new one is needed
+                {   
+                    Assert.IsTrue(arrayParam.Length == 2);
+
+                    int queueId = arrayParam[0];
+                    int arrayId = arrayParam[1];
+
+                    _messageQueues[queueId].SetCurrentArray(arrayId);
+                    break;
                 }
             case 1: //UMM_SET_QUEUE_FIRST_ARRAY = 1, first array of a given queue, we keep this info forever so we can reset queues
                 {
-                    Assert.IsTrue(arrayParam.Length == 2);
+                    Assert.IsTrue(arrayParam.Length == 2 || arrayParam.Length == 3);
 
                     int queueId = arrayParam[0];
                     int arrayId = arrayParam[1];
                     
-                    _messageQueues[queueId].SetFirstArray(arrayId);
+                    //there is no maximum number of queues, the queues are known as they are registered by this message
+                    if (queueId >= _messageQueues.Length)
+                        GrowMessageQueues(queueId + 1);
+
+                    //the control queue first array comes from UM_InitUnityMessagerAndGetControlQueueId and is being read right now
+                    if (queueId != _controlQueueId)
+                        _messageQueues[queueId].SetFirstArray(arrayId);
+
+                    if (arrayParam.Length == 3) //double buffered, so we also get the first array of the other set of arrays
+                        _messageQueues[queueId].SetSecondFirstArray(arrayParam[2]);
                     break;
                 }
-            case 2: //UMM_SET_RECEIVER_IDS_ARRAY = 2, sets the id for the control array of available receiver ids
+            case 2: //UMM_SET_RECEIVER_IDS_ARRAY = 2, sets the id for the header of the receiver ids table
                 {
                     Assert.IsTrue(arrayParam.Length == 1);
 
                     int arrayId = arrayParam[0];
 
-                    _receiverIdsSharedArray = UnityAdapter.Instance.GetSharedArray<int>(arrayId);
+                    _receiverIdsHeader = UnityAdapter.Instance.GetSharedArray<long>(arrayId);
+                    _receiverIdsChunks = new int[_receiverIdsHeader.Length - _receiverIdsFirstChunkPos][];
+                    break;
+                }
+            case 6: //UMM_REGISTER_PAYLOAD_TYPE = 6, a new type used by parameters on the payload queue
+                {
+                    Assert.IsTrue(arrayParam.Length >= 3);
+
+                    RegisterPayloadType(arrayParam[0], arrayParam[1], arrayParam[2], arrayParam, 3);
+                    break;
+                }
+            case 8: //UMM_REGISTER_INTERNED_STRING = 8, a new interned string, or a chunk of it
+                {
+                    Assert.IsTrue(arrayParam.Length >= 3);
+
+                    RegisterInternedStringChunk(arrayParam[0], arrayParam[1], arrayParam[2], arrayParam, 3);
+                    break;
+                }
+            case 9: //UMM_SET_INTERNED_STRING_QUEUE = 9, queue (or payload type) id of the interned string parameters
+                {
+                    Assert.IsTrue(arrayParam.Length == 1);
+
+                    _internedStringQueueId = arrayParam[0];
+                    break;
+                }
+            case 10: //UMM_SET_QUEUE_SPILL_ARRAY = 10, the next parameter of the queue is too big for its arrays, so it has its own
+                {
+                    Assert.IsTrue(arrayParam.Length == 2);
+
+                    int queueId = arrayParam[0];
+                    int arrayId = arrayParam[1];
+
+                    _messageQueues[queueId].SetSingleParamArray(arrayId, 0);
+                    break;
+                }
+            case 11: //UMM_SET_QUEUE_UNITY_ARRAY = 11, the next parameter of the queue references an UnityArray instead of being copied
+                {
+                    Assert.IsTrue(arrayParam.Length == 3);
+
+                    int queueId = arrayParam[0];
+                    int arrayId = arrayParam[1];
+                    int pos = arrayParam[2]; //in bytes for the payload queue
+
+                    _messageQueues[queueId].SetSingleParamArray(arrayId, pos);
+                    break;
+                }
+            case 13: //UMM_SET_STATISTICS_ARRAY = 13, sets the id for the array where the statistics are published
+                {
+                    Assert.IsTrue(arrayParam.Length == 1);
+
+                    _statistics = UnityAdapter.Instance.GetSharedArray<long>(arrayParam[0]);
                     break;
                 }
             default:
@@ -625,22 +1524,40 @@ public class UnityMessager : MonoBehaviour
     //Internal message receiver class, to handle messages addressed to UnityMessager itself, not being control messages
     private class MessageReceiver : IMessageReceiver
     {
+        public MessageReceiver(UnityMessager unityMessager)
+        {
+            _unityMessager = unityMessager;
+        }
+
         public void ReceiveMessage(ref UnityMessager.Message msg)
         {
             switch (msg.MessageId)
             {
                 case 3: //UMM_FINISH_DELIVERING_MESSAGES = 3, Send to mark the last message to be delivered (THIS ONE). 
-                    UnityMessager.Instance._controlQueue.OnFinishDeliveringMessages();
+                    _unityMessager._controlQueue.OnFinishDeliveringMessages();
                     break;
                 case 4: //UMM_REGISTER_NEW_COMPONENT = 4
-                    UnityMessager.Instance.RegisterComponentType(msg.ReadNextParamAndAdvance<int>(), 
+                    _unityMessager.RegisterComponentType(msg.ReadNextParamAndAdvance<int>(), 
                                                                  msg.ReadNextParamAsStringAndAdvance());
                     break;
+                case 5: //UMM_DISCARDED_MESSAGE = 5, a coalesced message replaced by a newer one, its parameters are just skipped
+                    break;
+                case 7: //UMM_REGISTER_ROUTING_BINDING = 7
+                    _unityMessager.RegisterRoutingBinding(msg.ReadNextParamAndAdvance<int>(), msg.ReadNextParamAndAdvance<int>(),
+                                                                  msg.ReadNextParamAsStringAndAdvance(),
+                                                                  msg.ReadNextParamAsStringAndAdvance());
+                    break;
+                case 12: //UMM_BATCH_MESSAGE = 12
+                    _unityMessager.DeliverBatchMessage(msg.ReadNextParamAndAdvance<int>(), 
+                                                               msg.ReadNextParamAsArrayAndAdvance<int>(), ref msg);
+                    break;
                 default:
                     Debug.LogError("[UnityMessager] Unknow message id received by UnityMessager.ReceiveMessage!");
                     break;
             }
         }
+
+        private UnityMessager _unityMessager; //instance the messages are addressed to
     }
 
     private struct ParamInfo
@@ -681,8 +1598,11 @@ public class UnityMessager : MonoBehaviour
             QueueType = instanceToCopy.QueueType;
 
             _firstArrayBase = instanceToCopy._firstArrayBase;
+            _secondFirstArrayBase = instanceToCopy._secondFirstArrayBase;
             _currentArrayBase = instanceToCopy._currentArrayBase;
             _currentArrayPos = instanceToCopy._currentArrayPos;
+            _arrayBaseBeforeSingleParam = instanceToCopy._arrayBaseBeforeSingleParam;
+            _arrayPosBeforeSingleParam = instanceToCopy._arrayPosBeforeSingleParam;
         }
 
         //Sets the id of the first array for this queue. Having this info we can reset the queue to its first id after delivering all the messages
@@ -693,6 +1613,12 @@ public class UnityMessager : MonoBehaviour
             QueueType = _firstArrayBase.GetType().GetElementType();
         }
 
+        //Sets the id of the first array of the other set of arrays, only used when the queues are double buffered
+        public void SetSecondFirstArray(int arrayId)
+        {
+            _secondFirstArrayBase = UnityAdapter.Instance.GetSharedArray(arrayId);
+        }
+
         //Just updates the current array id on this base class method. Derived classes should update their array references also.
         public virtual void SetCurrentArray(int arrayId) 
         {
@@ -700,11 +1626,42 @@ public class UnityMessager : MonoBehaviour
             _currentArrayPos = 0;
         }
 
+        //The next parameter of this queue is on another array starting at pos: a spill array, for parameters bigger than the queue 
+        //arrays, or an UnityArray referenced by the parameter. The current array and position are kept, so EndSingleParamArrayIfAny
+        //can return to them once this parameter is read.
+        public virtual void SetSingleParamArray(int arrayId, int pos)
+        {
+            Assert.IsTrue(_arrayBaseBeforeSingleParam == null); //these arrays hold a single parameter
+            _arrayBaseBeforeSingleParam = _currentArrayBase;
+            _arrayPosBeforeSingleParam = _currentArrayPos;
+            _currentArrayBase = UnityAdapter.Instance.GetSharedArray(arrayId);
+            _currentArrayPos = pos;
+        }
+
+        //Returns to the usual array of the queue if the last parameter read was on a single parameter array
+        public virtual void EndSingleParamArrayIfAny()
+        {
+            if (_arrayBaseBeforeSingleParam == null)
+                return;
+
+            _currentArrayBase = _arrayBaseBeforeSingleParam;
+            _currentArrayPos = _arrayPosBeforeSingleParam;
+            _arrayBaseBeforeSingleParam = null;
+        }
+
         //Resets the Message queue so it starts from its beginning at the next Message delivering process
         public virtual void Reset()
         {
+            if (_secondFirstArrayBase != null) //double buffered, the C++ side is writing to the other set since the delivering started
+            {
+                Array firstArrayBase = _firstArrayBase;
+                _firstArrayBase = _secondFirstArrayBase;
+                _secondFirstArrayBase = firstArrayBase;
+            }
+
             _currentArrayBase = _firstArrayBase;
             _currentArrayPos = 0;
+            _arrayBaseBeforeSingleParam = null;
         }
 
         //Advance the desired number of items on this queue without actually reading the held values.
@@ -732,7 +1689,10 @@ public class UnityMessager : MonoBehaviour
 
         protected int _currentArrayPos = 0;
         protected Array _firstArrayBase = null;
+        protected Array _secondFirstArrayBase = null; //null when not double buffered
         protected Array _currentArrayBase = null;
+        protected Array _arrayBaseBeforeSingleParam = null; //null when not reading from a single parameter array
+        protected int _arrayPosBeforeSingleParam = 0;
     }
 
     private abstract class MessageQueue<T>: MessageQueueBase
@@ -759,10 +1719,25 @@ public class UnityMessager : MonoBehaviour
             _currentArray = _currentArrayBase as T[];
         }
 
+        //complements the base class version by actually updating the current array reference 
+        public override void SetSingleParamArray(int arrayId, int pos)
+        {
+            base.SetSingleParamArray(arrayId, pos);
+            _currentArray = _currentArrayBase as T[];
+        }
+
+        //complements the base class version by actually updating the current array reference 
+        public override void EndSingleParamArrayIfAny()
+        {
+            base.EndSingleParamArrayIfAny();
+            _currentArray = _currentArrayBase as T[];
+        }
+
         //complements the base class version by actually updating the current array reference 
         public override void Reset()
         {
             base.Reset();
+            _firstArray = _firstArrayBase as T[]; //it may be swapped when double buffered
             _currentArray = _firstArray;
         }
 
@@ -772,9 +1747,20 @@ public class UnityMessager : MonoBehaviour
 
     private class ControlQueue: MessageQueue<int>
     {
-        public ControlQueue(int firstArrayid): base(UnityMessager._controlQueueId, firstArrayid) 
+        public ControlQueue(UnityMessager unityMessager, int firstArrayid, bool isCompact)
+            : base(UnityMessager._controlQueueId, firstArrayid) 
         {
+            _unityMessager = unityMessager;
             CurrentParamInfo = new ParamInfo(-1, 0);
+            _isCompact = isCompact;
+            Assert.IsTrue(!isCompact || BitConverter.IsLittleEndian); //the compact format is read from the int arrays as little endian
+        }
+
+        //complements the base class version, since compact messages to the same receiver of a previous one are sent without receiver id
+        public override void Reset()
+        {
+            base.Reset();
+            _lastReceiverId = 0;
         }
 
         public bool HasMessagesToBeDelivered { get { return _firstArray[0] != _emptyCode; } }
@@ -789,6 +1775,12 @@ public class UnityMessager : MonoBehaviour
             Assert.IsTrue(NumberOfParamsBeforeNextMessage == 0);
             DeliverControlMessagesIfAny(); //very important since queue arrays may be changed by these messages
 
+            if (_isCompact)
+            {
+                ReadNextCompactMessageToUnityMessagerInternalInstance();
+                return;
+            }
+
             int receiverId = _currentArray[_currentArrayPos + 0];
             int messageId = _currentArray[_currentArrayPos + 1];
             NumberOfParamsBeforeNextMessage = _currentArray[_currentArrayPos + 2];
@@ -806,14 +1798,30 @@ public class UnityMessager : MonoBehaviour
 
             ReadCurrentParam();
 
-
-            Message.FillUnityMessagerInternalMessageInstance(receiverId, componentId, messageId,
-                                                              NumberOfParamsBeforeNextMessage);
+            componentId = ResolveRoutingBinding(componentId);
+            Message.FillUnityMessagerInternalMessageInstance(_unityMessager, receiverId, componentId, messageId,
+                                                             NumberOfParamsBeforeNextMessage);
         }
 
         //The current parameter info is actually considered to be the "next parameter info" by the Message struct
         public ParamInfo CurrentParamInfo { get; private set; }
 
+        //Routing binding of the current message, null if it was not addressed through one
+        public RoutingBinding CurrentRoutingBinding { get; private set; }
+
+        //Component ids smaller than -1 are routing bindings, which are replaced by the component id of the binding
+        private int ResolveRoutingBinding(int componentId)
+        {
+            if (componentId > _firstRoutingBindingSlot)
+            {
+                CurrentRoutingBinding = null;
+                return componentId;
+            }
+
+            CurrentRoutingBinding = _unityMessager._routingBindings[_firstRoutingBindingSlot - componentId];
+            return CurrentRoutingBinding.ComponentId;
+        }
+
         public void AdvanceToNextParam()
         {
             --NumberOfParamsBeforeNextMessage;
@@ -833,6 +1841,13 @@ public class UnityMessager : MonoBehaviour
             }
 
             DeliverControlMessagesIfAny(); //very important since queue arrays may be changed by these messages
+
+            if (_isCompact)
+            {   //queue id shifted left, having the lowest bit set for array parameters, which have their length right after it
+                int queueIdAndIsArray = ReadVarint();
+                CurrentParamInfo = new ParamInfo(queueIdAndIsArray >> 1, (queueIdAndIsArray & 1) != 0 ? ReadVarint() : -1);
+                return;
+            }
             
             Assert.IsTrue(_currentArray[_currentArrayPos] != 0);
 
@@ -852,6 +1867,12 @@ public class UnityMessager : MonoBehaviour
         //more than one control message may come in sequence before the next non control message or the next parameter
         private void DeliverControlMessagesIfAny()
         {
+            if (_isCompact)
+            {
+                DeliverCompactControlMessagesIfAny();
+                return;
+            }
+
             //Control messages are marked by having 0 as receiverId (UnityMessager itself as receiver) and by
             //having the number of parameters set as negative.
             while (_currentArray[_currentArrayPos] == 0 && _currentArray[_currentArrayPos + 2] < 0)
@@ -863,25 +1884,109 @@ public class UnityMessager : MonoBehaviour
                 _currentArrayPos += (3 + nOfParams);
 
                 //only integer parameters are supported on control messages, all passed directly on the control queue
-                UnityMessager.Instance.HandleControlMessage(msgId, new ArrayParam<int>(_currentArray, firstIdx, nOfParams));                                                 
+                _unityMessager.HandleControlMessage(msgId, new ArrayParam<int>(_currentArray, firstIdx, nOfParams));                                                 
+            }
+        }
+
+        //Compact version of ReadNextMessageToUnityMessagerInternalInstance, check UnityMessagerCompact.h for the format details
+        private void ReadNextCompactMessageToUnityMessagerInternalInstance()
+        {
+            int tag = ReadByte();
+            Assert.IsTrue((tag & _compactTagMessage) != 0);
+
+            if ((tag & _compactTagSameReceiver) == 0)
+                _lastReceiverId = ReadZigZag();
+
+            int receiverId = _lastReceiverId;
+            int messageId = ReadZigZag();
+            int componentId = (tag & _compactTagComponent) != 0 ? ReadZigZag() : -1;
+            NumberOfParamsBeforeNextMessage = ReadByte();
+
+            if ((tag & _compactTagDiscarded) != 0)
+            {   //a coalesced message replaced by a newer one, same thing the C++ side does on the not compact format
+                receiverId = 0;
+                messageId = _discardedMessageId;
+                componentId = -1;
+            }
+
+            ReadCurrentParam();
+
+            componentId = ResolveRoutingBinding(componentId);
+            Message.FillUnityMessagerInternalMessageInstance(_unityMessager, receiverId, componentId, messageId,
+                                                             NumberOfParamsBeforeNextMessage);
+        }
+
+        //Compact version of DeliverControlMessagesIfAny, control messages start with a 0 byte, which is never the first byte
+        //of a message or parameter
+        private void DeliverCompactControlMessagesIfAny()
+        {
+            while (PeekByte() == _compactControlMessageTag)
+            {
+                ++_currentArrayPos;
+                int msgId = ReadVarint();
+                int nOfParams = ReadVarint();
+                Assert.IsTrue(nOfParams <= _compactControlParams.Length);
+
+                for (int i = 0; i < nOfParams; ++i)
+                    _compactControlParams[i] = ReadVarint();
+
+                _unityMessager.HandleControlMessage(msgId, new ArrayParam<int>(_compactControlParams, 0, nOfParams));
             }
         }
+
+        //On the compact format _currentArrayPos is the position in bytes of the current int array, read as little endian 
+        private int PeekByte()
+        {
+            return (_currentArray[_currentArrayPos >> 2] >> ((_currentArrayPos & 3) << 3)) & 0xFF;
+        }
+
+        private int ReadByte()
+        {
+            int value = PeekByte();
+            ++_currentArrayPos;
+            return value;
+        }
+
+        private int ReadVarint()
+        {
+            int value = 0;
+            for (int shift = 0; ; shift += 7)
+            {
+                int b = ReadByte();
+                value |= (b & 0x7F) << shift;
+                if ((b & 0x80) == 0)
+                    return value;
+            }
+        }
+
+        private int ReadZigZag()
+        {
+            int value = ReadVarint();
+            return (int)((uint)value >> 1) ^ -(value & 1);
+        }
+
+        private UnityMessager _unityMessager; //instance owning the queue, which handles its control messages
+        private bool _isCompact = false;
+        private int _lastReceiverId = 0; //receiver id of the last message on the compact format, check _compactTagSameReceiver
+        private int[] _compactControlParams = new int[_maxNOfControlMessageParams]; //values of the control message being delivered on the compact format
+
         //code to mark all the messages were delivered, UM_EMPTY_CONTROL_QUEUE_CODE is the corresponding constant at C++
         private const int _emptyCode = -123456;
+
+        //constants for the compact format corresponding to the UM_COMPACT_* ones on C++
+        private const int _compactControlMessageTag = 0;
+        private const int _compactTagMessage = 1;
+        private const int _compactTagSameReceiver = 2;
+        private const int _compactTagComponent = 4;
+        private const int _compactTagDiscarded = 8;
+        private const int _discardedMessageId = 5; //UMM_DISCARDED_MESSAGE
     }
 
 	private class ParamQueue<T> : MessageQueue<T>
 	{
-        //Singleton access point.
-        public static ParamQueue<T> Instance { get; private set; }
-
-        //Creates the singleton instance based on the base instance, which exists only for holding first and current id
-        //values and also the current position while real ParamQueue was not instanced by the generic parameter reader methods. 
-        public static void CreateInstance(MessageQueueBase baseInst)
-        {
-            Assert.IsTrue(Instance == null, "[UnityMessager] More than one ParamQueue instance being created for a same type!");
-            Instance = new ParamQueue<T>(baseInst);
-        }
+        //Created based on the base instance, which exists only for holding first and current id values and also the current 
+        //position while real ParamQueue was not instanced by the generic parameter reader methods, check GetParamQueue. 
+        public ParamQueue(MessageQueueBase baseInst) : base(baseInst) {}
 
         //Read the next value on the queue as a single param value
         public T ReadNext()
@@ -902,8 +2007,353 @@ public class UnityMessager : MonoBehaviour
             _currentArrayPos += length;
             return System.Text.ASCIIEncoding.ASCII.GetString(_currentArray as byte[], _currentArrayPos - length, length);           
         }
+    }
+
+    //Names given by C++ for a (component, objectName, methodName) tuple, which get resolved only once. The GameObject is found again
+    //only after being destroyed, and the method info is kept while the component type is the same.
+    private class RoutingBinding
+    {
+        public int ComponentId { get; private set; }
+        public string ObjectName { get; private set; } //null if the receiver is given by its receiver id
+        public string MethodName { get; private set; } //null if the message is delivered to an IMessageReceiver component
+        public ParameterInfo[] ParamInfos { get; private set; } //parameters of the last method returned by GetMethod
+
+        public RoutingBinding(int componentId, string objectName, string methodName)
+        {
+            ComponentId = componentId;
+            ObjectName = objectName;
+            MethodName = methodName;
+        }
+
+        public GameObject FindGameObject()
+        {
+            if (_gameObject == null) //also true for destroyed objects
+                _gameObject = GameObject.Find(ObjectName);
 
-        private ParamQueue(MessageQueueBase baseInst) : base(baseInst) {}
+            return _gameObject;
+        }
+
+        public Component GetComponent(GameObject gameObject, Type componentType)
+        {
+            if (_component == null || _componentGameObject != gameObject)
+            {
+                _component = gameObject.GetComponent(componentType);
+                _componentGameObject = gameObject;
+            }
+
+            return _component;
+        }
+
+        public MethodInfo GetMethod(Type type)
+        {
+            if (_methodOwnerType != type)
+            {
+                _methodInfo = type.GetMethod(MethodName);
+                ParamInfos = _methodInfo.GetParameters();
+                _methodOwnerType = type;
+            }
+
+            return _methodInfo;
+        }
+
+        private GameObject _gameObject = null;
+        private GameObject _componentGameObject = null;
+        private Component _component = null;
+        private Type _methodOwnerType = null;
+        private MethodInfo _methodInfo = null;
+    }
+
+    //Value pushed by C++ for an interned string parameter, corresponds to UnityMessager::InternedStringRef on C++
+    private struct InternedStringRef
+    {
+        public int Id;
+    }
+
+    //Type of parameters on the payload queue, registered by the C++ side on its first usage
+    private class PayloadType
+    {
+        public Type Type { get; private set; }
+        public int Alignment { get; private set; }
+        public int Size { get; private set; }
+
+        //Primitive types are copied from the payload bytes by Buffer.BlockCopy, while structs are marshaled
+        public bool IsPrimitive { get; private set; }
+
+        //Array of length 1 where single primitive values are copied to, so reading them doesn't allocate
+        public Array Scratch { get; private set; }
+
+        public PayloadType(Type type, int alignment)
+        {
+            Type = type;
+            Alignment = alignment;
+            Size = Marshal.SizeOf(type);
+            IsPrimitive = type.IsPrimitive;
+            Scratch = Array.CreateInstance(type, 1);
+        }
+    }
+
+    //Byte queue holding all the parameters of each message together, each parameter aligned to the alignment of its type relative
+    //to the start of the current array, the same way it is done by UnityMessager::PayloadQueue on C++
+    private class PayloadQueue : MessageQueue<Byte>
+    {
+        public PayloadQueue(MessageQueueBase baseInst) : base(baseInst) {}
+
+        public T ReadNext<T>(PayloadType type)
+        {
+            Align(type.Alignment);
+            T[] scratch = type.Scratch as T[];
+            if (type.IsPrimitive)
+                Buffer.BlockCopy(_currentArrayBase, _currentArrayPos, scratch, 0, type.Size);
+            else
+                scratch[0] = (T)Marshal.PtrToStructure(GetCurrentPtr(0), type.Type);
+
+            _currentArrayPos += type.Size;
+            return scratch[0];
+        }
+
+        //Differently from ParamQueue.ReadNextAsArray, the items are copied to a new array
+        public ArrayParam<T> ReadNextAsArray<T>(PayloadType type, int length)
+        {
+            return new ArrayParam<T>(ReadNextAsArrayBase(type, length) as T[], 0, length);
+        }
+
+        public Array ReadNextAsArrayBase(PayloadType type, int length)
+        {
+            Align(type.Alignment);
+            Array array = Array.CreateInstance(type.Type, length);
+            if (type.IsPrimitive)
+                Buffer.BlockCopy(_currentArrayBase, _currentArrayPos, array, 0, length * type.Size);
+            else
+            {
+                for (int i = 0; i < length; ++i)
+                    array.SetValue(Marshal.PtrToStructure(GetCurrentPtr(i * type.Size), type.Type), i);
+            }
+
+            _currentArrayPos += length * type.Size;
+            return array;
+        }
+
+        public object ReadNextAsObject(PayloadType type)
+        {
+            Align(type.Alignment);
+            object value;
+            if (type.IsPrimitive)
+            {
+                Buffer.BlockCopy(_currentArrayBase, _currentArrayPos, type.Scratch, 0, type.Size);
+                value = type.Scratch.GetValue(0);
+            }
+            else
+                value = Marshal.PtrToStructure(GetCurrentPtr(0), type.Type);
+
+            _currentArrayPos += type.Size;
+            return value;
+        }
+
+        //strings (and names) are Byte arrays, so they have no alignment
+        public string ReadNextAsString(int length)
+        {
+            _currentArrayPos += length;
+            return System.Text.ASCIIEncoding.ASCII.GetString(_currentArray, _currentArrayPos - length, length);
+        }
+
+        public void Skip(PayloadType type, int nOfItems)
+        {
+            Align(type.Alignment);
+            _currentArrayPos += nOfItems * type.Size;
+        }
+
+        private void Align(int alignment)
+        {
+            _currentArrayPos = (_currentArrayPos + alignment - 1) & ~(alignment - 1);
+        }
+
+        //The values are read from _currentArrayBase by byte positions, since a referenced UnityArray (check SetSingleParamArray)
+        //is not a Byte array. The shared arrays are pinned by the UnityAdapter.
+        private IntPtr GetCurrentPtr(int offsetInBytes)
+        {
+            IntPtr arrayPtr = Marshal.UnsafeAddrOfPinnedArrayElement(_currentArrayBase, 0);
+            return new IntPtr(arrayPtr.ToInt64() + _currentArrayPos + offsetInBytes);
+        }
+    }
+
+    //Writes the messages sent to C++ to the inbox arrays of the C++ UnityMessagerInbox of the channel, on the format described at 
+    //UnityMessagerInbox.h. Each message is written to a single array, so when it doesn't fit the current array it is moved to the
+    //next one, given by the C++ side. The parameter types are registered by their first parameter, being described by PayloadType.
+    private class InboxWriter
+    {
+        public InboxWriter(int channel)
+        {
+            _channel = channel;
+            _types = new List<PayloadType>() { new PayloadType(typeof(Byte), 1) }; //_byteTypeId
+            _typeIds = new Dictionary<Type, int>() { { typeof(Byte), _byteTypeId } };
+        }
+
+        public void StartMessage(int receiverId, int msgId)
+        {
+            Assert.IsTrue(_recordStart < 0, "[UnityMessager] Message to C++ started before ending the previous one!");
+
+            if (_firstArray == null) //the C++ inbox is created by the first message
+                _firstArray = UnityAdapter.Instance.GetSharedArray<Byte>(UnityMessagerDLL.UM_GetInboxFirstArrayId(_channel));
+
+            //once the C++ side drains the messages they are written from the first array again
+            int drainSerial = ReadInt(_firstArray, _drainSerialPos);
+            if (_currentArray == null || drainSerial != _drainSerial)
+            {
+                _drainSerial = drainSerial;
+                _currentArray = _firstArray;
+                _pos = _arrayHeaderSize;
+            }
+
+            _recordStart = _pos;
+            Reserve(_recordHeaderSize);
+            WriteInt(_recordStart + 4, receiverId);
+            WriteInt(_recordStart + 8, msgId);
+            _pos = _recordStart + _recordHeaderSize;
+            _nOfParams = 0;
+        }
+
+        public void PushParam<T>(T value)
+        {
+            PayloadType type;
+            int dataPos = WriteParamHeader(typeof(T), -1, out type);
+            if (type.IsPrimitive)
+            {
+                T[] scratch = type.Scratch as T[];
+                scratch[0] = value;
+                Buffer.BlockCopy(scratch, 0, _currentArray, dataPos, type.Size);
+            }
+            else
+                Marshal.StructureToPtr(value, Marshal.UnsafeAddrOfPinnedArrayElement(_currentArray, dataPos), false);
+        }
+
+        public void PushArrayParam<T>(T[] array, int startIdx, int length)
+        {
+            PayloadType type;
+            int dataPos = WriteParamHeader(typeof(T), length, out type);
+            if (type.IsPrimitive)
+                Buffer.BlockCopy(array, startIdx * type.Size, _currentArray, dataPos, length * type.Size);
+            else
+            {
+                for (int i = 0; i < length; ++i)
+                    Marshal.StructureToPtr(array[startIdx + i], 
+                                           Marshal.UnsafeAddrOfPinnedArrayElement(_currentArray, dataPos + i * type.Size), false);
+            }
+        }
+
+        public void PushString(string str)
+        {
+            PayloadType type;
+            int dataPos = WriteParamHeader(typeof(Byte), str.Length, out type);
+            System.Text.Encoding.ASCII.GetBytes(str, 0, str.Length, _currentArray, dataPos);
+        }
+
+        public void EndMessage()
+        {
+            Assert.IsTrue(_recordStart >= 0, "[UnityMessager] Message to C++ ended without being started!");
+
+            //the arrays have a multiple of _recordAlignment bytes, so the padding always fits
+            int endPos = Align(_pos, _recordAlignment);
+            WriteInt(_recordStart, endPos - _recordStart);
+            WriteInt(_recordStart + 12, _nOfParams);
+            WriteInt(_endPosPos, endPos); //only now the C++ side sees the message
+
+            _pos = endPos;
+            _recordStart = -1;
+        }
+
+        //Writes the parameter header, registering the type on its first usage, returns the position where its items MUST BE written
+        private int WriteParamHeader(Type paramType, int length, out PayloadType type)
+        {
+            Assert.IsTrue(_recordStart >= 0, "[UnityMessager] Parameter pushed without starting a message to C++!");
+
+            int typeId;
+            bool isNewType = !_typeIds.TryGetValue(paramType, out typeId);
+            if (isNewType)
+            {
+                typeId = _types.Count;
+                int size = Marshal.SizeOf(paramType);
+                _types.Add(new PayloadType(paramType, Math.Min(size & -size, _recordAlignment))); //as GetItemAlignment on C++
+                _typeIds.Add(paramType, typeId);
+            }
+
+            type = _types[typeId];
+            string typeName = isNewType ? paramType.FullName : null;
+            int dataSize = type.Size * (length >= 0 ? length : 1);
+            Reserve(_paramHeaderSize + (isNewType ? 8 + Align(typeName.Length, 4) : 0) + type.Alignment - 1 + dataSize);
+
+            WriteInt(_pos, isNewType ? typeId | _newTypeFlag : typeId);
+            WriteInt(_pos + 4, length);
+            _pos += _paramHeaderSize;
+
+            if (isNewType)
+            {
+                WriteInt(_pos, type.Size);
+                WriteInt(_pos + 4, typeName.Length);
+                System.Text.Encoding.ASCII.GetBytes(typeName, 0, typeName.Length, _currentArray, _pos + 8);
+                _pos = Align(_pos + 8 + typeName.Length, 4);
+            }
+
+            int dataPos = Align(_pos, type.Alignment);
+            _pos = dataPos + dataSize;
+            ++_nOfParams;
+            return dataPos;
+        }
+
+        //Makes sure the current array has nOfBytes free bytes, otherwise moves the message being written to the next array
+        private void Reserve(int nOfBytes)
+        {
+            if (_pos + nOfBytes <= _currentArray.Length)
+                return;
+
+            //the records start aligned to _recordAlignment on any array, so the parameter items keep their alignment
+            int writtenLength = _pos - _recordStart;
+            int arrayId = UnityMessagerDLL.UM_AdvanceInboxToNextArray(_channel, _arrayHeaderSize + writtenLength + nOfBytes);
+            Byte[] nextArray = UnityAdapter.Instance.GetSharedArray<Byte>(arrayId);
+            Buffer.BlockCopy(_currentArray, _recordStart, nextArray, _arrayHeaderSize, writtenLength);
+
+            _currentArray = nextArray;
+            _recordStart = _arrayHeaderSize;
+            _pos = _recordStart + writtenLength;
+        }
+
+        private void WriteInt(int pos, int value)
+        {
+            _currentArray[pos] = (Byte)value;
+            _currentArray[pos + 1] = (Byte)(value >> 8);
+            _currentArray[pos + 2] = (Byte)(value >> 16);
+            _currentArray[pos + 3] = (Byte)(value >> 24);
+        }
+
+        private static int ReadInt(Byte[] array, int pos)
+        {
+            return array[pos] | (array[pos + 1] << 8) | (array[pos + 2] << 16) | (array[pos + 3] << 24);
+        }
+
+        private static int Align(int pos, int alignment)
+        {
+            return (pos + alignment - 1) & ~(alignment - 1);
+        }
+
+        private int _channel;
+        private Byte[] _firstArray = null;
+        private Byte[] _currentArray = null;
+        private int _pos = 0; //next byte to write on the current array
+        private int _recordStart = -1; //start of the message being written, -1 if none
+        private int _nOfParams = 0;
+        private int _drainSerial = 0;
+
+        //parameter types by their ids, and the ids by the types
+        private List<PayloadType> _types;
+        private Dictionary<Type, int> _typeIds;
+
+        private const int _endPosPos = 0; //position of endPos on the array header, only written to the current array
+        private const int _drainSerialPos = 4; //position of drainSerial on the array header, only read from the first array
+        private const int _arrayHeaderSize = 8; //corresponds to UMI_ARRAY_HEADER_SIZE on C++
+        private const int _recordHeaderSize = 16; //corresponds to UMI_RECORD_HEADER_SIZE on C++
+        private const int _recordAlignment = 8; //corresponds to UMI_RECORD_ALIGNMENT on C++
+        private const int _paramHeaderSize = 8; //corresponds to UMI_PARAM_HEADER_SIZE on C++
+        private const int _newTypeFlag = 0x40000000; //corresponds to UMI_NEW_TYPE_FLAG on C++
+        private const int _byteTypeId = 0; //corresponds to UMI_BYTE_TYPE_ID on C++
     }
 
 #if (UNITY_WEBGL || UNITY_IOS) && !(UNITY_EDITOR)
@@ -918,16 +2368,41 @@ public class UnityMessager : MonoBehaviour
     private class UnityMessagerDLL
     {
         [DllImport(DLL_NAME)]
-        public static extern int UM_InitUnityMessagerAndGetControlQueueId(int maxNOfReceiverIds, int maxQueueArraysSizeInBytes);
+        public static extern int UM_InitUnityMessagerAndGetControlQueueId(int channelId, int maxNOfReceiverIds, 
+                                                                          int maxQueueArraysSizeInBytes, int initFlags);
+
+        [DllImport(DLL_NAME)]
+        public static extern void UM_ReserveReceiverIds(int channelId, int nOfIds);
+
+        [DllImport(DLL_NAME)]
+        public static extern void UM_OnStartMessageDelivering(int channelId);
+
+        [DllImport(DLL_NAME)]
+        public static extern void UM_OnFinishMessageDelivering(int channelId);
+
+        [DllImport(DLL_NAME)]
+        public static extern int UM_HasStagedMessages(int channelId);
+
+        [DllImport(DLL_NAME)]
+        public static extern void UM_ReleasePossibleQueueArrays(int channelId);
+
+        [DllImport(DLL_NAME)]
+        public static extern int UM_StartCapture(int channelId, string traceFilePath);
+
+        [DllImport(DLL_NAME)]
+        public static extern void UM_StopCapture(int channelId);
+
+        [DllImport(DLL_NAME)]
+        public static extern int UM_GetInboxFirstArrayId(int channelId);
 
         [DllImport(DLL_NAME)]
-        public static extern void UM_OnStartMessageDelivering();
+        public static extern int UM_AdvanceInboxToNextArray(int channelId, int minLengthInBytes);
 
         [DllImport(DLL_NAME)]
-        public static extern void UM_ReleasePossibleQueueArrays();
+        public static extern int UM_GetRingArrayId(int channelId);
 
         [DllImport(DLL_NAME)]
-        public static extern void UM_OnDestroy();
+        public static extern void UM_OnDestroy(int channelId);
     }
 }
 }
@@ -10,6 +10,12 @@
 #define EXPORT_API // XCode does not need annotating exported functions, so define is empty
 #endif
 
+#if _MSC_VER //thread local storage for POD variables, "thread_local" is not available on Visual Studio 2013
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
 #ifndef WIN32 //have debug as default for when dropping cpp sources directly on Assets/Plugin folder for iOS and WebGL targets
 #define _DEBUG
 #endif
@@ -4,6 +4,7 @@
 #include "Test.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 #include <time.h>
 #include "UnityAdapter.h"
 
@@ -59,6 +60,10 @@ void UnityForCppTest::CreateInstance(int testReceiverId, int nOfGameObjects, flo
 
 UnityForCppTest::~UnityForCppTest()
 {
+	//the UnityMessager may be destroyed before the test case
+	if (UnityForCpp::UnityMessager::HasInstance(UM_DEFAULT_CHANNEL))
+		UNITY_MESSAGER.GetInbox().SetReceiver(m_receiverId, NULL);
+
 	//Release the positions shared array
 	m_gameObjectPositions.Release();
 	m_gameObjectVelocities.clear();
@@ -77,7 +82,10 @@ UnityForCppTest::UnityForCppTest(int testReceiverId, int nOfGameObjects, float r
 	m_gameObjectPositions.Alloc(nOfGameObjects);
 	m_gameObjectVelocities.resize(nOfGameObjects);
 
-	SetPositionsArray(m_gameObjectPositions.GetId());
+	SetPositionsArray(m_gameObjectPositions.GetId(), m_gameObjectPositions.GetDirtyBitmapId());
+
+	//the C# side sends its inbox messages to the same receiver id it has given to us
+	UNITY_MESSAGER.GetInbox().SetReceiver(m_receiverId, this);
 
 	//Set random positions and velocities to the game objects, also ordering their creation at the C# side. 
 	//We consider the position from -1f to 1f, being these mapped to the left most and right most screen coordinates
@@ -87,7 +95,7 @@ UnityForCppTest::UnityForCppTest(int testReceiverId, int nOfGameObjects, float r
 		int receiverId = i < NUMBER_OF_GAME_OBJECT_ADAPTER_USAGES ? UNITY_MESSAGER.NewReceiverId() : -1;
 
 		Vec2 randomPos = Vec2(RANDOM_NEG_POS_1, RANDOM_NEG_POS_1);
-		m_gameObjectPositions[i] = randomPos;
+		m_gameObjectPositions.Set(i, randomPos);
 		m_gameObjectVelocities[i] = Vec2(0.01f*RANDOM_NEG_POS_1, 0.01f*RANDOM_NEG_POS_1);
 
 		InstanceGameObject(i, receiverId);
@@ -106,6 +114,10 @@ UnityForCppTest::UnityForCppTest(int testReceiverId, int nOfGameObjects, float r
 
 void UnityForCppTest::Update(float deltaTime)
 {
+	//-------0. Reads the messages sent from the C# side since the last update (as the pointer events), all of them
+	//---------- by this single call, instead of calling a plugin function for each one of them.
+	UNITY_MESSAGER.GetInbox().DrainMessages();
+
 	//-------1. First part of the update code: update the position for each game object, no need to send messages
 	//----------since the positions array is a shared array accessed directly from the C# side. 
 
@@ -138,7 +150,8 @@ void UnityForCppTest::Update(float deltaTime)
 			|| Lambda::checkAndSolveWallCollision(newPos.y, 1.0f))
 			m_gameObjectVelocities[i].y = -m_gameObjectVelocities[i].y;
 
-		m_gameObjectPositions[i] = newPos; //updates the position on the shared array, so the C# code can get it from here
+		//updates the position on the shared array, also marking it as dirty, so the C# code only reads the changed positions
+		m_gameObjectPositions.Set(i, newPos);
 	}
 
 
@@ -198,10 +211,11 @@ void UnityForCppTest::Update(float deltaTime)
 			break;
 		case 4:
 		{
-			//Test a reflection based message on a component of an object find by "GameObject.Find"
+			//Test a reflection based message on a component of an object find by "GameObject.Find", the static route keeps
+			//its routing binding id, so the names are not even hashed after the first time
+			static const UnityForCpp::UnityMessager::NamedRoute c_route("UnityForCppTest", "TestReflectionBasedMessage");
 			int iArray[5] = { 1, 2, 5, 9, 2 };
-			UNITY_MESSAGER.SendMessage<UnityForCppTestComp>("UnityForCppTest", "TestReflectionBasedMessage",
-																7, 0.2f, UM_ARRAY_PARAM(iArray, 5), "String Value", 1.1);
+			UNITY_MESSAGER.SendMessage<UnityForCppTestComp>(c_route, 7, 0.2f, UM_ARRAY_PARAM(iArray, 5), "String Value", 1.1);
 			break;
 		}
 		case 5:
@@ -225,8 +239,19 @@ void UnityForCppTest::Update(float deltaTime)
 	}
 }
 
+//Completion of the asynchronous read of FileTest.txt, called from the UnityAdapter Update on the C# side
+static void OnFileTestReadAsync(int requestId, UnityArray<uint8>* pContent, void* pUserData)
+{
+	ASSERT(pContent);
+	DEBUG_LOG("FileTest.txt was read asynchronously, its content is:");
+	DEBUG_LOG((const char*)pContent->GetPtr());
+}
+
 void UnityForCppTest::TestFileRelatedFeatures()
 {
+	DEBUG_LOG("Requesting the FileTest.txt asynchronously from C++, it is logged once the read completes");
+	UnityAdapter::ReadFileContentAsync("FileTest.txt", OnFileTestReadAsync);
+
 	DEBUG_LOG("Requesting the FileTest.txt from C++");
 	UnityArray<uint8> fileContent;
 	UnityAdapter::ReadFileContentToUnityArray("FileTest.txt", &fileContent);
@@ -253,3 +278,25 @@ void UnityForCppTest::TestFileRelatedFeatures()
 	ASSERT(savedFileContent.GetPtr() == NULL);
 	DEBUG_LOG("We have successfully deleted the file FileSavingTest.txt!");
 }
+
+void UnityForCppTest::ReceiveMessage(const UnityForCpp::UnityMessagerInbox::Message& message)
+{
+	switch (message.GetMsgId())
+	{
+	case TIM_POINTER_DOWN:
+	{
+		Vec2 pointerPos = message.GetParam<Vec2>(0);
+		for (int i = 0; i < m_numberOfGameObjects; ++i)
+		{
+			Vec2 dir = m_gameObjectPositions[i] - pointerPos;
+			float length = sqrtf(dir.x*dir.x + dir.y*dir.y);
+			float speed = 0.01f / (length > 0.0f ? length : 1.0f);
+			m_gameObjectVelocities[i] = dir * speed;
+		}
+		break;
+	}
+	default:
+		ERROR_LOG("[UnityForCppTest] Unknow message id received by UnityForCppTest::ReceiveMessage!");
+		break;
+	}
+}
@@ -7,12 +7,14 @@
 #include "Shared.h"
 #include "UnityArray.h"
 #include "UnityMessager.h"
+#include "UnityMessagerInbox.h"
 #include <vector>
 
 using UnityForCpp::UnityArray;
+using UnityForCpp::TrackedUnityArray;
 using std::vector;
 
-class UnityForCppTest
+class UnityForCppTest : private UnityForCpp::UnityMessagerInbox::Receiver
 {
 public:
 	//Singleton access point
@@ -60,9 +62,9 @@ public:
 	}
 
 private:
-	inline void SetPositionsArray(int arrayId)
+	inline void SetPositionsArray(int arrayId, int dirtyBitmapId)
 	{
-		UNITY_MESSAGER.SendMessage(m_receiverId, TRM_SET_POSITIONS_ARRAY, arrayId);
+		UNITY_MESSAGER.SendMessage(m_receiverId, TRM_SET_POSITIONS_ARRAY, arrayId, dirtyBitmapId);
 	}
 
 	inline void InstanceGameObject(int gameObjectId, int receiverId = -1)
@@ -71,6 +73,15 @@ private:
 	}
 
 	//------------ END OF THE EXPOSED C# INTERFACE -------------------------
+
+	//Messages sent from the C# side through the UnityMessager inbox, they are drained at the start of Update
+	enum TestInboxMessages
+	{
+		TIM_POINTER_DOWN = 0 //(Vec2 pointerPos) => the game objects start moving away from the pointer position
+	};
+
+	virtual void ReceiveMessage(const UnityForCpp::UnityMessagerInbox::Message& message);
+
 public:
 	//Custom type to be tested when used with UnityArray. Observe it is composed by blittable types,
 	//has a corresponding declarion at the C# side and instanced as supported type using the macro
@@ -83,9 +94,9 @@ public:
 		Vec2(float _x, float _y) : x(_x), y(_y) {}
 		Vec2() : x(0.0f), y(0.0f) {}
 
-		Vec2 operator+(Vec2& v) { return Vec2(x + v.x, y + v.y); }
-		Vec2 operator-(Vec2& v) { return Vec2(x - v.x, y - v.y); }
-		Vec2 operator*(float& f) { return Vec2(x*f, y*f); }
+		Vec2 operator+(const Vec2& v) const { return Vec2(x + v.x, y + v.y); }
+		Vec2 operator-(const Vec2& v) const { return Vec2(x - v.x, y - v.y); }
+		Vec2 operator*(float f) const { return Vec2(x*f, y*f); }
 	} Vec2;
 
 private:
@@ -97,7 +108,7 @@ private:
 
 	int m_receiverId; //receiverId allocated to the UnityForCppTest singleton receiver from the C# and passed on the initialization
 	int m_numberOfGameObjects; //number of game objects to order the creation and manage from the C++ code, passed on the initialization
-	UnityArray<Vec2> m_gameObjectPositions; //shared array containing the position of each managed game object.
+	TrackedUnityArray<Vec2> m_gameObjectPositions; //shared array containing the position of each managed game object.
 	vector<Vec2> m_gameObjectVelocities; //vector containing the velocity of each managed game object.
 	
 	double m_timeSinceStart;
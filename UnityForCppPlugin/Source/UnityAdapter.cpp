@@ -4,6 +4,7 @@
 #include "UnityAdapter.h"
 #include "UnityArray.h"
 #include <stdio.h>
+#include <unordered_map>
 
 namespace UnityForCpp
 {
@@ -54,10 +55,32 @@ namespace Internals
 	//C# function pointers to be set right after the DLL loading via the UnityAdapterPlugin interface
 	static OutputDebugStrFcPtr			nf_OutputDebugStr = NULL;
 	static RequestFileContentFcPtr		nf_RequestFileContent = NULL;
+	static RequestFileContentAsyncFcPtr	nf_RequestFileContentAsync = NULL;
+	static RequestFileRangeAsyncFcPtr	nf_RequestFileRangeAsync = NULL;
 	static SaveTextFileFcPtr			nf_SaveTextFile = NULL;
 	static RequestManagedArrayFcPtr		nf_RequestManagedArray = NULL;
 	static ReleaseManagedArrayFcPtr		nf_ReleaseManagedArray = NULL;
 
+	//Retained arrays by their ids, check RetainManagedArray
+	struct RetainedManagedArray
+	{
+		int nOfRetains;
+		bool isReleaseDeferred;
+	};
+	static std::unordered_map<int, RetainedManagedArray> nf_retainedManagedArrays;
+
+	//Asynchronous file reads by their request ids, check ReadFileContentAsync and ReadFileRangeAsync
+	struct FileReadRequest
+	{
+		int status; //UA_FILE_READ_* value
+		DeliveredManagedArray content; //set when the status is UA_FILE_READ_DONE
+		FileReadCompletedFcPtr completedFcPtr;
+		FileRangeReadCompletedFcPtr rangeCompletedFcPtr; //set only for the range reads
+		void* pUserData;
+	};
+	static std::unordered_map<int, FileReadRequest> nf_fileReadRequests;
+	static int nf_lastFileReadRequestId = 0;
+
 	void SetOutputDebugStrFcPtr(OutputDebugStrFcPtr fcPtr)
 	{
 		nf_OutputDebugStr = fcPtr;
@@ -70,6 +93,24 @@ namespace Internals
 		nf_SaveTextFile = openAndWriteAllFileFcPtr;
 	}
 
+	void SetFileReadAsyncFcPtrs(RequestFileContentAsyncFcPtr requestFileContentAsyncFcPtr,
+								RequestFileRangeAsyncFcPtr requestFileRangeAsyncFcPtr)
+	{
+		nf_RequestFileContentAsync = requestFileContentAsyncFcPtr;
+		nf_RequestFileRangeAsync = requestFileRangeAsyncFcPtr;
+	}
+
+	//Registers a new asynchronous read, returning its request id
+	static int NewFileReadRequest(FileReadCompletedFcPtr completedFcPtr, FileRangeReadCompletedFcPtr rangeCompletedFcPtr, void* pUserData)
+	{
+		int requestId = ++nf_lastFileReadRequestId;
+		if (requestId <= 0) //wrapped around
+			requestId = nf_lastFileReadRequestId = 1;
+
+		FileReadRequest request = { UA_FILE_READ_PENDING, DeliveredManagedArray(), completedFcPtr, rangeCompletedFcPtr, pUserData };
+		nf_fileReadRequests[requestId] = request;
+		return requestId;
+	}
 
 	void SetArrayFcPtrs(RequestManagedArrayFcPtr requestManagedArrayFcPtr,
 		ReleaseManagedArrayFcPtr releaseManagedArrayFcPtr)
@@ -87,6 +128,50 @@ namespace Internals
 		GetDeliveredManagedArrayAndSetNext(&deliveredArray);
 	}
 
+	void DeliverFileReadContent(int requestId, int id, void* pArray, int length)
+	{
+		std::unordered_map<int, FileReadRequest>::iterator it = nf_fileReadRequests.find(requestId);
+		if (it == nf_fileReadRequests.end())
+		{	//canceled while pending
+			if (pArray)
+				ReleaseManagedArray(id);
+			return;
+		}
+
+		FileReadRequest& request = it->second;
+		if (request.completedFcPtr == NULL)
+		{	//kept until it is polled
+			request.status = pArray ? UA_FILE_READ_DONE : UA_FILE_READ_NOT_FOUND;
+			request.content = pArray ? DeliveredManagedArray(id, length, pArray) : DeliveredManagedArray();
+			return;
+		}
+
+		//forgotten before the call, so the callback may start new reads
+		FileReadCompletedFcPtr completedFcPtr = request.completedFcPtr;
+		void* pUserData = request.pUserData;
+		nf_fileReadRequests.erase(it);
+
+		UnityArray<uint8> content;
+		if (pArray)
+			content = DeliveredManagedArray(id, length, pArray).GetAsNewUnityArray<uint8>();
+
+		completedFcPtr(requestId, pArray ? &content : NULL, pUserData);
+	}
+
+	void DeliverFileRangeRead(int requestId, int nOfBytesRead, int64 fileLength)
+	{
+		std::unordered_map<int, FileReadRequest>::iterator it = nf_fileReadRequests.find(requestId);
+		if (it == nf_fileReadRequests.end()) //canceled while pending
+			return;
+
+		ASSERT(it->second.rangeCompletedFcPtr);
+		FileRangeReadCompletedFcPtr rangeCompletedFcPtr = it->second.rangeCompletedFcPtr;
+		void* pUserData = it->second.pUserData;
+		nf_fileReadRequests.erase(it);
+
+		rangeCompletedFcPtr(requestId, nOfBytesRead, fileLength, pUserData);
+	}
+
 } //Internals
 
 //check declaration for comments
@@ -113,9 +198,42 @@ void ReleaseManagedArray(int arrayId)
 		return;
 	}
 
+	std::unordered_map<int, Internals::RetainedManagedArray>::iterator it = Internals::nf_retainedManagedArrays.find(arrayId);
+	if (it != Internals::nf_retainedManagedArrays.end())
+	{	//released for real when unretained
+		it->second.isReleaseDeferred = true;
+		return;
+	}
+
 	Internals::nf_ReleaseManagedArray(arrayId);
 }
 
+//check declaration for comments
+void RetainManagedArray(int arrayId)
+{
+	Internals::RetainedManagedArray retainedArray = { 0, false };
+	++(Internals::nf_retainedManagedArrays.insert(std::make_pair(arrayId, retainedArray)).first->second.nOfRetains);
+}
+
+//check declaration for comments
+void UnretainManagedArray(int arrayId)
+{
+	std::unordered_map<int, Internals::RetainedManagedArray>::iterator it = Internals::nf_retainedManagedArrays.find(arrayId);
+	if (it == Internals::nf_retainedManagedArrays.end())
+	{
+		ASSERT(false);
+		return;
+	}
+
+	if (--(it->second.nOfRetains) > 0)
+		return;
+
+	bool isReleaseDeferred = it->second.isReleaseDeferred;
+	Internals::nf_retainedManagedArrays.erase(it);
+	if (isReleaseDeferred)
+		ReleaseManagedArray(arrayId);
+}
+
 //check declaration for comments
 bool ReadFileContentToUnityArray(const char* fullFilePath, UnityArray<uint8>* pUnityArrayOutput)
 {
@@ -133,6 +251,67 @@ bool ReadFileContentToUnityArray(const char* fullFilePath, UnityArray<uint8>* pU
 	return true;
 }
 
+//check declaration for comments
+int ReadFileContentAsync(const char* fullFilePath, FileReadCompletedFcPtr completedFcPtr, void* pUserData)
+{
+	ASSERT(Internals::nf_RequestFileContentAsync);
+
+	int requestId = Internals::NewFileReadRequest(completedFcPtr, NULL, pUserData);
+	Internals::nf_RequestFileContentAsync(requestId, fullFilePath);
+	return requestId;
+}
+
+//check declaration for comments
+int ReadFileRangeAsync(const char* fullFilePath, int64 fileOffset, int length, UnityArray<uint8>* pDestArray, int destOffset,
+					   FileRangeReadCompletedFcPtr completedFcPtr, void* pUserData)
+{
+	ASSERT(Internals::nf_RequestFileRangeAsync);
+	ASSERT(completedFcPtr != NULL && pDestArray != NULL && pDestArray->GetId() >= 0);
+	ASSERT(fileOffset >= 0 && length >= 0 && destOffset >= 0 && destOffset + length <= pDestArray->GetLength());
+
+	int requestId = Internals::NewFileReadRequest(NULL, completedFcPtr, pUserData);
+	Internals::nf_RequestFileRangeAsync(requestId, fullFilePath, fileOffset, length, pDestArray->GetId(), destOffset);
+	return requestId;
+}
+
+//check declaration for comments
+int GetFileReadStatus(int requestId)
+{
+	std::unordered_map<int, Internals::FileReadRequest>::const_iterator it = Internals::nf_fileReadRequests.find(requestId);
+	return it != Internals::nf_fileReadRequests.end() ? it->second.status : UA_FILE_READ_INVALID_REQUEST;
+}
+
+//check declaration for comments
+bool TakeFileReadContent(int requestId, UnityArray<uint8>* pUnityArrayOutput)
+{
+	ASSERT(pUnityArrayOutput != NULL);
+
+	std::unordered_map<int, Internals::FileReadRequest>::iterator it = Internals::nf_fileReadRequests.find(requestId);
+	if (it == Internals::nf_fileReadRequests.end() || it->second.status == UA_FILE_READ_PENDING)
+		return false;
+
+	bool isDone = it->second.status == UA_FILE_READ_DONE;
+	if (isDone)
+		(*pUnityArrayOutput) = it->second.content.GetAsNewUnityArray<uint8>();
+
+	Internals::nf_fileReadRequests.erase(it);
+	return isDone;
+}
+
+//check declaration for comments
+void CancelFileRead(int requestId)
+{
+	std::unordered_map<int, Internals::FileReadRequest>::iterator it = Internals::nf_fileReadRequests.find(requestId);
+	if (it == Internals::nf_fileReadRequests.end())
+		return;
+
+	//a pending read has its content released when it is delivered, since the request is not found anymore
+	if (it->second.status == UA_FILE_READ_DONE)
+		ReleaseManagedArray(it->second.content.id);
+
+	Internals::nf_fileReadRequests.erase(it);
+}
+
 //check declaration for comments
 void SaveTextFile(const char* fullFilePath, const char* contentStr)
 {
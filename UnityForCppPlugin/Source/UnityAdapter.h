@@ -28,6 +28,46 @@ namespace UnityAdapter
 //data folder as path root. Bundle files are expected to have an Assets "Resources" folder as path root.
 bool ReadFileContentToUnityArray(const char* fullFilePath, UnityArray<uint8>* pUnityArrayOutput);
 
+//Possible results of GetFileReadStatus
+#define UA_FILE_READ_INVALID_REQUEST -1 //unknown request id, or one already taken, canceled or delivered to its callback
+#define UA_FILE_READ_PENDING 0
+#define UA_FILE_READ_DONE 1
+#define UA_FILE_READ_NOT_FOUND 2
+
+//Called when an asynchronous read completes (check ReadFileContentAsync), pContent is NULL if the file could not be found.
+//The content is released after the call, unless you move it to your own UnityArray (ex: m_content = std::move(*pContent)).
+typedef void(*FileReadCompletedFcPtr)(int requestId, UnityArray<uint8>* pContent, void* pUserData);
+
+//Asynchronous version of ReadFileContentToUnityArray, searching the file in the same way. It returns a request id right away,
+//while the C# side reads the file on a background thread (bundle files are loaded by Resources.LoadAsync), so many reads may 
+//be in flight without stalling the frame. Reads are completed by the C# UnityAdapter Update, after which the content is 
+//either delivered to completedFcPtr (if it is not NULL) or kept for you to poll by GetFileReadStatus and TakeFileReadContent.
+//The request ids are never 0. All the asynchronous read functions MUST BE CALLED ON THE MAIN THREAD.
+int ReadFileContentAsync(const char* fullFilePath, FileReadCompletedFcPtr completedFcPtr = NULL, void* pUserData = NULL);
+
+//Returns one of the UA_FILE_READ_* values for the request
+int GetFileReadStatus(int requestId);
+
+//Moves the content of a completed read to the output array (DO NOT CALL "Alloc" on it), returning true. It returns false if the
+//read is still pending or the file was not found, the request is forgotten once it is completed, whatever the result.
+bool TakeFileReadContent(int requestId, UnityArray<uint8>* pUnityArrayOutput);
+
+//Forgets the request, its content is released right away if it is completed, or when it completes otherwise
+void CancelFileRead(int requestId);
+
+//Called when an asynchronous range read completes (check ReadFileRangeAsync). nOfBytesRead is less than the requested length
+//when the end of the file is reached, or -1 if the file could not be read, in which case fileLength is -1 too.
+typedef void(*FileRangeReadCompletedFcPtr)(int requestId, int nOfBytesRead, int64 fileLength, void* pUserData);
+
+//Reads up to length bytes of the file, starting at fileOffset, to an existing array at destOffset, so large files can be read
+//by parts without allocating arrays for them (check UnityFileStreamReader). The C# side reads it on a background thread,
+//completing it by calling completedFcPtr (which is REQUIRED) from its Update, as for ReadFileContentAsync. The file is looked
+//for at the persistent data folder and then at the StreamingAssets folder (not on Android, where these are compressed on
+//the apk), since bundle files are only loaded whole. DO NOT TOUCH the destination range until the read completes (releasing
+//the array in the meantime is safe though). CancelFileRead only skips the completedFcPtr call, the read itself goes on.
+int ReadFileRangeAsync(const char* fullFilePath, int64 fileOffset, int length, UnityArray<uint8>* pDestArray, int destOffset,
+					   FileRangeReadCompletedFcPtr completedFcPtr, void* pUserData);
+
 //Save the contentStr data to the file at the specified path (creates file and directory if needed).
 //The persistent data folder for the platform will be the path root. An existing file for this path will be overwriten.
 void SaveTextFile(const char* fullFilePath, const char* contentStr);
@@ -58,6 +98,12 @@ int NewManagedArray(const char* managedTypeName, int length, void** pOutputArray
 //Release the shared/managed C# array
 void ReleaseManagedArray(int arrayId);
 
+//While retained, ReleaseManagedArray calls for the array are deferred until it is unretained as many times as it was retained.
+//It allows the UnityMessager to keep arrays referenced by messages alive until these are delivered, even if the UnityArray 
+//instance releases it before. Only the main thread may retain arrays (and release retained ones).
+void RetainManagedArray(int arrayId);
+void UnretainManagedArray(int arrayId);
+
 
 //namespace to separate actual utilities offered by UnityAdapter to the cpp code from the internal namespace stuff
 //providing this implementation and that needs to be accessible to UnityAdapterPlugin.h
@@ -70,6 +116,9 @@ namespace Internals
 	//At C# UnityForCpp.UnityAdapter.UnityAdapterDLL defines delegates for each one of these function pointer types
 	typedef void(*OutputDebugStrFcPtr)(int, const char *); //(logType, string) -> string to pass to Debug.Log()
 	typedef void(*RequestFileContentFcPtr)(const char *);//(fullFilePath) -> file content should be returned via SetFileContent
+	typedef void(*RequestFileContentAsyncFcPtr)(int, const char *);//(requestId, fullFilePath) -> delivered via DeliverFileReadContent
+	typedef void(*RequestFileRangeAsyncFcPtr)(int, const char *, int64, int, int, int);//(requestId, fullFilePath, fileOffset, length,
+																						//destArrayId, destOffset) -> delivered via DeliverFileRangeRead
 	typedef void(*SaveTextFileFcPtr)(const char *, const char*); //(fullFilePath, contentAsStr) 
 	typedef void(*RequestManagedArrayFcPtr)(const char*, int); //(dotNETTypeName, arrayLength)
 	typedef void(*ReleaseManagedArrayFcPtr)(int); //(arrayId)
@@ -81,6 +130,10 @@ namespace Internals
 	void SetFileFcPtrs(RequestFileContentFcPtr requestFileContentFcPtr,
 						SaveTextFileFcPtr openAndWriteAllFileFcPtr);
 
+	//Check for comments at UnityAdapterPlugin.h
+	void SetFileReadAsyncFcPtrs(RequestFileContentAsyncFcPtr requestFileContentAsyncFcPtr,
+								RequestFileRangeAsyncFcPtr requestFileRangeAsyncFcPtr);
+
 	//Check for comments at UnityAdapterPlugin.h
 	void SetArrayFcPtrs(RequestManagedArrayFcPtr requestManagedArrayFcPtr,
 						ReleaseManagedArrayFcPtr releaseManagedArrayFcPtr);
@@ -88,6 +141,12 @@ namespace Internals
 	//Check for comments at UnityAdapterPlugin.h
 	void DeliverRequestedManagedArray(int id, void* pArray, int length);
 
+	//Check for comments at UnityAdapterPlugin.h
+	void DeliverFileReadContent(int requestId, int id, void* pArray, int length);
+
+	//Check for comments at UnityAdapterPlugin.h
+	void DeliverFileRangeRead(int requestId, int nOfBytesRead, int64 fileLength);
+
 } //Internals namespace
 
 } //UnityAdapter namespace
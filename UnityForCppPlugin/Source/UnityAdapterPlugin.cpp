@@ -24,6 +24,14 @@ extern "C"
 		UAInternals::SetFileFcPtrs(requestFileContentFcPtr, openAndWriteAllFileFcPtr);
 	}
 
+	//Sets the function pointers for the C# functions starting the asynchronous file reads, which are completed by UA_DeliverFileReadContent
+	//and UA_DeliverFileRangeRead. UnityAdapter.RequestFileContentAsync and UnityAdapter.RequestFileRangeAsync (both C#) are expected
+	void EXPORT_API UA_SetFileReadAsyncFcPtrs(UAInternals::RequestFileContentAsyncFcPtr requestFileContentAsyncFcPtr,
+											  UAInternals::RequestFileRangeAsyncFcPtr requestFileRangeAsyncFcPtr)
+	{
+		UAInternals::SetFileReadAsyncFcPtrs(requestFileContentAsyncFcPtr, requestFileRangeAsyncFcPtr);
+	}
+
 	//Sets the function pointers for the C# functions providing shared arrays from the managed memory
 	//UnityAdapter.RequestManagedArray and UnityAdapter.ReleaseManagedArray (both C#) are expected, check their comments
 	void EXPORT_API UA_SetArrayFcPtrs(UAInternals::RequestManagedArrayFcPtr requestManagedArrayFcPtr,
@@ -38,4 +46,18 @@ extern "C"
 	{
 		UAInternals::DeliverRequestedManagedArray(id, pArray, length);
 	}
+
+	//Function used by the C# code to complete the asynchronous file read of the given request (check UnityAdapter::ReadFileContentAsync),
+	//pArray is NULL if the file was not found. The content array is already registered as a shared array with the given id.
+	void EXPORT_API UA_DeliverFileReadContent(int requestId, int id, void* pArray, int length)
+	{
+		UAInternals::DeliverFileReadContent(requestId, id, pArray, length);
+	}
+
+	//Function used by the C# code to complete the asynchronous range read of the given request (check UnityAdapter::ReadFileRangeAsync),
+	//nOfBytesRead and fileLength are -1 if the file could not be read
+	void EXPORT_API UA_DeliverFileRangeRead(int requestId, int nOfBytesRead, int64 fileLength)
+	{
+		UAInternals::DeliverFileRangeRead(requestId, nOfBytesRead, fileLength);
+	}
 } // end of export C block
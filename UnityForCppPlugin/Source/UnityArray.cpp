@@ -5,6 +5,7 @@
 #include "UnityArray.h"
 #include "UnityAdapter.h"
 #include <string>
+#include <string.h>
 
 namespace UnityForCpp
 {
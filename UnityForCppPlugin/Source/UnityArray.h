@@ -127,6 +127,101 @@ private:
 	friend struct UnityAdapter::Internals::DeliveredManagedArray;
 };
 
+//Shared array keeping track of the items written through Set or GetForWrite, so the C# side can update only the items that 
+//have changed instead of going over the whole array. The tracking is done on a companion shared array, the dirty bitmap, 
+//which is an UnityArray<uint32> having at the position 0 a flag set when any item is dirty and at the next positions a bit 
+//per item. The C# side reads and clears it (check UnityAdapter.ConsumeDirtyItems), so the dirty items are the ones written 
+//since the last time it did that. It holds the UnityArray instead of extending it, so the items can only be written through 
+//the tracking methods and the array can't be allocated or released apart from its dirty bitmap.
+template <typename T>
+class TrackedUnityArray
+{
+public:
+	//Same as UnityArray::Alloc, also allocating the dirty bitmap, all the items start dirty
+	void Alloc(int length)
+	{
+		m_array.Alloc(length);
+		m_dirtyBitmap.Alloc(1 + (length + 31) / 32);
+		MarkAllDirty();
+	}
+
+	//Same as UnityArray::Release, also releasing the dirty bitmap
+	void Release()
+	{
+		m_array.Release();
+		m_dirtyBitmap.Release();
+	}
+
+	//Id of the tracked array, pass it to C# together with GetDirtyBitmapId
+	int GetId() const { return m_array.GetId(); }
+
+	//Id of the dirty bitmap, pass it to C# together with GetId
+	int GetDirtyBitmapId() const { return m_dirtyBitmap.GetId(); }
+
+	int GetLength() const { return m_array.GetLength(); }
+
+	//Read only access to the tracked array, write it through Set or GetForWrite instead
+	const UnityArray<T>& GetArray() const { return m_array; }
+
+	const T& Get(int i) const { return m_array.Get(i); }
+	const T& operator[](int i) const { return m_array.Get(i); }
+
+	void Set(int i, const T& value)
+	{
+		m_array.Get(i) = value;
+		MarkDirty(i);
+	}
+
+	//The item is marked as dirty before being written, so write it before the C# side reads the dirty bitmap again
+	T& GetForWrite(int i)
+	{
+		MarkDirty(i);
+		return m_array.Get(i);
+	}
+
+	void MarkDirty(int i)
+	{
+		ASSERT(i >= 0 && i < m_array.GetLength());
+		uint32* pBitmap = m_dirtyBitmap.GetPtr();
+		pBitmap[0] = 1;
+		pBitmap[1 + (i >> 5)] |= 1u << (i & 31);
+	}
+
+	void MarkDirtyRange(int first, int length)
+	{
+		ASSERT(first >= 0 && length >= 0 && first + length <= m_array.GetLength());
+		if (length == 0)
+			return;
+
+		uint32* pBitmap = m_dirtyBitmap.GetPtr();
+		pBitmap[0] = 1;
+
+		//whole words are set at once, only the words at the ends of the range are set bit by bit
+		int last = first + length - 1;
+		int firstWord = first >> 5;
+		int lastWord = last >> 5;
+		uint32 firstMask = ~0u << (first & 31);
+		uint32 lastMask = ~0u >> (31 - (last & 31));
+		if (firstWord == lastWord)
+		{
+			pBitmap[1 + firstWord] |= firstMask & lastMask;
+			return;
+		}
+
+		pBitmap[1 + firstWord] |= firstMask;
+		for (int word = firstWord + 1; word < lastWord; ++word)
+			pBitmap[1 + word] = ~0u;
+
+		pBitmap[1 + lastWord] |= lastMask;
+	}
+
+	void MarkAllDirty() { MarkDirtyRange(0, m_array.GetLength()); }
+
+private:
+	UnityArray<T> m_array;
+	UnityArray<uint32> m_dirtyBitmap;
+};
+
 } //UnityForCpp namespace
 
 
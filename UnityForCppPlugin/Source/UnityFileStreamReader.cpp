@@ -0,0 +1,229 @@
+//Copyright (c) 2016, Samuel Pollachini (Samuel Polacchini)
+//The UnityForCpp project is licensed under the terms of the MIT license
+
+#include "UnityFileStreamReader.h"
+#include "UnityAdapter.h"
+#include <string.h>
+
+namespace UnityForCpp
+{
+
+UnityFileStreamReader::UnityFileStreamReader(UnityArray<uint8>* pWindow, int nOfChunks)
+	: m_pWindow(pWindow), m_chunkSize(0), m_chunks(), m_chunksInFileOrder(), m_filePath(), m_isOpen(false), m_hasFailed(false),
+	m_fileLength(-1), m_position(0), m_nextReadOffset(0), m_returnedChunkIdx(-1)
+{
+	ASSERT(pWindow != NULL && pWindow->GetId() >= 0); //the window MUST BE ALLOCATED
+	ASSERT(nOfChunks > 0 && pWindow->GetLength() >= nOfChunks);
+
+	m_chunkSize = pWindow->GetLength() / nOfChunks;
+	Chunk freeChunk = { UFSR_CHUNK_FREE, 0, 0, 0 };
+	m_chunks.resize(nOfChunks, freeChunk);
+}
+
+UnityFileStreamReader::~UnityFileStreamReader()
+{
+	//the completions would get to a deleted reader otherwise
+	for (size_t i = 0; i < m_chunks.size(); ++i)
+	{
+		if (m_chunks[i].state == UFSR_CHUNK_READING || m_chunks[i].state == UFSR_CHUNK_DISCARDED)
+			UnityAdapter::CancelFileRead(m_chunks[i].requestId);
+	}
+}
+
+void UnityFileStreamReader::Open(const char* fullFilePath)
+{
+	Close();
+
+	m_filePath = fullFilePath;
+	m_isOpen = true;
+	ReadAhead();
+}
+
+void UnityFileStreamReader::Close()
+{
+	FreeReturnedChunk();
+	DiscardChunks();
+
+	m_isOpen = false;
+	m_hasFailed = false;
+	m_fileLength = -1;
+	m_position = 0;
+	m_nextReadOffset = 0;
+}
+
+bool UnityFileStreamReader::IsWaiting() const
+{
+	if (!m_isOpen || m_hasFailed || IsAtEnd())
+		return false;
+
+	return m_chunksInFileOrder.empty() || m_chunks[m_chunksInFileOrder.front()].state != UFSR_CHUNK_READY;
+}
+
+const uint8* UnityFileStreamReader::GetNextChunk(int& length)
+{
+	FreeReturnedChunk();
+
+	length = 0;
+	Chunk* pChunk = GetReadyFirstChunk();
+	if (pChunk == NULL)
+	{
+		ReadAhead();
+		return NULL;
+	}
+
+	int chunkIdx = m_chunksInFileOrder.front();
+	int offset = (int)(m_position - pChunk->fileOffset);
+	length = pChunk->length - offset;
+	m_position += length;
+
+	//kept out of the read ahead until the next call, since the returned bytes are still being used
+	pChunk->state = UFSR_CHUNK_RETURNED;
+	m_returnedChunkIdx = chunkIdx;
+	m_chunksInFileOrder.pop_front();
+	ReadAhead();
+
+	return m_pWindow->GetPtr() + chunkIdx * m_chunkSize + offset;
+}
+
+int UnityFileStreamReader::Read(void* pDest, int nOfBytes)
+{
+	FreeReturnedChunk();
+
+	int nOfBytesCopied = 0;
+	Chunk* pChunk;
+	while (nOfBytesCopied < nOfBytes && (pChunk = GetReadyFirstChunk()) != NULL)
+	{
+		int offset = (int)(m_position - pChunk->fileOffset);
+		int count = pChunk->length - offset < nOfBytes - nOfBytesCopied ? pChunk->length - offset : nOfBytes - nOfBytesCopied;
+		memcpy(static_cast<uint8*>(pDest) + nOfBytesCopied, m_pWindow->GetPtr() + m_chunksInFileOrder.front() * m_chunkSize + offset, count);
+
+		nOfBytesCopied += count;
+		m_position += count;
+	}
+
+	GetReadyFirstChunk(); //frees the last chunk if all its bytes were copied, so it is read ahead again
+	ReadAhead();
+	return nOfBytesCopied;
+}
+
+void UnityFileStreamReader::Seek(int64 position)
+{
+	ASSERT(position >= 0);
+	FreeReturnedChunk();
+
+	if (!m_chunksInFileOrder.empty() && position >= m_chunks[m_chunksInFileOrder.front()].fileOffset && position < m_nextReadOffset)
+	{	//within the chunks read ahead, so only the ones before it are discarded
+		while (position >= m_chunks[m_chunksInFileOrder.front()].fileOffset + m_chunkSize)
+		{
+			Chunk& chunk = m_chunks[m_chunksInFileOrder.front()];
+			chunk.state = chunk.state == UFSR_CHUNK_READING ? UFSR_CHUNK_DISCARDED : UFSR_CHUNK_FREE;
+			m_chunksInFileOrder.pop_front();
+		}
+	}
+	else
+	{
+		DiscardChunks();
+		m_nextReadOffset = position;
+	}
+
+	m_position = position;
+	ReadAhead();
+}
+
+void UnityFileStreamReader::ReadAhead()
+{
+	if (!m_isOpen || m_hasFailed)
+		return;
+
+	//until the file length is known all the free chunks are requested, the ones past the end just read nothing
+	for (int i = 0; i < (int)m_chunks.size() && (m_fileLength < 0 || m_nextReadOffset < m_fileLength); ++i)
+	{
+		Chunk& chunk = m_chunks[i];
+		if (chunk.state != UFSR_CHUNK_FREE)
+			continue;
+
+		chunk.state = UFSR_CHUNK_READING;
+		chunk.fileOffset = m_nextReadOffset;
+		chunk.length = 0;
+		chunk.requestId = UnityAdapter::ReadFileRangeAsync(m_filePath.c_str(), m_nextReadOffset, m_chunkSize, m_pWindow, i * m_chunkSize,
+														   OnChunkRead, this);
+		m_chunksInFileOrder.push_back(i);
+		m_nextReadOffset += m_chunkSize;
+	}
+}
+
+void UnityFileStreamReader::FreeReturnedChunk()
+{
+	if (m_returnedChunkIdx < 0)
+		return;
+
+	m_chunks[m_returnedChunkIdx].state = UFSR_CHUNK_FREE;
+	m_returnedChunkIdx = -1;
+}
+
+void UnityFileStreamReader::DiscardChunks()
+{
+	for (size_t i = 0; i < m_chunksInFileOrder.size(); ++i)
+	{
+		Chunk& chunk = m_chunks[m_chunksInFileOrder[i]];
+		chunk.state = chunk.state == UFSR_CHUNK_READING ? UFSR_CHUNK_DISCARDED : UFSR_CHUNK_FREE;
+	}
+
+	m_chunksInFileOrder.clear();
+}
+
+UnityFileStreamReader::Chunk* UnityFileStreamReader::GetReadyFirstChunk()
+{
+	while (!m_hasFailed && !m_chunksInFileOrder.empty())
+	{
+		Chunk& chunk = m_chunks[m_chunksInFileOrder.front()];
+		if (chunk.state != UFSR_CHUNK_READY)
+			return NULL;
+
+		if (m_position >= chunk.fileOffset && m_position < chunk.fileOffset + chunk.length)
+			return &chunk;
+
+		//all its bytes were consumed, or it is past the end of the file (being after the position too when the position is past
+		//the end, since the chunks read before knowing the file length are past the end as well)
+		chunk.state = UFSR_CHUNK_FREE;
+		m_chunksInFileOrder.pop_front();
+	}
+
+	return NULL;
+}
+
+void UnityFileStreamReader::OnChunkRead(int requestId, int nOfBytesRead, int64 fileLength, void* pUserData)
+{
+	UnityFileStreamReader* pReader = static_cast<UnityFileStreamReader*>(pUserData);
+	for (size_t i = 0; i < pReader->m_chunks.size(); ++i)
+	{
+		Chunk& chunk = pReader->m_chunks[i];
+		if (chunk.requestId != requestId || (chunk.state != UFSR_CHUNK_READING && chunk.state != UFSR_CHUNK_DISCARDED))
+			continue;
+
+		if (chunk.state == UFSR_CHUNK_DISCARDED)
+		{	//only now its bytes are not written anymore
+			chunk.state = UFSR_CHUNK_FREE;
+			pReader->ReadAhead();
+			return;
+		}
+
+		chunk.state = UFSR_CHUNK_READY;
+		chunk.length = nOfBytesRead > 0 ? nOfBytesRead : 0;
+		if (nOfBytesRead < 0)
+		{
+			if (!pReader->m_hasFailed) //the other chunks being read fail the same way
+				ERROR_LOGF("[UnityFileStreamReader] Could not read the file %s!", pReader->m_filePath.c_str());
+
+			pReader->m_hasFailed = true;
+		}
+		else
+			pReader->m_fileLength = fileLength;
+
+		return;
+	}
+
+	ASSERT(false); //the completion of a read not requested by this reader
+}
+
+}; //UnityForCpp
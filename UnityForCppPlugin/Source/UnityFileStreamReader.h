@@ -0,0 +1,126 @@
+//Copyright (c) 2016, Samuel Pollachini (Samuel Polacchini)
+//The UnityForCpp project is licensed under the terms of the MIT license
+
+#ifndef UNITY_FILE_STREAM_READER_H
+#define UNITY_FILE_STREAM_READER_H
+
+#include "Shared.h"
+#include "UnityArray.h"
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace UnityForCpp
+{
+
+//Reads a file sequentially through a window, an UnityArray<uint8> given by you, so files of any size (replays, audio, baked
+//world data) are read with the fixed memory of the window, instead of having them whole on a new array as it happens with
+//UnityAdapter::ReadFileContentToUnityArray. The window is split into chunks, which are read ahead of your position by
+//UnityAdapter::ReadFileRangeAsync, so while you parse a chunk the next ones are being read on a C# background thread.
+//Check ReadFileRangeAsync for where the files are looked for, Resources bundle files are not supported.
+//
+//Reads complete on the C# UnityAdapter Update, so when the chunk at your position is not read yet GetNextChunk and Read just
+//return nothing, try again on the next frame (check IsWaiting). Everything here MUST BE DONE ON THE MAIN THREAD.
+//
+//Usage example:
+//		UnityArray<uint8> window; window.Alloc(4 * 256 * 1024);
+//		UnityFileStreamReader reader(&window, 4);
+//		reader.Open("Replays/last.replay");
+//		(each frame) while ((pChunk = reader.GetNextChunk(length)) != NULL) Parse(pChunk, length);
+//
+class UnityFileStreamReader
+{
+public:
+	//The window MUST BE ALLOCATED and be kept while the reader exists, being split into nOfChunks chunks of the same size (the
+	//remaining bytes are not used). More chunks mean more read-ahead, 2 chunks is the minimum for reading while parsing.
+	UnityFileStreamReader(UnityArray<uint8>* pWindow, int nOfChunks);
+	~UnityFileStreamReader();
+
+	//Starts reading the file from its beginning, closing the one being read, if any
+	void Open(const char* fullFilePath);
+
+	//Stops reading the file. Reads in flight into the window are discarded when they complete, their chunks are only read
+	//again after that, since their bytes are still being written.
+	void Close();
+
+	bool IsOpen() const { return m_isOpen; }
+
+	//True if the file could not be read (not found, for instance), nothing is returned after that
+	bool HasFailed() const { return m_hasFailed; }
+
+	//True when all the bytes of the file were returned
+	bool IsAtEnd() const { return m_fileLength >= 0 && m_position >= m_fileLength; }
+
+	//True if the chunk at the position is still being read, so nothing is returned until a next frame
+	bool IsWaiting() const;
+
+	//Length of the file, -1 until the first read completes
+	int64 GetFileLength() const { return m_fileLength; }
+
+	//Position on the file of the next byte to be returned
+	int64 GetPosition() const { return m_position; }
+
+	//Returns the bytes of the file from the position to the end of its chunk, pointing to the window, which stays valid until
+	//the next GetNextChunk, Read, Seek or Close call. Returns NULL (and length 0) if the chunk is not read yet or at the end.
+	const uint8* GetNextChunk(int& length);
+
+	//Copies up to nOfBytes from the position to pDest, crossing chunks, returns the number of bytes copied. Less bytes are
+	//copied when the next chunk is not read yet or at the end, so keep calling it until you get all the bytes you need.
+	int Read(void* pDest, int nOfBytes);
+
+	//Moves the position, the chunks read ahead are kept if it is within them (so skipping forward is cheap), otherwise they
+	//are discarded and reading restarts from there
+	void Seek(int64 position);
+
+private:
+	//chunk states
+	enum
+	{
+		UFSR_CHUNK_FREE = 0,
+		UFSR_CHUNK_READING,
+		UFSR_CHUNK_DISCARDED, //still being read, but the bytes are not wanted anymore (after Seek or Close)
+		UFSR_CHUNK_READY,
+		UFSR_CHUNK_RETURNED //returned by GetNextChunk, its bytes are kept until the next call
+	};
+
+	struct Chunk
+	{
+		int state;
+		int requestId;
+		int64 fileOffset;
+		int length; //bytes read
+	};
+
+	//Requests reads for the free chunks, in the file order, while the end of the file is not reached
+	void ReadAhead();
+
+	//Frees the chunk returned by GetNextChunk, if any
+	void FreeReturnedChunk();
+
+	//Discards the chunks read or being read ahead
+	void DiscardChunks();
+
+	//Returns the first chunk on the file order if it is ready, having bytes from the position, NULL otherwise. The chunks 
+	//before it (all their bytes were consumed, or they are past the end of the file) are freed.
+	Chunk* GetReadyFirstChunk();
+
+	//ReadFileRangeAsync completion, pUserData is the reader
+	static void OnChunkRead(int requestId, int nOfBytesRead, int64 fileLength, void* pUserData);
+
+	UnityArray<uint8>* m_pWindow;
+	int m_chunkSize;
+	std::vector<Chunk> m_chunks; //their bytes are at m_chunkSize * (index) on the window
+	std::deque<int> m_chunksInFileOrder; //indexes of the chunks being read or read ahead, from the one at the position
+
+	std::string m_filePath;
+	bool m_isOpen;
+	bool m_hasFailed;
+	int64 m_fileLength;
+	int64 m_position;
+	int64 m_nextReadOffset; //file offset of the next chunk to be requested
+	int m_returnedChunkIdx; //chunk returned by GetNextChunk, -1 if none
+};
+
+}; //UnityForCpp
+
+#endif
@@ -2,6 +2,12 @@
 //The UnityForCpp project is licensed under the terms of the MIT license
 
 #include "UnityMessager.h"
+#include "UnityMessagerInbox.h"
+#include "UnityMessagerRing.h"
+#include "UnityMessagerWire.h"
+#include "UnityAdapter.h"
+#include <algorithm>
+#include <thread>
 
 
 #define UM_MIN_ALLOWED_VALUE_FOR_RECEIVER_IDS 16
@@ -10,25 +16,74 @@
 //the message base is defined by (receiverId, messagerId, numberOfParameters)
 #define UM_MESSAGE_BASE_LENGTH 3
 
-//this corresponds to UnityMessager._controlQueueId on C#
-#define UM_CONTROL_QUEUE_ID 0
+//Type names are sent packed in the int parameters of UMM_REGISTER_PAYLOAD_TYPE (4 chars per int) after these other parameters
+#define UM_REGISTER_PAYLOAD_TYPE_BASE_N_OF_PARAMS 3
+
+//The same for the chars of the interned strings on UMM_REGISTER_INTERNED_STRING, longer strings are split on several messages
+#define UM_REGISTER_INTERNED_STRING_BASE_N_OF_PARAMS 3
+#define UM_REGISTER_INTERNED_STRING_MAX_CHUNK_LENGTH ((UM_MAX_N_OF_CONTROL_MESSAGE_PARAMS - UM_REGISTER_INTERNED_STRING_BASE_N_OF_PARAMS) * 4)
+
+//FNV-1a, used to hash the names of the routing bindings
+#define UM_FNV_OFFSET_BASIS 14695981039346656037ULL
+#define UM_FNV_PRIME 1099511628211ULL
 
 //This code is set by the C# code to the first position of the first array of the control queue in order to
 //set that all messages were delivered, in such way the control queue can be considered empty. 
 //UnityMessager.ControlQueue._emptyCode is the corresponding constant on the C# code.
 #define UM_EMPTY_CONTROL_QUEUE_CODE -123456
 
+//Producer indices given to worker threads not bound by BindProducerThread start from this value, so they are merged
+//after the producers explicitly bound (as long as these have used indices smaller than this one)
+#define UM_FIRST_AUTO_PRODUCER_INDEX (1 << 24)
+
+//Size in bytes of the usual blocks of memory holding the parameter values of the staged messages. Parameters bigger than
+//that get their own block, which is released when the staged messages are merged into the shared message queues.
+#define UM_STAGING_DATA_BLOCK_SIZE 16384
+
+//Alignment in bytes for each parameter value on the staging data blocks
+#define UM_STAGING_DATA_ALIGNMENT 8
+
+UA_SUPPORTED_TYPE(UnityForCpp::UnityMessager::InternedStringRef, "UnityForCpp.UnityMessager+InternedStringRef")
+
 namespace UnityForCpp
 {
 
-UnityMessager* UnityMessager::s_pInstance = NULL;
+UnityMessager* UnityMessager::s_pInstances[UM_MAX_N_OF_CHANNELS] = {};
+
+THREAD_LOCAL UnityMessager::StagingQueue* UnityMessager::s_pThreadStagingQueues[UM_MAX_N_OF_CHANNELS] = {};
+THREAD_LOCAL uint32 UnityMessager::s_threadStagingQueueSerials[UM_MAX_N_OF_CHANNELS] = {};
+
+//UM_UNREGISTERED_CHANNEL_IDS initializes the static arrays of ids per channel, a missing value would be 0 instead of -1
+static const int c_unregisteredChannelIds[] = UM_UNREGISTERED_CHANNEL_IDS;
+static_assert(sizeof(c_unregisteredChannelIds) == UM_MAX_N_OF_CHANNELS * sizeof(int), 
+			  "UM_UNREGISTERED_CHANNEL_IDS MUST have UM_MAX_N_OF_CHANNELS values");
+
+//last serial given to an UnityMessager instance, 0 is never used so it is never valid for the thread local cache.
+static uint32 f_lastInstanceSerial = 0;
+
+//last stamp given to an interned string, global so the ids cached by InternedString instances are never valid for other instances
+static uint32 f_lastInternedStringStamp = 0;
 
-int UnityMessager::InstanceAndProvideAwakeInfo(int maxNOfReceiverIds, int maxQueueArraysSizeInBytes)
+//Packs the chars as little endian ints (4 chars per int), so the C# side gets the chars in order from the int bytes
+static void PackChars(const char* str, int length, int* pDest)
 {
-	if (maxNOfReceiverIds < UM_MIN_ALLOWED_VALUE_FOR_RECEIVER_IDS)
+	memset(pDest, 0, ((length + 3) / 4) * sizeof(int));
+	for (int i = 0; i < length; ++i)
+		pDest[i / 4] |= (int)(uint8)str[i] << (8 * (i % 4));
+}
+
+int UnityMessager::InstanceAndProvideAwakeInfo(int initialNOfReceiverIds, int maxQueueArraysSizeInBytes, int initFlags, int channelId)
+{
+	if (channelId < 0 || channelId >= UM_MAX_N_OF_CHANNELS)
+	{
+		ERROR_LOGF("UnityMessager channel %d is not valid, the channels go from 0 to %d.", channelId, UM_MAX_N_OF_CHANNELS - 1);
+		return -1;
+	}
+
+	if (initialNOfReceiverIds < UM_MIN_ALLOWED_VALUE_FOR_RECEIVER_IDS)
 	{
-		WARNING_LOGF("UnityMessager min value for maxNOfReceiverIds is %d. This value will be forced.", UM_MIN_ALLOWED_VALUE_FOR_RECEIVER_IDS);
-		maxNOfReceiverIds = UM_MIN_ALLOWED_VALUE_FOR_RECEIVER_IDS;
+		WARNING_LOGF("UnityMessager min value for initialNOfReceiverIds is %d. This value will be forced.", UM_MIN_ALLOWED_VALUE_FOR_RECEIVER_IDS);
+		initialNOfReceiverIds = UM_MIN_ALLOWED_VALUE_FOR_RECEIVER_IDS;
 	}
 
 	if (maxQueueArraysSizeInBytes < UM_MIN_ALLOWED_VALUE_FOR_QUEUE_ARRAY_SIZE)
@@ -37,106 +92,639 @@ int UnityMessager::InstanceAndProvideAwakeInfo(int maxNOfReceiverIds, int maxQue
 		maxQueueArraysSizeInBytes = UM_MIN_ALLOWED_VALUE_FOR_QUEUE_ARRAY_SIZE;
 	}
 	
-	ASSERT(s_pInstance == NULL);
+	ASSERT(s_pInstances[channelId] == NULL);
 
 	//We make this assignment here since it is the logical place for it to be. However, we know the UnityMessager constructor
-	//will do this assignment itself because s_pInstance must be valid when the control queue is beign instanced. 
-	s_pInstance = new UnityMessager(maxNOfReceiverIds, maxQueueArraysSizeInBytes);
+	//will do this assignment itself, so the instance is already accessible while its control queue is beign instanced. 
+	s_pInstances[channelId] = new UnityMessager(initialNOfReceiverIds, maxQueueArraysSizeInBytes, initFlags, channelId);
 
-	return s_pInstance->ProvideUnityMessagerAwakeInfo();
+	return s_pInstances[channelId]->ProvideUnityMessagerAwakeInfo();
 }
 
-UnityMessager::UnityMessager(int maxNOfReceiverIds, int maxQueueArraysSizeInBytes)
-	: m_receiverIds(), m_lastAssignedComponentId(-1), m_pControlQueue(NULL),
-	m_maxQueueArraysSizeInBytes(UM_MIN_ALLOWED_VALUE_FOR_QUEUE_ARRAY_SIZE),
-	m_lastAssignedQueueId(-1)
+UnityMessager::UnityMessager(int initialNOfReceiverIds, int maxQueueArraysSizeInBytes, int initFlags, int channelId)
+	: m_receiverIdsHeader(), m_lastAssignedComponentId(-1), m_lastAssignedPayloadTypeId(0), m_pControlQueue(NULL), m_pPayloadQueue(NULL),
+	m_maxQueueArraysSizeInBytes(UM_MIN_ALLOWED_VALUE_FOR_QUEUE_ARRAY_SIZE), 
+	m_isDoubleBuffered((initFlags & UM_INIT_FLAG_DOUBLE_BUFFERED) != 0), m_initFlags(initFlags),
+	m_channelId(channelId), m_lastAssignedQueueId(-1), m_mainThreadId(std::this_thread::get_id()), m_stagingQueues(), m_stagingQueuesMutex(),
+	m_lastAutoProducerIndex(UM_FIRST_AUTO_PRODUCER_INDEX - 1), m_hasStagedMessages(false), 
+	m_instanceSerial(++f_lastInstanceSerial), m_coalescedMessageIdxs(), m_coalescedMessages(), m_coalescedParams(),
+	m_routingBindings(), m_routingBindingIdxs(), m_internedStrings(), m_internedStringIdxs(), m_internedStringsClockHand(0),
+	m_internedStringQueueId(-1), m_messageSerial(0), m_isCollectingStatistics((initFlags & UM_INIT_FLAG_STATISTICS) != 0),
+	m_publishedStatistics(), m_nOfMessagesByMsgId(), m_bytesByQueueId(), m_arraysRetainedIdx(0), m_pTraceWriter(NULL), m_lastTracedTypeId(0),
+	m_pInbox(NULL), m_pRing(NULL)
 {
-	ASSERT(maxNOfReceiverIds >= UM_MIN_ALLOWED_VALUE_FOR_RECEIVER_IDS
+	ASSERT(initialNOfReceiverIds >= UM_MIN_ALLOWED_VALUE_FOR_RECEIVER_IDS
 		&& maxQueueArraysSizeInBytes >= UM_MIN_ALLOWED_VALUE_FOR_QUEUE_ARRAY_SIZE);
 
 	m_maxQueueArraysSizeInBytes = maxQueueArraysSizeInBytes;
-	m_receiverIds.Alloc(maxNOfReceiverIds); //instances the shared array to control the receiver ids.
-
-	//The position 0 of the m_receiverIds shared array indicates the NEXT FREE receiver id, and at the position
-	//of this given id on the m_receiverIds shared array we set the next free id after that. So, it is a kind of 
-	//simple linked list of free receiver ids stablished by the m_receiverIds array. Check the comments for the 
-	//implementation of NewReceiverId() for more details about how the control of the free receiver ids is made. 
-	for (int i = 0; i < maxNOfReceiverIds; ++i)
-		m_receiverIds[i] = i + 1; //"i+1" is the next free id after the initialization, indicated by the i position. 
 
-	m_receiverIds[maxNOfReceiverIds - 1] = 0; //0 means there is no other free id beyond this one.
+	//instances the shared header of the receiver ids table, the chunks are added bellow (check UM_RECEIVER_IDS_HEAD_POS)
+	m_receiverIdsHeader.Alloc(UM_RECEIVER_IDS_HEADER_LENGTH);
+	m_receiverIdsHeader[UM_RECEIVER_IDS_HEAD_POS] = 0;
+	m_receiverIdsHeader[UM_RECEIVER_IDS_N_OF_FREE_POS] = 0;
+	m_receiverIdsHeader[UM_RECEIVER_IDS_N_OF_CHUNKS_POS] = 0;
+	for (int i = 0; i < UM_MAX_N_OF_RECEIVER_ID_CHUNKS; ++i)
+	{
+		m_receiverIdsHeader[UM_RECEIVER_IDS_FIRST_CHUNK_POS + i] = -1;
+		m_receiverIdsChunks[i].store(NULL, std::memory_order_relaxed);
+	}
 
-	for (int i = 0; i < UM_MAX_N_OF_COMPONENTS; ++i)
-		m_staticComponentIdsToResetPtrs[i] = NULL;
+	//the slot 0 of the first chunk is the UMR_MESSAGER one, so it is not counted for the ids requested
+	int nOfReceiverIds = initialNOfReceiverIds < UM_MAX_N_OF_RECEIVER_IDS - 1 ? initialNOfReceiverIds + 1 : UM_MAX_N_OF_RECEIVER_IDS;
+	for (int i = 0; i < nOfReceiverIds; i += UM_RECEIVER_IDS_CHUNK_LENGTH)
+		AddReceiverIdsChunk();
 
-	//initialize the message queues array. Except for the ControlQueue the other message queues are ParamQueue<T> objects
-	//that get instanced only at the first time a parameter T is pushed to a message in a given game execution.
-	for (int i = 0; i < UM_MAX_N_OF_MESSAGE_QUEUES; ++i)
-		m_messageQueuesPtrs[i] = NULL;
+	memset(m_statistics, 0, sizeof(m_statistics));
+	if (m_isCollectingStatistics)
+	{
+		m_publishedStatistics.Alloc(UM_STATISTICS_LENGTH);
+		memset(m_publishedStatistics.GetPtr(), 0, sizeof(m_statistics));
+	}
 
-	//We set this here because it is needed for the ControlQueue instance creation right bellow. 
-	s_pInstance = this; 
+	//Except for the ControlQueue the message queues are ParamQueue<T> objects that get instanced (and added to m_messageQueues)
+	//only at the first time a parameter T is pushed to a message in a given game execution.
+	//We set this here, so the instance of the channel is accessible from the ControlQueue instance creation right bellow. 
+	s_pInstances[m_channelId] = this; 
 
-	m_pControlQueue = new ControlQueue();
+	m_pControlQueue = new ControlQueue(*this, (initFlags & UM_INIT_FLAG_COMPACT_CONTROL_QUEUE) != 0);
 	ASSERT(m_pControlQueue->GetQueueId() == UM_CONTROL_QUEUE_ID); //CONTROL QUEUE MUST BE THE QUEUE 0
 	
-	m_messageQueuesPtrs[UM_CONTROL_QUEUE_ID] = m_pControlQueue;
+	m_messageQueues.Grow(UM_CONTROL_QUEUE_ID + 1);
+	m_messageQueues[UM_CONTROL_QUEUE_ID] = m_pControlQueue;
 	m_lastAssignedQueueId = UM_CONTROL_QUEUE_ID;
+
+	if (initFlags & UM_INIT_FLAG_INTERLEAVED_PARAMS)
+	{	//it registers itself as any other queue, but no ParamQueue is ever created when interleaved
+		m_pPayloadQueue = new PayloadQueue(*this);
+		ASSERT(m_pPayloadQueue->GetQueueId() == UM_PAYLOAD_QUEUE_ID);
+	}
 }
 
-void UnityMessager::DeleteInstance()
+void UnityMessager::DeleteInstance(int channelId)
 {
-	DELETE(s_pInstance);
+	ASSERT(channelId >= 0 && channelId < UM_MAX_N_OF_CHANNELS);
+	DELETE(s_pInstances[channelId]);
 }
 
 UnityMessager::~UnityMessager() 
 {
+	StopCapture();
+	DELETE(m_pInbox);
+	DELETE(m_pRing);
+
 	//reset component ids to -1, so next time they are used (happens on Unity Editor) the registering process is repeated
 	for (int i = 0; i <= m_lastAssignedComponentId; ++i)
 		*(m_staticComponentIdsToResetPtrs[i]) = -1;
 
+	//the same for the payload type ids, which start from 1
+	for (int i = 1; i <= m_lastAssignedPayloadTypeId; ++i)
+		*(m_payloadTypes[i].staticIdToResetPtr) = -1;
+
+	for (int i = 0; i < UM_MAX_N_OF_RECEIVER_ID_CHUNKS; ++i)
+		delete m_receiverIdsChunks[i].load(std::memory_order_relaxed);
+
 	m_pControlQueue = NULL; //we delete it bellow
+	m_pPayloadQueue = NULL;
 	for (int i = 0; i <= m_lastAssignedQueueId; ++i)
-		DELETE(m_messageQueuesPtrs[i]);
+		DELETE(m_messageQueues[i]);
+
+	//messages still staged are just discarded, as it happens to the ones on the shared queues
+	for (std::map<int, StagingQueue*>::iterator it = m_stagingQueues.begin(); it != m_stagingQueues.end(); ++it)
+		delete it->second;
+
+	m_stagingQueues.clear();
+
+	//the messages not delivered yet won't be anymore
+	UnretainArraysRetainedUntilDelivered(0);
+	UnretainArraysRetainedUntilDelivered(1);
+
+	s_pInstances[m_channelId] = NULL;
+}
+
+//The receiver ids table is shared with the C# side, which gives and releases ids the same way (check UnityMessager.NewReceiverId
+//on C#), so it is only accessed through atomic operations (check AtomicAt at UnityMessagerWire.h)
 
-	s_pInstance = NULL;
+//Head of the free slots list pointing to the slot at index, with the tag of the previous head incremented
+static int64 NewReceiverIdsListHead(int64 previousHead, int index)
+{
+	return (int64)(((((uint64)previousHead >> 32) + 1) << 32) | (uint32)index);
 }
 
 int UnityMessager::NewReceiverId()
 {
-	int nextFreeId = m_receiverIds[0]; //Position 0 holder the next free id
+	int index = PopFreeReceiverIdSlot();
+	if (index == 0 && IsOnMainThread() && AddReceiverIdsChunk())
+		index = PopFreeReceiverIdSlot();
 
-	//The next free id holds the next free id after it, so bellow we are removing the next free id from the free ids single linked list
-	m_receiverIds[0] = m_receiverIds[nextFreeId]; 
-	// -1 means this id is use, not being free anymore. ONLY THE C# CODE CAN RELEASE IDs, so they get back to the single linked list.
-	m_receiverIds[nextFreeId] = -1;
-	
-	ASSERT(nextFreeId != 0); //IF IT FAILS WE GOT OUT OF RECEIVER IDS, this must not happen!!!
-	return nextFreeId;
+	if (index == 0) //only worker threads run out of ids before UM_MAX_N_OF_RECEIVER_IDS
+	{
+		ERROR_LOG("[UnityMessager] No receiver id available for this thread, reserve them on the main thread by ReserveReceiverIds!");
+		return -1;
+	}
+
+	int generation = AtomicAt(GetReceiverIdSlot(index) + UM_RECEIVER_ID_SLOT_GENERATION).load(std::memory_order_relaxed);
+	return (generation << UM_RECEIVER_ID_INDEX_BITS) | index;
+}
+
+bool UnityMessager::ReleaseReceiverId(int receiverId)
+{
+	int index = UM_RECEIVER_ID_INDEX(receiverId);
+	int nOfChunks = (int)AtomicAt(&m_receiverIdsHeader[UM_RECEIVER_IDS_N_OF_CHUNKS_POS]).load(std::memory_order_acquire);
+	if (receiverId <= 0 || index == 0 || index / UM_RECEIVER_IDS_CHUNK_LENGTH >= nOfChunks || !IsReceiverIdSlotInUse(index, receiverId))
+	{
+		WARNING_LOG("[UnityMessager] Attempt to release a receiver id not being used!");
+		return false;
+	}
+
+	//claims the slot, so a concurrent release of the same id (the check above passing for both) can't push it twice
+	int* pSlot = GetReceiverIdSlot(index);
+	std::atomic<int>& generation = AtomicAt(pSlot + UM_RECEIVER_ID_SLOT_GENERATION);
+	std::atomic<int>& next = AtomicAt(pSlot + UM_RECEIVER_ID_SLOT_NEXT);
+	int previousNext = UM_RECEIVER_ID_IN_USE;
+	while (!next.compare_exchange_strong(previousNext, UM_RECEIVER_ID_RELEASING, std::memory_order_acquire, std::memory_order_relaxed))
+	{
+		if (previousNext != UM_RECEIVER_ID_RELEASING)
+		{
+			WARNING_LOG("[UnityMessager] Attempt to release a receiver id not being used!");
+			return false;
+		}
+
+		//claimed by another release for a few instructions, it may be a stale one giving the slot back to us
+		previousNext = UM_RECEIVER_ID_IN_USE;
+		std::this_thread::yield();
+	}
+
+	//the slot may have been released and given again since the check above, as a new id, which is not ours to release.
+	//The generation only changes while the slot is claimed, so it is stable now.
+	int currentGeneration = generation.load(std::memory_order_relaxed);
+	if (currentGeneration != (receiverId >> UM_RECEIVER_ID_INDEX_BITS))
+	{
+		next.store(UM_RECEIVER_ID_IN_USE, std::memory_order_release);
+		WARNING_LOG("[UnityMessager] Attempt to release a receiver id not being used!");
+		return false;
+	}
+
+	generation.store((currentGeneration + 1) & UM_RECEIVER_ID_GENERATION_MASK, std::memory_order_relaxed);
+
+	//pushes the slot to the front of the free list, the release ordering makes its generation visible to whoever pops it
+	std::atomic<int64>& head = AtomicAt(&m_receiverIdsHeader[UM_RECEIVER_IDS_HEAD_POS]);
+	int64 previousHead = head.load(std::memory_order_relaxed);
+	do 
+	{
+		next.store((int)(uint32)previousHead, std::memory_order_relaxed);
+	} while (!head.compare_exchange_weak(previousHead, NewReceiverIdsListHead(previousHead, index), 
+										 std::memory_order_release, std::memory_order_relaxed));
+
+	AtomicAt(&m_receiverIdsHeader[UM_RECEIVER_IDS_N_OF_FREE_POS]).fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+void UnityMessager::ReserveReceiverIds(int nOfIds)
+{
+	ASSERT(IsOnMainThread());
+	while (AtomicAt(&m_receiverIdsHeader[UM_RECEIVER_IDS_N_OF_FREE_POS]).load(std::memory_order_relaxed) < nOfIds
+		   && AddReceiverIdsChunk());
+}
+
+bool UnityMessager::AddReceiverIdsChunk()
+{
+	int chunkIdx = (int)m_receiverIdsHeader[UM_RECEIVER_IDS_N_OF_CHUNKS_POS]; //only written on the main thread
+	if (chunkIdx == UM_MAX_N_OF_RECEIVER_ID_CHUNKS)
+	{
+		ERROR_LOGF("[UnityMessager] All the %d receiver ids are in use!", UM_MAX_N_OF_RECEIVER_IDS);
+		return false;
+	}
+
+	UnityArray<int>* pChunk = new UnityArray<int>();
+	pChunk->Alloc(UM_RECEIVER_IDS_CHUNK_LENGTH * UM_RECEIVER_ID_SLOT_LENGTH);
+
+	//the slots are linked in order, the last one is linked to the current head when pushing them all to the list bellow
+	int firstIndex = chunkIdx * UM_RECEIVER_IDS_CHUNK_LENGTH;
+	for (int i = 0; i < UM_RECEIVER_IDS_CHUNK_LENGTH; ++i)
+	{
+		(*pChunk)[i * UM_RECEIVER_ID_SLOT_LENGTH + UM_RECEIVER_ID_SLOT_GENERATION] = 0;
+		(*pChunk)[i * UM_RECEIVER_ID_SLOT_LENGTH + UM_RECEIVER_ID_SLOT_NEXT] = firstIndex + i + 1;
+	}
+
+	int nOfFreeSlots = UM_RECEIVER_IDS_CHUNK_LENGTH;
+	if (chunkIdx == 0) //the UMR_MESSAGER slot is always in use, with the generation 0, so its id is always 0
+	{
+		(*pChunk)[UM_RECEIVER_ID_SLOT_NEXT] = UM_RECEIVER_ID_IN_USE;
+		++firstIndex;
+		--nOfFreeSlots;
+	}
+
+	//publishes the chunk before its slots get to the list, so any thread getting one of them finds its chunk
+	m_receiverIdsChunks[chunkIdx].store(pChunk, std::memory_order_release);
+	AtomicAt(&m_receiverIdsHeader[UM_RECEIVER_IDS_FIRST_CHUNK_POS + chunkIdx]).store(pChunk->GetId(), std::memory_order_relaxed);
+	AtomicAt(&m_receiverIdsHeader[UM_RECEIVER_IDS_N_OF_CHUNKS_POS]).store(chunkIdx + 1, std::memory_order_release);
+
+	std::atomic<int>& lastNext = AtomicAt(&(*pChunk)[(UM_RECEIVER_IDS_CHUNK_LENGTH - 1) * UM_RECEIVER_ID_SLOT_LENGTH + UM_RECEIVER_ID_SLOT_NEXT]);
+	std::atomic<int64>& head = AtomicAt(&m_receiverIdsHeader[UM_RECEIVER_IDS_HEAD_POS]);
+	int64 previousHead = head.load(std::memory_order_relaxed);
+	do
+	{
+		lastNext.store((int)(uint32)previousHead, std::memory_order_relaxed);
+	} while (!head.compare_exchange_weak(previousHead, NewReceiverIdsListHead(previousHead, firstIndex),
+										 std::memory_order_release, std::memory_order_relaxed));
+
+	AtomicAt(&m_receiverIdsHeader[UM_RECEIVER_IDS_N_OF_FREE_POS]).fetch_add(nOfFreeSlots, std::memory_order_relaxed);
+	return true;
+}
+
+int UnityMessager::PopFreeReceiverIdSlot()
+{
+	//Lock free pop from the free list, being the tag of the head what makes the compare and swap fail when another thread
+	//has changed the list after the head was read (the next read bellow may be stale then, but it is never used)
+	std::atomic<int64>& head = AtomicAt(&m_receiverIdsHeader[UM_RECEIVER_IDS_HEAD_POS]);
+	int64 previousHead = head.load(std::memory_order_acquire);
+	int index;
+	do
+	{
+		index = (int)(uint32)previousHead;
+		if (index == 0)
+			return 0;
+
+		int next = AtomicAt(GetReceiverIdSlot(index) + UM_RECEIVER_ID_SLOT_NEXT).load(std::memory_order_relaxed);
+		if (head.compare_exchange_weak(previousHead, NewReceiverIdsListHead(previousHead, next), 
+									   std::memory_order_acquire, std::memory_order_acquire))
+			break;
+	} while (true);
+
+	// -1 means this slot is in use, not being free anymore, until its id gets released (by the C++ or by the C# code)
+	AtomicAt(GetReceiverIdSlot(index) + UM_RECEIVER_ID_SLOT_NEXT).store(UM_RECEIVER_ID_IN_USE, std::memory_order_relaxed);
+	AtomicAt(&m_receiverIdsHeader[UM_RECEIVER_IDS_N_OF_FREE_POS]).fetch_sub(1, std::memory_order_relaxed);
+	return index;
+}
+
+bool UnityMessager::IsReceiverIdSlotInUse(int index, int receiverId) const
+{
+	//the id is in use only while its slot is (a slot claimed by a release still is) and has its generation, otherwise it
+	//was released before
+	int* pSlot = GetReceiverIdSlot(index);
+	int next = AtomicAt(pSlot + UM_RECEIVER_ID_SLOT_NEXT).load(std::memory_order_acquire);
+	return (next == UM_RECEIVER_ID_IN_USE || next == UM_RECEIVER_ID_RELEASING)
+		&& AtomicAt(pSlot + UM_RECEIVER_ID_SLOT_GENERATION).load(std::memory_order_relaxed) == (receiverId >> UM_RECEIVER_ID_INDEX_BITS);
+}
+
+int* UnityMessager::GetReceiverIdSlot(int index) const
+{
+	UnityArray<int>* pChunk = m_receiverIdsChunks[index / UM_RECEIVER_IDS_CHUNK_LENGTH].load(std::memory_order_acquire);
+	ASSERT(pChunk != NULL);
+	return pChunk->GetPtr() + (index % UM_RECEIVER_IDS_CHUNK_LENGTH) * UM_RECEIVER_ID_SLOT_LENGTH;
 }
 
 int UnityMessager::ProvideUnityMessagerAwakeInfo()
 {
-	//For now this is the only message we need to send to initialize the C# UnityMessager instace
-	int params[] = { m_receiverIds.GetId() };
+	int params[] = { m_receiverIdsHeader.GetId() };
 	m_pControlQueue->SendControlMessage(UMM_SET_RECEIVER_IDS_ARRAY, 1, params);
 
+	if (m_isCollectingStatistics)
+	{
+		int statisticsParams[] = { m_publishedStatistics.GetId() };
+		m_pControlQueue->SendControlMessage(UMM_SET_STATISTICS_ARRAY, 1, statisticsParams);
+	}
+
+	//The C# side gets the first array of the control queue from the return bellow, but when double buffered it also 
+	//needs to know the first array of the other set, which is never registered as it happens to the parameter queues. 
+	if (m_isDoubleBuffered)
+	{
+		int firstArrayParams[] = { UM_CONTROL_QUEUE_ID, m_pControlQueue->GetFirstArrayId(), 
+								   m_pControlQueue->GetSecondFirstArrayId() };
+		m_pControlQueue->SendControlMessage(UMM_SET_QUEUE_FIRST_ARRAY, UM_SET_QUEUE_FIRST_ARRAY_DOUBLE_BUFFERED_N_OF_PARAMS, 
+											firstArrayParams);
+	}
+
 	return m_pControlQueue->GetFirstArrayId();
 }
 
 void UnityMessager::OnStartMessageDelivering()
 {
+	ASSERT(IsOnMainThread());
+
+	//messages sent from worker threads are delivered together with the ones sent from the main thread
+	MergeStagingQueues();
+
 	m_pControlQueue->SendMessage(0, UMM_FINISH_DELIVERING_MESSAGES);
 
-	//Reset all the queues, preparing them for the next usage which should happen only after all messages get delivered
+	if (m_pTraceWriter)
+		CaptureDelivering();
+
+	//Reset all the queues, preparing them for the next usage which should happen only after all messages get delivered,
+	//or right away when double buffered, since then the queues start writing to their other set of arrays
+	for (int i = 0; i <= m_lastAssignedQueueId; ++i)
+		m_messageQueues[i]->Reset();
+
+	//the queue resets above have measured the bytes written to them
+	if (m_isCollectingStatistics)
+		PublishStatistics();
+
+	//coalesced messages cannot be overwritten anymore, they are being delivered
+	m_coalescedMessageIdxs.clear();
+	m_coalescedMessages.clear();
+	m_coalescedParams.clear();
+
+	//arrays referenced by messages sent from now on are kept apart from the ones referenced by the messages being delivered
+	m_arraysRetainedIdx = 1 - m_arraysRetainedIdx;
+}
+
+void UnityMessager::OnFinishMessageDelivering()
+{
+	ASSERT(IsOnMainThread());
+	UnretainArraysRetainedUntilDelivered(1 - m_arraysRetainedIdx);
+
+	//allocating the arrays expected to be needed now, instead of when sending messages
+	for (int i = 0; i <= m_lastAssignedQueueId; ++i)
+		m_messageQueues[i]->AdjustCapacity();
+
+	//the same for the receiver ids, so worker threads giving ids don't run out of them while the free list is not empty
+	if (AtomicAt(&m_receiverIdsHeader[UM_RECEIVER_IDS_N_OF_FREE_POS]).load(std::memory_order_relaxed) < UM_RECEIVER_IDS_CHUNK_LENGTH / 4
+		&& m_receiverIdsHeader[UM_RECEIVER_IDS_N_OF_CHUNKS_POS] < UM_MAX_N_OF_RECEIVER_ID_CHUNKS)
+		AddReceiverIdsChunk();
+}
+
+int64 UnityMessager::GetStatistic(int statisticPos) const
+{
+	ASSERT(statisticPos >= 0 && statisticPos < UM_STATISTICS_LENGTH);
+	return m_isCollectingStatistics ? m_publishedStatistics[statisticPos] : 0;
+}
+
+bool UnityMessager::StartCapture(const char* traceFilePath)
+{
+	ASSERT(IsOnMainThread());
+	StopCapture();
+
+	m_pTraceWriter = new UnityMessagerTrace::Writer();
+	if (!m_pTraceWriter->Open(traceFilePath, m_initFlags, m_maxQueueArraysSizeInBytes))
+	{
+		DELETE(m_pTraceWriter);
+		return false;
+	}
+
+	//the first frame has all the types registered until now
+	m_lastTracedTypeId = 0;
+	return true;
+}
+
+void UnityMessager::StopCapture()
+{
+	DELETE(m_pTraceWriter);
+}
+
+void UnityMessager::CaptureDelivering()
+{
+	m_pTraceWriter->BeginFrame();
+
+	//the types registered since the previous frame, payload type ids and parameter queue ids both start from 1
+	if (m_pPayloadQueue)
+	{
+		for (int typeId = m_lastTracedTypeId + 1; typeId <= m_lastAssignedPayloadTypeId; ++typeId)
+		{
+			const PayloadTypeInfo& payloadType = m_payloadTypes[typeId];
+			m_pTraceWriter->AddType(typeId, payloadType.size, payloadType.alignment, payloadType.managedTypeName);
+		}
+
+		m_lastTracedTypeId = m_lastAssignedPayloadTypeId;
+	}
+	else
+	{
+		for (int queueId = m_lastTracedTypeId + 1; queueId <= m_lastAssignedQueueId; ++queueId)
+			m_messageQueues[queueId]->AddTypeToTrace(*m_pTraceWriter);
+
+		m_lastTracedTypeId = m_lastAssignedQueueId;
+	}
+
 	for (int i = 0; i <= m_lastAssignedQueueId; ++i)
-		m_messageQueuesPtrs[i]->Reset();
+		m_messageQueues[i]->AddArraysToTrace(*m_pTraceWriter);
+
+	m_pTraceWriter->EndFrame();
+}
+
+//Inserts (key, value) into the nOfPairs (key, value) pairs kept in descending order of value, so the last pair is dropped
+//when it gets in. Values not bigger than the last one don't get in, so the unused pairs (-1, 0) never get a 0 value.
+static void InsertTopPair(int64* pPairs, int nOfPairs, int key, int64 value)
+{
+	int pos = nOfPairs;
+	while (pos > 0 && pPairs[2 * (pos - 1) + 1] < value)
+		--pos;
+
+	if (pos == nOfPairs)
+		return;
+
+	memmove(pPairs + 2 * (pos + 1), pPairs + 2 * pos, 2 * (nOfPairs - pos - 1) * sizeof(int64));
+	pPairs[2 * pos] = key;
+	pPairs[2 * pos + 1] = value;
+}
+
+void UnityMessager::PublishStatistics()
+{
+	m_statistics[UM_STATISTIC_DELIVERING_SERIAL] = m_publishedStatistics[UM_STATISTIC_DELIVERING_SERIAL] + 1;
+
+	int64* pTopQueues = m_statistics + UM_STATISTIC_FIRST_TOP_QUEUE;
+	for (int i = 0; i < UM_STATISTIC_N_OF_TOP_QUEUES; ++i)
+	{
+		pTopQueues[2 * i] = -1;
+		pTopQueues[2 * i + 1] = 0;
+	}
+
+	for (size_t queueId = 0; queueId < m_bytesByQueueId.size(); ++queueId)
+		InsertTopPair(pTopQueues, UM_STATISTIC_N_OF_TOP_QUEUES, (int)queueId, m_bytesByQueueId[queueId]);
+
+	int64* pTopMsgIds = m_statistics + UM_STATISTIC_FIRST_TOP_MSG_ID;
+	for (int i = 0; i < UM_STATISTIC_N_OF_TOP_MSG_IDS; ++i)
+	{
+		pTopMsgIds[2 * i] = -1;
+		pTopMsgIds[2 * i + 1] = 0;
+	}
+
+	for (std::unordered_map<int, int64>::iterator it = m_nOfMessagesByMsgId.begin(); it != m_nOfMessagesByMsgId.end(); ++it)
+		InsertTopPair(pTopMsgIds, UM_STATISTIC_N_OF_TOP_MSG_IDS, it->first, it->second);
+
+	memcpy(m_publishedStatistics.GetPtr(), m_statistics, sizeof(m_statistics));
+	memset(m_statistics, 0, sizeof(m_statistics));
+	m_nOfMessagesByMsgId.clear();
+	std::fill(m_bytesByQueueId.begin(), m_bytesByQueueId.end(), 0);
+}
+
+void UnityMessager::RetainArrayUntilDelivered(int arrayId)
+{
+	if (m_arraysRetainedUntilDelivered[m_arraysRetainedIdx].insert(arrayId).second) //retained only once per delivering
+		UnityAdapter::RetainManagedArray(arrayId);
+}
+
+void UnityMessager::UnretainArraysRetainedUntilDelivered(int setIdx)
+{
+	std::unordered_set<int>& retainedArrays = m_arraysRetainedUntilDelivered[setIdx];
+	for (std::unordered_set<int>::iterator it = retainedArrays.begin(); it != retainedArrays.end(); ++it)
+		UnityAdapter::UnretainManagedArray(*it);
+
+	retainedArrays.clear();
+}
+
+void UnityMessager::StartMessage(int receiverId, int componentId, int msgId, const char* objectName, const char* methodName)
+{
+	++m_messageSerial;
+
+	//messages addressed by the method name are all counted under the msgId -1
+	CountSentMessage(receiverId, componentId, methodName ? -1 : msgId);
+
+	if (objectName || methodName)
+	{
+		int bindingId = GetRoutingBindingId(componentId, objectName, methodName);
+		if (bindingId >= 0)
+		{	//the C# side gets the names from the binding, so nothing else is pushed
+			m_pControlQueue->SendMessage(objectName ? -1 : receiverId, UM_ROUTING_BINDING_COMPONENT_SLOT(bindingId), 
+										 methodName ? -1 : msgId);
+			return;
+		}
+	}
+
+	int nameQueueId; //names are not registered as parameters, so it is not used
+	if (objectName)
+	{
+		//Push the object name direcly on the Byte parameter queue (or on the payload queue), but without registering it as a parameter
+		int objectNameLength = strlen(objectName);
+		memcpy(PushParamSpace<uint8>(objectNameLength, nameQueueId), objectName, objectNameLength);
+
+		//We mark we are using "GameObject.Find" instead of a usual receiver id by setting the negative object name length as the receiver id
+		receiverId = -objectNameLength;
+	}
+
+	if (methodName)
+	{
+		//Push the method name direcly on the Byte parameter queue, but without registering it as a parameter
+		int methodNameLength = strlen(methodName);
+		memcpy(PushParamSpace<uint8>(methodNameLength, nameQueueId), methodName, methodNameLength);
+
+		//We mark we are using reflection instead of a usual message id by setting the negative method name length as the message id
+		msgId = -methodNameLength;
+	}
+
+	if (componentId != -1)
+		m_pControlQueue->SendMessage(receiverId, componentId, msgId);
+	else
+		m_pControlQueue->SendMessage(receiverId, msgId);
+}
+
+int UnityMessager::GetRoutingBindingId(int componentId, const char* objectName, const char* methodName)
+{
+	ASSERT(componentId >= 0); //only component messages can be name based
+
+	//a single pass over the names, each one ended by a separator that also tells if it was given (NULL names are not the same as "")
+	uint64 hash = (UM_FNV_OFFSET_BASIS ^ (uint32)componentId) * UM_FNV_PRIME;
+	const char* names[] = { objectName, methodName };
+	for (int i = 0; i < 2; ++i)
+	{
+		for (const char* pChar = names[i]; pChar && *pChar; ++pChar)
+			hash = (hash ^ (uint8)*pChar) * UM_FNV_PRIME;
+
+		hash = (hash ^ (names[i] ? 0x100 : 0x200)) * UM_FNV_PRIME;
+	}
+
+	std::unordered_map<uint64, int>::iterator it = m_routingBindingIdxs.find(hash);
+	if (it != m_routingBindingIdxs.end())
+	{
+		const RoutingBinding& binding = m_routingBindings[it->second];
+		bool matches = binding.componentId == componentId
+			&& (objectName ? binding.objectName == objectName : binding.objectName.empty())
+			&& (methodName ? binding.methodName == methodName : binding.methodName.empty());
+
+		return matches ? it->second : -1; //a collision just keeps sending the names for this one
+	}
+
+	//empty names are never looked for, so they just mean the binding does not replace the receiverId or the msgId
+	RoutingBinding binding;
+	binding.componentId = componentId;
+	binding.objectName = objectName ? objectName : "";
+	binding.methodName = methodName ? methodName : "";
+	if ((objectName && binding.objectName.empty()) || (methodName && binding.methodName.empty()))
+		return -1;
+
+	int bindingId = (int)m_routingBindings.size();
+	m_routingBindings.push_back(binding);
+	m_routingBindingIdxs[hash] = bindingId;
+
+	//a regular message, delivered before the message being started right after this one
+	SendMessage(UMR_MESSAGER, UMM_REGISTER_ROUTING_BINDING, bindingId, componentId, 
+				binding.objectName.c_str(), binding.methodName.c_str());
+	return bindingId;
+}
+
+UnityMessager::CoalescedMessage* UnityMessager::FindCoalescedMessage(int receiverId, int msgId)
+{
+	std::unordered_map<uint64, int>::iterator it = m_coalescedMessageIdxs.find(((uint64)(uint32)receiverId << 32) | (uint32)msgId);
+	return it != m_coalescedMessageIdxs.end() ? &m_coalescedMessages[it->second] : NULL;
+}
+
+void UnityMessager::StartCoalescedMessage(int receiverId, int msgId, int nOfParams, CoalescedMessage* pPreviousMessage)
+{
+	CountSentMessage(receiverId, -1, msgId);
+
+	CoalescedMessage coalescedMessage;
+	coalescedMessage.pControlRecord = m_pControlQueue->SendMessage(receiverId, msgId);
+	coalescedMessage.firstParamIdx = (int)m_coalescedParams.size();
+	coalescedMessage.nOfParams = nOfParams;
+
+	if (pPreviousMessage)
+	{
+		//The previous message gets addressed to the C# UnityMessager itself, which just ignores it. Its number of parameters
+		//is kept, so its parameters get skipped as it happens to any message not reading all of them.
+		m_pControlQueue->DiscardMessage(pPreviousMessage->pControlRecord);
+		*pPreviousMessage = coalescedMessage;
+	}
+	else
+	{
+		m_coalescedMessageIdxs[((uint64)(uint32)receiverId << 32) | (uint32)msgId] = (int)m_coalescedMessages.size();
+		m_coalescedMessages.push_back(coalescedMessage);
+	}
+}
+
+void UnityMessager::BindProducerThread(int producerIndex)
+{
+	ASSERT(!IsOnMainThread()); //the main thread always writes directly to the shared queues
+	std::lock_guard<std::mutex> lock(m_stagingQueuesMutex);
+
+	StagingQueue*& pStagingQueue = m_stagingQueues[producerIndex];
+	if (pStagingQueue == NULL)
+		pStagingQueue = new StagingQueue(&m_hasStagedMessages);
+
+	s_pThreadStagingQueues[m_channelId] = pStagingQueue;
+	s_threadStagingQueueSerials[m_channelId] = m_instanceSerial;
+}
+
+UnityMessager::StagingQueue& UnityMessager::GetStagingQueueForThisThread()
+{
+	//the cached staging queue may come from a previous UnityMessager instance (previous game execution on the editor)
+	if (s_pThreadStagingQueues[m_channelId] == NULL || s_threadStagingQueueSerials[m_channelId] != m_instanceSerial)
+	{
+		int producerIndex;
+		{
+			std::lock_guard<std::mutex> lock(m_stagingQueuesMutex);
+			producerIndex = ++m_lastAutoProducerIndex;
+		}
+
+		BindProducerThread(producerIndex);
+	}
+
+	return *s_pThreadStagingQueues[m_channelId];
+}
+
+void UnityMessager::MergeStagingQueues()
+{
+	std::lock_guard<std::mutex> lock(m_stagingQueuesMutex);
+
+	//reset before merging, so a message staged while merging sets it again and is surely delivered in the next time
+	m_hasStagedMessages.store(false, std::memory_order_release);
+
+	//std::map iterates by key order, so the producer index defines the merge order
+	for (std::map<int, StagingQueue*>::iterator it = m_stagingQueues.begin(); it != m_stagingQueues.end(); ++it)
+		it->second->MergeInto(*this);
 }
 
 void UnityMessager::RegisterNewComponent(const char* componentTypeName, int* componentIdStaticPtr)
 {
 	*componentIdStaticPtr = ++m_lastAssignedComponentId;
-	ASSERT(m_lastAssignedComponentId < UM_MAX_N_OF_COMPONENTS);
+	m_staticComponentIdsToResetPtrs.Grow(m_lastAssignedComponentId + 1);
 
 	SendMessage(0, UMM_REGISTER_NEW_COMPONENT, m_lastAssignedComponentId, componentTypeName);
 	
@@ -144,16 +732,134 @@ void UnityMessager::RegisterNewComponent(const char* componentTypeName, int* com
 	m_staticComponentIdsToResetPtrs[m_lastAssignedComponentId] = componentIdStaticPtr;
 }
 
+int UnityMessager::RegisterPayloadType(const char* managedTypeName, int size, int alignment, int* payloadTypeIdStaticPtr)
+{
+	*payloadTypeIdStaticPtr = ++m_lastAssignedPayloadTypeId;
+	m_payloadTypes.Grow(m_lastAssignedPayloadTypeId + 1);
+
+	PayloadTypeInfo& payloadType = m_payloadTypes[m_lastAssignedPayloadTypeId];
+	payloadType.managedTypeName = managedTypeName;
+	payloadType.size = size;
+	payloadType.alignment = alignment;
+
+	//store the static variable address to we can reset it when UnityMessager instance is destroyed
+	payloadType.staticIdToResetPtr = payloadTypeIdStaticPtr;
+
+	int nameLength = strlen(managedTypeName);
+	int nOfNameParams = (nameLength + 3) / 4;
+	ASSERT(UM_REGISTER_PAYLOAD_TYPE_BASE_N_OF_PARAMS + nOfNameParams <= UM_MAX_N_OF_CONTROL_MESSAGE_PARAMS);
+
+	int params[UM_MAX_N_OF_CONTROL_MESSAGE_PARAMS] = { m_lastAssignedPayloadTypeId, alignment, nameLength };
+	PackChars(managedTypeName, nameLength, params + UM_REGISTER_PAYLOAD_TYPE_BASE_N_OF_PARAMS);
+
+	m_pControlQueue->SendControlMessage(UMM_REGISTER_PAYLOAD_TYPE, UM_REGISTER_PAYLOAD_TYPE_BASE_N_OF_PARAMS + nOfNameParams, params);
+
+	return m_lastAssignedPayloadTypeId;
+}
+
+int UnityMessager::InternString(const InternedString& stringParam)
+{
+	const char* str = stringParam.m_str;
+	int length = stringParam.m_length;
+
+	if (m_internedStringQueueId < 0)
+	{	//the C# side needs to know which parameters are interned strings
+		m_internedStringQueueId = GetParamQueueId<InternedStringRef>();
+		m_pControlQueue->SendControlMessage(UMM_SET_INTERNED_STRING_QUEUE, 1, &m_internedStringQueueId);
+	}
+
+	uint64 hash = UM_FNV_OFFSET_BASIS;
+	for (int i = 0; i < length; ++i)
+		hash = (hash ^ (uint8)str[i]) * UM_FNV_PRIME;
+
+	int id;
+	std::unordered_map<uint64, int>::iterator it = m_internedStringIdxs.find(hash);
+	if (it != m_internedStringIdxs.end())
+	{
+		id = it->second;
+		InternedStringSlot& slot = m_internedStrings[id];
+		if (slot.str.size() == (size_t)length && memcmp(slot.str.data(), str, length) == 0)
+		{
+			slot.isReferenced = true;
+			slot.lastMessageSerial = m_messageSerial;
+			stringParam.m_cachedId = id;
+			stringParam.m_cachedStamp = slot.stamp;
+			return id;
+		}
+		//else it is a hash collision, the slot just gets the new string, being its previous string registered again when used
+	}
+	else if ((int)m_internedStrings.size() < UM_MAX_N_OF_INTERNED_STRINGS)
+	{
+		id = (int)m_internedStrings.size();
+		m_internedStrings.push_back(InternedStringSlot());
+	}
+	else
+	{	//CLOCK eviction: the strings used since the last time the hand has passed by them get a second chance
+		for (;;)
+		{
+			int candidateId = m_internedStringsClockHand;
+			InternedStringSlot& candidate = m_internedStrings[candidateId];
+			m_internedStringsClockHand = (m_internedStringsClockHand + 1) % UM_MAX_N_OF_INTERNED_STRINGS;
+
+			if (candidate.lastMessageSerial == m_messageSerial) //its id was already pushed by the message being sent
+				continue;
+
+			if (!candidate.isReferenced)
+			{
+				id = candidateId;
+				break;
+			}
+
+			candidate.isReferenced = false;
+		}
+
+		m_internedStringIdxs.erase(m_internedStrings[id].hash);
+	}
+
+	m_internedStringIdxs[hash] = id;
+
+	InternedStringSlot& slot = m_internedStrings[id];
+	slot.str.assign(str, length);
+	slot.hash = hash;
+	slot.stamp = ++f_lastInternedStringStamp;
+	slot.isReferenced = true;
+	slot.lastMessageSerial = m_messageSerial;
+
+	stringParam.m_cachedId = id;
+	stringParam.m_cachedStamp = slot.stamp;
+
+	//control messages, so they can come in the middle of the message. Messages read before them still get the previous string.
+	int params[UM_MAX_N_OF_CONTROL_MESSAGE_PARAMS];
+	int offset = 0;
+	do
+	{
+		int chunkLength = length - offset < UM_REGISTER_INTERNED_STRING_MAX_CHUNK_LENGTH ? 
+						  length - offset : UM_REGISTER_INTERNED_STRING_MAX_CHUNK_LENGTH;
+
+		params[0] = id;
+		params[1] = length;
+		params[2] = offset;
+		PackChars(str + offset, chunkLength, params + UM_REGISTER_INTERNED_STRING_BASE_N_OF_PARAMS);
+
+		m_pControlQueue->SendControlMessage(UMM_REGISTER_INTERNED_STRING, 
+											UM_REGISTER_INTERNED_STRING_BASE_N_OF_PARAMS + (chunkLength + 3) / 4, params);
+		offset += chunkLength;
+	} while (offset < length);
+
+	return id;
+}
+
 void UnityMessager::RegisterMessageQueue(int queueId, MessageQueueBase* pMsgQueue)
 {
 	if (queueId == UM_CONTROL_QUEUE_ID)
 		return;
 
-	ASSERT(queueId < UM_MAX_N_OF_MESSAGE_QUEUES);
-	m_messageQueuesPtrs[queueId] = pMsgQueue;
+	m_messageQueues.Grow(queueId + 1);
+	m_messageQueues[queueId] = pMsgQueue;
 
-	int params[] = { queueId, pMsgQueue->GetFirstArrayId() };
-	m_pControlQueue->SendControlMessage(UMM_SET_QUEUE_FIRST_ARRAY, 2, params);
+	int params[] = { queueId, pMsgQueue->GetFirstArrayId(), pMsgQueue->GetSecondFirstArrayId() };
+	m_pControlQueue->SendControlMessage(UMM_SET_QUEUE_FIRST_ARRAY, 
+										m_isDoubleBuffered ? UM_SET_QUEUE_FIRST_ARRAY_DOUBLE_BUFFERED_N_OF_PARAMS : 2, params);
 }
 
 void UnityMessager::ReleasePossibleQueueArrays()
@@ -165,17 +871,72 @@ void UnityMessager::ReleasePossibleQueueArrays()
 	}
 
 	for (int i = 0; i <= m_lastAssignedQueueId; ++i)
-		m_messageQueuesPtrs[i]->ReleaseArraysExceptFirst();
+		m_messageQueues[i]->ReleaseArraysExceptFirst();
+
+	if (m_pInbox)
+		m_pInbox->ReleaseArraysExceptFirst();
+}
+
+UnityMessagerInbox& UnityMessager::GetInbox()
+{
+	ASSERT(IsOnMainThread());
+	if (m_pInbox == NULL)
+		m_pInbox = new UnityMessagerInbox(m_maxQueueArraysSizeInBytes);
+
+	return *m_pInbox;
+}
+
+UnityMessagerRing& UnityMessager::GetRing(int capacityInBytes)
+{
+	ASSERT(IsOnMainThread());
+	if (m_pRing == NULL)
+		m_pRing = new UnityMessagerRing(capacityInBytes > 0 ? capacityInBytes : UMR_DEFAULT_CAPACITY_IN_BYTES);
+
+	return *m_pRing;
 }
 
-UnityMessager::ControlQueue::ControlQueue()
-	: MessageQueue<int>(), m_pCurrentNOfParams(NULL), isAdvancingToNextNode(false)
+UnityMessager::ControlQueue::ControlQueue(UnityMessager& unityMessager, bool isCompact)
+	: MessageQueue<int>(unityMessager), m_pCurrentNOfParams(NULL), m_pCurrentCompactNOfParams(NULL), isAdvancingToNextNode(false),
+	m_isCompact(isCompact), m_lastReceiverId(0), m_hasLastReceiverId(false)
 {
 	m_pCurrentNode->unityArray[0] = UM_EMPTY_CONTROL_QUEUE_CODE;
+	if (m_pSecondFirstNode)
+		m_pSecondFirstNode->unityArray[0] = UM_EMPTY_CONTROL_QUEUE_CODE;
+}
+
+void UnityMessager::ControlQueue::Reset()
+{
+	//the compact format position is in bytes, while the base Reset measures the usage in ints before reseting it
+	if (m_isCompact)
+		m_currentArrayPos = (m_currentArrayPos + sizeof(int) - 1) / sizeof(int);
+
+	MessageQueue<int>::Reset();
+	m_hasLastReceiverId = false;
+}
+
+void UnityMessager::ControlQueue::DiscardMessage(void* pMessage)
+{
+	if (m_isCompact)
+	{	//the tag flag keeps the record length, so the receiver id is still valid for a next UM_COMPACT_TAG_SAME_RECEIVER message
+		*reinterpret_cast<uint8*>(pMessage) |= UM_COMPACT_TAG_DISCARDED;
+		return;
+	}
+
+	int* controlQueueRef = reinterpret_cast<int*>(pMessage);
+	controlQueueRef[0] = UMR_MESSAGER;
+	controlQueueRef[1] = UMM_DISCARDED_MESSAGE;
 }
 
 void UnityMessager::ControlQueue::SendControlMessage(int msgId, int nOfParams, const int* intParams)
 {
+	m_unityMessager.AddToStatistic(UM_STATISTIC_N_OF_CONTROL_MESSAGES, 1);
+
+	if (m_isCompact)
+	{
+		SendCompactControlMessage(msgId, nOfParams, intParams);
+		return;
+	}
+
 	int* controlQueueRef = AllocSpace(UM_MESSAGE_BASE_LENGTH + nOfParams);
 	controlQueueRef[0] = UMR_MESSAGER; //(0)
 	controlQueueRef[1] = msgId;
@@ -186,6 +947,20 @@ void UnityMessager::ControlQueue::SendControlMessage(int msgId, int nOfParams, c
 		controlQueueRef[3 + i] = intParams[i];
 }
 
+void UnityMessager::ControlQueue::SendCompactControlMessage(int msgId, int nOfParams, const int* intParams)
+{
+	uint8* pDest = AllocCompactSpace(UM_COMPACT_MAX_CONTROL_MESSAGE_LENGTH(nOfParams));
+	*(pDest++) = UM_COMPACT_CONTROL_MESSAGE_TAG;
+	pDest = UnityMessagerCompact::WriteVarint(pDest, (uint32)msgId);
+	pDest = UnityMessagerCompact::WriteVarint(pDest, (uint32)nOfParams);
+
+	//control messages only have not negative int parameters (queue and array ids)
+	for (int i = 0; i < nOfParams; ++i)
+		pDest = UnityMessagerCompact::WriteVarint(pDest, (uint32)intParams[i]);
+
+	CommitCompactSpace(pDest);
+}
+
 inline bool UnityMessager::ControlQueue::IsThereAnyMessageToDeliver()
 {
 	return m_pFirstNode->unityArray[0] != UM_EMPTY_CONTROL_QUEUE_CODE;
@@ -205,8 +980,128 @@ void UnityMessager::ControlQueue::AdvanceToNextUnityArrayNode()
 }
 
 
-} //UnityForCpp
+UnityMessager::StagingQueue::StagingQueue(std::atomic<bool>* pHasStagedMessagesFlag)
+	: m_messages(), m_params(), m_dataBlocks(), m_dataBlockSizes(), m_currentDataBlockIdx(0), m_currentDataBlockPos(0), 
+	m_mutex(), m_pHasStagedMessagesFlag(pHasStagedMessagesFlag)
+{
+}
 
+UnityMessager::StagingQueue::~StagingQueue()
+{
+	for (size_t i = 0; i < m_dataBlocks.size(); ++i)
+		delete[] m_dataBlocks[i];
+}
+
+void* UnityMessager::StagingQueue::AllocData(int size)
+{
+	size = (size + UM_STAGING_DATA_ALIGNMENT - 1) & ~(UM_STAGING_DATA_ALIGNMENT - 1);
+
+	//look for the next block having enough space, data blocks are never moved once allocated
+	while (m_currentDataBlockIdx < (int)m_dataBlocks.size() 
+			&& m_currentDataBlockPos + size > m_dataBlockSizes[m_currentDataBlockIdx])
+	{
+		++m_currentDataBlockIdx;
+		m_currentDataBlockPos = 0;
+	}
+
+	if (m_currentDataBlockIdx == (int)m_dataBlocks.size())
+	{
+		int blockSize = size > UM_STAGING_DATA_BLOCK_SIZE ? size : UM_STAGING_DATA_BLOCK_SIZE;
+		m_dataBlocks.push_back(new uint8[blockSize]);
+		m_dataBlockSizes.push_back(blockSize);
+	}
+
+	m_currentDataBlockPos += size;
+	return m_dataBlocks[m_currentDataBlockIdx] + m_currentDataBlockPos - size;
+}
+
+const char* UnityMessager::StagingQueue::CopyString(const char* str)
+{
+	int size = strlen(str) + 1;
+	char* strCopy = reinterpret_cast<char*>(AllocData(size));
+	memcpy(strCopy, str, size);
+
+	return strCopy;
+}
 
+void UnityMessager::StagingQueue::MergeInto(UnityMessager& unityMessager)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (size_t i = 0; i < m_messages.size(); ++i)
+	{
+		const StagedMessage& stagedMessage = m_messages[i];
+		if (stagedMessage.isCoalesced)
+		{
+			MergeCoalescedMessage(unityMessager, stagedMessage);
+			continue;
+		}
 
+		//registering a new component sends a message, so it MUST COME BEFORE starting the staged message
+		int componentId = stagedMessage.componentIdGetterFcPtr ? stagedMessage.componentIdGetterFcPtr(unityMessager.m_channelId) : -1;
+		unityMessager.StartMessage(stagedMessage.receiverId, componentId, stagedMessage.msgId,
+								   stagedMessage.objectName, stagedMessage.methodName);
 
+		for (int j = stagedMessage.firstParamIdx; j < stagedMessage.firstParamIdx + stagedMessage.nOfParams; ++j)
+			m_params[j].replayFcPtr(unityMessager, m_params[j].pData, m_params[j].length, -1, RM_PUSH);
+
+		//a batch message has its msgId and its receiver ids as the first parameters, check SendBatchMessage
+		if (stagedMessage.receiverId == UMR_MESSAGER && stagedMessage.msgId == UMM_BATCH_MESSAGE)
+		{
+			const StagedParam* pParams = &m_params[stagedMessage.firstParamIdx];
+			unityMessager.CountBatchMessages(*reinterpret_cast<const int*>(pParams[0].pData), pParams[1].length);
+		}
+	}
+
+	m_messages.clear();
+	m_params.clear();
+
+	//blocks bigger than usual are only kept until the merge, so a single big parameter doesn't keep the memory forever
+	size_t nOfKeptBlocks = 0;
+	for (size_t i = 0; i < m_dataBlocks.size(); ++i)
+	{
+		if (m_dataBlockSizes[i] > UM_STAGING_DATA_BLOCK_SIZE)
+			delete[] m_dataBlocks[i];
+		else
+		{
+			m_dataBlocks[nOfKeptBlocks] = m_dataBlocks[i];
+			m_dataBlockSizes[nOfKeptBlocks++] = m_dataBlockSizes[i];
+		}
+	}
+
+	m_dataBlocks.resize(nOfKeptBlocks);
+	m_dataBlockSizes.resize(nOfKeptBlocks);
+	m_currentDataBlockIdx = 0;
+	m_currentDataBlockPos = 0;
+}
+
+void UnityMessager::StagingQueue::MergeCoalescedMessage(UnityMessager& unityMessager, const StagedMessage& stagedMessage)
+{
+	//same steps of UnityMessager::SendCoalescedMessage, but for parameters known only at runtime
+	CoalescedMessage* pPreviousMessage = unityMessager.FindCoalescedMessage(stagedMessage.receiverId, stagedMessage.msgId);
+	bool canOverwrite = pPreviousMessage && pPreviousMessage->nOfParams == stagedMessage.nOfParams;
+	for (int j = 0; canOverwrite && j < stagedMessage.nOfParams; ++j)
+	{
+		const StagedParam& stagedParam = m_params[stagedMessage.firstParamIdx + j];
+		canOverwrite = stagedParam.replayFcPtr(unityMessager, stagedParam.pData, stagedParam.length, 
+											   pPreviousMessage->firstParamIdx + j, RM_MATCH_COALESCED);
+	}
+
+	if (canOverwrite)
+	{
+		for (int j = 0; j < stagedMessage.nOfParams; ++j)
+		{
+			const StagedParam& stagedParam = m_params[stagedMessage.firstParamIdx + j];
+			stagedParam.replayFcPtr(unityMessager, stagedParam.pData, stagedParam.length, 
+									pPreviousMessage->firstParamIdx + j, RM_OVERWRITE_COALESCED);
+		}
+
+		return;
+	}
+
+	unityMessager.StartCoalescedMessage(stagedMessage.receiverId, stagedMessage.msgId, stagedMessage.nOfParams, pPreviousMessage);
+	for (int j = stagedMessage.firstParamIdx; j < stagedMessage.firstParamIdx + stagedMessage.nOfParams; ++j)
+		m_params[j].replayFcPtr(unityMessager, m_params[j].pData, m_params[j].length, -1, RM_PUSH_COALESCED);
+}
+
+} //UnityForCpp
@@ -6,11 +6,25 @@
 
 #include "Shared.h"
 #include "UnityArray.h"
-
-//Alternative access point to the UnityMessager singleton instance.
+#include "UnityMessagerTrace.h"
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string.h>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+//Alternative access point to the UnityMessager instance of the default channel.
 //
 #define UNITY_MESSAGER UnityForCpp::UnityMessager::GetInstance()
 
+//Alternative access point to the UnityMessager instance of a given channel, check UnityMessager::GetInstance.
+//
+#define UNITY_MESSAGER_CHANNEL(channelId) UnityForCpp::UnityMessager::GetInstance(channelId)
+
 //Declare an Unity Game Object component, the EXACT NAME of the script file/type on C# MUST BE used. You need to declare your component 
 //before using SendMessage<componentName>(receiverId, msgId, params...). Check UM_DECLARE_COMPONENT_AS for additional details.
 //
@@ -28,36 +42,168 @@
 //
 #define UM_CREATE_ARRAY_TO_FILL_PARAM(type, length) UnityForCpp::UnityMessager::ArrayToFillParam<type>::CreateArrayToFill(length);
 
+//Use this DIRECTLY on the parameter list when calling SendMessage in order to pass a whole UnityArray as array parameter without 
+//copying its items, check UnityMessager::UnityArrayParam. UM_UNITY_ARRAY_RANGE_PARAM does the same for a range of its items.
+//
+#define UM_UNITY_ARRAY_PARAM(unityArray) UM_UNITY_ARRAY_RANGE_PARAM(unityArray, 0, (unityArray).GetLength())
+#define UM_UNITY_ARRAY_RANGE_PARAM(unityArray, offset, length) UnityForCpp::UnityMessager::MakeUnityArrayParam(unityArray, offset, length)
+
+//Use this to DIRECTLY on the parameter list when calling SendMessage in order to pass a string literal as an interned string,
+//so its length is known at compile time. Check UnityMessager::InternedString for the details.
+//
+#define UM_INTERNED_STRING_LITERAL(literal) UnityForCpp::UnityMessager::InternedString(literal, sizeof(literal) - 1)
+
+//Flags that may be combined for the initFlags parameter of UnityMessager::InstanceAndProvideAwakeInfo, they are set by the C#
+//UnityMessager instance accordingly to its inspector settings, which MUST BE KEPT IN SYNCH with the values defined here.
+//
+//Each message queue keeps two sets of arrays, the C# side reads one of them while the C++ side writes to the other.
+#define UM_INIT_FLAG_DOUBLE_BUFFERED 1
+//The control queue uses the variable length format described at UnityMessagerCompact.h instead of an int per value.
+#define UM_INIT_FLAG_COMPACT_CONTROL_QUEUE 2
+//All the parameters of a message are packed together (aligned) into a single byte queue instead of a ParamQueue per type.
+#define UM_INIT_FLAG_INTERLEAVED_PARAMS 4
+//Statistics about the messages sent are collected for each delivering and published on a shared array, check UnityMessager::GetStatistic.
+#define UM_INIT_FLAG_STATISTICS 8
+
+//Positions of the statistics array published at each delivering (check UnityMessager::GetStatistic), which MUST BE KEPT IN SYNCH 
+//with the UnityMessager.Statistic constants on C#. All the values are for the messages sent since the previous delivering.
+//
+//Number of deliverings the statistics were published for, so the C# side knows when they are from a new delivering
+#define UM_STATISTIC_DELIVERING_SERIAL 0
+//Messages sent, the ones addressed to the C# UnityMessager itself excluded. A batch message (check SendBatchMessage) counts as
+//a message for each one of its receivers, under its msgId for the UM_STATISTIC_FIRST_TOP_MSG_ID pairs as well.
+#define UM_STATISTIC_N_OF_MESSAGES 1
+//Messages addressed to the C# UnityMessager itself, the control messages and the batch messages themselves included
+#define UM_STATISTIC_N_OF_CONTROL_MESSAGES 2
+//Advances of the message queues to their next arrays (each one sends a UMM_SET_QUEUE_ARRAY control message)
+#define UM_STATISTIC_N_OF_ARRAY_ADVANCES 3
+//Arrays allocated by these advances, so the queues didn't have the capacity they needed (check MessageQueue::AdjustCapacity)
+#define UM_STATISTIC_N_OF_ARRAY_ALLOCS 4
+//Array parameters bigger than their queue arrays, each one written to a spill array, and the spill arrays allocated for them
+#define UM_STATISTIC_N_OF_SPILLED_PARAMS 5
+#define UM_STATISTIC_N_OF_SPILL_ARRAY_ALLOCS 6
+//(queueId, bytes) pairs for the message queues with more bytes written, in descending order, the unused ends of their arrays
+//and their spill arrays included. The control queue is the queue 0 and, when interleaved, the payload queue is the queue 1.
+//Unused pairs are (-1, 0).
+#define UM_STATISTIC_FIRST_TOP_QUEUE 8
+#define UM_STATISTIC_N_OF_TOP_QUEUES 16
+//(msgId, number of messages) pairs for the message ids with more messages sent, in descending order. Unused pairs are (-1, 0).
+#define UM_STATISTIC_FIRST_TOP_MSG_ID (UM_STATISTIC_FIRST_TOP_QUEUE + 2 * UM_STATISTIC_N_OF_TOP_QUEUES)
+#define UM_STATISTIC_N_OF_TOP_MSG_IDS 8
+#define UM_STATISTICS_LENGTH (UM_STATISTIC_FIRST_TOP_MSG_ID + 2 * UM_STATISTIC_N_OF_TOP_MSG_IDS)
+
+//Channel of the UnityMessager instance used by UNITY_MESSAGER and by the methods taking an optional channelId
+#define UM_DEFAULT_CHANNEL 0
+
+//Maximum number of channels, each one being an independent UnityMessager instance, check UnityMessager::GetInstance.
+//It corresponds to UnityMessager._maxNOfChannels on C#, so once you update this value here be sure to update there too.
+#define UM_MAX_N_OF_CHANNELS 8
+
+//Initial value of the static arrays keeping an id per channel (component and payload type ids), a -1 for each channel,
+//so it MUST have UM_MAX_N_OF_CHANNELS values, which is checked on UnityMessager.cpp.
+#define UM_UNREGISTERED_CHANNEL_IDS { -1, -1, -1, -1, -1, -1, -1, -1 }
+
+//Receiver ids are handles made of the index of their slot on the receiver ids table (the low bits) and of the generation of the
+//slot (the high bits, never reaching the sign bit), which is incremented each time an id of the slot is released, so a released
+//id is never equal to the ids given for its slot after that (until the generation wraps). The table grows by chunks of slots,
+//so the ids given before stay valid, up to UM_MAX_N_OF_RECEIVER_IDS. Check UnityMessager::NewReceiverId for the details.
+//They correspond to the UnityMessager._receiverId* constants on C#, so once you update these values here be sure to update there too.
+#define UM_RECEIVER_ID_INDEX_BITS 20
+#define UM_RECEIVER_ID_INDEX_MASK ((1 << UM_RECEIVER_ID_INDEX_BITS) - 1)
+#define UM_RECEIVER_ID_GENERATION_MASK ((1 << (31 - UM_RECEIVER_ID_INDEX_BITS)) - 1)
+#define UM_RECEIVER_ID_INDEX(receiverId) ((receiverId) & UM_RECEIVER_ID_INDEX_MASK)
+#define UM_MAX_N_OF_RECEIVER_IDS (UM_RECEIVER_ID_INDEX_MASK + 1)
+#define UM_RECEIVER_IDS_CHUNK_LENGTH 1024
+#define UM_MAX_N_OF_RECEIVER_ID_CHUNKS (UM_MAX_N_OF_RECEIVER_IDS / UM_RECEIVER_IDS_CHUNK_LENGTH)
+
+//Layout of the receiver ids table, shared with the C# side (check UMM_SET_RECEIVER_IDS_ARRAY). Its header is an int64 array:
+//- UM_RECEIVER_IDS_HEAD_POS is the head of the free slots list, (int32 tag << 32) | index of the first free slot, being 0 an
+//empty list (the slot 0 is the UMR_MESSAGER one, never free). The tag is incremented by each change, so the compare and swap
+//updating the head fails if the list has changed since it was read, even if the same index got back to the head.
+//- UM_RECEIVER_IDS_N_OF_FREE_POS is the number of free slots, UM_RECEIVER_IDS_N_OF_CHUNKS_POS the number of chunks,
+//and the array id of each chunk follows from UM_RECEIVER_IDS_FIRST_CHUNK_POS (-1 for the chunks not allocated yet).
+//Each chunk is an int array with (generation, next) for each one of its UM_RECEIVER_IDS_CHUNK_LENGTH slots, being next the index
+//of the next free slot on the list (0 for the last one), UM_RECEIVER_ID_IN_USE or UM_RECEIVER_ID_RELEASING. The latter is set
+//by a compare and swap from UM_RECEIVER_ID_IN_USE claiming the slot for a release, so only one of concurrent releases of the
+//same id (from any thread, on C++ or C#) bumps the generation and pushes the slot. All of them are accessed atomically.
+#define UM_RECEIVER_IDS_HEAD_POS 0
+#define UM_RECEIVER_IDS_N_OF_FREE_POS 1
+#define UM_RECEIVER_IDS_N_OF_CHUNKS_POS 2
+#define UM_RECEIVER_IDS_FIRST_CHUNK_POS 3
+#define UM_RECEIVER_IDS_HEADER_LENGTH (UM_RECEIVER_IDS_FIRST_CHUNK_POS + UM_MAX_N_OF_RECEIVER_ID_CHUNKS)
+#define UM_RECEIVER_ID_SLOT_LENGTH 2
+#define UM_RECEIVER_ID_SLOT_GENERATION 0
+#define UM_RECEIVER_ID_SLOT_NEXT 1
+#define UM_RECEIVER_ID_IN_USE -1
+#define UM_RECEIVER_ID_RELEASING -2
+
 namespace UnityForCpp
 {
 
+class UnityMessagerInbox; //foward declaration, check UnityMessagerInbox.h
+class UnityMessagerRing; //foward declaration, check UnityMessagerRing.h
+
 //This class allows messages to be sent from C++ to the C# side of Unity. It works together with the corresponding class on C#,
 //where you need to call UnityMessager.DeliverMessager to have these messages you sent delivered, otherwise they will be 
 //accumulated on the messages queues (which may become bigger and bigger).
+//There is an instance per channel, each one created by a C# UnityMessager instance set to the same channel. Channels are fully 
+//independent: each one has its own message queues, receiver ids, components and delivering call on C#, so the messages of
+//each channel may be delivered at its own rate or point of the frame (as UI, gameplay and low rate AI messages), and a burst
+//of messages on a channel doesn't delay the delivering of the other ones or grow their queues. The order of messages is only 
+//kept among the messages of a same channel.
 //
 class UnityMessager
 {
 public:
-	//Singleton access point. The UNITY_MESSAGER macro may be used instead for your convenience.
+	//Access point to the instance of a channel, the default channel when channelId is not given. The UNITY_MESSAGER and 
+	//UNITY_MESSAGER_CHANNEL macros may be used instead for your convenience.
 	//
-	static UnityMessager& GetInstance() { ASSERT(s_pInstance); return *s_pInstance; }
+	static UnityMessager& GetInstance(int channelId = UM_DEFAULT_CHANNEL) 
+	{ 
+		ASSERT(channelId >= 0 && channelId < UM_MAX_N_OF_CHANNELS && s_pInstances[channelId]); 
+		return *s_pInstances[channelId]; 
+	}
+
+	//Returns true if the instance of the channel exists, which happens once the C# UnityMessager of the channel gets awake
+	static bool HasInstance(int channelId) { return channelId >= 0 && channelId < UM_MAX_N_OF_CHANNELS && s_pInstances[channelId]; }
+
+	//Channel of this instance
+	int GetChannelId() const { return m_channelId; }
 
 	//Use this method when ordering the creation of a new receiver C# object from the C++ code. You usually will be sending
 	//this id as parameter to the "create" message, for which the receiver is the factory of this new receiver C# object, 
 	//which should be set as receiver bound to this passed id on the C# UnityMessager instance. This way you can send
 	//messages to the newly created receiver object *IMMEDIATELY* after the create message, EVEN knowing the C# instance of this
-	//new C# receiver instance doesn't exist yet, since the create message was not delivered yet. 
+	//new C# receiver instance doesn't exist yet, since the create message was not delivered yet.
+	//It may be called from any thread, taking the id from the free list shared with the C# side without locks. The table of ids
+	//grows by a chunk when the list gets empty on the main thread, and after the deliverings when the free ids are running out,
+	//but worker threads never grow it: they get -1 (logging an error) if there is no free id, check ReserveReceiverIds.
 	//
 	int NewReceiverId();
+
+	//Releases an id given by NewReceiverId (on C++ or C#), as the C# UnityMessager.ReleaseReceiverId, but keeping the C# object
+	//bound to it until a new id of its slot is set to another object. Messages already sent to the id are still delivered to that
+	//object, while messages sent to it after its slot got a new id are not (it is a stale id). It may be called from any thread,
+	//returning false (logging a warning) if the id is not in use, as for an id already released.
+	//
+	bool ReleaseReceiverId(int receiverId);
+
+	//Makes the table of receiver ids grow to have at least nOfIds free ids, so worker threads creating many receivers don't
+	//run out of them before the next delivering. It MUST BE called from the main thread.
+	//
+	void ReserveReceiverIds(int nOfIds);
 	
 	//Sends a message with any number of parameters to an specific C# object set as receiver for the receiverId (which may also be
 	//the default component set for a GameObject receiver). The message id (msgId) CANNOT be negative, except for that, it's totally   
 	//under your control for you to route received messages on your C# code. Any type supported by UnityArray is also supported here   
-	//(check UA_SUPPORTED_TYPE comments), as well as arrays of these types passed using an instance of the struct ArrayParam or 
-	//of the class ArrayToFillParam (check the comments of these). Also C strings are supported (char* or const char*), 
+	//(check UA_SUPPORTED_TYPE comments), as well as arrays of these types passed using an instance of the struct ArrayParam,  
+	//of the class ArrayToFillParam or of the struct UnityArrayParam (check the comments of these). Also C strings are supported (char* or const char*), 
 	//being packed to a byte array (uint8) that can be read as string when unpacking the message on the C# code.
 	//YOU CAN NEVER SEND NEW MESSAGES DURING THE MESSAGE DELIVERING PROCESS STARTED BY THE C# CODE, BE AWARE OF THAT
-	//FOR THE CASE YOUR C# MESSAGE HANDLE CODE INVOKES C++ CODE, SO YOU DON'T SEND MESSAGES THERE!
+	//FOR THE CASE YOUR C# MESSAGE HANDLE CODE INVOKES C++ CODE, SO YOU DON'T SEND MESSAGES THERE! The exception is when
+	//the UnityMessager is double buffered (check UM_INIT_FLAG_DOUBLE_BUFFERED), then messages sent during the delivering
+	//process are written to the other set of queue arrays, being delivered by the next C# DeliverMessages call.
+	//All the SendMessage versions may also be called from worker threads, check BindProducerThread for the details.
 	//
 	template<typename... PARAMS> void SendMessage(int receiverId, int msgId, const PARAMS&... params);
 
@@ -68,6 +214,9 @@ public:
 
 	//Version of SendMessage for component objects based on reflection, which locates the target GameObject with "GameObject.Find"
 	//and calls the target method using reflection. The number and types of the parameters must be exactly the same of the target method.
+	//The first message sent for a given (COMPONENT_TYPE, objectName, methodName) registers a routing binding, so the next ones carry 
+	//only the binding id and the C# side reuses the GameObject found (until it is destroyed) and the method info. The same is valid
+	//for the two SendMessage versions bellow.
 	//
 	template<typename COMPONENT_TYPE, typename... PARAMS> void SendMessage(const char* objectName, const char* methodName, const PARAMS&... params);
 
@@ -80,6 +229,65 @@ public:
 	//
 	template<typename COMPONENT_TYPE, typename... PARAMS> void SendMessage(const char* objectName, int msgId, const PARAMS&... params);
 
+	//Versions of the three name based SendMessage versions above taking the names by a NamedRoute, which caches its routing
+	//binding id, so sending it again costs as much as sending by a receiverId and msgId. The first one is for the routes 
+	//with an object name, the second one for the routes with only a method name. Check NamedRoute for the details.
+	//
+	class NamedRoute;
+	template<typename COMPONENT_TYPE, typename... PARAMS> void SendMessage(const NamedRoute& route, const PARAMS&... params);
+	template<typename COMPONENT_TYPE, typename... PARAMS> void SendMessage(int receiverId, const NamedRoute& methodRoute, const PARAMS&... params);
+
+	//Version of SendMessage for state updates, where only the last message sent with a given (receiverId, msgId) matters until
+	//the next delivering. Sending it again overwrites the parameters of the previous message in place, so the message keeps 
+	//the position of its first sending among the other messages, and the bytes written and messages delivered are bounded
+	//by the number of distinct (receiverId, msgId) pairs. If the parameter types or array lengths differ from the previous 
+	//ones, the previous message is discarded (the C# UnityMessager ignores it) and a new message is sent instead. 
+	//Messages sent by the other SendMessage versions are never coalesced.
+	//
+	template<typename... PARAMS> void SendCoalescedMessage(int receiverId, int msgId, const PARAMS&... params);
+
+	//Version of SendMessage for sending a same message to many receivers at once, each one getting its own parameter values.
+	//Each parameter is a column holding one item per receiver, passed as an ArrayParam, ArrayToFillParam or UnityArrayParam
+	//of length nOfReceivers, so the receiver receiverIds[i] gets the items at i as its single value parameters. The whole batch
+	//is written as a single message with the columns as array parameters, instead of a message per receiver, being delivered
+	//by the C# side calling ReceiveMessage for each receiver in order. Only C# object receivers (which may also be the default 
+	//component of GameObject receivers) can be addressed, and the parameters cannot be read as arrays or strings.
+	//
+	template<typename... PARAMS> void SendBatchMessage(const int* receiverIds, int nOfReceivers, int msgId, const PARAMS&... columns);
+
+	//Messages sent from any thread other than the main thread (the one initializing the UnityMessager) are not written to
+	//the shared message queues, but to a staging buffer owned by the producer the thread is bound to. When the C# side starts
+	//delivering messages the staging buffers are merged into the shared queues ordered by their producer index, so the final 
+	//order of the messages doesn't depend on thread scheduling. Call this from the worker thread before sending messages,
+	//threads never bound get a producer index on their first message, being merged after the explicitly bound producers.
+	//Worker threads MUST NOT fill ArrayToFillParam instances after the merge, so be done with them before delivering messages.
+	//
+	void BindProducerThread(int producerIndex);
+
+	//Returns a statistic (value of an UM_STATISTIC_* position) published by the last delivering, or 0 if the UnityMessager
+	//is not collecting statistics (check UM_INIT_FLAG_STATISTICS). They are published when the C# side starts delivering
+	//messages, being available on C# through UnityMessager.GetStatistic from then, without any extra call to the C++ side.
+	//
+	int64 GetStatistic(int statisticPos) const;
+
+	//Starts capturing the message stream to a trace file (check UnityMessagerTrace.h), which is created or overwritten. At each
+	//delivering the content of the message queues the C# side is about to read, the control messages included, is written to it
+	//as a frame. Tools/UnityMessagerTraceTool.cpp replays and analyzes the traces. Returns false if the file cannot be created.
+	//
+	bool StartCapture(const char* traceFilePath);
+
+	//Stops capturing, closing the trace file. Called by the destructor too, so the trace is complete when the game ends.
+	void StopCapture();
+
+	//Inbox of the messages sent from C# to C++ on this channel (check UnityMessagerInbox.h), which is created on the first call.
+	//Drain it at the start of your update, instead of exposing a plugin function per event the C# side reports.
+	UnityMessagerInbox& GetInbox();
+
+	//Ring of this channel for messages written by a C++ thread while a C# thread reads them (check UnityMessagerRing.h), created
+	//on the first call with capacityInBytes (UMR_DEFAULT_CAPACITY_IN_BYTES if it is 0), which is ignored by the next calls. Call it
+	//on the main thread, then hand the ring to your producer thread. It is kept until the UnityMessager is destroyed.
+	UnityMessagerRing& GetRing(int capacityInBytes = 0);
+
 	//Simple struct for used to push array parameters by wrapping a C array pointer together with its length in a single
 	//parameter. Uses the macro UM_ARRAY_PARAM for instancing it directly when passing the parameters to SendMessage. 
 	//
@@ -128,6 +336,104 @@ public:
 		friend class UnityMessager;
 	};
 
+	//Array parameter referencing a range of an existing UnityArray, being only the array id, offset and length sent to the C# side,
+	//where the receiver reads the items directly from the shared array. Since the items are read when the message is delivered,
+	//changes made to them before that are seen by the receiver. The UnityArray may be released before the delivering, the shared 
+	//array is kept alive until then (check UnityAdapter::RetainManagedArray). Use the macros UM_UNITY_ARRAY_PARAM and 
+	//UM_UNITY_ARRAY_RANGE_PARAM for passing it. The items are copied as an ArrayParam when sent from worker threads or by
+	//SendCoalescedMessage, since these messages are written to the queues (or overwritten) later.
+	//
+	template <typename T> struct UnityArrayParam
+	{
+		const UnityArray<T>* pUnityArray;
+		int offset;
+		int length;
+
+		//*USE* the macros UM_UNITY_ARRAY_PARAM or UM_UNITY_ARRAY_RANGE_PARAM instead for your convenience.
+		UnityArrayParam(const UnityArray<T>& unityArray, int rangeOffset, int rangeLength)
+			: pUnityArray(&unityArray), offset(rangeOffset), length(rangeLength) 
+		{
+			ASSERT(unityArray.GetId() >= 0 && offset >= 0 && length >= 0 && offset + length <= unityArray.GetLength());
+		}
+
+		ArrayParam<T> AsArrayParam() const { return ArrayParam<T>(pUnityArray->GetPtr() + offset, length); }
+	};
+
+	//Deduces T for the UnityArrayParam, use the macros UM_UNITY_ARRAY_PARAM or UM_UNITY_ARRAY_RANGE_PARAM instead
+	template <typename T> static UnityArrayParam<T> MakeUnityArrayParam(const UnityArray<T>& unityArray, int offset, int length)
+	{
+		return UnityArrayParam<T>(unityArray, offset, length);
+	}
+
+	//String parameter sent through the interned strings table: the first time a given string is sent it gets an id and its
+	//chars are sent to the C# side, the next times only the id is sent and the C# side reuses the same managed string, so
+	//it is read by ReadNextParamAsStringAndAdvance without allocating. Use it for strings sent repeatedly, as UI labels or
+	//log categories. The table is bounded, keeping the UM_MAX_N_OF_INTERNED_STRINGS most recently used strings.
+	//An instance kept by the user (a static one, for instance) also caches its id, so sending it again doesn't even
+	//look for the string on the table. Use the macro UM_INTERNED_STRING_LITERAL for passing string literals.
+	//Interned strings on coalesced messages are sent as regular strings, since these may be overwritten in place.
+	//
+	class InternedString
+	{
+	public:
+		explicit InternedString(const char* str)
+			: m_str(str), m_length((int)strlen(str)), m_cachedId(-1), m_cachedStamp(0) {}
+
+		//the length is given for avoiding strlen, when the string is a literal (check UM_INTERNED_STRING_LITERAL) or it is known
+		InternedString(const char* str, int length)
+			: m_str(str), m_length(length), m_cachedId(-1), m_cachedStamp(0) {}
+
+		const char* GetString() const { return m_str; }
+		int GetLength() const { return m_length; }
+
+	private:
+		const char* m_str;
+		int m_length;
+
+		//id of the string on the table, valid while the table slot keeps the same stamp. Mutable for the same reasons
+		//of ArrayToFillParam::m_pArray, it is only updated on the main thread.
+		mutable int m_cachedId;
+		mutable uint32 m_cachedStamp;
+
+		friend class UnityMessager;
+	};
+
+	//Names addressing a message to a component object by "GameObject.Find" and/or reflection, for the SendMessage versions
+	//taking a NamedRoute. An instance kept by the user (a static one, for instance) caches the id of its routing binding
+	//(check the SendMessage version taking objectName and methodName), so sending it again doesn't even hash the names. 
+	//The names are not copied, so they MUST outlive the instance, as string literals do.
+	//
+	class NamedRoute
+	{
+	public:
+		NamedRoute(const char* objectName, const char* methodName) : m_objectName(objectName), m_methodName(methodName), 
+			m_msgId(0), m_cachedBindingId(-1), m_cachedComponentId(-1), m_cachedInstanceSerial(0) {}
+
+		NamedRoute(const char* objectName, int msgId) : m_objectName(objectName), m_methodName(NULL), 
+			m_msgId(msgId), m_cachedBindingId(-1), m_cachedComponentId(-1), m_cachedInstanceSerial(0) {}
+
+		//route of the messages to a receiverId, check the SendMessage version taking receiverId and methodName
+		explicit NamedRoute(const char* methodName) : m_objectName(NULL), m_methodName(methodName), 
+			m_msgId(0), m_cachedBindingId(-1), m_cachedComponentId(-1), m_cachedInstanceSerial(0) {}
+
+		const char* GetObjectName() const { return m_objectName; }
+		const char* GetMethodName() const { return m_methodName; }
+		int GetMsgId() const { return m_msgId; }
+
+	private:
+		const char* m_objectName;
+		const char* m_methodName;
+		int m_msgId;
+
+		//binding id (-1 if the route has no binding) for the component id on the UnityMessager instance of the serial. Mutable
+		//for the same reasons of InternedString::m_cachedId, it is only updated on the main thread.
+		mutable int m_cachedBindingId;
+		mutable int m_cachedComponentId;
+		mutable uint32 m_cachedInstanceSerial;
+
+		friend class UnityMessager;
+	};
+
 	//base class for declaration of GameObject components, use the macro UM_DECLARE_COMPONENT for declaring new components 
 	//this is a static class based on static polymorphism, with the unique purpose of providing an unique id per component type.
 	//derived classes from Component<DerivedClass> must implement the static method GetManagedTypeName (see below)
@@ -135,19 +441,20 @@ public:
 	template <typename T> class Component
 	{
 	public:
-		//Returns an unique component id for the component, to be used internally by the UnityMessager 
-		static int GetId() { return s_id >= 0 ? s_id : GenerateSetAndGetComponentId(); }
+		//Returns an unique component id for the component on the channel, to be used internally by the UnityMessager 
+		static int GetId(int channelId) { return s_ids[channelId] >= 0 ? s_ids[channelId] : GenerateSetAndGetComponentId(channelId); }
 
 		//STATIC METHOD TO BE IMPLEMENTED BY THE DERIVED CLASS, must the return the exact C# component file and type name. 
 		//static const char* GetManagedTypeName(); 
 	private:
-		//Register the component by sending a register message to the C# side and by retrieving an unique component id, which
-		//is set to the s_id static variable of the class.
-		static int GenerateSetAndGetComponentId();
+		//Register the component by sending a register message to the C# side of the channel and by retrieving an unique 
+		//component id, which is set to the position of the channel on the s_ids static array of the class.
+		static int GenerateSetAndGetComponentId(int channelId);
 		
-		//this static variable is tracked by the UnityMessager instance after being registered, so it can be reset when the game
-		//execution ends. To reset it means to set its value to -1, so at next time the component is used it is registered again
-		static int s_id;
+		//the ids of this static array are tracked by the UnityMessager instance of their channel after being registered, so they can
+		//be reset when the channel instance is deleted. To reset it means to set its value to -1, so at next time the component is
+		//used on the channel it is registered again. Each channel registers its components by itself, so their ids may differ.
+		static int s_ids[UM_MAX_N_OF_CHANNELS];
 	};
 
 	//===================== END OF THE PUBLIC INTERFACE TO THE USER ==============================================
@@ -161,47 +468,315 @@ public:
 	//It must be called when the C# UnityMessage instance will start the message delivering process, so a last
 	//message to mark the end of the delivering process can be send and also the C++ side to be reset since we know
 	//all the messages will be delivered, which implies messages queues will be empty when sending the next message.
+	//When double buffered the queues also swap their sets of arrays, so the next messages don't touch the ones being delivered.
 	void OnStartMessageDelivering();
 
 	//This method MUST BE USED ONLY by the UnityMessagerPlugin interface implementation.
-	//Creates the singleton instance and returns the id for the first array of the control queue, which should be 
+	//It must be called when the C# UnityMessager instance finishes the message delivering process, so the shared arrays 
+	//referenced by the delivered messages (check UnityArrayParam) can be unretained and the message queues can adjust their 
+	//capacity for the next messages (check MessageQueue::AdjustCapacity).
+	void OnFinishMessageDelivering();
+
+	//This method MUST BE USED ONLY by the UnityMessagerPlugin interface implementation.
+	//Returns true if worker threads have staged messages not merged yet, check BindProducerThread for more details. 
+	//The C# side uses it for knowing there are messages to deliver even when the control queue is empty.
+	bool HasStagedMessages() const { return m_hasStagedMessages.load(std::memory_order_acquire); }
+
+	//This method MUST BE USED ONLY by the UnityMessagerPlugin interface implementation.
+	//Creates the instance of the channel and returns the id for the first array of its control queue, which should be 
 	//returned to the calling C# code, in such way its UnityMessager instance can also be properly constructed.
-	//- maxNOfReceiverIds defines the maximum number of receiver C# objects that can be used simultaneously, this
-	//value cannot be changed until the next game execution. The min accepted value is 16. 
+	//- initialNOfReceiverIds defines the number of receiver ids available from the start, rounded up to whole chunks of
+	//UM_RECEIVER_IDS_CHUNK_LENGTH ids. The table of ids grows when needed, check NewReceiverId. The min accepted value is 16.
 	//- maxQueueArraysSizeInBytes defines the maximum size in bytes for each array of each message queue, 
 	//independently of the message queue type. With that you are actually defining the desired size for shared memory 
 	//blocks used to send messages. 512 bytes is minimum, but 1024 or 2048 could be better values in many cases.
-	static int InstanceAndProvideAwakeInfo(int maxNOfReceiverIds, int maxQueueArraysSizeInBytes);
+	//Array parameters bigger than that are still accepted, each one goes to a spill array taken from a pool of each queue.
+	//- initFlags is a combination of the UM_INIT_FLAG_* values, 0 for the default behaviour.
+	//- channelId is the channel of the instance, from 0 to (UM_MAX_N_OF_CHANNELS - 1), check GetInstance.
+	//Each channel takes its own settings, so a low rate channel may use smaller queue arrays, for instance.
+	static int InstanceAndProvideAwakeInfo(int initialNOfReceiverIds, int maxQueueArraysSizeInBytes, int initFlags, 
+										   int channelId = UM_DEFAULT_CHANNEL);
 
 	//This method MUST BE USED ONLY by the UnityMessagerPlugin interface implementation.
-	//When OnDestroy is called at the UnityMessager C# instance, we need to delete the UnityMessager instance
+	//When OnDestroy is called at the UnityMessager C# instance, we need to delete the UnityMessager instance of its channel
 	//so all the MessageQueue shared arrays in use are released. After DeleteInstance is called a new
-	//singleton instance may be created on a new game execution via the Unity Editor.
-	static void DeleteInstance();
+	//instance may be created for the channel on a new game execution via the Unity Editor.
+	static void DeleteInstance(int channelId = UM_DEFAULT_CHANNEL);
+
+	//FOR INTERNAL USAGE ONLY, value pushed for an InternedString parameter. It is public only for being declared by UA_SUPPORTED_TYPE.
+	struct InternedStringRef
+	{
+		int id;
+	};
 
 private: 
 	class MessageQueueBase; //foward declarations
 	template <typename T> class MessageQueue;
 	class ControlQueue;
+	class PayloadQueue;
+	class StagingQueue;
+
+	//Component::GetId as function pointer, so messages staged on worker threads register their components on the main thread
+	typedef int(*ComponentIdGetterFcPtr)(int channelId);
+
+	static UnityMessager* s_pInstances[UM_MAX_N_OF_CHANNELS]; //pointers to the instance of each channel, NULL if not created
 
-	static UnityMessager* s_pInstance; //pointer to the singleton instance
+	//staging queue cached by each worker thread for each channel, valid only when its serial matches m_instanceSerial
+	static THREAD_LOCAL StagingQueue* s_pThreadStagingQueues[UM_MAX_N_OF_CHANNELS];
+	static THREAD_LOCAL uint32 s_threadStagingQueueSerials[UM_MAX_N_OF_CHANNELS];
 
-	//Singleton instance constructor, check InstanceAndProvideAwakeInfo comments for more details
-	UnityMessager(int maxNOfReceiverIds, int maxQueueArraysSizeInBytes);
+	//Channel instance constructor, check InstanceAndProvideAwakeInfo comments for more details
+	UnityMessager(int initialNOfReceiverIds, int maxQueueArraysSizeInBytes, int initFlags, int channelId);
 	~UnityMessager(); 
 
 	//Registers a new component assigning an unique id to (*componentIdStaticPtr), which MUST be the static variable
 	//of the component class, so it is tracked to be reset when the game execution ends, being prepared to a new execution 
 	void RegisterNewComponent(const char* componentTypeName, int* componentIdStaticPtr);
 
+	//Starts a new message on the control queue. When objectName or methodName are given (not NULL) the message is addressed
+	//through their routing binding (check GetRoutingBindingId), being the binding id set in place of the componentId and -1 
+	//in place of the receiverId and/or msgId the binding replaces. If the binding cannot be used the names are pushed directly 
+	//on the Byte parameter queue, being their negative lengths set in place of the receiverId and msgId respectively, which 
+	//is how the C# side knows it should use "GameObject.Find" and/or reflection for delivering the message.
+	//A componentId of -1 means the message is not addressed to a GameObject component, while the ones smaller than -1 are
+	//routing bindings already set in place of it (check UM_ROUTING_BINDING_COMPONENT_SLOT).
+	void StartMessage(int receiverId, int componentId, int msgId, const char* objectName, const char* methodName);
+
+	//Returns the routing binding id for the given (componentId, objectName, methodName), registering it with a 
+	//UMM_REGISTER_ROUTING_BINDING message on its first usage. Returns -1 if the names hash collides with another binding.
+	int GetRoutingBindingId(int componentId, const char* objectName, const char* methodName);
+
+	//The same, using the binding id cached by the route when it is still valid
+	int GetRoutingBindingId(int componentId, const NamedRoute& route);
+
+	//Sends a message addressed by names (check StartMessage) in a single pass when it has a routing binding (bindingId >= 0),
+	//as the messages addressed by a receiverId and msgId. Otherwise it is sent with the names, as StartMessage does.
+	template <typename... PARAMS> 
+	void SendRoutedMessage(int receiverId, int componentId, int msgId, const char* objectName, const char* methodName, 
+						   int bindingId, const PARAMS&... params);
+
+	//Counts a message for the statistics, check UM_INIT_FLAG_STATISTICS. Messages sent from worker threads are counted when merged.
+	void CountSentMessage(int receiverId, int componentId, int msgId);
+
+	//Counts the messages of a batch message for the statistics, one for each receiver, besides the batch message itself
+	void CountBatchMessages(int msgId, int nOfReceivers);
+
+	//Adds value to a statistic of the messages being sent, if collecting them. Called on the main thread only.
+	void AddToStatistic(int statisticPos, int64 value)
+	{
+		if (m_isCollectingStatistics)
+			m_statistics[statisticPos] += value;
+	}
+
+	//Adds bytes written to a message queue for the statistics, if collecting them. Called on the main thread only.
+	void AddToQueueBytes(int queueId, int64 nOfBytes)
+	{
+		if (!m_isCollectingStatistics)
+			return;
+
+		if (queueId >= (int)m_bytesByQueueId.size())
+			m_bytesByQueueId.resize(queueId + 1, 0);
+
+		m_bytesByQueueId[queueId] += nOfBytes;
+	}
+
+	//Publishes the statistics of the messages sent since the previous delivering on m_publishedStatistics and clears them
+	void PublishStatistics();
+
+	//Writes the content of the message queues to be delivered as a trace frame, check StartCapture. Called before reseting them.
+	void CaptureDelivering();
+
+	//Returns true if called from the thread that has initialized the UnityMessager (the main thread at the C# side)
+	bool IsOnMainThread() const { return std::this_thread::get_id() == m_mainThreadId; }
+
+	//Returns the staging queue for the producer the calling worker thread is bound to, binding it to a new producer if needed
+	StagingQueue& GetStagingQueueForThisThread();
+
+	//Replays all the staged messages into the shared message queues, ordered by producer index. Called on the main thread only.
+	void MergeStagingQueues();
+
 	void PushParam() {} //just for compiling the variadic templates with no arguments
 
 	//PushParam variations for different parameter types, all of them push a single parameter to
 	//their respective ParamQueue and register this parameter existence on the control queue
 	template <typename T> void PushParam(const T& param);
 	void PushParam(const char* stringParam);
+	void PushParam(const InternedString& stringParam);
 	template <typename T> void PushParam(const ArrayParam<T>& arrayParam);
-	template <typename T> void PushParam(const ArrayToFillParam<T>& arrayParam); 
+	template <typename T> void PushParam(const ArrayToFillParam<T>& arrayParam);
+	template <typename T> void PushParam(const UnityArrayParam<T>& unityArrayParam);
+
+	//Sends the UMM_SET_QUEUE_UNITY_ARRAY control message for the parameter, so the C# side reads it from the UnityArray, which
+	//is retained until delivered. Returns the value to register the parameter on the control queue, check PushParamSpace.
+	template <typename T> int ReferUnityArray(const UnityArrayParam<T>& unityArrayParam);
+
+	//Retains the shared array until the messages sent until the next delivering get delivered, check OnFinishMessageDelivering
+	void RetainArrayUntilDelivered(int arrayId);
+
+	//Unretains the arrays retained by RetainArrayUntilDelivered on the given set of m_arraysRetainedUntilDelivered 
+	void UnretainArraysRetainedUntilDelivered(int setIdx);
+
+	//Queue id and array length (-1 for single parameters) of a parameter to be registered on the control queue
+	struct ParamRegistration
+	{
+		int queueId;
+		int length;
+	};
+
+	//Compile time info for a parameter type: the type of its ParamQueue, if it is registered as an array parameter and if
+	//it is an UnityArrayParam (read from its own UnityArray instead of its ParamQueue)
+	template <typename T> struct ParamTraits { typedef T QueueType; enum { c_isArray = 0, c_isUnityArray = 0 }; };
+
+	//Compile time layout of a message with the given parameter types, check SendMessageInSinglePass
+	template <typename... PARAMS> struct MessageLayout;
+
+	//True if any of the PARAMS is pushed to the ParamQueue of QUEUE_TYPE (c_value), or is an UnityArrayParam of QUEUE_TYPE
+	//(c_byUnityArray)
+	template <typename QUEUE_TYPE, typename... PARAMS> struct UsesParamQueue;
+
+	//True if any of the PARAMS is an UnityArrayParam
+	template <typename... PARAMS> struct HasUnityArrayParam;
+
+	//Sends a message whose layout (number of parameters and of array parameters) is known at compile time. The parameters are
+	//pushed to their ParamQueues first, so any array advance of these queues is sent before the message, being the message
+	//then written to the control queue by a single reservation, already with its final number of parameters. The ParamQueues
+	//getting more than one parameter are reserved for all of them first (check ReserveParamQueues), since an array advance in
+	//the middle of them would need to come between their registrations. Messages that can't be reserved this way take the 
+	//usual path of registering each parameter right after pushing it: the ones whose parameters on a same ParamQueue don't fit
+	//its arrays, or that have an UnityArrayParam sharing its ParamQueue with other parameters (its UnityArray is referred by
+	//a control message for the next parameter of the queue). The same happens to the interleaved messages with an 
+	//UnityArrayParam, or not fitting the payload queue arrays, since all their parameters share the payload queue.
+	template <typename... PARAMS> void SendMessageInSinglePass(int receiverId, int componentId, int msgId, const PARAMS&... params);
+
+	//Reserves each ParamQueue getting more than one of the given parameters for all of them (check MessageQueue::Reserve),
+	//returns false if the parameters of any of these queues don't fit its arrays.
+	bool ReserveParamQueues() { return true; }
+	template <typename PARAM1, typename... OTHER_PARAMS>
+	bool ReserveParamQueues(const PARAM1& param1, const OTHER_PARAMS&... otherParams);
+
+	//Returns the number of items the given parameters take on the ParamQueue of QUEUE_TYPE
+	template <typename QUEUE_TYPE> static int GetParamQueueLength() { return 0; }
+	template <typename QUEUE_TYPE, typename PARAM1, typename... OTHER_PARAMS>
+	static int GetParamQueueLength(const PARAM1& param1, const OTHER_PARAMS&... otherParams);
+
+	//Number of items a parameter takes on its ParamQueue
+	template <typename T> static int GetParamLength(const T& param) { return 1; }
+	static int GetParamLength(const char* stringParam) { return (int)strlen(stringParam); }
+	static int GetParamLength(const InternedString& stringParam) { return 1; }
+	template <typename T> static int GetParamLength(const ArrayParam<T>& arrayParam) { return arrayParam.length; }
+	template <typename T> static int GetParamLength(const ArrayToFillParam<T>& arrayParam) { return arrayParam.GetLength(); }
+	template <typename T> static int GetParamLength(const UnityArrayParam<T>& unityArrayParam) { return 0; }
+
+	//Allocates space for a parameter of length items (-1 for single parameters) on the ParamQueue for T, or on the payload queue
+	//when the parameters are interleaved (check UM_INIT_FLAG_INTERLEAVED_PARAMS), returning where the items MUST be written.
+	//queueId gets the value to register the parameter on the control queue, which is the payload type id when interleaved.
+	template <typename T> T* PushParamSpace(int length, int& queueId);
+
+	//Returns the value registered on the control queue for parameters of type T, check PushParamSpace
+	template <typename T> int GetParamQueueId();
+
+	//Id of the type T on the payload queue of each channel, it is registered by RegisterPayloadType on its first usage
+	template <typename T> struct PayloadType { static int s_ids[UM_MAX_N_OF_CHANNELS]; };
+	template <typename T> int GetPayloadTypeId();
+
+	//Assigns an unique id to (*payloadTypeIdStaticPtr) for a type used on the payload queue, sending it to the C# side with
+	//the alignment and managed name of the type. Since it is done by a control message, it can be called in the middle of
+	//a message. Check RegisterNewComponent, these ids are also reset when the game execution ends.
+	int RegisterPayloadType(const char* managedTypeName, int size, int alignment, int* payloadTypeIdStaticPtr);
+
+	//Returns the upper bound for the bytes the given parameters take on the payload queue, alignment padding included
+	int GetMaxPayloadLength() { return 0; }
+	template <typename T> int GetMaxPayloadLength(const T& param);
+	int GetMaxPayloadLength(const char* stringParam);
+	int GetMaxPayloadLength(const InternedString& stringParam);
+	template <typename T> int GetMaxPayloadLength(const ArrayParam<T>& arrayParam);
+	template <typename T> int GetMaxPayloadLength(const ArrayToFillParam<T>& arrayParam);
+	template <typename T> int GetMaxPayloadLength(const UnityArrayParam<T>& unityArrayParam) { return 0; }
+	template <typename PARAM1, typename... OTHER_PARAMS>
+	int GetMaxPayloadLength(const PARAM1& param1, const OTHER_PARAMS&... otherParams);
+
+	//PushParam variations that don't register the parameter on the control queue, filling pRegistration instead
+	void PushParamData(ParamRegistration* pRegistration) {}
+	template <typename T> void PushParamData(ParamRegistration* pRegistration, const T& param);
+	void PushParamData(ParamRegistration* pRegistration, const char* stringParam);
+	void PushParamData(ParamRegistration* pRegistration, const InternedString& stringParam);
+	template <typename T> void PushParamData(ParamRegistration* pRegistration, const ArrayParam<T>& arrayParam);
+	template <typename T> void PushParamData(ParamRegistration* pRegistration, const ArrayToFillParam<T>& arrayParam);
+	template <typename T> void PushParamData(ParamRegistration* pRegistration, const UnityArrayParam<T>& unityArrayParam);
+	template <typename PARAM1, typename... OTHER_PARAMS>
+	void PushParamData(ParamRegistration* pRegistration, const PARAM1& param1, const OTHER_PARAMS&... otherParams);
+
+	//Returns true if all the given parameters are arrays of the given length, so they can be columns of a batch message
+	bool AreBatchColumns(int length) { return true; }
+	template <typename PARAM1, typename... OTHER_PARAMS>
+	bool AreBatchColumns(int length, const PARAM1& column1, const OTHER_PARAMS&... otherColumns);
+
+	//Returns the length of an array parameter, or -1 for the other parameter types, check AreBatchColumns
+	template <typename T> int GetBatchColumnLength(const T& param) { return -1; }
+	template <typename T> int GetBatchColumnLength(const ArrayParam<T>& arrayParam) { return arrayParam.length; }
+	template <typename T> int GetBatchColumnLength(const ArrayToFillParam<T>& arrayParam) { return arrayParam.GetLength(); }
+	template <typename T> int GetBatchColumnLength(const UnityArrayParam<T>& unityArrayParam) { return unityArrayParam.length; }
+
+	//Location of the last message sent by SendCoalescedMessage for a given (receiverId, msgId), valid until the next delivering 
+	struct CoalescedMessage
+	{
+		void* pControlRecord; //points the message on the control queue, so it can be discarded if it cannot be overwritten
+		int firstParamIdx; //index of the first parameter on m_coalescedParams
+		int nOfParams;
+	};
+
+	//Location of a parameter of a coalesced message on its ParamQueue, so it can be overwritten in place
+	struct CoalescedParam
+	{
+		int queueId;
+		int length; //array length for array parameters, -1 for single parameters
+		void* pData;
+	};
+
+	//Returns the last coalesced message sent with the given (receiverId, msgId) since the last delivering, or NULL
+	CoalescedMessage* FindCoalescedMessage(int receiverId, int msgId);
+	
+	//Starts a new coalesced message, discarding pPreviousMessage if given, its parameters MUST BE pushed by PushCoalescedParam 
+	void StartCoalescedMessage(int receiverId, int msgId, int nOfParams, CoalescedMessage* pPreviousMessage);
+
+	//PushParam variations keeping the location of the pushed parameter for overwriting it by a later SendCoalescedMessage
+	void PushCoalescedParam() {}
+	template <typename T> void PushCoalescedParam(const T& param);
+	void PushCoalescedParam(const char* stringParam);
+	void PushCoalescedParam(const InternedString& stringParam);
+	template <typename T> void PushCoalescedParam(const ArrayParam<T>& arrayParam);
+	template <typename T> void PushCoalescedParam(const ArrayToFillParam<T>& arrayParam);
+	template <typename T> void PushCoalescedParam(const UnityArrayParam<T>& unityArrayParam);
+	template <typename PARAM1, typename... OTHER_PARAMS> void PushCoalescedParam(const PARAM1& param1, const OTHER_PARAMS&... otherParams);
+
+	//Returns true if the parameter at paramIdx on m_coalescedParams has the same type (and array length) of the given parameter
+	bool MatchesCoalescedParam(int paramIdx) { return true; }
+	template <typename T> bool MatchesCoalescedParam(int paramIdx, const T& param);
+	bool MatchesCoalescedParam(int paramIdx, const char* stringParam);
+	bool MatchesCoalescedParam(int paramIdx, const InternedString& stringParam);
+	template <typename T> bool MatchesCoalescedParam(int paramIdx, const ArrayParam<T>& arrayParam);
+	template <typename T> bool MatchesCoalescedParam(int paramIdx, const ArrayToFillParam<T>& arrayParam);
+	template <typename T> bool MatchesCoalescedParam(int paramIdx, const UnityArrayParam<T>& unityArrayParam);
+	template <typename PARAM1, typename... OTHER_PARAMS> 
+	bool MatchesCoalescedParam(int paramIdx, const PARAM1& param1, const OTHER_PARAMS&... otherParams);
+
+	//Overwrites the parameter at paramIdx on m_coalescedParams, which MUST match the given parameter (check MatchesCoalescedParam)
+	void OverwriteCoalescedParam(int paramIdx) {}
+	template <typename T> void OverwriteCoalescedParam(int paramIdx, const T& param);
+	void OverwriteCoalescedParam(int paramIdx, const char* stringParam);
+	void OverwriteCoalescedParam(int paramIdx, const InternedString& stringParam);
+	template <typename T> void OverwriteCoalescedParam(int paramIdx, const ArrayParam<T>& arrayParam);
+	template <typename T> void OverwriteCoalescedParam(int paramIdx, const ArrayToFillParam<T>& arrayParam);
+	template <typename T> void OverwriteCoalescedParam(int paramIdx, const UnityArrayParam<T>& unityArrayParam);
+	template <typename PARAM1, typename... OTHER_PARAMS>
+	void OverwriteCoalescedParam(int paramIdx, const PARAM1& param1, const OTHER_PARAMS&... otherParams);
+
+	//Returns the id of the string on the interned strings table, using the id cached by the InternedString when still valid
+	int GetInternedStringId(const InternedString& stringParam);
+
+	//Looks for the string on the interned strings table, adding it if not found. New strings are sent to the C# side by 
+	//UMM_REGISTER_INTERNED_STRING control messages, so it can be called in the middle of a message.
+	int InternString(const InternedString& stringParam);
 
 	//Variadic template version of PushParam, MAYBE IT SHOULD BE PUBLIC, so users can push parameters programatically
 	//when the final number of parameters is not known in advance, IN OTHER HAND, in the great majority of these cases
@@ -213,54 +788,229 @@ private:
 	int ProvideUnityMessagerAwakeInfo();
 
 	//This private getter method exists to be used directly by MessageQueue instances on their construction.  
-	//This value is set on the singleton instance creation and is used as size reference for each new ParamQueue instanced.
+	//This value is set on the channel instance creation and is used as size reference for each new ParamQueue instanced.
 	//By being a value in bytes, each queue may have a different length depending on their type size.
 	int GetMaxQueueArraysSizeInBytes() { return m_maxQueueArraysSizeInBytes; }
 
+	//This private getter method exists to be used directly by MessageQueue instances on their construction.
+	//When true each queue allocates a second set of arrays, check UM_INIT_FLAG_DOUBLE_BUFFERED.
+	bool IsDoubleBuffered() { return m_isDoubleBuffered; }
+
 	//This private getter method exists to be used directly by MessageQueue instances on their construction.  
-	//It returns the next available queueId (index of the m_messageQueuesPtrs array), which must be used for registering the queue
+	//It returns the next available queueId (index on the m_messageQueues registry), which must be used for registering the queue
 	int GetNextFreeQueueIdAndIncrement() { return ++m_lastAssignedQueueId; }
 	
 	//This method exists to be used directly by MessageQueue instances on their construction.  
-	//It register a new MessageQueue being instanced by saving it on the m_messageQueuesPtrs array
+	//It register a new MessageQueue being instanced by saving it on the m_messageQueues registry
 	void RegisterMessageQueue(int queueId, MessageQueueBase* msgQueue);
 
-	//This sets the suport for (UM_MAX_N_OF_MESSAGE_QUEUES - 1) different parameter types. If you exceed that a C assertion will
-	//be triggered so you know you need to increase this value and recompile your code. However, with that set to 32 it is almost
-	//impossible to have this value not being enough for anyone's needs.
-	//It corresponds to UnityMessager._maxNOfMessageQueues on C#, so once you update this value here be sure to update there too.
-#define UM_MAX_N_OF_MESSAGE_QUEUES 32
+	//Length of the chunks of the Registry tables, as a power of two (UM_REGISTRY_CHUNK_LENGTH == 1 << UM_REGISTRY_CHUNK_BITS)
+#define UM_REGISTRY_CHUNK_BITS 5
+#define UM_REGISTRY_CHUNK_LENGTH (1 << UM_REGISTRY_CHUNK_BITS)
 
-	//Maximum number of components that can be declared, this should be big enough, but if more components are declared 
-	//an assertion will be triggered so you can increase this value and recompile your code.
-#define UM_MAX_N_OF_COMPONENTS 32
+	//Table of items indexed by ids given in sequence, with no maximum number of ids. It grows by chunks of UM_REGISTRY_CHUNK_LENGTH 
+	//items, so the items never move once added and getting one by its id is O(1), however many ids are registered. It backs the
+	//tables of message queues, components and payload types, so large projects may use hundreds of parameter types and components
+	//without having to increase a fixed maximum on both sides. The C# side grows its own tables as the ids are registered to it.
+	//It is only accessed on the main thread.
+	template <typename T>
+	class Registry
+	{
+	public:
+		Registry() : m_chunks(), m_size(0) {}
+		~Registry() 
+		{ 
+			for (size_t i = 0; i < m_chunks.size(); ++i)
+				delete[] m_chunks[i];
+		}
+
+		int GetSize() const { return m_size; }
+
+		T& operator[](int id) 
+		{ 
+			ASSERT(id >= 0 && id < m_size);
+			return m_chunks[id >> UM_REGISTRY_CHUNK_BITS][id & (UM_REGISTRY_CHUNK_LENGTH - 1)];
+		}
 
-	//this array is shared with the C# code and implements a system to allows new receiver ids to be requested
-	//by the C++ code or by the C# code, as the user logic requires, check NewReceiverId() implemention for details.
-	UnityArray<int> m_receiverIds;
+		//Makes the ids up to (size - 1) valid, the items of the new ones are value initialized (NULL for pointers)
+		void Grow(int size)
+		{
+			while ((int)m_chunks.size() * UM_REGISTRY_CHUNK_LENGTH < size)
+				m_chunks.push_back(new T[UM_REGISTRY_CHUNK_LENGTH]());
+
+			if (size > m_size)
+				m_size = size;
+		}
+
+	private:
+		Registry(const Registry&); //not copyable, it owns its chunks
+		Registry& operator=(const Registry&);
+
+		std::vector<T*> m_chunks;
+		int m_size;
+	};
+
+	//Adds a chunk of slots to the receiver ids table, linking them to the free list, returns false if the table is full.
+	//It is called only from the main thread, so the chunks are allocated (by the C# side) and published in order.
+	bool AddReceiverIdsChunk();
+
+	//Takes the first slot of the free list, returning its index, 0 if the list is empty
+	int PopFreeReceiverIdSlot();
+
+	//Returns true if the slot at the index is in use by receiverId, so it is not free and has the generation of the id
+	bool IsReceiverIdSlotInUse(int index, int receiverId) const;
+
+	//(generation, next) of the slot at the index, which MUST BE of a chunk already published
+	int* GetReceiverIdSlot(int index) const;
+
+	//Header of the receiver ids table, shared with the C# code so both sides may give and release ids without calling
+	//each other, check UM_RECEIVER_IDS_HEAD_POS for its layout and NewReceiverId() implemention for details.
+	UnityArray<int64> m_receiverIdsHeader;
+
+	//chunks of the receiver ids table, published by AddReceiverIdsChunk before any of their slots gets to the free list
+	std::atomic<UnityArray<int>*> m_receiverIdsChunks[UM_MAX_N_OF_RECEIVER_ID_CHUNKS];
 
 	//Since the game can be restarted from the Unity Editor we need to keep track of the component ids assigned, which
 	//needs to be reset to -1 when the game execution ends so a new assignement can properly happen in synch with the C# script
-	int* m_staticComponentIdsToResetPtrs[UM_MAX_N_OF_COMPONENTS];
+	Registry<int*> m_staticComponentIdsToResetPtrs;
 
 	//this is incremented for each new component being registered, returning an unique id for that component
 	int m_lastAssignedComponentId;
 
-	//array keeping all the instaced messages queues, being the control queue at the position 0 and the ParamQueue for 
+	//last payload type id assigned, payload type ids start from 1 since they are registered on the control queue as queue ids
+	int m_lastAssignedPayloadTypeId;
+
+	//Payload types by their ids, the type info is only needed for the traces (check CaptureDelivering)
+	struct PayloadTypeInfo
+	{
+		const char* managedTypeName;
+		int size;
+		int alignment;
+
+		//the same as m_staticComponentIdsToResetPtrs, but for the payload type ids, check RegisterPayloadType
+		int* staticIdToResetPtr;
+	};
+
+	Registry<PayloadTypeInfo> m_payloadTypes;
+
+	//registry keeping all the instaced messages queues, being the control queue at the position 0 and the ParamQueue for 
 	//each different parameter type on following positions (order is determined by the usage order when pushing parameters).
-	MessageQueueBase* m_messageQueuesPtrs[UM_MAX_N_OF_MESSAGE_QUEUES];
+	Registry<MessageQueueBase*> m_messageQueues;
 
 	//Control queue, unique during the UnityMessager instance lifetime, created with that and correponding to the
-	//position 0 of the array m_messageQueuesPtrs.
+	//position 0 of the m_messageQueues registry.
 	ControlQueue* m_pControlQueue;
 
+	//Payload queue, only created when the parameters are interleaved (check UM_INIT_FLAG_INTERLEAVED_PARAMS), NULL otherwise.
+	//It is always the queue 1 of the m_messageQueues registry, so the C# side knows it.
+	PayloadQueue* m_pPayloadQueue;
+
 	//check comments for GetMaxQueueArraysSizeInBytes
 	int m_maxQueueArraysSizeInBytes;
 
+	//check comments for IsDoubleBuffered
+	bool m_isDoubleBuffered;
+
+	//UM_INIT_FLAG_* flags given on the instance creation
+	int m_initFlags;
+
+	//check comments for GetChannelId
+	int m_channelId;
+
 	//when a new ParamQueue is instanced by its template dependent PushParam method, this attribute provides
-	//the next available id on the m_messageQueuesPtrs array. 
+	//the next available id on the m_messageQueues registry. 
 	int m_lastAssignedQueueId;
 
+	//id of the thread that has created the instance, the unique one allowed to write directly to the shared message queues
+	std::thread::id m_mainThreadId;
+
+	//staging queues for messages sent from worker threads, the map key is the producer index so it also defines the merge order
+	std::map<int, StagingQueue*> m_stagingQueues;
+
+	//protects m_stagingQueues and m_lastAutoProducerIndex, which are accessed when worker threads get bound to producers
+	std::mutex m_stagingQueuesMutex;
+
+	//last producer index given to a worker thread sending messages without calling BindProducerThread before
+	int m_lastAutoProducerIndex;
+
+	//set by the staging queues when a message is staged, reset when they are merged, check HasStagedMessages
+	std::atomic<bool> m_hasStagedMessages;
+
+	//unique for each instance created, it invalidates the staging queue pointers cached by the worker threads from previous instances
+	uint32 m_instanceSerial;
+
+	//coalesced messages sent since the last delivering, indexed by their (receiverId, msgId) key, check SendCoalescedMessage
+	std::unordered_map<uint64, int> m_coalescedMessageIdxs;
+	std::vector<CoalescedMessage> m_coalescedMessages;
+	std::vector<CoalescedParam> m_coalescedParams;
+
+	//Names of a routing binding, empty when the binding does not replace the receiverId or the msgId respectively
+	struct RoutingBinding
+	{
+		int componentId;
+		std::string objectName;
+		std::string methodName;
+	};
+
+	//routing bindings indexed by their id, and the ids indexed by the hash of their names, check GetRoutingBindingId
+	std::vector<RoutingBinding> m_routingBindings;
+	std::unordered_map<uint64, int> m_routingBindingIdxs;
+
+	//Maximum number of strings kept by the interned strings table, once it is full the least recently used ones get replaced
+#define UM_MAX_N_OF_INTERNED_STRINGS 1024
+
+	//Entry of the interned strings table, its index is the string id 
+	struct InternedStringSlot
+	{
+		std::string str;
+		uint64 hash;
+		uint32 stamp; //unique for each string assigned to a slot, so InternedString instances know if their cached id is valid
+		bool isReferenced; //set when used, cleared by the eviction clock hand, check InternString
+		uint32 lastMessageSerial; //m_messageSerial when last used
+	};
+
+	//interned strings table and the string ids indexed by the hash of their strings
+	std::vector<InternedStringSlot> m_internedStrings;
+	std::unordered_map<uint64, int> m_internedStringIdxs;
+
+	//next slot checked for eviction (CLOCK policy), once the table is full
+	int m_internedStringsClockHand;
+
+	//id of the queue for InternedStringRef parameters (payload type id when interleaved), -1 until the first interned string
+	int m_internedStringQueueId;
+
+	//incremented for each message started, so the interned strings used by the message being sent are never evicted
+	uint32 m_messageSerial;
+
+	//Statistics of the messages sent since the previous delivering, check UM_INIT_FLAG_STATISTICS. They are copied to the shared
+	//array m_publishedStatistics when published, which is only allocated when collecting statistics.
+	bool m_isCollectingStatistics;
+	int64 m_statistics[UM_STATISTICS_LENGTH];
+	UnityArray<int64> m_publishedStatistics;
+
+	//number of messages sent since the previous delivering by msgId, for the UM_STATISTIC_FIRST_TOP_MSG_ID pairs
+	std::unordered_map<int, int64> m_nOfMessagesByMsgId;
+
+	//bytes written since the previous delivering by queueId, for the UM_STATISTIC_FIRST_TOP_QUEUE pairs
+	std::vector<int64> m_bytesByQueueId;
+
+	//Arrays referenced by UnityArrayParam parameters, retained since the message sending until it is delivered. The set at
+	//m_arraysRetainedIdx gets the arrays referenced by new messages, the other one the arrays of the messages being delivered.
+	std::unordered_set<int> m_arraysRetainedUntilDelivered[2];
+	int m_arraysRetainedIdx;
+
+	//Writer of the trace file when capturing, NULL otherwise, check StartCapture
+	UnityMessagerTrace::Writer* m_pTraceWriter;
+
+	//last parameter type (queue id, or payload type id when interleaved) written to the trace, so each type is written once
+	int m_lastTracedTypeId;
+
+	//check comments for GetInbox, NULL until then
+	UnityMessagerInbox* m_pInbox;
+
+	//check comments for GetRing, NULL until then
+	UnityMessagerRing* m_pRing;
+
 	//Provides a polymorphic access point to MessageQueue instances for the methods required out of 
 	//template dependent methods on UnityMessager. 
 	class MessageQueueBase
@@ -268,10 +1018,26 @@ private:
 	public:
 		virtual ~MessageQueueBase() {} //virtual so it can be used to properly delete MessageQueue instances 
 		virtual int GetFirstArrayId() = 0; //check comments on the MessageQueue interface 
+		virtual int GetSecondFirstArrayId() = 0; //check comments on the MessageQueue interface 
 		virtual void Reset() = 0; //check comments on the MessageQueue interface 
 		virtual void ReleaseArraysExceptFirst() = 0; //check comments on the MessageQueue interface 
+		virtual void AdjustCapacity() = 0; //check comments on the MessageQueue interface 
+		virtual void AddArraysToTrace(UnityMessagerTrace::Writer& traceWriter) = 0; //check comments on the MessageQueue interface 
+		virtual void AddTypeToTrace(UnityMessagerTrace::Writer& traceWriter) {} //check comments on the ParamQueue interface 
 	};
 
+	//Number of deliverings a message queue keeps the capacity for its peak usage, check MessageQueue::AdjustCapacity
+#define UM_QUEUE_CAPACITY_WINDOW_N_OF_DELIVERINGS 120
+
+	//A message queue uses arrays longer than its first array when its expected usage takes more than this number of arrays,
+	//doubling their length up to UM_MAX_QUEUE_ARRAYS_LENGTH_FACTOR times the first array length.
+#define UM_N_OF_QUEUE_ARRAYS_FOR_LONGER_ARRAYS 4
+#define UM_MAX_QUEUE_ARRAYS_LENGTH_FACTOR 16
+
+	//Number of size classes for the spill arrays of a message queue, check MessageQueue::GetSpillSizeClass. Since the class n
+	//holds arrays 2^n times longer than the queue arrays, 32 classes cover any int length.
+#define UM_N_OF_SPILL_ARRAY_SIZE_CLASSES 32
+
 	//A message queue is a sequence of shared arrays between C# and C++ always filled from its first array
 	//to its last one as queue and read by the C# code in the same way (FIFO: first in, first out).
 	//The C++ side of a message queue is responsible for allocating new UnityArrays and controlling their 
@@ -280,14 +1046,15 @@ private:
 	class MessageQueue : public MessageQueueBase
 	{
 	public:
-		MessageQueue();
+		//unityMessager is the instance of the channel owning the queue, which the queue sends its control messages to
+		MessageQueue(UnityMessager& unityMessager);
 
 		//Instances live for a same game execution together with the UnityMessager instance. When the game 
 		//will be closed or stopped on the Editor, all the message queues are deleted and will release their arrays. 
 		virtual ~MessageQueue();
 
 		//each MessageQueue instance has an unique queueId, corresponding to its position on the MessageQueueBase 
-		//array at the UnityMessager singleton instance. The control queue must be always the id 0, while each
+		//array at the UnityMessager instance of its channel. The control queue must be always the id 0, while each
 		//type gets a different id on the sequence depending of the order they are required on the user's code.
 		//This ways a same type can get different ids when the user's code changes, but this queueId won't change
 		//during the lifetime of the UnityMessager and MessageQueue instances. 
@@ -297,24 +1064,67 @@ private:
 		//role on the C# side, allowing a message queue to reset itself without receiving special control messages
 		int GetFirstArrayId() { return m_pFirstNode->unityArray.GetId(); }
 
+		//Get the array id of the first UnityArray of the set of arrays not being currently written, -1 if not double buffered.
+		int GetSecondFirstArrayId() { return m_pSecondFirstNode ? m_pSecondFirstNode->unityArray.GetId() : -1; }
+
 		//Is reset means the current array is the first queue array and the current position is 0.
 		bool IsReset();
+
+		//Makes sure the current array has length free items, so the next writes summing up to length items (alignment padding
+		//included for the payload queue) don't advance the queue. It allows several parameters to be pushed before their
+		//registration on the control queue. Returns false if length is bigger than the arrays of the queue, so the parameters
+		//need to be registered one by one.
+		bool Reserve(int length);
 		
 		//Check IsReset comments. It is used to prepare the message queue to be used from its begining instead of
 		//the previous current array and position. The start of the delivering process on the C# defines this moment,
 		//since program execution is on the C# code and no other messages will be pushed until it is ended.
+		//When double buffered the queue swaps to its other set of arrays before reseting, since the one written until
+		//now is going to be read by the C# code, while new messages may be pushed during the delivering process. 
 		virtual void Reset();
 
 		//Used to free arrays that are not essential to keep the instance alive and functional. The first array is 
 		//the unique that cannot be released, since the C# side stores it for reseting the queue by itself. 
+		//When double buffered the first array of each set is kept.
 		virtual void ReleaseArraysExceptFirst();
 
+		//Called when the C# side finishes delivering messages, so the queue prepares the set of arrays to be written after 
+		//the next Reset (the only one when not double buffered) for the expected usage: the peak usage measured by Reset over the
+		//last UM_QUEUE_CAPACITY_WINDOW_N_OF_DELIVERINGS to (2 * UM_QUEUE_CAPACITY_WINDOW_N_OF_DELIVERINGS) deliverings. Missing
+		//arrays are allocated now, so the steady state doesn't allocate arrays when sending messages, while the arrays beyond the 
+		//expected usage are released, so the memory taken by an usage spike is given back once it gets out of the window. 
+		//Queues expected to use many arrays get longer ones, check UM_N_OF_QUEUE_ARRAYS_FOR_LONGER_ARRAYS.
+		virtual void AdjustCapacity();
+
+		//Adds the arrays written since the last Reset to a trace frame in their reading order, the current one only up to
+		//its current position, followed by the spill arrays in use. Check UnityMessager::StartCapture.
+		virtual void AddArraysToTrace(UnityMessagerTrace::Writer& traceWriter);
+
 	protected:
+		//Current position of the current array in bytes
+		virtual int GetCurrentArrayPosInBytes() { return m_currentArrayPos * sizeof(T); }
+
 		//Returns a pointer to the current next free position of the queue, while advancing the current position for 
 		//the next call of AllocSpace. If the current array of the queue doesn't have space for the desired length,
-		//the queue advances to its next array (allocating a new UnityArray if needed).
+		//the queue advances to its next array (allocating a new UnityArray if needed). Lengths bigger than the queue
+		//arrays get a spill array instead, check AllocSpillSpace.
 		T* AllocSpace(int length);
 
+		//The first arrays keep the length given by the UnityMessager maxQueueArraysSizeInBytes, while the next ones may be
+		//longer (check AdjustCapacity), so this is the length any array of the queue has at least.
+		int GetMinArrayLength() { return m_pFirstNode->unityArray.GetLength(); }
+
+		//Returns the space for an array parameter bigger than the queue arrays on a spill array taken from the pool, sending 
+		//a UMM_SET_QUEUE_SPILL_ARRAY control message so the C# side reads just the next parameter from it. The current
+		//array and position of the queue are kept, the C# side goes back to them after reading the spilled parameter.
+		T* AllocSpillSpace(int length);
+
+		//Spill arrays are pooled by size classes, the class n holding arrays 2^n times longer than the queue arrays
+		int GetSpillSizeClass(int length);
+
+		//Deletes all the spill arrays, the ones on the pool and the ones in use
+		void DeleteSpillArrays();
+
 		//Advances the queue to its next UnityArray and sends a control message by accessing the UnityMessager instance
 		//so the C# code will be warned before reading the next value when delivering the current message.
 		void AdvanceToNextUnityArrayNode();
@@ -335,9 +1145,27 @@ private:
 		} Node;
 
 		Node* m_pFirstNode; //first node of the single linked list of nodes.
+		Node* m_pSecondFirstNode; //first node of the list of nodes not being written (double buffered only, otherwise NULL)
 		Node* m_pCurrentNode; //current node (UnityArray) being filled
 		int m_currentArrayPos; //next position to fill on the current node (UnityArray) of the queue.
 		int m_queueId; //check comments for GetQueueId
+
+		int m_arraysLength; //length for new arrays after the first ones, check AdjustCapacity
+
+		//peak usage (in items, the unused ends of the arrays included) of the current and of the last window of deliverings
+		int m_currentWindowPeakLength;
+		int m_lastWindowPeakLength;
+		int m_nOfDeliveringsOnWindow;
+
+		//Spill arrays not in use, by size class (check GetSpillSizeClass)
+		std::vector<UnityArray<T>*> m_spillArraysPool[UM_N_OF_SPILL_ARRAY_SIZE_CLASSES];
+		
+		//Spill arrays used since the last Reset and before it. The ones used before the previous Reset go back to the pool, 
+		//since only then the C# side surely has finished reading them (even when double buffered).
+		std::vector<UnityArray<T>*> m_spillArraysInUse[2];
+		int m_spillArraysInUseIdx; //index of the set being filled on m_spillArraysInUse
+
+		UnityMessager& m_unityMessager; //instance of the channel owning the queue
 	};
 
 	//Control queue, always should be the message queue of id 0 on the UnityMessager message queues array
@@ -345,9 +1173,12 @@ private:
 	class ControlQueue : public MessageQueue<int>
 	{
 	public:
-		//should be created together with the UnityMessager instance, by the constructor of MessageQueue<int>
-		//it requires the singleton access point for UnityMessager to exist already when its being instanced.
-		ControlQueue(); 
+		//should be created together with the UnityMessager instance, being unityMessager the instance under construction.
+		//When isCompact is true the queue arrays are filled with the format described at UnityMessagerCompact.h
+		ControlQueue(UnityMessager& unityMessager, bool isCompact); 
+
+		//Complements MessageQueue<int>::Reset, the compact format doesn't repeat receiver ids only until the next delivering
+		virtual void Reset();
 
 		//Returns false only if the queue can be considered empty, which is set by the C# code when all 
 		//messages were delivered
@@ -355,11 +1186,21 @@ private:
 		
 		//Register an usual message to the queue, after that it is ready for registering parameters of the
 		//last message sent or to start a new message sending by being re-called with another message.
-		void SendMessage(int receiverId, int msgId);
+		//Returns a pointer to the message on the queue, valid until the next delivering, check DiscardMessage.
+		void* SendMessage(int receiverId, int msgId);
 
 		//Version of ControlQueue::SendMessage with support for a component id
 		void SendMessage(int receiverId, int componentId, int msgId);
 
+		//Sends a message together with the registrations of its parameters (already pushed to their queues), reserving space for
+		//the whole message at once. A negative componentId means the message is not addressed to a GameObject component.
+		void SendMessage(int receiverId, int componentId, int msgId, int nOfParams, int nOfArrayParams,
+						 const ParamRegistration* pRegistrations);
+
+		//Changes a message returned by SendMessage, so it is addressed to the C# UnityMessager instance as a
+		//UMM_DISCARDED_MESSAGE, keeping its parameters so they get skipped when it's delivered (and ignored).
+		void DiscardMessage(void* pMessage);
+
 		//Sends a control message, it means a message addressed to the UnityMessager receiver instance on C#.
 		//These are special messages that can have only integer parameters and that can be sent while parameters 
 		//for the last sent message still being filled, since they are essential for advancing a queue to 
@@ -373,6 +1214,9 @@ private:
 		void RegisterParam(int queueId, int length);
 
 	private:
+		//Overrides the base one, since on the compact format m_currentArrayPos is in bytes already
+		virtual int GetCurrentArrayPosInBytes() { return m_isCompact ? m_currentArrayPos : m_currentArrayPos * sizeof(int); }
+
 		// *HIDES* the base AllocSpace method by an specific one that consider the need of keeping space for 
 		// advancing the control queue itself to its next array before pushing new control values
 		int* AllocSpace(int length);
@@ -384,42 +1228,176 @@ private:
 		//Helper method to increment the number of parameters set on the control queue when registering a new parameter
 		void IncrementNumberOfParamsForCurrentMessage();
 
+		//Versions of the public methods for the compact format, check UnityMessagerCompact.h. All the positions on the
+		//compact format are in bytes, so for it m_currentArrayPos is the next free BYTE of the current array.
+		void* SendCompactMessage(int receiverId, int componentId, int msgId);
+		void SendCompactMessage(int receiverId, int componentId, int msgId, int nOfParams, int nOfArrayParams,
+								const ParamRegistration* pRegistrations);
+		void RegisterCompactParam(int queueId, int length);
+
+		//Writes a compact message record header at pDest with the given number of parameters, returning the end of the header
+		uint8* WriteCompactMessageHeader(uint8* pDest, int receiverId, int componentId, int msgId, int nOfParams);
+		void SendCompactControlMessage(int msgId, int nOfParams, const int* intParams);
+
+		//Returns the next free byte of the current array, advancing to the next array if there is no space for maxLength bytes
+		//(plus the space for advancing the queue itself), CommitCompactSpace MUST be called after writing the record
+		uint8* AllocCompactSpace(int maxLength);
+		void CommitCompactSpace(uint8* pEndOfRecord);
+
 		//points the control queue position where the number of parameters for the last sent message is 
 		//registered in order to increment it when new parameters are pushed
 		int *m_pCurrentNOfParams;
+		uint8 *m_pCurrentCompactNOfParams; //the same for the compact format
 		
 		//When set true AdvanceToNextUnityArrayNode should return, since it is already advancing by an enclosing call
 		bool isAdvancingToNextNode;
+
+		bool m_isCompact;
+
+		//receiver id of the last message on the compact format, valid if m_hasLastReceiverId, check UM_COMPACT_TAG_SAME_RECEIVER
+		int m_lastReceiverId;
+		bool m_hasLastReceiverId;
 	};
 
-	//Parameter Queue, just one instance of it for each parameter type will exist.  
+	//Parameter Queue, just one instance of it for each parameter type will exist on each channel.
 	template <typename T> 
 	class ParamQueue : public MessageQueue<T>
 	{
 	public:
-		//It is a sigleton that creates itself when accessed by the corresponding template method on UnityMessager. 
-		static ParamQueue<T>& GetInstance() { return *(s_pInstance ? s_pInstance : (s_pInstance = new ParamQueue<T>())); }
+		//There is an instance per channel, which creates itself when accessed by the corresponding template method on UnityMessager.
+		static ParamQueue<T>& GetInstance(UnityMessager& unityMessager)
+		{
+			ParamQueue<T>*& pInstance = s_pInstances[unityMessager.m_channelId];
+			return *(pInstance ? pInstance : (pInstance = new ParamQueue<T>(unityMessager)));
+		}
 
-		//It MUST be deleted in case the game is finished via the Unity Editor. In this case the singleton access point gets  
+		//It MUST be deleted in case the game is finished via the Unity Editor. In this case the access point of its channel gets  
 		//NULLed by the destructor being filled again by a new instance next time it is accessed, on a a new game run.
-		virtual ~ParamQueue() { s_pInstance = NULL; }
+		virtual ~ParamQueue() { s_pInstances[this->m_unityMessager.m_channelId] = NULL; }
 
-		//push parameter method for single items
-		void Push(const T& item);
+		//push parameter method for single items, returns the pointer to the pushed item on the queue
+		T* Push(const T& item);
 		
-		//push parameter method for arrays to be copied into the queue
-		void Push(const T* pItemArray, int length);
+		//push parameter method for arrays to be copied into the queue, returns the pointer to the first pushed item on the queue
+		T* Push(const T* pItemArray, int length);
 
 		//push parameter method for arrays to be filled, returning the pointer to the first element to be filled. 
 		void PushAndGetPtrToFill(T** const ppQueueSubArrayOutput, int length);
 
+		//Adds the parameter type of the queue to a trace frame, check UnityMessager::CaptureDelivering
+		virtual void AddTypeToTrace(UnityMessagerTrace::Writer& traceWriter)
+		{
+			traceWriter.AddType(this->m_queueId, sizeof(T), std::alignment_of<T>::value, UnityArray<T>::s_managedTypeName);
+		}
+
 	protected:
 		//declares the base method name as being template dependent to avoid compilation issues with emscripten
 		using MessageQueue<T>::AllocSpace;
 
 	private:
-		ParamQueue() {}
-		static ParamQueue<T>* s_pInstance; //singleton instance pointer holder
+		ParamQueue(UnityMessager& unityMessager) : MessageQueue<T>(unityMessager) {}
+		static ParamQueue<T>* s_pInstances[UM_MAX_N_OF_CHANNELS]; //instance pointer holder of each channel
+	};
+
+	//Byte queue where all the parameters of each message are written together when they are interleaved, each parameter
+	//aligned to the alignment of its type. The parameters are registered on the control queue by their payload type ids.
+	class PayloadQueue : public MessageQueue<uint8>
+	{
+	public:
+		PayloadQueue(UnityMessager& unityMessager) : MessageQueue<uint8>(unityMessager) {}
+
+		//Allocates length bytes aligned to alignment (relative to the start of the current array), returning where to write them
+		uint8* Push(int length, int alignment);
+	};
+
+	//Buffer for the messages sent by a producer (one or more worker threads bound to the same producer index). It never touches 
+	//the shared message queues, which may require C# calls for getting new arrays, keeping the messages and their parameters on
+	//regular C++ memory until MergeInto replays them on the main thread through the same methods used by the usual SendMessage.
+	class StagingQueue
+	{
+	public:
+		//pHasStagedMessagesFlag points to the flag of the owner UnityMessager, which is set each time a message is staged
+		StagingQueue(std::atomic<bool>* pHasStagedMessagesFlag);
+		~StagingQueue();
+
+		//Stages a message and its parameters, check UnityMessager::StartMessage for the meaning of the first parameters
+		//isCoalesced is set for messages sent by SendCoalescedMessage, which are coalesced when merged.
+		template <typename... PARAMS> void StageMessage(int receiverId, int msgId, ComponentIdGetterFcPtr componentIdGetterFcPtr,
+														const char* objectName, const char* methodName, bool isCoalesced, 
+														const PARAMS&... params);
+
+		//Replays all the staged messages, on their staging order, to the unityMessager shared queues and clears the staging queue.
+		//It MUST be called from the main thread.
+		void MergeInto(UnityMessager& unityMessager);
+
+	private:
+		//What a ReplayParamFcPtr call does with the staged parameter, coalesced messages may need to check the
+		//parameters of the previous message before overwriting them or pushing the new parameters
+		enum ReplayMode { RM_PUSH, RM_PUSH_COALESCED, RM_MATCH_COALESCED, RM_OVERWRITE_COALESCED };
+
+		//Replays a single staged parameter on the main thread, by pushing it as a regular parameter or by the coalesced
+		//message methods, in which case coalescedParamIdx is the index of the parameter being matched or overwritten.
+		//Returns the MatchesCoalescedParam result for RM_MATCH_COALESCED, true otherwise.
+		typedef bool(*ReplayParamFcPtr)(UnityMessager&, const void* pData, int length, int coalescedParamIdx, ReplayMode mode);
+
+		struct StagedParam
+		{
+			ReplayParamFcPtr replayFcPtr;
+			const void* pData; //points to data held by the staging queue data blocks
+			int length; //array length for array parameters, not used by single parameters
+		};
+
+		struct StagedMessage
+		{
+			int receiverId;
+			int msgId;
+			ComponentIdGetterFcPtr componentIdGetterFcPtr; //NULL when not addressed to a component
+			const char* objectName; //NULL or a copy held by the staging queue data blocks
+			const char* methodName; //NULL or a copy held by the staging queue data blocks
+			int firstParamIdx; //index of the first parameter on m_params
+			int nOfParams;
+			bool isCoalesced; //sent by SendCoalescedMessage
+		};
+
+		//Returns space for size bytes from the data blocks, which are never moved, so the returned pointer is valid until the merge
+		void* AllocData(int size);
+		const char* CopyString(const char* str);
+
+		void StageParam() {} //just for compiling the variadic templates with no arguments
+
+		//StageParam variations corresponding to each PushParam variation, so the same overload is selected for a given parameter 
+		template <typename T> void StageParam(const T& param);
+		void StageParam(const char* stringParam);
+		void StageParam(const InternedString& stringParam);
+		template <typename T> void StageParam(const ArrayParam<T>& arrayParam);
+		template <typename T> void StageParam(const ArrayToFillParam<T>& arrayParam);
+		template <typename T> void StageParam(const UnityArrayParam<T>& unityArrayParam);
+		template <typename PARAM1, typename... OTHER_PARAMS> void StageParam(const PARAM1& param1, const OTHER_PARAMS&... otherParams);
+
+		template <typename T> static bool ReplaySingleParam(UnityMessager& unityMessager, const void* pData, int length,
+															int coalescedParamIdx, ReplayMode mode);
+		template <typename T> static bool ReplayArrayParam(UnityMessager& unityMessager, const void* pData, int length,
+														   int coalescedParamIdx, ReplayMode mode);
+		static bool ReplayInternedStringParam(UnityMessager& unityMessager, const void* pData, int length,
+											  int coalescedParamIdx, ReplayMode mode);
+
+		//Merges a staged message sent by SendCoalescedMessage, the same way SendCoalescedMessage does on the main thread
+		void MergeCoalescedMessage(UnityMessager& unityMessager, const StagedMessage& stagedMessage);
+
+		std::vector<StagedMessage> m_messages;
+		std::vector<StagedParam> m_params;
+
+		//Blocks of memory holding the parameter values. They are kept after the merge, so the staging queue stops allocating 
+		//memory once it gets enough for the usual amount of messages its producer sends between two deliveries.
+		std::vector<uint8*> m_dataBlocks;
+		std::vector<int> m_dataBlockSizes;
+		int m_currentDataBlockIdx;
+		int m_currentDataBlockPos;
+
+		//taken for each staged message and for the merge, so staging and merging are always safe, even if they overlap
+		std::mutex m_mutex;
+
+		std::atomic<bool>* m_pHasStagedMessagesFlag;
 	};
 };
 
@@ -5,112 +5,266 @@
 #define UNITY_MESSAGER_HPP
 
 #include "UnityMessager.h"
+#include "UnityMessagerCompact.h"
 #include "UnityArray.h"
 #include <string>
+#include <string.h>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
 
 //This is the "Unity Messager Receiver" id for the UnityMessager instance itself (at the C# side)
 #define UMR_MESSAGER 0
 
+//this corresponds to UnityMessager._controlQueueId on C#
+#define UM_CONTROL_QUEUE_ID 0
+
+//this corresponds to UnityMessager._payloadQueueId on C#, the queue created right after the control queue when interleaved
+#define UM_PAYLOAD_QUEUE_ID 1
+
 //"Unity Messager Receiver" defined messages for the UnityMessager instance itself (at the C# side)
 enum UmrMessagerMessages {
 	UMM_SET_QUEUE_ARRAY = 0, //(int queueId, int arrayId) => Sets the id of the next array to be used by the specified message queue 
 	UMM_SET_QUEUE_FIRST_ARRAY = 1,//(int queueId, int arrayId) => Sets the id for the first array of a message queue, which never changes
-	UMM_SET_RECEIVER_IDS_ARRAY = 2,//(int arrayId) => Sets the id for the array used to control the available receiver ids
+	UMM_SET_RECEIVER_IDS_ARRAY = 2,//(int arrayId) => Sets the id for the header of the receiver ids table, check UM_RECEIVER_IDS_HEAD_POS
 	UMM_FINISH_DELIVERING_MESSAGES = 3, //() => Sets the finish point for the delivering message process.
-	UMM_REGISTER_NEW_COMPONENT = 4
+	UMM_REGISTER_NEW_COMPONENT = 4,
+	UMM_DISCARDED_MESSAGE = 5, //(...) => Replaces a coalesced message that couldn't be overwritten in place, it is just ignored
+	UMM_REGISTER_PAYLOAD_TYPE = 6, //(int typeId, int alignment, int nameLength, int packedName...) => Payload type, check RegisterPayloadType
+	UMM_REGISTER_ROUTING_BINDING = 7, //(int bindingId, int componentId, string objectName, string methodName) => check GetRoutingBindingId
+	UMM_REGISTER_INTERNED_STRING = 8, //(int stringId, int length, int offset, int packedChars...) => check InternString
+	UMM_SET_INTERNED_STRING_QUEUE = 9, //(int queueId) => queue (or payload type) id of the InternedStringRef parameters
+	UMM_SET_QUEUE_SPILL_ARRAY = 10, //(int queueId, int arrayId) => The next parameter of the queue is at the start of this array
+	UMM_SET_QUEUE_UNITY_ARRAY = 11, //(int queueId, int arrayId, int pos) => The next parameter of the queue is on this array at pos
+	UMM_BATCH_MESSAGE = 12, //(int msgId, int[] receiverIds, columns...) => A message for each receiver, check SendBatchMessage
+	UMM_SET_STATISTICS_ARRAY = 13 //(int arrayId) => Sets the id for the array where the statistics are published, check GetStatistic
 };
 
+//When double buffered, UMM_SET_QUEUE_FIRST_ARRAY has a third parameter: the id for the first array of the other set of arrays
+#define UM_SET_QUEUE_FIRST_ARRAY_DOUBLE_BUFFERED_N_OF_PARAMS 3
+
+//Length of a UMM_SET_QUEUE_ARRAY control message on the control queue, always kept available by ControlQueue::AllocSpace
+#define UM_SET_QUEUE_ARRAY_MSG_LENGTH 5
+
+//Messages addressed through a routing binding carry it in place of the component id, as a value smaller than -1 
+//since -1 means no component. UnityMessager._firstRoutingBindingSlot is the corresponding constant on the C# code.
+#define UM_ROUTING_BINDING_COMPONENT_SLOT(bindingId) (-2 - (bindingId))
+
 namespace UnityForCpp
 {
 
 template<typename... PARAMS>
 void UnityMessager::SendMessage(int receiverId, int msgId, const PARAMS&... params)
 {
-	m_pControlQueue->SendMessage(receiverId, msgId);
-	PushParam(params...);
+	if (!IsOnMainThread())
+	{
+		GetStagingQueueForThisThread().StageMessage(receiverId, msgId, NULL, NULL, NULL, false, params...);
+		return;
+	}
+
+	SendMessageInSinglePass(receiverId, -1, msgId, params...);
 }
 
 template<typename COMPONENT_TYPE, typename... PARAMS>
 void UnityMessager::SendMessage(int receiverId, int msgId, const PARAMS&... params)
 {
-	m_pControlQueue->SendMessage(receiverId, COMPONENT_TYPE::GetId(), msgId);
-	PushParam(params...);
+	if (!IsOnMainThread())
+	{
+		GetStagingQueueForThisThread().StageMessage(receiverId, msgId, &COMPONENT_TYPE::GetId, NULL, NULL, false, params...);
+		return;
+	}
+
+	SendMessageInSinglePass(receiverId, COMPONENT_TYPE::GetId(m_channelId), msgId, params...);
 }
 
 template<typename COMPONENT_TYPE, typename... PARAMS>
 void UnityMessager::SendMessage(int receiverId, const char* methodName, const PARAMS&... params)
 {
-	int componentId = COMPONENT_TYPE::GetId(); //MUST COME BEFORE modifing any message queue, since this may call SendMessage internally
-	int methodNameLength = strlen(methodName);
-	
-	//Push the method name direcly on the Byte parameter queue, but without registering it as a parameter
-	ParamQueue<uint8>::GetInstance().Push((const uint8*)methodName, methodNameLength);
-
-	//We mark we are using reflection instead of a usual message id by setting the negative method name length as the message id
-	m_pControlQueue->SendMessage(receiverId, componentId, -methodNameLength);
+	if (!IsOnMainThread())
+	{
+		GetStagingQueueForThisThread().StageMessage(receiverId, 0, &COMPONENT_TYPE::GetId, NULL, methodName, false, params...);
+		return;
+	}
 
-	PushParam(params...);
+	int componentId = COMPONENT_TYPE::GetId(m_channelId);
+	SendRoutedMessage(receiverId, componentId, 0, NULL, methodName, GetRoutingBindingId(componentId, NULL, methodName), params...);
 }
 
 template<typename COMPONENT_TYPE, typename... PARAMS> 
 void UnityMessager::SendMessage(const char* objectName, int msgId, const PARAMS&... params)
 {
-	int componentId = COMPONENT_TYPE::GetId(); //MUST COME BEFORE modifing any message queue, since this may call SendMessage internally
-	int objectNameLength = strlen(objectName);
+	if (!IsOnMainThread())
+	{
+		GetStagingQueueForThisThread().StageMessage(0, msgId, &COMPONENT_TYPE::GetId, objectName, NULL, false, params...);
+		return;
+	}
 
-	//Push the object name direcly on the Byte parameter queue, but without registering it as a parameter
-	ParamQueue<uint8>::GetInstance().Push((const uint8*)objectName, objectNameLength);
+	int componentId = COMPONENT_TYPE::GetId(m_channelId);
+	SendRoutedMessage(0, componentId, msgId, objectName, NULL, GetRoutingBindingId(componentId, objectName, NULL), params...);
+}
 
-	//We mark we are using reflection instead of a usual receiver id by setting the negative object name length as the receiver id
-	m_pControlQueue->SendMessage(-objectNameLength, componentId, msgId);
+template<typename COMPONENT_TYPE, typename... PARAMS> 
+void UnityMessager::SendMessage(const char* objectName, const char* methodName, const PARAMS&... params)
+{
+	if (!IsOnMainThread())
+	{
+		GetStagingQueueForThisThread().StageMessage(0, 0, &COMPONENT_TYPE::GetId, objectName, methodName, false, params...);
+		return;
+	}
 
-	PushParam(params...);
+	int componentId = COMPONENT_TYPE::GetId(m_channelId);
+	SendRoutedMessage(0, componentId, 0, objectName, methodName, GetRoutingBindingId(componentId, objectName, methodName), params...);
 }
 
 template<typename COMPONENT_TYPE, typename... PARAMS> 
-void UnityMessager::SendMessage(const char* objectName, const char* methodName, const PARAMS&... params)
+void UnityMessager::SendMessage(const NamedRoute& route, const PARAMS&... params)
 {
-	int componentId = COMPONENT_TYPE::GetId(); //MUST COME BEFORE modifing any message queue, since this may call SendMessage internally
+	ASSERT(route.m_objectName); //routes with only a method name are sent to a receiverId
+	if (!IsOnMainThread())
+	{
+		GetStagingQueueForThisThread().StageMessage(0, route.m_msgId, &COMPONENT_TYPE::GetId, route.m_objectName, 
+													route.m_methodName, false, params...);
+		return;
+	}
 
-	//Push the object name direcly on the Byte parameter queue, but without registering it as a parameter
-	int objectNameLength = strlen(objectName);
-	ParamQueue<uint8>::GetInstance().Push((const uint8*)objectName, objectNameLength);
+	int componentId = COMPONENT_TYPE::GetId(m_channelId);
+	SendRoutedMessage(0, componentId, route.m_msgId, route.m_objectName, route.m_methodName, 
+					  GetRoutingBindingId(componentId, route), params...);
+}
 
-	//Push the method name direcly on the Byte parameter queue, but without registering it as a parameter
-	int methodNameLength = strlen(methodName);
-	ParamQueue<uint8>::GetInstance().Push((const uint8*)methodName, methodNameLength);
+template<typename COMPONENT_TYPE, typename... PARAMS> 
+void UnityMessager::SendMessage(int receiverId, const NamedRoute& methodRoute, const PARAMS&... params)
+{
+	ASSERT(!methodRoute.m_objectName && methodRoute.m_methodName);
+	if (!IsOnMainThread())
+	{
+		GetStagingQueueForThisThread().StageMessage(receiverId, 0, &COMPONENT_TYPE::GetId, NULL, methodRoute.m_methodName, 
+													false, params...);
+		return;
+	}
+
+	int componentId = COMPONENT_TYPE::GetId(m_channelId);
+	SendRoutedMessage(receiverId, componentId, 0, NULL, methodRoute.m_methodName, GetRoutingBindingId(componentId, methodRoute), 
+					  params...);
+}
 
-	//We mark where strings are used instead of the usual ids by setting their negative lengths instead as the ids
-	m_pControlQueue->SendMessage(-objectNameLength, componentId, -methodNameLength);
+template<typename... PARAMS>
+void UnityMessager::SendCoalescedMessage(int receiverId, int msgId, const PARAMS&... params)
+{
+	if (!IsOnMainThread())
+	{
+		GetStagingQueueForThisThread().StageMessage(receiverId, msgId, NULL, NULL, NULL, true, params...);
+		return;
+	}
 
-	PushParam(params...);
+	CoalescedMessage* pPreviousMessage = FindCoalescedMessage(receiverId, msgId);
+	if (pPreviousMessage && pPreviousMessage->nOfParams == sizeof...(PARAMS) 
+		&& MatchesCoalescedParam(pPreviousMessage->firstParamIdx, params...))
+	{
+		OverwriteCoalescedParam(pPreviousMessage->firstParamIdx, params...);
+		return;
+	}
+
+	StartCoalescedMessage(receiverId, msgId, sizeof...(PARAMS), pPreviousMessage);
+	PushCoalescedParam(params...);
 }
 
+template<typename... PARAMS>
+void UnityMessager::SendBatchMessage(const int* receiverIds, int nOfReceivers, int msgId, const PARAMS&... columns)
+{
+	ASSERT(msgId >= 0 && nOfReceivers >= 0 && AreBatchColumns(nOfReceivers, columns...));
+	if (nOfReceivers == 0)
+		return;
+
+	//the receiver ids are sent as the first column, being the batch delivered by the UnityMessager itself at the C# side
+	SendMessage(UMR_MESSAGER, UMM_BATCH_MESSAGE, msgId, UM_ARRAY_PARAM(receiverIds, nOfReceivers), columns...);
+	if (IsOnMainThread()) //staged ones are counted when merged
+		CountBatchMessages(msgId, nOfReceivers);
+}
+
+template <typename PARAM1, typename... OTHER_PARAMS>
+inline bool UnityMessager::AreBatchColumns(int length, const PARAM1& column1, const OTHER_PARAMS&... otherColumns)
+{
+	return GetBatchColumnLength(column1) == length && AreBatchColumns(length, otherColumns...);
+}
 
 inline void UnityMessager::PushParam(const char* stringParam)
 {	//a C string is just pushed as an uint8 array (System.Byte array at the C# side)
 	PushParam(UM_ARRAY_PARAM((const uint8*)stringParam, strlen(stringParam)));
 }
 
+inline void UnityMessager::PushParam(const InternedString& stringParam)
+{
+	InternedStringRef stringRef = { GetInternedStringId(stringParam) }; //MUST come first, it may send control messages
+	PushParam(stringRef);
+}
+
 template <typename T> 
 inline void UnityMessager::PushParam(const ArrayParam<T>& arrayParam)
 {
-	ParamQueue<T>::GetInstance().Push(arrayParam.pArray, arrayParam.length);
-	m_pControlQueue->RegisterParam(ParamQueue<T>::GetInstance().GetQueueId(), arrayParam.length);
+	int queueId;
+	memcpy(PushParamSpace<T>(arrayParam.length, queueId), arrayParam.pArray, arrayParam.length*sizeof(T));
+	m_pControlQueue->RegisterParam(queueId, arrayParam.length);
 }
 
 template <typename T>
 inline void UnityMessager::PushParam(const ArrayToFillParam<T>& arrayToFillParam)
 {
-	ParamQueue<T>::GetInstance().PushAndGetPtrToFill(&(arrayToFillParam.m_pArray), arrayToFillParam.GetLength());
-	m_pControlQueue->RegisterParam(ParamQueue<T>::GetInstance().GetQueueId(), arrayToFillParam.GetLength());
+	int queueId;
+	arrayToFillParam.m_pArray = PushParamSpace<T>(arrayToFillParam.GetLength(), queueId);
+	m_pControlQueue->RegisterParam(queueId, arrayToFillParam.GetLength());
+}
+
+template <typename T>
+inline void UnityMessager::PushParam(const UnityArrayParam<T>& unityArrayParam)
+{
+	m_pControlQueue->RegisterParam(ReferUnityArray(unityArrayParam), unityArrayParam.length);
+}
+
+template <typename T>
+inline int UnityMessager::ReferUnityArray(const UnityArrayParam<T>& unityArrayParam)
+{
+	int queueId = GetParamQueueId<T>(); //MUST come first, it may create the queue or register the payload type
+
+	//positions on the payload queue are in bytes
+	int msgParams[3] = { m_pPayloadQueue ? m_pPayloadQueue->GetQueueId() : queueId, unityArrayParam.pUnityArray->GetId(),
+						 m_pPayloadQueue ? unityArrayParam.offset * (int)sizeof(T) : unityArrayParam.offset };
+	m_pControlQueue->SendControlMessage(UMM_SET_QUEUE_UNITY_ARRAY, 3, msgParams);
+
+	RetainArrayUntilDelivered(unityArrayParam.pUnityArray->GetId());
+	return queueId;
 }
 
 template <typename T>
 inline void UnityMessager::PushParam(const T& param)
 {
-	ParamQueue<T>::GetInstance().Push(param);
-	m_pControlQueue->RegisterParam(ParamQueue<T>::GetInstance().GetQueueId());
+	int queueId;
+	*PushParamSpace<T>(-1, queueId) = param;
+	m_pControlQueue->RegisterParam(queueId);
+}
+
+inline void UnityMessager::CountSentMessage(int receiverId, int componentId, int msgId)
+{
+	if (!m_isCollectingStatistics)
+		return;
+
+	if (receiverId == UMR_MESSAGER && componentId < 0) //name based messages also have receiverId 0, but a component
+	{
+		++m_statistics[UM_STATISTIC_N_OF_CONTROL_MESSAGES];
+		return;
+	}
+
+	++m_statistics[UM_STATISTIC_N_OF_MESSAGES];
+	++m_nOfMessagesByMsgId[msgId];
+}
+
+inline void UnityMessager::CountBatchMessages(int msgId, int nOfReceivers)
+{
+	if (!m_isCollectingStatistics)
+		return;
+
+	m_statistics[UM_STATISTIC_N_OF_MESSAGES] += nOfReceivers;
+	m_nOfMessagesByMsgId[msgId] += nOfReceivers;
 }
 
 template <typename PARAM1, typename... OTHER_PARAMS>
@@ -120,15 +274,408 @@ inline void UnityMessager::PushParam(const PARAM1& param1, const OTHER_PARAMS&..
 	PushParam(otherParams...);
 }
 
+//ParamTraits for the parameter types handled by the specific PushParam variations
+template <typename T>
+struct UnityMessager::ParamTraits< UnityMessager::ArrayParam<T> > { typedef T QueueType; enum { c_isArray = 1, c_isUnityArray = 0 }; };
+
+template <typename T>
+struct UnityMessager::ParamTraits< UnityMessager::ArrayToFillParam<T> > { typedef T QueueType; enum { c_isArray = 1, c_isUnityArray = 0 }; };
+
+template <>
+struct UnityMessager::ParamTraits<const char*> { typedef uint8 QueueType; enum { c_isArray = 1, c_isUnityArray = 0 }; };
+
+template <int N> //string literals
+struct UnityMessager::ParamTraits<char[N]> { typedef uint8 QueueType; enum { c_isArray = 1, c_isUnityArray = 0 }; };
+
+template <>
+struct UnityMessager::ParamTraits<UnityMessager::InternedString> { typedef InternedStringRef QueueType; enum { c_isArray = 0, c_isUnityArray = 0 }; };
+
+template <typename T>
+struct UnityMessager::ParamTraits< UnityMessager::UnityArrayParam<T> > { typedef T QueueType; enum { c_isArray = 1, c_isUnityArray = 1 }; };
+
+template <>
+struct UnityMessager::HasUnityArrayParam<> { enum { c_value = 0 }; };
+
+template <typename PARAM1, typename... OTHER_PARAMS>
+struct UnityMessager::HasUnityArrayParam<PARAM1, OTHER_PARAMS...> { enum { c_value = HasUnityArrayParam<OTHER_PARAMS...>::c_value }; };
+
+template <typename T, typename... OTHER_PARAMS>
+struct UnityMessager::HasUnityArrayParam<UnityMessager::UnityArrayParam<T>, OTHER_PARAMS...> { enum { c_value = 1 }; };
+
+template <typename QUEUE_TYPE>
+struct UnityMessager::UsesParamQueue<QUEUE_TYPE> { enum { c_value = 0, c_byUnityArray = 0 }; };
+
+template <typename QUEUE_TYPE, typename PARAM1, typename... OTHER_PARAMS>
+struct UnityMessager::UsesParamQueue<QUEUE_TYPE, PARAM1, OTHER_PARAMS...>
+{
+	enum { 
+		c_value = std::is_same<QUEUE_TYPE, typename ParamTraits<PARAM1>::QueueType>::value
+				  || UsesParamQueue<QUEUE_TYPE, OTHER_PARAMS...>::c_value,
+		c_byUnityArray = (std::is_same<QUEUE_TYPE, typename ParamTraits<PARAM1>::QueueType>::value && ParamTraits<PARAM1>::c_isUnityArray)
+						 || UsesParamQueue<QUEUE_TYPE, OTHER_PARAMS...>::c_byUnityArray
+	};
+};
+
+template <>
+struct UnityMessager::MessageLayout<> { enum { c_nOfArrayParams = 0, c_hasSharedUnityArrayQueue = 0 }; };
+
+template <typename PARAM1, typename... OTHER_PARAMS>
+struct UnityMessager::MessageLayout<PARAM1, OTHER_PARAMS...>
+{
+	typedef UsesParamQueue<typename ParamTraits<PARAM1>::QueueType, OTHER_PARAMS...> OthersUseQueue;
+	enum {
+		c_nOfArrayParams = ParamTraits<PARAM1>::c_isArray + MessageLayout<OTHER_PARAMS...>::c_nOfArrayParams,
+		//an UnityArrayParam sharing its ParamQueue with other parameter, either PARAM1 or one of the others
+		c_hasSharedUnityArrayQueue = (ParamTraits<PARAM1>::c_isUnityArray ? OthersUseQueue::c_value : OthersUseQueue::c_byUnityArray)
+									 || MessageLayout<OTHER_PARAMS...>::c_hasSharedUnityArrayQueue
+	};
+};
+
+template <typename... PARAMS>
+inline void UnityMessager::SendMessageInSinglePass(int receiverId, int componentId, int msgId, const PARAMS&... params)
+{
+	typedef MessageLayout<PARAMS...> Layout;
+	++m_messageSerial;
+
+	//when interleaved all the parameters go to the payload queue, so it is the whole message that can't have an array advance
+	if (m_pPayloadQueue ? HasUnityArrayParam<PARAMS...>::c_value != 0 || !m_pPayloadQueue->Reserve(GetMaxPayloadLength(params...))
+						: Layout::c_hasSharedUnityArrayQueue != 0 || !ReserveParamQueues(params...))
+	{
+		StartMessage(receiverId, componentId, msgId, NULL, NULL);
+		PushParam(params...);
+		return;
+	}
+
+	ParamRegistration registrations[sizeof...(PARAMS) + 1]; //+1 just for avoiding a zero length array
+	PushParamData(registrations, params...);
+	CountSentMessage(receiverId, componentId, msgId);
+	m_pControlQueue->SendMessage(receiverId, componentId, msgId, sizeof...(PARAMS), Layout::c_nOfArrayParams, registrations);
+}
+
+inline int UnityMessager::GetRoutingBindingId(int componentId, const NamedRoute& route)
+{
+	if (route.m_cachedInstanceSerial != m_instanceSerial || route.m_cachedComponentId != componentId)
+	{	//component ids are given by each instance, which has its own bindings
+		route.m_cachedBindingId = GetRoutingBindingId(componentId, route.m_objectName, route.m_methodName);
+		route.m_cachedComponentId = componentId;
+		route.m_cachedInstanceSerial = m_instanceSerial;
+	}
+
+	return route.m_cachedBindingId;
+}
+
+template <typename... PARAMS>
+inline void UnityMessager::SendRoutedMessage(int receiverId, int componentId, int msgId, const char* objectName, 
+											 const char* methodName, int bindingId, const PARAMS&... params)
+{
+	if (bindingId < 0)
+	{
+		StartMessage(receiverId, componentId, msgId, objectName, methodName);
+		PushParam(params...);
+		return;
+	}
+
+	//the C# side gets the names from the binding, so the message is the same of a message to a component by ids
+	SendMessageInSinglePass(objectName ? -1 : receiverId, UM_ROUTING_BINDING_COMPONENT_SLOT(bindingId), methodName ? -1 : msgId, 
+							params...);
+}
+
+template <typename PARAM1, typename... OTHER_PARAMS>
+inline bool UnityMessager::ReserveParamQueues(const PARAM1& param1, const OTHER_PARAMS&... otherParams)
+{
+	//the later parameters of a same queue reserve less than the first one, so they don't advance it again
+	typedef typename ParamTraits<PARAM1>::QueueType QueueType;
+	if (UsesParamQueue<QueueType, OTHER_PARAMS...>::c_value 
+		&& !ParamQueue<QueueType>::GetInstance(*this).Reserve(GetParamQueueLength<QueueType>(param1, otherParams...)))
+		return false;
+
+	return ReserveParamQueues(otherParams...);
+}
+
+template <typename QUEUE_TYPE, typename PARAM1, typename... OTHER_PARAMS>
+inline int UnityMessager::GetParamQueueLength(const PARAM1& param1, const OTHER_PARAMS&... otherParams)
+{
+	return (std::is_same<QUEUE_TYPE, typename ParamTraits<PARAM1>::QueueType>::value ? GetParamLength(param1) : 0)
+		   + GetParamQueueLength<QUEUE_TYPE>(otherParams...);
+}
+
+template <typename T>
+inline void UnityMessager::PushParamData(ParamRegistration* pRegistration, const T& param)
+{
+	*PushParamSpace<T>(-1, pRegistration->queueId) = param;
+	pRegistration->length = -1;
+}
+
+inline void UnityMessager::PushParamData(ParamRegistration* pRegistration, const char* stringParam)
+{
+	PushParamData(pRegistration, UM_ARRAY_PARAM((const uint8*)stringParam, strlen(stringParam)));
+}
+
+inline void UnityMessager::PushParamData(ParamRegistration* pRegistration, const InternedString& stringParam)
+{
+	InternedStringRef stringRef = { GetInternedStringId(stringParam) };
+	PushParamData(pRegistration, stringRef);
+}
+
+template <typename T>
+inline void UnityMessager::PushParamData(ParamRegistration* pRegistration, const ArrayParam<T>& arrayParam)
+{
+	memcpy(PushParamSpace<T>(arrayParam.length, pRegistration->queueId), arrayParam.pArray, arrayParam.length*sizeof(T));
+	pRegistration->length = arrayParam.length;
+}
+
+template <typename T>
+inline void UnityMessager::PushParamData(ParamRegistration* pRegistration, const UnityArrayParam<T>& unityArrayParam)
+{
+	pRegistration->queueId = ReferUnityArray(unityArrayParam);
+	pRegistration->length = unityArrayParam.length;
+}
+
+template <typename T>
+inline void UnityMessager::PushParamData(ParamRegistration* pRegistration, const ArrayToFillParam<T>& arrayToFillParam)
+{
+	arrayToFillParam.m_pArray = PushParamSpace<T>(arrayToFillParam.GetLength(), pRegistration->queueId);
+	pRegistration->length = arrayToFillParam.GetLength();
+}
+
+template <typename PARAM1, typename... OTHER_PARAMS>
+inline void UnityMessager::PushParamData(ParamRegistration* pRegistration, const PARAM1& param1, const OTHER_PARAMS&... otherParams)
+{
+	PushParamData(pRegistration, param1);
+	PushParamData(pRegistration + 1, otherParams...);
+}
+
+template <typename T>
+inline T* UnityMessager::PushParamSpace(int length, int& queueId)
+{
+	int nOfItems = length >= 0 ? length : 1;
+	if (m_pPayloadQueue)
+	{
+		queueId = GetPayloadTypeId<T>();
+		return reinterpret_cast<T*>(m_pPayloadQueue->Push(nOfItems * sizeof(T), std::alignment_of<T>::value));
+	}
+
+	ParamQueue<T>& paramQueue = ParamQueue<T>::GetInstance(*this);
+	queueId = paramQueue.GetQueueId();
+
+	T* pParamDataDest;
+	paramQueue.PushAndGetPtrToFill(&pParamDataDest, nOfItems);
+	return pParamDataDest;
+}
+
+template <typename T>
+inline int UnityMessager::GetParamQueueId()
+{
+	return m_pPayloadQueue ? GetPayloadTypeId<T>() : ParamQueue<T>::GetInstance(*this).GetQueueId();
+}
+
+//-1 means the type was not registered yet on the channel
+template <typename T> int UnityMessager::PayloadType<T>::s_ids[UM_MAX_N_OF_CHANNELS] = UM_UNREGISTERED_CHANNEL_IDS;
+
+template <typename T>
+inline int UnityMessager::GetPayloadTypeId()
+{
+	int typeId = PayloadType<T>::s_ids[m_channelId];
+	return typeId >= 0 ? typeId : RegisterPayloadType(UnityArray<T>::s_managedTypeName, sizeof(T), std::alignment_of<T>::value, 
+													  &PayloadType<T>::s_ids[m_channelId]);
+}
+
+template <typename T>
+inline int UnityMessager::GetMaxPayloadLength(const T& param)
+{
+	return sizeof(T) + std::alignment_of<T>::value - 1;
+}
+
+inline int UnityMessager::GetMaxPayloadLength(const char* stringParam)
+{
+	return strlen(stringParam);
+}
+
+inline int UnityMessager::GetMaxPayloadLength(const InternedString& stringParam)
+{
+	return GetMaxPayloadLength(InternedStringRef());
+}
+
+template <typename T>
+inline int UnityMessager::GetMaxPayloadLength(const ArrayParam<T>& arrayParam)
+{
+	return arrayParam.length*sizeof(T) + std::alignment_of<T>::value - 1;
+}
+
+template <typename T>
+inline int UnityMessager::GetMaxPayloadLength(const ArrayToFillParam<T>& arrayToFillParam)
+{
+	return arrayToFillParam.GetLength()*sizeof(T) + std::alignment_of<T>::value - 1;
+}
+
+template <typename PARAM1, typename... OTHER_PARAMS>
+inline int UnityMessager::GetMaxPayloadLength(const PARAM1& param1, const OTHER_PARAMS&... otherParams)
+{
+	return GetMaxPayloadLength(param1) + GetMaxPayloadLength(otherParams...);
+}
+
+template <typename T>
+inline void UnityMessager::PushCoalescedParam(const T& param)
+{
+	CoalescedParam coalescedParam = { -1, -1, NULL };
+	T* pParamDataDest = PushParamSpace<T>(-1, coalescedParam.queueId);
+	*pParamDataDest = param;
+	coalescedParam.pData = pParamDataDest;
+	m_pControlQueue->RegisterParam(coalescedParam.queueId);
+	m_coalescedParams.push_back(coalescedParam);
+}
+
+inline void UnityMessager::PushCoalescedParam(const char* stringParam)
+{	//a C string is just pushed as an uint8 array, the same way PushParam does
+	PushCoalescedParam(UM_ARRAY_PARAM((const uint8*)stringParam, strlen(stringParam)));
+}
+
+inline void UnityMessager::PushCoalescedParam(const InternedString& stringParam)
+{	//not interned, an id overwritten in place could be read before its string gets registered on the C# side
+	PushCoalescedParam(UM_ARRAY_PARAM((const uint8*)stringParam.m_str, stringParam.m_length));
+}
+
+template <typename T>
+inline void UnityMessager::PushCoalescedParam(const ArrayParam<T>& arrayParam)
+{
+	CoalescedParam coalescedParam = { -1, arrayParam.length, NULL };
+	coalescedParam.pData = PushParamSpace<T>(arrayParam.length, coalescedParam.queueId);
+	memcpy(coalescedParam.pData, arrayParam.pArray, arrayParam.length*sizeof(T));
+	m_pControlQueue->RegisterParam(coalescedParam.queueId, arrayParam.length);
+	m_coalescedParams.push_back(coalescedParam);
+}
+
+template <typename T>
+inline void UnityMessager::PushCoalescedParam(const ArrayToFillParam<T>& arrayToFillParam)
+{
+	CoalescedParam coalescedParam = { -1, arrayToFillParam.GetLength(), NULL };
+	arrayToFillParam.m_pArray = PushParamSpace<T>(arrayToFillParam.GetLength(), coalescedParam.queueId);
+	coalescedParam.pData = arrayToFillParam.m_pArray;
+	m_pControlQueue->RegisterParam(coalescedParam.queueId, arrayToFillParam.GetLength());
+	m_coalescedParams.push_back(coalescedParam);
+}
+
+template <typename T>
+inline void UnityMessager::PushCoalescedParam(const UnityArrayParam<T>& unityArrayParam)
+{	//copied, the values of the previous message are overwritten in place
+	PushCoalescedParam(unityArrayParam.AsArrayParam());
+}
+
+template <typename PARAM1, typename... OTHER_PARAMS>
+inline void UnityMessager::PushCoalescedParam(const PARAM1& param1, const OTHER_PARAMS&... otherParams)
+{
+	PushCoalescedParam(param1);
+	PushCoalescedParam(otherParams...);
+}
+
+template <typename T>
+inline bool UnityMessager::MatchesCoalescedParam(int paramIdx, const T& param)
+{
+	const CoalescedParam& coalescedParam = m_coalescedParams[paramIdx];
+	return coalescedParam.length < 0 && coalescedParam.queueId == GetParamQueueId<T>();
+}
+
+inline bool UnityMessager::MatchesCoalescedParam(int paramIdx, const char* stringParam)
+{
+	return MatchesCoalescedParam(paramIdx, UM_ARRAY_PARAM((const uint8*)stringParam, strlen(stringParam)));
+}
+
+inline bool UnityMessager::MatchesCoalescedParam(int paramIdx, const InternedString& stringParam)
+{
+	return MatchesCoalescedParam(paramIdx, UM_ARRAY_PARAM((const uint8*)stringParam.m_str, stringParam.m_length));
+}
+
+template <typename T>
+inline bool UnityMessager::MatchesCoalescedParam(int paramIdx, const ArrayParam<T>& arrayParam)
+{
+	const CoalescedParam& coalescedParam = m_coalescedParams[paramIdx];
+	return coalescedParam.length == arrayParam.length && coalescedParam.queueId == GetParamQueueId<T>();
+}
+
+template <typename T>
+inline bool UnityMessager::MatchesCoalescedParam(int paramIdx, const ArrayToFillParam<T>& arrayToFillParam)
+{
+	const CoalescedParam& coalescedParam = m_coalescedParams[paramIdx];
+	return coalescedParam.length == arrayToFillParam.GetLength() 
+			&& coalescedParam.queueId == GetParamQueueId<T>();
+}
+
+template <typename T>
+inline bool UnityMessager::MatchesCoalescedParam(int paramIdx, const UnityArrayParam<T>& unityArrayParam)
+{
+	return MatchesCoalescedParam(paramIdx, unityArrayParam.AsArrayParam());
+}
+
+template <typename PARAM1, typename... OTHER_PARAMS>
+inline bool UnityMessager::MatchesCoalescedParam(int paramIdx, const PARAM1& param1, const OTHER_PARAMS&... otherParams)
+{
+	return MatchesCoalescedParam(paramIdx, param1) && MatchesCoalescedParam(paramIdx + 1, otherParams...);
+}
+
+template <typename T>
+inline void UnityMessager::OverwriteCoalescedParam(int paramIdx, const T& param)
+{
+	*reinterpret_cast<T*>(m_coalescedParams[paramIdx].pData) = param;
+}
+
+inline void UnityMessager::OverwriteCoalescedParam(int paramIdx, const char* stringParam)
+{
+	OverwriteCoalescedParam(paramIdx, UM_ARRAY_PARAM((const uint8*)stringParam, strlen(stringParam)));
+}
+
+inline void UnityMessager::OverwriteCoalescedParam(int paramIdx, const InternedString& stringParam)
+{
+	OverwriteCoalescedParam(paramIdx, UM_ARRAY_PARAM((const uint8*)stringParam.m_str, stringParam.m_length));
+}
+
+template <typename T>
+inline void UnityMessager::OverwriteCoalescedParam(int paramIdx, const ArrayParam<T>& arrayParam)
+{
+	memcpy(m_coalescedParams[paramIdx].pData, arrayParam.pArray, arrayParam.length*sizeof(T));
+}
+
+template <typename T>
+inline void UnityMessager::OverwriteCoalescedParam(int paramIdx, const ArrayToFillParam<T>& arrayToFillParam)
+{	//the array gets filled directly over the values of the previous message
+	arrayToFillParam.m_pArray = reinterpret_cast<T*>(m_coalescedParams[paramIdx].pData);
+}
+
+template <typename T>
+inline void UnityMessager::OverwriteCoalescedParam(int paramIdx, const UnityArrayParam<T>& unityArrayParam)
+{
+	OverwriteCoalescedParam(paramIdx, unityArrayParam.AsArrayParam());
+}
+
+template <typename PARAM1, typename... OTHER_PARAMS>
+inline void UnityMessager::OverwriteCoalescedParam(int paramIdx, const PARAM1& param1, const OTHER_PARAMS&... otherParams)
+{
+	OverwriteCoalescedParam(paramIdx, param1);
+	OverwriteCoalescedParam(paramIdx + 1, otherParams...);
+}
+
+inline int UnityMessager::GetInternedStringId(const InternedString& stringParam)
+{
+	int id = stringParam.m_cachedId;
+	if (id >= 0 && id < (int)m_internedStrings.size() && m_internedStrings[id].stamp == stringParam.m_cachedStamp)
+	{
+		m_internedStrings[id].isReferenced = true;
+		m_internedStrings[id].lastMessageSerial = m_messageSerial;
+		return id;
+	}
+
+	return InternString(stringParam);
+}
+
 template <typename T>
 inline T* UnityMessager::MessageQueue<T>::AllocSpace(int length)
 {
 	//If we don't have enough space on the current array, we need to advance to the next array of the queue.
 	if (m_currentArrayPos + length > m_pCurrentNode->unityArray.GetLength())
 	{
-		//We can never push an array with bigger length than the UnityArray length for a message queue. 
-		//An isolated UnityArray must be used on these cases, having its id passed as int parameter.
-		ASSERT(length < m_pCurrentNode->unityArray.GetLength());
+		//An array with bigger length than the UnityArray length for a message queue goes to a spill array
+		if (length > GetMinArrayLength())
+			return AllocSpillSpace(length);
+
 		AdvanceToNextUnityArrayNode();
 	}
 
@@ -137,13 +684,84 @@ inline T* UnityMessager::MessageQueue<T>::AllocSpace(int length)
 }
 
 template <typename T>
-UnityMessager::MessageQueue<T>::MessageQueue()
-	: m_pFirstNode(NULL), m_pCurrentNode(NULL), m_currentArrayPos(0), m_queueId(-1)
+inline bool UnityMessager::MessageQueue<T>::Reserve(int length)
+{
+	if (length > GetMinArrayLength()) //the next array may be shorter than the current one
+		return false;
+
+	if (m_currentArrayPos + length > m_pCurrentNode->unityArray.GetLength())
+		AdvanceToNextUnityArrayNode();
+
+	return true;
+}
+
+template <typename T>
+T* UnityMessager::MessageQueue<T>::AllocSpillSpace(int length)
+{
+	std::vector<UnityArray<T>*>& pool = m_spillArraysPool[GetSpillSizeClass(length)];
+	UnityArray<T>* pSpillArray = NULL;
+	m_unityMessager.AddToStatistic(UM_STATISTIC_N_OF_SPILLED_PARAMS, 1);
+	if (!pool.empty() && pool.back()->GetLength() >= length)
+	{
+		pSpillArray = pool.back();
+		pool.pop_back();
+	}
+	else
+	{
+		//all the arrays of a class have its length, except when it would exceed the int range
+		int64 classLength = (int64)m_pFirstNode->unityArray.GetLength() << GetSpillSizeClass(length);
+		pSpillArray = new UnityArray<T>();
+		pSpillArray->Alloc(classLength > 0x7FFFFFFF ? length : (int)classLength);
+		m_unityMessager.AddToStatistic(UM_STATISTIC_N_OF_SPILL_ARRAY_ALLOCS, 1);
+	}
+
+	m_spillArraysInUse[m_spillArraysInUseIdx].push_back(pSpillArray);
+
+	int msgParams[2] = { m_queueId, pSpillArray->GetId() };
+	m_unityMessager.m_pControlQueue->SendControlMessage(UMM_SET_QUEUE_SPILL_ARRAY, 2, msgParams);
+
+	return &((*pSpillArray)[0]);
+}
+
+template <typename T>
+int UnityMessager::MessageQueue<T>::GetSpillSizeClass(int length)
+{
+	int sizeClass = 1;
+	while (((int64)m_pFirstNode->unityArray.GetLength() << sizeClass) < length)
+		++sizeClass;
+
+	ASSERT(sizeClass < UM_N_OF_SPILL_ARRAY_SIZE_CLASSES);
+	return sizeClass;
+}
+
+template <typename T>
+void UnityMessager::MessageQueue<T>::DeleteSpillArrays()
+{
+	for (int i = 0; i < UM_N_OF_SPILL_ARRAY_SIZE_CLASSES + 2; ++i)
+	{
+		std::vector<UnityArray<T>*>& spillArrays = i < UM_N_OF_SPILL_ARRAY_SIZE_CLASSES ? m_spillArraysPool[i] 
+																						 : m_spillArraysInUse[i - UM_N_OF_SPILL_ARRAY_SIZE_CLASSES];
+		for (size_t j = 0; j < spillArrays.size(); ++j)
+			DELETE(spillArrays[j]);
+
+		spillArrays.clear();
+	}
+}
+
+template <typename T>
+UnityMessager::MessageQueue<T>::MessageQueue(UnityMessager& unityMessager)
+	: m_pFirstNode(NULL), m_pSecondFirstNode(NULL), m_pCurrentNode(NULL), m_currentArrayPos(0), m_queueId(-1),
+	m_arraysLength(0), m_currentWindowPeakLength(0), m_lastWindowPeakLength(0), m_nOfDeliveringsOnWindow(0), 
+	m_spillArraysInUseIdx(0), m_unityMessager(unityMessager)
 {
-	UnityMessager& unityMessager = UnityMessager::GetInstance();
 
 	m_pFirstNode = new Node(unityMessager.GetMaxQueueArraysSizeInBytes() / sizeof(T));
 	m_pCurrentNode = m_pFirstNode;
+	m_arraysLength = m_pFirstNode->unityArray.GetLength();
+
+	if (unityMessager.IsDoubleBuffered())
+		m_pSecondFirstNode = new Node(m_pFirstNode->unityArray.GetLength());
+
 	m_queueId = unityMessager.GetNextFreeQueueIdAndIncrement();
 	unityMessager.RegisterMessageQueue(m_queueId, this);
 }
@@ -158,19 +776,32 @@ UnityMessager::MessageQueue<T>::~MessageQueue()
 		m_pFirstNode = m_pFirstNode->pNext;
 		DELETE(pToDelete);
 	}
+
+	while (m_pSecondFirstNode) //the same for the second list of nodes when double buffered
+	{
+		Node* pToDelete = m_pSecondFirstNode;
+		m_pSecondFirstNode = m_pSecondFirstNode->pNext;
+		DELETE(pToDelete);
+	}
+
+	DeleteSpillArrays();
 }
 
 template <typename T>
 void UnityMessager::MessageQueue<T>::AdvanceToNextUnityArrayNode()
 {
+	m_unityMessager.AddToStatistic(UM_STATISTIC_N_OF_ARRAY_ADVANCES, 1);
 	if (m_pCurrentNode->pNext == NULL) //we may have it already created from previous usages
-		m_pCurrentNode->pNext = new Node(m_pFirstNode->unityArray.GetLength());
+	{
+		m_pCurrentNode->pNext = new Node(m_arraysLength);
+		m_unityMessager.AddToStatistic(UM_STATISTIC_N_OF_ARRAY_ALLOCS, 1);
+	}
 
 	//Sends the control message that goes in front of the new value being set, in such way the 
 	//UnityMessager instance at the C# side changes the current array instance before reading values from the
 	//respective message queue. 
 	int msgParams[2] = { m_queueId, m_pCurrentNode->pNext->unityArray.GetId() };
-	UnityMessager::GetInstance().m_pControlQueue->SendControlMessage(UMM_SET_QUEUE_ARRAY, 2, msgParams);
+	m_unityMessager.m_pControlQueue->SendControlMessage(UMM_SET_QUEUE_ARRAY, 2, msgParams);
 
 	//observe we advance to the next node (array) ONLY AFTER we have sent the control message
 	m_pCurrentNode = m_pCurrentNode->pNext;
@@ -180,8 +811,40 @@ void UnityMessager::MessageQueue<T>::AdvanceToNextUnityArrayNode()
 template <typename T>
 inline void UnityMessager::MessageQueue<T>::Reset()
 {
+	//usage of the set of arrays written until now, check AdjustCapacity
+	int usedLength = m_currentArrayPos;
+	for (Node* pNode = m_pFirstNode; pNode != m_pCurrentNode; pNode = pNode->pNext)
+		usedLength += pNode->unityArray.GetLength();
+
+	m_currentWindowPeakLength = std::max(m_currentWindowPeakLength, usedLength);
+
+	int64 usedSpillLength = 0;
+	const std::vector<UnityArray<T>*>& usedSpillArrays = m_spillArraysInUse[m_spillArraysInUseIdx];
+	for (size_t i = 0; i < usedSpillArrays.size(); ++i)
+		usedSpillLength += usedSpillArrays[i]->GetLength();
+
+	m_unityMessager.AddToQueueBytes(m_queueId, (usedLength + usedSpillLength) * (int64)sizeof(T));
+
+	if (++m_nOfDeliveringsOnWindow == UM_QUEUE_CAPACITY_WINDOW_N_OF_DELIVERINGS)
+	{
+		m_lastWindowPeakLength = m_currentWindowPeakLength;
+		m_currentWindowPeakLength = 0;
+		m_nOfDeliveringsOnWindow = 0;
+	}
+
+	if (m_pSecondFirstNode) //double buffered, the C# side is going to read the set of arrays written until now
+		std::swap(m_pFirstNode, m_pSecondFirstNode);
+
 	m_pCurrentNode = m_pFirstNode;
 	m_currentArrayPos = 0;
+
+	//the spill arrays used before the previous Reset were read by the previous delivering, which has surely finished now
+	m_spillArraysInUseIdx = 1 - m_spillArraysInUseIdx;
+	std::vector<UnityArray<T>*>& spillArraysToRecycle = m_spillArraysInUse[m_spillArraysInUseIdx];
+	for (size_t i = 0; i < spillArraysToRecycle.size(); ++i)
+		m_spillArraysPool[GetSpillSizeClass(spillArraysToRecycle[i]->GetLength())].push_back(spillArraysToRecycle[i]);
+
+	spillArraysToRecycle.clear();
 }
 
 template <typename T>
@@ -194,28 +857,120 @@ template <typename T>
 void UnityMessager::MessageQueue<T>::ReleaseArraysExceptFirst()
 {
 	ASSERT(IsReset());
-	Node* pNextToDelete = m_pFirstNode->pNext;
-	m_pFirstNode->pNext = NULL;
-	while (pNextToDelete) //single linked list destruction (except by the first element)
+	for (int i = 0; i < 2; ++i)
 	{
-		Node* pToDelete = pNextToDelete;
-		pNextToDelete = pNextToDelete->pNext;
-		DELETE(pToDelete);
+		Node* pFirstNode = i == 0 ? m_pFirstNode : m_pSecondFirstNode;
+		if (pFirstNode == NULL) //not double buffered
+			break;
+
+		Node* pNextToDelete = pFirstNode->pNext;
+		pFirstNode->pNext = NULL;
+		while (pNextToDelete) //single linked list destruction (except by the first element)
+		{
+			Node* pToDelete = pNextToDelete;
+			pNextToDelete = pNextToDelete->pNext;
+			DELETE(pToDelete);
+		}
+	}
+
+	//there is nothing to deliver, so no spill array is going to be read by the C# side
+	DeleteSpillArrays();
+
+	//the usage measured until now should not bring the released arrays back
+	m_arraysLength = m_pFirstNode->unityArray.GetLength();
+	m_currentWindowPeakLength = 0;
+	m_lastWindowPeakLength = 0;
+	m_nOfDeliveringsOnWindow = 0;
+}
+
+template <typename T>
+void UnityMessager::MessageQueue<T>::AdjustCapacity()
+{
+	//When double buffered the set of arrays just delivered is not used until the next Reset, otherwise the queue was reset 
+	//when the delivering started and nothing was written since then.
+	ASSERT(m_pSecondFirstNode || IsReset());
+	Node* pIdleFirstNode = m_pSecondFirstNode ? m_pSecondFirstNode : m_pFirstNode;
+	int expectedLength = std::max(m_currentWindowPeakLength, m_lastWindowPeakLength);
+	int firstArrayLength = pIdleFirstNode->unityArray.GetLength();
+
+	m_arraysLength = firstArrayLength;
+	while (m_arraysLength < firstArrayLength * UM_MAX_QUEUE_ARRAYS_LENGTH_FACTOR
+		   && expectedLength > m_arraysLength * UM_N_OF_QUEUE_ARRAYS_FOR_LONGER_ARRAYS)
+		m_arraysLength *= 2;
+
+	//keeps the arrays with the current length until the expected length fits, releasing the other ones
+	int capacity = firstArrayLength;
+	Node* pLastNode = pIdleFirstNode;
+	Node* pNode = pIdleFirstNode->pNext;
+	pIdleFirstNode->pNext = NULL;
+	while (pNode)
+	{
+		Node* pNextNode = pNode->pNext;
+		if (capacity < expectedLength && pNode->unityArray.GetLength() == m_arraysLength)
+		{
+			pNode->pNext = NULL;
+			pLastNode->pNext = pNode;
+			pLastNode = pNode;
+			capacity += m_arraysLength;
+		}
+		else
+			DELETE(pNode);
+
+		pNode = pNextNode;
+	}
+
+	//and allocates the missing ones
+	for (; capacity < expectedLength; capacity += m_arraysLength)
+	{
+		pLastNode->pNext = new Node(m_arraysLength);
+		pLastNode = pLastNode->pNext;
 	}
 }
 
-inline void UnityMessager::ControlQueue::SendMessage(int receiverId, int msgId)
+template <typename T>
+void UnityMessager::MessageQueue<T>::AddArraysToTrace(UnityMessagerTrace::Writer& traceWriter)
 {
+	//queues not used since the last Reset are left out
+	const std::vector<UnityArray<T>*>& usedSpillArrays = m_spillArraysInUse[m_spillArraysInUseIdx];
+	if (IsReset() && usedSpillArrays.empty())
+		return;
+
+	for (Node* pNode = m_pFirstNode; pNode != m_pCurrentNode; pNode = pNode->pNext)
+	{
+		traceWriter.AddArray(pNode->unityArray.GetId(), m_queueId, pNode->unityArray.GetPtr(), 
+							 pNode->unityArray.GetLength() * sizeof(T));
+	}
+
+	traceWriter.AddArray(m_pCurrentNode->unityArray.GetId(), m_queueId, m_pCurrentNode->unityArray.GetPtr(), 
+						 GetCurrentArrayPosInBytes());
+
+	for (size_t i = 0; i < usedSpillArrays.size(); ++i)
+		traceWriter.AddArray(usedSpillArrays[i]->GetId(), -1, usedSpillArrays[i]->GetPtr(), usedSpillArrays[i]->GetLength() * sizeof(T));
+}
+
+inline void* UnityMessager::ControlQueue::SendMessage(int receiverId, int msgId)
+{
+	if (m_isCompact)
+		return SendCompactMessage(receiverId, -1, msgId);
+
 	int* controlQueueRef = AllocSpace(3);
 	m_pCurrentNOfParams = &(controlQueueRef[2]); //pointer to the value to increment when parameters a pushed
 
 	controlQueueRef[0] = receiverId;
 	controlQueueRef[1] = msgId;
 	controlQueueRef[2] = 0; //number of parameters pointed by m_pCurrentNOfParams
+
+	return controlQueueRef;
 }
 
 inline void UnityMessager::ControlQueue::SendMessage(int receiverId, int componentId, int msgId)
 {
+	if (m_isCompact)
+	{
+		SendCompactMessage(receiverId, componentId, msgId);
+		return;
+	}
+
 	int* controlQueueRef = AllocSpace(4);
 	m_pCurrentNOfParams = &(controlQueueRef[2]); //pointer to the value to increment when parameters a pushed
 
@@ -223,10 +978,62 @@ inline void UnityMessager::ControlQueue::SendMessage(int receiverId, int compone
 	controlQueueRef[1] = msgId;
 
 	//A negative number of parameters (incremented by -1 to assure it's negative) is a sign to indicate the next value is the component id
-	controlQueueRef[2] = -1; 
+	controlQueueRef[2] = -1;
 	controlQueueRef[3] = componentId;
 }
 
+inline void UnityMessager::ControlQueue::SendMessage(int receiverId, int componentId, int msgId, int nOfParams,
+													 int nOfArrayParams, const ParamRegistration* pRegistrations)
+{
+	if (m_isCompact)
+	{
+		SendCompactMessage(receiverId, componentId, msgId, nOfParams, nOfArrayParams, pRegistrations);
+		return;
+	}
+
+	int headerLength = componentId != -1 ? 4 : 3; //component ids smaller than -1 are routing bindings, check StartMessage
+	int length = headerLength + nOfParams + nOfArrayParams;
+	if (length > GetMinArrayLength() - UM_SET_QUEUE_ARRAY_MSG_LENGTH)
+	{	//too many parameters to fit on a single array, so the message may have to be split by an array advance
+		if (componentId != -1)
+			SendMessage(receiverId, componentId, msgId);
+		else
+			SendMessage(receiverId, msgId);
+
+		for (int i = 0; i < nOfParams; ++i)
+		{
+			if (pRegistrations[i].length >= 0)
+				RegisterParam(pRegistrations[i].queueId, pRegistrations[i].length);
+			else
+				RegisterParam(pRegistrations[i].queueId);
+		}
+		return;
+	}
+
+	int* controlQueueRef = AllocSpace(length);
+	controlQueueRef[0] = receiverId;
+	controlQueueRef[1] = msgId;
+	if (componentId != -1)
+	{
+		controlQueueRef[2] = -(nOfParams + 1); //check the SendMessage version with component id above
+		controlQueueRef[3] = componentId;
+	}
+	else
+		controlQueueRef[2] = nOfParams;
+
+	int* pDest = controlQueueRef + headerLength;
+	for (int i = 0; i < nOfParams; ++i)
+	{
+		if (pRegistrations[i].length >= 0) //array parameter, check RegisterParam(queueId, length)
+		{
+			*(pDest++) = -pRegistrations[i].queueId;
+			*(pDest++) = pRegistrations[i].length;
+		}
+		else
+			*(pDest++) = pRegistrations[i].queueId;
+	}
+}
+
 inline void UnityMessager::ControlQueue::IncrementNumberOfParamsForCurrentMessage()
 {
 	if (*m_pCurrentNOfParams >= 0) //a negative number of params (incremented by -1) means a message to a game object component 
@@ -237,6 +1044,12 @@ inline void UnityMessager::ControlQueue::IncrementNumberOfParamsForCurrentMessag
 
 inline void UnityMessager::ControlQueue::RegisterParam(int queueId)
 {
+	if (m_isCompact)
+	{
+		RegisterCompactParam(queueId, -1);
+		return;
+	}
+
 	int* controlQueueRef = AllocSpace(1);
 	controlQueueRef[0] = queueId;
 	IncrementNumberOfParamsForCurrentMessage();
@@ -244,14 +1057,18 @@ inline void UnityMessager::ControlQueue::RegisterParam(int queueId)
 
 inline void UnityMessager::ControlQueue::RegisterParam(int queueId, int length)
 {
+	if (m_isCompact)
+	{
+		RegisterCompactParam(queueId, length);
+		return;
+	}
+
 	int* controlQueueRef = AllocSpace(2);
 	controlQueueRef[0] = - queueId; //NEGATIVE queueId VALUE IS THE SIGN FOR AN ARRAY PARAMETER INSTEAD OF A SINGLE PARAMETER
 	controlQueueRef[1] = length; //SO THE C# CONTROL QUEUE INSTANCE KNOWS THE ARRAY LENGTH COMES NEXT 
 	IncrementNumberOfParamsForCurrentMessage();
 }
 
-#define UM_SET_QUEUE_ARRAY_MSG_LENGTH 5
-
 inline int* UnityMessager::ControlQueue::AllocSpace(int length)
 {
 	//The control queue makes sure to save space for a "set queue array" message, needed when the control queue 
@@ -263,20 +1080,128 @@ inline int* UnityMessager::ControlQueue::AllocSpace(int length)
 	return &(m_pCurrentNode->unityArray[m_currentArrayPos - length]);
 }
 
-template <typename T> UnityMessager::ParamQueue<T>* UnityMessager::ParamQueue<T>::s_pInstance = NULL;
+inline uint8* UnityMessager::ControlQueue::AllocCompactSpace(int maxLength)
+{
+	//the same done by ControlQueue::AllocSpace, but in bytes
+	int lengthInBytes = m_pCurrentNode->unityArray.GetLength() * sizeof(int);
+	if (m_currentArrayPos + maxLength > lengthInBytes - UM_COMPACT_MAX_CONTROL_MESSAGE_LENGTH(2))
+		AdvanceToNextUnityArrayNode();
+
+	return reinterpret_cast<uint8*>(&(m_pCurrentNode->unityArray[0])) + m_currentArrayPos;
+}
+
+inline void UnityMessager::ControlQueue::CommitCompactSpace(uint8* pEndOfRecord)
+{
+	m_currentArrayPos = (int)(pEndOfRecord - reinterpret_cast<uint8*>(&(m_pCurrentNode->unityArray[0])));
+}
+
+inline uint8* UnityMessager::ControlQueue::WriteCompactMessageHeader(uint8* pDest, int receiverId, int componentId, 
+																	 int msgId, int nOfParams)
+{
+	uint8* pTag = pDest++; //tag byte is set bellow
+
+	uint8 tag = UM_COMPACT_TAG_MESSAGE;
+	if (m_hasLastReceiverId && receiverId == m_lastReceiverId)
+		tag |= UM_COMPACT_TAG_SAME_RECEIVER;
+	else
+		pDest = UnityMessagerCompact::WriteZigZag(pDest, receiverId);
+
+	pDest = UnityMessagerCompact::WriteZigZag(pDest, msgId);
+	if (componentId != -1) //component ids smaller than -1 are routing bindings, check StartMessage
+	{
+		tag |= UM_COMPACT_TAG_COMPONENT;
+		pDest = UnityMessagerCompact::WriteZigZag(pDest, componentId);
+	}
+
+	*pTag = tag;
+	m_pCurrentCompactNOfParams = pDest;
+	*(pDest++) = (uint8)nOfParams; //number of parameters pointed by m_pCurrentCompactNOfParams
+
+	m_lastReceiverId = receiverId;
+	m_hasLastReceiverId = true;
+	return pDest;
+}
+
+inline void* UnityMessager::ControlQueue::SendCompactMessage(int receiverId, int componentId, int msgId)
+{
+	uint8* pRecord = AllocCompactSpace(UM_COMPACT_MAX_MESSAGE_LENGTH);
+	CommitCompactSpace(WriteCompactMessageHeader(pRecord, receiverId, componentId, msgId, 0));
+	return pRecord;
+}
+
+inline void UnityMessager::ControlQueue::SendCompactMessage(int receiverId, int componentId, int msgId, int nOfParams,
+															int nOfArrayParams, const ParamRegistration* pRegistrations)
+{
+	ASSERT(nOfParams <= UM_COMPACT_MAX_N_OF_PARAMS);
+
+	//single parameters take a single varint, while array parameters take two of them
+	int maxLength = UM_COMPACT_MAX_MESSAGE_LENGTH + (nOfParams + nOfArrayParams) * UM_COMPACT_MAX_VARINT_LENGTH;
+	int lengthInBytes = GetMinArrayLength() * sizeof(int);
+	if (maxLength > lengthInBytes - UM_COMPACT_MAX_CONTROL_MESSAGE_LENGTH(2))
+	{	//too many parameters to fit on a single array, so the message may have to be split by an array advance
+		SendCompactMessage(receiverId, componentId, msgId);
+		for (int i = 0; i < nOfParams; ++i)
+			RegisterCompactParam(pRegistrations[i].queueId, pRegistrations[i].length);
+		return;
+	}
+
+	uint8* pDest = WriteCompactMessageHeader(AllocCompactSpace(maxLength), receiverId, componentId, msgId, nOfParams);
+	for (int i = 0; i < nOfParams; ++i)
+	{
+		const ParamRegistration& registration = pRegistrations[i];
+		pDest = UnityMessagerCompact::WriteVarint(pDest, ((uint32)registration.queueId << 1) | (registration.length >= 0 ? 1 : 0));
+		if (registration.length >= 0)
+			pDest = UnityMessagerCompact::WriteVarint(pDest, (uint32)registration.length);
+	}
+
+	CommitCompactSpace(pDest);
+}
+
+inline void UnityMessager::ControlQueue::RegisterCompactParam(int queueId, int length)
+{
+	uint8* pDest = AllocCompactSpace(UM_COMPACT_MAX_PARAM_LENGTH);
+	pDest = UnityMessagerCompact::WriteVarint(pDest, ((uint32)queueId << 1) | (length >= 0 ? 1 : 0));
+	if (length >= 0)
+		pDest = UnityMessagerCompact::WriteVarint(pDest, (uint32)length);
+
+	CommitCompactSpace(pDest);
+
+	ASSERT(*m_pCurrentCompactNOfParams < UM_COMPACT_MAX_N_OF_PARAMS);
+	++(*m_pCurrentCompactNOfParams);
+}
+
+inline uint8* UnityMessager::PayloadQueue::Push(int length, int alignment)
+{
+	int alignedPos = (m_currentArrayPos + alignment - 1) & ~(alignment - 1);
+	if (alignedPos + length > m_pCurrentNode->unityArray.GetLength())
+	{	//the same done by MessageQueue::AllocSpace, the start of a spill array is aligned for any type
+		if (length > GetMinArrayLength())
+			return AllocSpillSpace(length);
+
+		AdvanceToNextUnityArrayNode();
+		alignedPos = 0;
+	}
+
+	m_currentArrayPos = alignedPos + length;
+	return &(m_pCurrentNode->unityArray[alignedPos]);
+}
+
+template <typename T> UnityMessager::ParamQueue<T>* UnityMessager::ParamQueue<T>::s_pInstances[UM_MAX_N_OF_CHANNELS] = {};
 
 template <typename T>
-inline void UnityMessager::ParamQueue<T>::Push(const T& param)
+inline T* UnityMessager::ParamQueue<T>::Push(const T& param)
 {
 	T* pParamDataDest = AllocSpace(1);
 	*pParamDataDest = param;
+	return pParamDataDest;
 }
 
 template <typename T>
-inline void UnityMessager::ParamQueue<T>::Push(const T* pItemArray, int length)
+inline T* UnityMessager::ParamQueue<T>::Push(const T* pItemArray, int length)
 {
 	T* pParamDataDest = AllocSpace(length);
 	memcpy(pParamDataDest, pItemArray, length*sizeof(T));
+	return pParamDataDest;
 }
 
 template <typename T>
@@ -286,15 +1211,140 @@ inline void UnityMessager::ParamQueue<T>::PushAndGetPtrToFill(T** const ppQueueS
 	(*ppQueueSubArrayOutput) = AllocSpace(length);
 }
 
+template <typename... PARAMS>
+void UnityMessager::StagingQueue::StageMessage(int receiverId, int msgId, ComponentIdGetterFcPtr componentIdGetterFcPtr,
+											   const char* objectName, const char* methodName, bool isCoalesced, 
+											   const PARAMS&... params)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	StagedMessage stagedMessage;
+	stagedMessage.receiverId = receiverId;
+	stagedMessage.msgId = msgId;
+	stagedMessage.componentIdGetterFcPtr = componentIdGetterFcPtr;
+	stagedMessage.objectName = objectName ? CopyString(objectName) : NULL;
+	stagedMessage.methodName = methodName ? CopyString(methodName) : NULL;
+	stagedMessage.firstParamIdx = (int)m_params.size();
+	stagedMessage.nOfParams = sizeof...(PARAMS);
+	stagedMessage.isCoalesced = isCoalesced;
+	m_messages.push_back(stagedMessage);
+
+	StageParam(params...);
+	m_pHasStagedMessagesFlag->store(true, std::memory_order_release);
+}
+
+template <typename T>
+inline void UnityMessager::StagingQueue::StageParam(const T& param)
+{
+	void* pData = AllocData(sizeof(T));
+	memcpy(pData, &param, sizeof(T));
+
+	StagedParam stagedParam = { &ReplaySingleParam<T>, pData, 1 };
+	m_params.push_back(stagedParam);
+}
+
+inline void UnityMessager::StagingQueue::StageParam(const char* stringParam)
+{	//a C string is just staged as an uint8 array, the same way PushParam does
+	StageParam(UM_ARRAY_PARAM((const uint8*)stringParam, strlen(stringParam)));
+}
+
+inline void UnityMessager::StagingQueue::StageParam(const InternedString& stringParam)
+{	//the string is copied, being interned only on the main thread when merged
+	void* pData = AllocData(stringParam.m_length);
+	memcpy(pData, stringParam.m_str, stringParam.m_length);
+
+	StagedParam stagedParam = { &ReplayInternedStringParam, pData, stringParam.m_length };
+	m_params.push_back(stagedParam);
+}
+
+template <typename T>
+inline void UnityMessager::StagingQueue::StageParam(const ArrayParam<T>& arrayParam)
+{
+	void* pData = AllocData(arrayParam.length * sizeof(T));
+	memcpy(pData, arrayParam.pArray, arrayParam.length * sizeof(T));
+
+	StagedParam stagedParam = { &ReplayArrayParam<T>, pData, arrayParam.length };
+	m_params.push_back(stagedParam);
+}
+
+template <typename T>
+inline void UnityMessager::StagingQueue::StageParam(const ArrayToFillParam<T>& arrayToFillParam)
+{
+	//the array will be filled directly on the staging data block, being copied to the parameter queue on the merge
+	T* pArrayToFill = reinterpret_cast<T*>(AllocData(arrayToFillParam.GetLength() * sizeof(T)));
+	arrayToFillParam.m_pArray = pArrayToFill;
+
+	StagedParam stagedParam = { &ReplayArrayParam<T>, pArrayToFill, arrayToFillParam.GetLength() };
+	m_params.push_back(stagedParam);
+}
+
+template <typename T>
+inline void UnityMessager::StagingQueue::StageParam(const UnityArrayParam<T>& unityArrayParam)
+{	//copied, the UnityArray can only be retained on the main thread
+	StageParam(unityArrayParam.AsArrayParam());
+}
+
+template <typename PARAM1, typename... OTHER_PARAMS>
+inline void UnityMessager::StagingQueue::StageParam(const PARAM1& param1, const OTHER_PARAMS&... otherParams)
+{
+	StageParam(param1);
+	StageParam(otherParams...);
+}
+
+template <typename T>
+bool UnityMessager::StagingQueue::ReplaySingleParam(UnityMessager& unityMessager, const void* pData, int length,
+													int coalescedParamIdx, ReplayMode mode)
+{
+	const T& param = *reinterpret_cast<const T*>(pData);
+	switch (mode)
+	{
+	case RM_PUSH: unityMessager.PushParam(param); break;
+	case RM_PUSH_COALESCED: unityMessager.PushCoalescedParam(param); break;
+	case RM_MATCH_COALESCED: return unityMessager.MatchesCoalescedParam(coalescedParamIdx, param);
+	case RM_OVERWRITE_COALESCED: unityMessager.OverwriteCoalescedParam(coalescedParamIdx, param); break;
+	}
+
+	return true;
+}
+
+template <typename T>
+bool UnityMessager::StagingQueue::ReplayArrayParam(UnityMessager& unityMessager, const void* pData, int length,
+												   int coalescedParamIdx, ReplayMode mode)
+{
+	ArrayParam<T> arrayParam(reinterpret_cast<const T*>(pData), length);
+	switch (mode)
+	{
+	case RM_PUSH: unityMessager.PushParam(arrayParam); break;
+	case RM_PUSH_COALESCED: unityMessager.PushCoalescedParam(arrayParam); break;
+	case RM_MATCH_COALESCED: return unityMessager.MatchesCoalescedParam(coalescedParamIdx, arrayParam);
+	case RM_OVERWRITE_COALESCED: unityMessager.OverwriteCoalescedParam(coalescedParamIdx, arrayParam); break;
+	}
+
+	return true;
+}
+
+inline bool UnityMessager::StagingQueue::ReplayInternedStringParam(UnityMessager& unityMessager, const void* pData, int length,
+																  int coalescedParamIdx, ReplayMode mode)
+{
+	if (mode == RM_PUSH)
+	{
+		unityMessager.PushParam(InternedString(reinterpret_cast<const char*>(pData), length));
+		return true;
+	}
+
+	return ReplayArrayParam<uint8>(unityMessager, pData, length, coalescedParamIdx, mode); //coalesced ones are not interned
+}
+
+//-1 means the component was not registered yet on the channel, this triggers the register method
 template <typename T>
-int UnityMessager::Component<T>::s_id = -1; //-1 means the component was not registered yet, this triggers the register method
+int UnityMessager::Component<T>::s_ids[UM_MAX_N_OF_CHANNELS] = UM_UNREGISTERED_CHANNEL_IDS;
 
 template <typename T>
-int UnityMessager::Component<T>::GenerateSetAndGetComponentId()
+int UnityMessager::Component<T>::GenerateSetAndGetComponentId(int channelId)
 {
 	//send the message to get it registered for this id and managed type name before any use
-	UNITY_MESSAGER.RegisterNewComponent(T::GetManagedTypeName(), &s_id);
-	return s_id;
+	UNITY_MESSAGER_CHANNEL(channelId).RegisterNewComponent(T::GetManagedTypeName(), &s_ids[channelId]);
+	return s_ids[channelId];
 }
 
 } //UnityForCpp
@@ -0,0 +1,163 @@
+//Copyright (c) 2016, Samuel Pollachini (Samuel Polacchini)
+//The UnityForCpp project is licensed under the terms of the MIT license
+
+#ifndef UNITY_MESSAGER_COMPACT_H
+#define UNITY_MESSAGER_COMPACT_H
+
+#include "Shared.h"
+
+//Compact format for the UnityMessager control queue, used when the flag UM_INIT_FLAG_COMPACT_CONTROL_QUEUE is set.
+//The control queue arrays are still int arrays, but their content is a stream of bytes (read as little endian by the C# side)
+//made by the records bellow, where "varint" is an unsigned LEB128 value and "zigzag" is a signed value zigzag encoded as varint:
+//
+//- Control message:  [UM_COMPACT_CONTROL_MESSAGE_TAG] [varint msgId] [varint nOfParams] [varint param] ...
+//- Message:          [tag] [zigzag receiverId] [zigzag msgId] [zigzag componentId] [byte nOfParams]
+//                    the receiverId is omitted for UM_COMPACT_TAG_SAME_RECEIVER, the componentId is only present for
+//                    UM_COMPACT_TAG_COMPONENT (being negative for routing bindings), while the number of parameters is a single
+//                    byte so it can be incremented in place.
+//- Parameter:        [varint (queueId << 1) | isArray] [varint arrayLength, only when isArray]
+//
+//Control messages may come before any message or parameter record, so the first byte of these records is never 0
+//(queues ids for parameters are always bigger than 0). The receiver of the last message record is kept until the next
+//delivering, so consecutive messages to a same receiver (the usual case) cost 3 bytes plus 1 or 2 bytes per parameter.
+
+#define UM_COMPACT_CONTROL_MESSAGE_TAG 0
+
+//Flags for the tag byte of message records, UM_COMPACT_TAG_MESSAGE is always set.
+#define UM_COMPACT_TAG_MESSAGE 1
+#define UM_COMPACT_TAG_SAME_RECEIVER 2 //same receiverId of the previous message record, which is omitted
+#define UM_COMPACT_TAG_COMPONENT 4 //message to a component, the componentId comes after the msgId
+#define UM_COMPACT_TAG_DISCARDED 8 //coalesced message replaced by a newer one, check UnityMessager::SendCoalescedMessage
+
+#define UM_COMPACT_MAX_VARINT_LENGTH 5
+#define UM_COMPACT_MAX_N_OF_PARAMS 255
+
+//Max number of parameters of a control message, on both formats. It corresponds to UnityMessager._maxNOfControlMessageParams on C#.
+#define UM_MAX_N_OF_CONTROL_MESSAGE_PARAMS 64
+
+//Max length in bytes of each kind of record, used for reserving space on the control queue arrays before writing them
+#define UM_COMPACT_MAX_MESSAGE_LENGTH (2 + 3 * UM_COMPACT_MAX_VARINT_LENGTH)
+#define UM_COMPACT_MAX_PARAM_LENGTH (2 * UM_COMPACT_MAX_VARINT_LENGTH)
+#define UM_COMPACT_MAX_CONTROL_MESSAGE_LENGTH(nOfParams) (1 + (2 + (nOfParams)) * UM_COMPACT_MAX_VARINT_LENGTH)
+
+namespace UnityForCpp
+{
+
+namespace UnityMessagerCompact
+{
+	//Writes value as varint at pDest, returning the position right after the written bytes
+	inline uint8* WriteVarint(uint8* pDest, uint32 value)
+	{
+		while (value >= 0x80)
+		{
+			*(pDest++) = (uint8)(value | 0x80);
+			value >>= 7;
+		}
+
+		*(pDest++) = (uint8)value;
+		return pDest;
+	}
+
+	//Writes a signed value as zigzag, so small negative values (as the ones used for names) also take few bytes
+	inline uint8* WriteZigZag(uint8* pDest, int value)
+	{
+		return WriteVarint(pDest, ((uint32)value << 1) ^ (uint32)(value >> 31));
+	}
+
+	//Reads a varint at pSrc, advancing it to the position right after the read bytes
+	inline uint32 ReadVarint(const uint8*& pSrc)
+	{
+		uint32 value = 0;
+		for (int shift = 0; ; shift += 7)
+		{
+			uint8 byte = *(pSrc++);
+			value |= (uint32)(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0)
+				return value;
+		}
+	}
+
+	inline int ReadZigZag(const uint8*& pSrc)
+	{
+		uint32 value = ReadVarint(pSrc);
+		return (int)(value >> 1) ^ -(int)(value & 1);
+	}
+
+	//Reference decoder for the compact format. It follows the same steps of the C# UnityMessager.ControlQueue when the
+	//control queue is compact, but reading a single byte stream, so UMM_SET_QUEUE_ARRAY control messages are just reported
+	//as any other control message. It is meant for tools and tests, the plugin itself never decodes the control queue.
+	class ReferenceDecoder
+	{
+	public:
+		enum RecordType { RT_CONTROL_MESSAGE, RT_MESSAGE, RT_PARAM };
+
+		struct Record
+		{
+			RecordType type;
+			int receiverId; //RT_MESSAGE only, also for discarded messages
+			int msgId; //RT_MESSAGE and RT_CONTROL_MESSAGE
+			int componentId; //RT_MESSAGE only, -1 if the message is not addressed to a component, smaller for routing bindings
+			int nOfParams; //RT_MESSAGE and RT_CONTROL_MESSAGE
+			bool isDiscarded; //RT_MESSAGE only
+			int queueId; //RT_PARAM only
+			int arrayLength; //RT_PARAM only, -1 for single parameters
+			int controlParams[UM_MAX_N_OF_CONTROL_MESSAGE_PARAMS]; //RT_CONTROL_MESSAGE only, nOfParams values
+		};
+
+		ReferenceDecoder(const uint8* pStream, int length)
+			: m_pCurrent(pStream), m_pEnd(pStream + length), m_nOfParamsToRead(0), m_lastReceiverId(0) {}
+
+		//Reads the next record, returning false when the end of the stream was reached
+		bool ReadNext(Record& record)
+		{
+			if (m_pCurrent >= m_pEnd)
+				return false;
+
+			if (*m_pCurrent == UM_COMPACT_CONTROL_MESSAGE_TAG)
+			{
+				++m_pCurrent;
+				record.type = RT_CONTROL_MESSAGE;
+				record.msgId = (int)ReadVarint(m_pCurrent);
+				record.nOfParams = (int)ReadVarint(m_pCurrent);
+				ASSERT(record.nOfParams <= UM_MAX_N_OF_CONTROL_MESSAGE_PARAMS);
+				for (int i = 0; i < record.nOfParams; ++i)
+					record.controlParams[i] = (int)ReadVarint(m_pCurrent);
+			}
+			else if (m_nOfParamsToRead > 0)
+			{
+				--m_nOfParamsToRead;
+				uint32 queueIdAndIsArray = ReadVarint(m_pCurrent);
+				record.type = RT_PARAM;
+				record.queueId = (int)(queueIdAndIsArray >> 1);
+				record.arrayLength = (queueIdAndIsArray & 1) ? (int)ReadVarint(m_pCurrent) : -1;
+			}
+			else
+			{
+				uint8 tag = *(m_pCurrent++);
+				ASSERT(tag & UM_COMPACT_TAG_MESSAGE);
+				if ((tag & UM_COMPACT_TAG_SAME_RECEIVER) == 0)
+					m_lastReceiverId = ReadZigZag(m_pCurrent);
+
+				record.type = RT_MESSAGE;
+				record.receiverId = m_lastReceiverId;
+				record.msgId = ReadZigZag(m_pCurrent);
+				record.componentId = (tag & UM_COMPACT_TAG_COMPONENT) ? ReadZigZag(m_pCurrent) : -1;
+				record.nOfParams = *(m_pCurrent++);
+				record.isDiscarded = (tag & UM_COMPACT_TAG_DISCARDED) != 0;
+				m_nOfParamsToRead = record.nOfParams;
+			}
+
+			return true;
+		}
+
+	private:
+		const uint8* m_pCurrent;
+		const uint8* m_pEnd;
+		int m_nOfParamsToRead; //parameter records expected before the next message record
+		int m_lastReceiverId; //for messages tagged with UM_COMPACT_TAG_SAME_RECEIVER
+	};
+}
+
+} //UnityForCpp
+
+#endif
@@ -0,0 +1,375 @@
+//Copyright (c) 2016, Samuel Pollachini (Samuel Polacchini)
+//The UnityForCpp project is licensed under the terms of the MIT license
+
+#include "UnityMessagerDecoder.h"
+#include <limits.h>
+
+namespace UnityForCpp
+{
+
+UnityMessagerDecoder::UnityMessagerDecoder(int initFlags)
+	: m_isCompact((initFlags & UM_INIT_FLAG_COMPACT_CONTROL_QUEUE) != 0),
+	m_isInterleaved((initFlags & UM_INIT_FLAG_INTERLEAVED_PARAMS) != 0),
+	m_types(), m_byteTypeId(-1), m_pArraySource(NULL), m_queues(), m_lastReceiverId(0),
+	m_nOfControlBytesRead(0), m_nOfControlMessageBytesRead(0), m_params()
+{
+}
+
+void UnityMessagerDecoder::SetType(int typeId, int itemSize, int alignment, const char* managedTypeName)
+{
+	ASSERT(typeId >= 0 && itemSize > 0 && alignment > 0 && (alignment & (alignment - 1)) == 0);
+	if (typeId >= (int)m_types.size())
+	{
+		TypeInfo notSet = { 0, 1 };
+		m_types.resize(typeId + 1, notSet);
+	}
+
+	m_types[typeId].itemSize = itemSize;
+	m_types[typeId].alignment = alignment;
+	if (strcmp(managedTypeName, "System.Byte") == 0)
+		m_byteTypeId = typeId;
+}
+
+bool UnityMessagerDecoder::DecodeDelivering(ArraySource& arraySource, const int* firstArrayIds, int nOfQueues, Handler& handler)
+{
+	m_pArraySource = &arraySource;
+	m_queues.clear();
+	for (int queueId = 0; queueId < nOfQueues; ++queueId)
+	{
+		if (firstArrayIds[queueId] >= 0)
+			SetQueueArray(queueId, firstArrayIds[queueId]);
+	}
+
+	m_nOfControlBytesRead = 0;
+	m_nOfControlMessageBytesRead = 0;
+	while (true)
+	{
+		if (!DeliverControlMessagesIfAny(handler))
+			return false;
+
+		int firstControlByte = m_nOfControlBytesRead;
+		int firstControlMessageByte = m_nOfControlMessageBytesRead;
+
+		Message message;
+		if (!ReadMessageHeader(message))
+			return false;
+
+		//names are pushed before the parameters, but not registered as parameters (check UnityMessager::StartMessage)
+		message.objectName = message.methodName = NULL;
+		if (message.componentId >= -1 && (message.receiverId < 0 || message.msgId < 0))
+		{
+			int nameQueueId = m_isInterleaved ? UM_PAYLOAD_QUEUE_ID : m_byteTypeId;
+			const uint8* pName;
+			if (nameQueueId < 0)
+				return false;
+
+			if (message.receiverId < 0)
+			{
+				if (!ReadFromQueue(nameQueueId, -message.receiverId, 1, pName))
+					return false;
+				message.objectName = reinterpret_cast<const char*>(pName);
+			}
+
+			if (message.msgId < 0)
+			{
+				if (!ReadFromQueue(nameQueueId, -message.msgId, 1, pName))
+					return false;
+				message.methodName = reinterpret_cast<const char*>(pName);
+			}
+		}
+
+		m_params.resize(message.nOfParams);
+		for (int i = 0; i < message.nOfParams; ++i)
+		{
+			Param& param = m_params[i];
+			if (!DeliverControlMessagesIfAny(handler) || !ReadParamInfo(param))
+				return false;
+
+			if (param.typeId >= (int)m_types.size() || m_types[param.typeId].itemSize <= 0)
+				return false;
+
+			const TypeInfo& type = m_types[param.typeId];
+			int64 sizeInBytes = (int64)type.itemSize * (param.length < 0 ? 1 : param.length);
+			if (sizeInBytes > INT_MAX)
+				return false;
+
+			param.sizeInBytes = (int)sizeInBytes;
+			if (!ReadFromQueue(m_isInterleaved ? UM_PAYLOAD_QUEUE_ID : param.typeId, param.sizeInBytes,
+							   m_isInterleaved ? type.alignment : 1, param.pData))
+				return false;
+		}
+
+		message.pParams = message.nOfParams > 0 ? &m_params[0] : NULL;
+		message.controlBytes = (m_nOfControlBytesRead - firstControlByte) - (m_nOfControlMessageBytesRead - firstControlMessageByte);
+		handler.OnMessage(message);
+
+		if (message.receiverId == UMR_MESSAGER && message.msgId == UMM_FINISH_DELIVERING_MESSAGES && message.componentId == -1)
+			return true;
+	}
+}
+
+UnityMessagerDecoder::QueueState& UnityMessagerDecoder::GetQueue(int queueId)
+{
+	if (queueId >= (int)m_queues.size())
+	{
+		QueueState notSet = { NULL, 0, 0, false, NULL, 0, 0 };
+		m_queues.resize(queueId + 1, notSet);
+	}
+
+	return m_queues[queueId];
+}
+
+void UnityMessagerDecoder::SetQueueArray(int queueId, int arrayId)
+{
+	QueueState& queue = GetQueue(queueId);
+	queue.pArray = m_pArraySource->GetArray(arrayId, queue.length);
+	queue.pos = 0;
+}
+
+bool UnityMessagerDecoder::DeliverControlMessagesIfAny(Handler& handler)
+{
+	while (true)
+	{
+		int firstControlByte = m_nOfControlBytesRead;
+		int msgId, nOfParams;
+		if (m_isCompact)
+		{
+			const QueueState& controlQueue = GetQueue(UM_CONTROL_QUEUE_ID);
+			if (controlQueue.pArray == NULL || controlQueue.pos >= controlQueue.length
+				|| controlQueue.pArray[controlQueue.pos] != UM_COMPACT_CONTROL_MESSAGE_TAG)
+				return true;
+
+			uint8 tag;
+			uint32 value;
+			ReadControlByte(tag);
+			if (!ReadControlVarint(value))
+				return false;
+			msgId = (int)value;
+
+			if (!ReadControlVarint(value) || value > UM_MAX_N_OF_CONTROL_MESSAGE_PARAMS)
+				return false;
+			nOfParams = (int)value;
+
+			for (int i = 0; i < nOfParams; ++i)
+			{
+				if (!ReadControlVarint(value))
+					return false;
+				m_controlParams[i] = (int)value;
+			}
+		}
+		else
+		{
+			//[UMR_MESSAGER, msgId, -nOfParams, params...], while regular messages to UMR_MESSAGER have a positive number of parameters
+			int receiverId, negNOfParams;
+			if (!PeekControlInt(0, receiverId) || receiverId != UMR_MESSAGER || !PeekControlInt(2, negNOfParams) || negNOfParams >= 0)
+				return true;
+
+			ReadControlInt(receiverId);
+			ReadControlInt(msgId);
+			ReadControlInt(negNOfParams);
+			nOfParams = -negNOfParams;
+			if (nOfParams > UM_MAX_N_OF_CONTROL_MESSAGE_PARAMS)
+				return false;
+
+			for (int i = 0; i < nOfParams; ++i)
+			{
+				if (!ReadControlInt(m_controlParams[i]))
+					return false;
+			}
+		}
+
+		int controlBytes = m_nOfControlBytesRead - firstControlByte;
+		m_nOfControlMessageBytesRead += controlBytes;
+
+		//reported before being handled, since UMM_SET_QUEUE_ARRAY for the control queue changes the array being read
+		handler.OnControlMessage(msgId, nOfParams, m_controlParams, controlBytes);
+		HandleControlMessage(msgId, nOfParams, m_controlParams);
+	}
+}
+
+void UnityMessagerDecoder::HandleControlMessage(int msgId, int nOfParams, const int* pParams)
+{
+	switch (msgId)
+	{
+	case UMM_SET_QUEUE_FIRST_ARRAY:
+		//as on the C# side, a queue registered while delivering is read from its first array (the control queue is being read)
+		if (nOfParams >= 2 && pParams[0] > UM_CONTROL_QUEUE_ID)
+			SetQueueArray(pParams[0], pParams[1]);
+		break;
+	case UMM_SET_QUEUE_ARRAY:
+		if (nOfParams >= 2 && pParams[0] >= 0)
+			SetQueueArray(pParams[0], pParams[1]);
+		break;
+	case UMM_SET_QUEUE_SPILL_ARRAY:
+	case UMM_SET_QUEUE_UNITY_ARRAY:
+		if (nOfParams >= 2 && pParams[0] >= 0)
+		{
+			QueueState& queue = GetQueue(pParams[0]);
+			queue.hasSingleParamArray = true;
+			queue.pSingleParamArray = m_pArraySource->GetArray(pParams[1], queue.singleParamLength);
+			queue.singleParamPos = 0;
+			if (msgId == UMM_SET_QUEUE_UNITY_ARRAY && nOfParams >= 3)
+			{	//the position is in items, except for the payload queue
+				int itemSize = !m_isInterleaved && pParams[0] < (int)m_types.size() ? m_types[pParams[0]].itemSize : 1;
+				queue.singleParamPos = pParams[2] * itemSize;
+			}
+		}
+		break;
+	case UMM_REGISTER_PAYLOAD_TYPE:
+		if (nOfParams >= 2 && pParams[0] >= 0 && pParams[0] < (int)m_types.size())
+			m_types[pParams[0]].alignment = pParams[1];
+		break;
+	}
+}
+
+bool UnityMessagerDecoder::ReadMessageHeader(Message& message)
+{
+	message.isDiscarded = false;
+	if (m_isCompact)
+	{
+		uint8 tag, nOfParams;
+		if (!ReadControlByte(tag) || (tag & UM_COMPACT_TAG_MESSAGE) == 0)
+			return false;
+
+		if ((tag & UM_COMPACT_TAG_SAME_RECEIVER) == 0 && !ReadControlZigZag(m_lastReceiverId))
+			return false;
+		message.receiverId = m_lastReceiverId;
+
+		message.componentId = -1;
+		if (!ReadControlZigZag(message.msgId) || ((tag & UM_COMPACT_TAG_COMPONENT) != 0 && !ReadControlZigZag(message.componentId))
+			|| !ReadControlByte(nOfParams))
+			return false;
+
+		message.nOfParams = nOfParams;
+		message.isDiscarded = (tag & UM_COMPACT_TAG_DISCARDED) != 0;
+		return true;
+	}
+
+	int nOfParams;
+	if (!ReadControlInt(message.receiverId) || !ReadControlInt(message.msgId) || !ReadControlInt(nOfParams))
+		return false;
+
+	//component messages have -(nOfParams + 1) followed by the component id
+	message.componentId = -1;
+	if (nOfParams < 0)
+	{
+		if (!ReadControlInt(message.componentId))
+			return false;
+		nOfParams = -nOfParams - 1;
+	}
+
+	message.nOfParams = nOfParams;
+	message.isDiscarded = message.receiverId == UMR_MESSAGER && message.msgId == UMM_DISCARDED_MESSAGE;
+	return true;
+}
+
+bool UnityMessagerDecoder::ReadParamInfo(Param& param)
+{
+	if (m_isCompact)
+	{
+		uint32 value;
+		if (!ReadControlVarint(value) || (value >> 1) == 0)
+			return false;
+
+		param.typeId = (int)(value >> 1);
+		param.length = -1;
+		if ((value & 1) != 0)
+		{
+			if (!ReadControlVarint(value))
+				return false;
+			param.length = (int)value;
+		}
+
+		return true;
+	}
+
+	//queueId for single parameters, or [-queueId, length] for arrays
+	int value;
+	if (!ReadControlInt(value) || value == 0)
+		return false;
+
+	param.typeId = value > 0 ? value : -value;
+	param.length = -1;
+	return value > 0 || (ReadControlInt(param.length) && param.length >= 0);
+}
+
+bool UnityMessagerDecoder::ReadFromQueue(int queueId, int sizeInBytes, int alignment, const uint8*& pData)
+{
+	QueueState& queue = GetQueue(queueId);
+	if (queue.hasSingleParamArray)
+	{
+		queue.hasSingleParamArray = false;
+		pData = queue.pSingleParamArray ? queue.pSingleParamArray + queue.singleParamPos : NULL;
+		return pData == NULL || queue.singleParamPos + sizeInBytes <= queue.singleParamLength;
+	}
+
+	//the payload queue aligns each parameter relative to the start of the array (check UnityMessager::PayloadQueue::Push)
+	int pos = (queue.pos + alignment - 1) & ~(alignment - 1);
+	if (queue.pArray == NULL || pos + sizeInBytes > queue.length)
+		return false;
+
+	pData = queue.pArray + pos;
+	queue.pos = pos + sizeInBytes;
+	return true;
+}
+
+bool UnityMessagerDecoder::PeekControlInt(int offset, int& value)
+{
+	const QueueState& controlQueue = GetQueue(UM_CONTROL_QUEUE_ID);
+	int pos = controlQueue.pos + offset * (int)sizeof(int);
+	if (controlQueue.pArray == NULL || pos + (int)sizeof(int) > controlQueue.length)
+		return false;
+
+	memcpy(&value, controlQueue.pArray + pos, sizeof(int));
+	return true;
+}
+
+bool UnityMessagerDecoder::ReadControlInt(int& value)
+{
+	if (!PeekControlInt(0, value))
+		return false;
+
+	m_queues[UM_CONTROL_QUEUE_ID].pos += sizeof(int);
+	m_nOfControlBytesRead += sizeof(int);
+	return true;
+}
+
+bool UnityMessagerDecoder::ReadControlByte(uint8& value)
+{
+	QueueState& controlQueue = GetQueue(UM_CONTROL_QUEUE_ID);
+	if (controlQueue.pArray == NULL || controlQueue.pos >= controlQueue.length)
+		return false;
+
+	value = controlQueue.pArray[controlQueue.pos++];
+	++m_nOfControlBytesRead;
+	return true;
+}
+
+bool UnityMessagerDecoder::ReadControlVarint(uint32& value)
+{
+	value = 0;
+	for (int i = 0; i < UM_COMPACT_MAX_VARINT_LENGTH; ++i)
+	{
+		uint8 byte;
+		if (!ReadControlByte(byte))
+			return false;
+
+		value |= (uint32)(byte & 0x7F) << (7 * i);
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+bool UnityMessagerDecoder::ReadControlZigZag(int& value)
+{
+	uint32 zigZag;
+	if (!ReadControlVarint(zigZag))
+		return false;
+
+	value = (int)(zigZag >> 1) ^ -(int)(zigZag & 1);
+	return true;
+}
+
+}; //UnityForCpp
@@ -0,0 +1,137 @@
+//Copyright (c) 2016, Samuel Pollachini (Samuel Polacchini)
+//The UnityForCpp project is licensed under the terms of the MIT license
+
+#ifndef UNITY_MESSAGER_DECODER_H
+#define UNITY_MESSAGER_DECODER_H
+
+#include "UnityMessager.h"
+#include <vector>
+
+namespace UnityForCpp
+{
+
+//Native decoder for the messages of a delivering. It follows the same steps of the C# UnityMessager.DeliverMessages over the
+//control queue (on both formats) and over the parameter queues (or the payload queue when interleaved), getting the arrays
+//by their ids from an ArraySource, so it doesn't depend on the UnityAdapter. The control messages changing the arrays of the
+//queues are handled by the decoder itself, while all the messages (the control ones included) are reported to a Handler in
+//the order they are read. It is meant for tools, as the ones reading traces (check UnityMessagerTrace.h).
+//
+class UnityMessagerDecoder
+{
+public:
+	//Provides the arrays read by the decoder by their ids
+	class ArraySource
+	{
+	public:
+		virtual ~ArraySource() {}
+
+		//Returns the bytes of the array, or NULL if the array is not available, setting lengthInBytes in both cases (0 if NULL)
+		virtual const uint8* GetArray(int arrayId, int& lengthInBytes) = 0;
+	};
+
+	struct Param
+	{
+		int typeId; //queue id, or payload type id when interleaved
+		int length; //array length, -1 for single parameters
+		int sizeInBytes;
+		const uint8* pData; //NULL if not available, as for the UnityArrays referenced by UnityArrayParam parameters on traces
+	};
+
+	struct Message
+	{
+		int receiverId; //the negative length of the object name for messages addressed by it
+		int msgId; //the negative length of the method name for messages addressed by it
+		int componentId; //-1 if not addressed to a component, smaller than -1 for routing bindings (check UnityMessager::StartMessage)
+		bool isDiscarded; //coalesced message replaced by a newer one, the C# side just skips it
+		int nOfParams;
+		const Param* pParams;
+		const char* objectName; //NULL if not addressed by the object name, NOT null terminated
+		const char* methodName; //NULL if not addressed by the method name, NOT null terminated
+		int controlBytes; //bytes taken on the control queue by the message and its parameter registrations
+	};
+
+	class Handler
+	{
+	public:
+		virtual ~Handler() {}
+
+		//Called for every control message, also for the ones handled by the decoder itself. Control messages sent while
+		//the parameters of a message were pushed are reported before the message.
+		virtual void OnControlMessage(int msgId, int nOfParams, const int* pParams, int controlBytes) {}
+
+		//The message and its parameters are valid only during the call
+		virtual void OnMessage(const Message& message) {}
+	};
+
+	//initFlags are the UM_INIT_FLAG_* values the UnityMessager was created with
+	UnityMessagerDecoder(int initFlags);
+
+	//Sets the size and the alignment of a parameter type, it MUST BE SET for all the types read. The type named "System.Byte"
+	//is also the one of the names of the messages addressed by name.
+	void SetType(int typeId, int itemSize, int alignment, const char* managedTypeName);
+
+	//Decodes the messages of a delivering, each queue starting from its first array (firstArrayIds is indexed by the queue id,
+	//being -1 for queues not used) and stopping after the UMM_FINISH_DELIVERING_MESSAGES message, which is also reported.
+	//Returns false if the message stream is not valid, for instance, if an array of the control queue is not available.
+	bool DecodeDelivering(ArraySource& arraySource, const int* firstArrayIds, int nOfQueues, Handler& handler);
+
+private:
+	struct TypeInfo
+	{
+		int itemSize;
+		int alignment;
+	};
+
+	//Reading state of a queue, positions in bytes
+	struct QueueState
+	{
+		const uint8* pArray;
+		int length;
+		int pos;
+
+		//array of the next parameter only, check UMM_SET_QUEUE_SPILL_ARRAY and UMM_SET_QUEUE_UNITY_ARRAY
+		bool hasSingleParamArray;
+		const uint8* pSingleParamArray;
+		int singleParamLength;
+		int singleParamPos;
+	};
+
+	QueueState& GetQueue(int queueId);
+	void SetQueueArray(int queueId, int arrayId);
+
+	//Reads and handles the control messages at the current position of the control queue, reporting them to the handler
+	bool DeliverControlMessagesIfAny(Handler& handler);
+	void HandleControlMessage(int msgId, int nOfParams, const int* pParams);
+
+	bool ReadMessageHeader(Message& message);
+	bool ReadParamInfo(Param& param);
+
+	//Reads sizeInBytes from the queue, aligned to alignment, setting pData to where they are (NULL if the array is not available)
+	bool ReadFromQueue(int queueId, int sizeInBytes, int alignment, const uint8*& pData);
+
+	//Control queue readers, the int format is read by ints and the compact one by bytes (check UnityMessagerCompact.h)
+	bool PeekControlInt(int offset, int& value);
+	bool ReadControlInt(int& value);
+	bool ReadControlByte(uint8& value);
+	bool ReadControlVarint(uint32& value);
+	bool ReadControlZigZag(int& value);
+
+	bool m_isCompact;
+	bool m_isInterleaved;
+	std::vector<TypeInfo> m_types; //indexed by type id
+	int m_byteTypeId; //type of the names, -1 if not set
+
+	ArraySource* m_pArraySource;
+	std::vector<QueueState> m_queues; //indexed by queue id, the control queue being the 0
+
+	int m_lastReceiverId; //check UM_COMPACT_TAG_SAME_RECEIVER
+	int m_nOfControlBytesRead; //since the delivering started
+	int m_nOfControlMessageBytesRead; //the same, but for the control messages only
+
+	int m_controlParams[UM_MAX_N_OF_CONTROL_MESSAGE_PARAMS];
+	std::vector<Param> m_params; //parameters of the message being read
+};
+
+}; //UnityForCpp
+
+#endif
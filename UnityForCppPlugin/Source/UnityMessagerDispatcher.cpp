@@ -0,0 +1,356 @@
+//Copyright (c) 2016, Samuel Pollachini (Samuel Polacchini)
+//The UnityForCpp project is licensed under the terms of the MIT license
+
+#include "UnityMessagerDispatcher.h"
+#include <algorithm>
+
+//corresponds to UM_EMPTY_CONTROL_QUEUE_CODE on UnityMessager.cpp
+#define UMD_EMPTY_CONTROL_QUEUE_CODE -123456
+
+//corresponds to UM_ROUTING_BINDING_COMPONENT_SLOT on UnityMessager.cpp, component id for the binding 0
+#define UMD_FIRST_ROUTING_BINDING_SLOT -2
+
+//parameters before the packed chars of UMM_REGISTER_PAYLOAD_TYPE and UMM_REGISTER_INTERNED_STRING
+#define UMD_PACKED_CHARS_FIRST_PARAM 3
+
+namespace UnityForCpp
+{
+
+//Unpacks chars packed as little endian on ints, as done by the UnityMessager for the control message parameters
+static void UnpackChars(const int* pPackedChars, int nOfChars, char* pDest)
+{
+	for (int i = 0; i < nOfChars; ++i)
+		pDest[i] = (char)((pPackedChars[i / 4] >> (8 * (i % 4))) & 0xFF);
+}
+
+const std::string& UnityMessagerDispatcher::Message::GetComponentTypeName() const
+{
+	static const std::string c_empty;
+	const std::vector<std::string>& componentTypeNames = m_dispatcher.m_componentTypeNames;
+	return m_componentId >= 0 && m_componentId < (int)componentTypeNames.size() ? componentTypeNames[m_componentId] : c_empty;
+}
+
+std::string UnityMessagerDispatcher::Message::GetStringParam(int paramIdx) const
+{
+	const UnityMessagerDecoder::Param& param = GetDecodedParam(paramIdx);
+	ASSERT(m_batchRowIdx < 0);
+
+	if (param.typeId == m_dispatcher.m_internedStringQueueId && param.length < 0)
+	{
+		int id = GetParam<UnityMessager::InternedStringRef>(paramIdx).id;
+		const std::vector<std::string>& internedStrings = m_dispatcher.m_internedStrings;
+		return id >= 0 && id < (int)internedStrings.size() ? internedStrings[id] : std::string();
+	}
+
+	ASSERT(param.length >= 0 && param.sizeInBytes == param.length); //strings are sent as byte arrays
+	return param.pData ? std::string(reinterpret_cast<const char*>(param.pData), param.sizeInBytes) : std::string();
+}
+
+const UnityMessagerDecoder::Param& UnityMessagerDispatcher::Message::GetDecodedParam(int paramIdx) const
+{
+	ASSERT(paramIdx >= 0 && paramIdx < m_nOfParams);
+	return m_pParams[paramIdx];
+}
+
+UnityMessagerDispatcher::UnityMessagerDispatcher(int initFlags, int controlQueueFirstArrayId, SharedArrays& sharedArrays, 
+												 int channelId)
+	: m_decoder(initFlags), m_sharedArrays(sharedArrays), m_channelId(channelId), m_isDoubleBuffered((initFlags & UM_INIT_FLAG_DOUBLE_BUFFERED) != 0),
+	m_isInterleaved((initFlags & UM_INIT_FLAG_INTERLEAVED_PARAMS) != 0), m_firstArrayIds(1, controlQueueFirstArrayId),
+	m_secondFirstArrayIds(1, -1), m_componentTypeNames(), m_routingBindings(), m_internedStrings(),
+	m_internedStringChunks(), m_internedStringQueueId(-1), m_receivers(), m_boundReceiverIds(), m_msgReceivers(), m_namedReceivers(),
+	m_pDefaultReceiver(NULL), m_nOfMessagesDelivered(0), m_nOfMessagesWithoutReceiver(0), m_nOfBytesDelivered(0)
+{
+	//the names of the messages addressed by them are read from the payload queue as bytes
+	if (m_isInterleaved)
+		m_decoder.SetType(UM_PAYLOAD_QUEUE_ID, 1, 1, "System.Byte");
+}
+
+void UnityMessagerDispatcher::SetReceiver(int receiverId, Receiver* pReceiver)
+{
+	ASSERT(receiverId >= 0);
+	int index = UM_RECEIVER_ID_INDEX(receiverId);
+	if (index >= (int)m_receivers.size())
+	{
+		m_receivers.resize(index + 1, NULL);
+		m_boundReceiverIds.resize(index + 1, -1);
+	}
+
+	//removing the receiver of a stale id doesn't remove the one set for the current id of the slot
+	if (pReceiver == NULL && m_boundReceiverIds[index] != receiverId)
+		return;
+
+	m_receivers[index] = pReceiver;
+	m_boundReceiverIds[index] = pReceiver ? receiverId : -1;
+}
+
+void UnityMessagerDispatcher::SetReceiver(int receiverId, int msgId, Receiver* pReceiver)
+{
+	ASSERT(receiverId >= 0 && msgId >= 0);
+	uint64 key = ((uint64)(uint32)receiverId << 32) | (uint32)msgId;
+	if (pReceiver)
+		m_msgReceivers[key] = pReceiver;
+	else
+		m_msgReceivers.erase(key);
+}
+
+void UnityMessagerDispatcher::SetReceiver(const char* objectName, Receiver* pReceiver)
+{
+	if (pReceiver)
+		m_namedReceivers[objectName] = pReceiver;
+	else
+		m_namedReceivers.erase(objectName);
+}
+
+void UnityMessagerDispatcher::ReleaseReceiverId(int receiverId)
+{
+	//the receiver ids table is the same one the C# side uses, which is shared with the UnityMessager
+	if (UnityMessager::GetInstance(m_channelId).ReleaseReceiverId(receiverId))
+		SetReceiver(receiverId, NULL);
+}
+
+bool UnityMessagerDispatcher::DeliverMessages()
+{
+	UnityMessager::GetInstance(m_channelId).OnStartMessageDelivering();
+
+	m_nOfMessagesDelivered = 0;
+	m_nOfMessagesWithoutReceiver = 0;
+	m_nOfBytesDelivered = 0;
+
+	//the first array ids are all read before the first control message, so registering queues while decoding is fine
+	bool isValid = m_decoder.DecodeDelivering(m_sharedArrays, &m_firstArrayIds[0], (int)m_firstArrayIds.size(), *this);
+	if (!isValid)
+		ERROR_LOG("[UnityMessagerDispatcher] Invalid message stream, the remaining messages were not delivered!");
+
+	//as done by the C# side, the UnityMessager checks it before releasing the queue arrays
+	int* pControlQueueArray = reinterpret_cast<int*>(m_sharedArrays.GetArrayForWrite(m_firstArrayIds[UM_CONTROL_QUEUE_ID]));
+	if (pControlQueueArray)
+		pControlQueueArray[0] = UMD_EMPTY_CONTROL_QUEUE_CODE;
+
+	//the C++ side is writing to the other set of arrays since the delivering started
+	if (m_isDoubleBuffered)
+	{
+		for (size_t queueId = 0; queueId < m_firstArrayIds.size(); ++queueId)
+		{
+			if (m_secondFirstArrayIds[queueId] >= 0)
+				std::swap(m_firstArrayIds[queueId], m_secondFirstArrayIds[queueId]);
+		}
+	}
+
+	//the UnityArrays referenced by the delivered messages may be released now
+	UnityMessager::GetInstance(m_channelId).OnFinishMessageDelivering();
+	return isValid;
+}
+
+void UnityMessagerDispatcher::OnControlMessage(int msgId, int nOfParams, const int* pParams, int controlBytes)
+{
+	m_nOfBytesDelivered += controlBytes;
+
+	switch (msgId)
+	{
+	case UMM_SET_QUEUE_FIRST_ARRAY:
+		if (nOfParams >= 2)
+			RegisterQueueFirstArray(pParams[0], pParams[1], nOfParams >= 3 ? pParams[2] : -1);
+		break;
+	case UMM_REGISTER_PAYLOAD_TYPE:
+		if (nOfParams >= UMD_PACKED_CHARS_FIRST_PARAM && (pParams[2] + 3) / 4 <= nOfParams - UMD_PACKED_CHARS_FIRST_PARAM)
+			RegisterPayloadType(pParams[0], pParams[1], pParams[2], pParams + UMD_PACKED_CHARS_FIRST_PARAM);
+		break;
+	case UMM_REGISTER_INTERNED_STRING:
+		if (nOfParams >= UMD_PACKED_CHARS_FIRST_PARAM)
+			RegisterInternedStringChunk(pParams[0], pParams[1], pParams[2], pParams + UMD_PACKED_CHARS_FIRST_PARAM,
+										nOfParams - UMD_PACKED_CHARS_FIRST_PARAM);
+		break;
+	case UMM_SET_INTERNED_STRING_QUEUE:
+		if (nOfParams >= 1)
+			m_internedStringQueueId = pParams[0];
+		break;
+	}
+}
+
+void UnityMessagerDispatcher::OnMessage(const UnityMessagerDecoder::Message& decodedMessage)
+{
+	m_nOfBytesDelivered += decodedMessage.controlBytes;
+	for (int i = 0; i < decodedMessage.nOfParams; ++i)
+		m_nOfBytesDelivered += decodedMessage.pParams[i].sizeInBytes;
+
+	if (decodedMessage.isDiscarded)
+		return;
+
+	Message message(*this);
+	message.m_receiverId = decodedMessage.receiverId >= 0 ? decodedMessage.receiverId : -1;
+	message.m_msgId = decodedMessage.msgId >= 0 ? decodedMessage.msgId : -1;
+	message.m_componentId = decodedMessage.componentId;
+	message.m_nOfParams = decodedMessage.nOfParams;
+	message.m_pParams = decodedMessage.pParams;
+
+	if (decodedMessage.objectName)
+		message.m_objectName.assign(decodedMessage.objectName, -decodedMessage.receiverId);
+	if (decodedMessage.methodName)
+		message.m_methodName.assign(decodedMessage.methodName, -decodedMessage.msgId);
+
+	//component ids smaller than -1 are routing bindings, which are replaced by the component id and the names of the binding
+	if (message.m_componentId <= UMD_FIRST_ROUTING_BINDING_SLOT)
+	{
+		int bindingId = UMD_FIRST_ROUTING_BINDING_SLOT - message.m_componentId;
+		if (bindingId >= (int)m_routingBindings.size())
+		{
+			ERROR_LOG("[UnityMessagerDispatcher] Message sent through an unknown routing binding!");
+			return;
+		}
+
+		const RoutingBinding& binding = m_routingBindings[bindingId];
+		message.m_componentId = binding.componentId;
+		message.m_objectName = binding.objectName;
+		message.m_methodName = binding.methodName;
+		if (!binding.methodName.empty())
+			message.m_msgId = -1;
+	}
+
+	if (message.m_receiverId == UMR_MESSAGER && message.m_componentId == -1 && message.m_objectName.empty())
+	{
+		HandleMessagerMessage(message);
+		return;
+	}
+
+	Dispatch(message);
+}
+
+void UnityMessagerDispatcher::RegisterQueueFirstArray(int queueId, int firstArrayId, int secondFirstArrayId)
+{
+	if (queueId < 0)
+		return;
+
+	if (queueId >= (int)m_firstArrayIds.size())
+	{
+		m_firstArrayIds.resize(queueId + 1, -1);
+		m_secondFirstArrayIds.resize(queueId + 1, -1);
+	}
+
+	//the control queue first array is the one being read right now
+	if (queueId != UM_CONTROL_QUEUE_ID)
+		m_firstArrayIds[queueId] = firstArrayId;
+	m_secondFirstArrayIds[queueId] = secondFirstArrayId;
+
+	//as the C# side, the parameter type comes from the type of the queue array, when interleaved the type ids are the payload ones
+	const char* managedTypeName = m_sharedArrays.GetManagedTypeName(firstArrayId);
+	if (m_isInterleaved || queueId == UM_CONTROL_QUEUE_ID || managedTypeName == NULL)
+		return;
+
+	int itemSize = m_sharedArrays.GetTypeSize(managedTypeName);
+	ASSERT(itemSize > 0);
+	if (itemSize > 0)
+		m_decoder.SetType(queueId, itemSize, 1, managedTypeName);
+}
+
+void UnityMessagerDispatcher::RegisterPayloadType(int typeId, int alignment, int nameLength, const int* pPackedName)
+{
+	std::string managedTypeName(nameLength, ' ');
+	UnpackChars(pPackedName, nameLength, &managedTypeName[0]);
+
+	int itemSize = m_sharedArrays.GetTypeSize(managedTypeName.c_str());
+	ASSERT(itemSize > 0); //as the C# side, the type MUST BE known
+	if (typeId >= 0 && itemSize > 0 && alignment > 0 && (alignment & (alignment - 1)) == 0)
+		m_decoder.SetType(typeId, itemSize, alignment, managedTypeName.c_str());
+}
+
+void UnityMessagerDispatcher::RegisterInternedStringChunk(int id, int length, int offset, const int* pPackedChars, int nOfPackedChars)
+{
+	if (id < 0 || length < 0 || offset < 0 || offset > length)
+		return;
+
+	m_internedStringChunks.resize(length);
+	int chunkLength = std::min(length - offset, nOfPackedChars * 4);
+	UnpackChars(pPackedChars, chunkLength, &m_internedStringChunks[0] + offset);
+	if (offset + chunkLength < length)
+		return;
+
+	//evicted strings are replaced on the C++ side, messages delivered before have already got the previous string
+	if (id >= (int)m_internedStrings.size())
+		m_internedStrings.resize(id + 1);
+	m_internedStrings[id] = m_internedStringChunks;
+}
+
+void UnityMessagerDispatcher::HandleMessagerMessage(Message& message)
+{
+	switch (message.m_msgId)
+	{
+	case UMM_REGISTER_NEW_COMPONENT: //(int componentId, string componentTypeName)
+		if (message.m_nOfParams == 2)
+		{
+			int componentId = message.GetParam<int>(0);
+			if (componentId >= (int)m_componentTypeNames.size())
+				m_componentTypeNames.resize(componentId + 1);
+			if (componentId >= 0)
+				m_componentTypeNames[componentId] = message.GetStringParam(1);
+		}
+		break;
+	case UMM_REGISTER_ROUTING_BINDING: //(int bindingId, int componentId, string objectName, string methodName)
+		if (message.m_nOfParams == 4)
+		{
+			int bindingId = message.GetParam<int>(0);
+			ASSERT(bindingId == (int)m_routingBindings.size()); //the id is the index, as it happens to the component ids
+			if (bindingId >= (int)m_routingBindings.size())
+				m_routingBindings.resize(bindingId + 1);
+
+			RoutingBinding& binding = m_routingBindings[bindingId];
+			binding.componentId = message.GetParam<int>(1);
+			binding.objectName = message.GetStringParam(2);
+			binding.methodName = message.GetStringParam(3);
+		}
+		break;
+	case UMM_BATCH_MESSAGE: //(int msgId, int[] receiverIds, columns...), dispatched as a message per receiver
+		if (message.m_nOfParams >= 2)
+		{
+			int receiversLength;
+			const int* pReceiverIds = message.GetArrayParam<int>(1, receiversLength);
+
+			Message batchMessage(*this);
+			batchMessage.m_msgId = message.GetParam<int>(0);
+			batchMessage.m_nOfParams = message.m_nOfParams - 2;
+			batchMessage.m_pParams = message.m_pParams + 2;
+			for (int i = 0; pReceiverIds && i < receiversLength; ++i)
+			{
+				batchMessage.m_receiverId = pReceiverIds[i];
+				batchMessage.m_batchRowIdx = i;
+				Dispatch(batchMessage);
+			}
+		}
+		break;
+	}
+}
+
+void UnityMessagerDispatcher::Dispatch(const Message& message)
+{
+	++m_nOfMessagesDelivered;
+
+	Receiver* pReceiver = NULL;
+	if (!message.m_objectName.empty())
+	{
+		std::unordered_map<std::string, Receiver*>::const_iterator it = m_namedReceivers.find(message.m_objectName);
+		pReceiver = it != m_namedReceivers.end() ? it->second : NULL;
+	}
+	else if (message.m_receiverId >= 0)
+	{
+		if (message.m_msgId >= 0 && !m_msgReceivers.empty())
+		{
+			uint64 key = ((uint64)(uint32)message.m_receiverId << 32) | (uint32)message.m_msgId;
+			std::unordered_map<uint64, Receiver*>::const_iterator it = m_msgReceivers.find(key);
+			pReceiver = it != m_msgReceivers.end() ? it->second : NULL;
+		}
+
+		//as the C# side, messages to a stale id don't get to the receiver set for the current id of its slot
+		int index = UM_RECEIVER_ID_INDEX(message.m_receiverId);
+		if (pReceiver == NULL && index < (int)m_receivers.size() && m_boundReceiverIds[index] == message.m_receiverId)
+			pReceiver = m_receivers[index];
+	}
+
+	if (pReceiver == NULL)
+		pReceiver = m_pDefaultReceiver;
+
+	if (pReceiver)
+		pReceiver->ReceiveMessage(message);
+	else
+		++m_nOfMessagesWithoutReceiver;
+}
+
+}; //UnityForCpp
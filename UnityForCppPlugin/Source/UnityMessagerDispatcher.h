@@ -0,0 +1,195 @@
+//Copyright (c) 2016, Samuel Pollachini (Samuel Polacchini)
+//The UnityForCpp project is licensed under the terms of the MIT license
+
+#ifndef UNITY_MESSAGER_DISPATCHER_H
+#define UNITY_MESSAGER_DISPATCHER_H
+
+#include "UnityMessagerDecoder.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace UnityForCpp
+{
+
+//Native counterpart of the C# UnityMessager.DeliverMessages, so the C++ code can run headless (with no Unity at all) using the
+//same messaging code: DeliverMessages starts the delivering on the UnityMessager, decodes its messages by the UnityMessagerDecoder
+//and dispatches each one to the Receiver registered for it, finishing the delivering after that. As the C# side, it keeps
+//the queue arrays and the parameter types from the control messages, and handles the messages to the UnityMessager itself:
+//component registrations, routing bindings (resolved to their component and names), interned strings, discarded coalesced
+//messages and batch messages (dispatched as a message per receiver). The shared arrays come from a SharedArrays instance,
+//playing the role the C# UnityAdapter has for the C# side.
+//
+class UnityMessagerDispatcher : private UnityMessagerDecoder::Handler
+{
+public:
+	//Provides the shared arrays by their ids, as the C# UnityAdapter does, besides the type of their items
+	class SharedArrays : public UnityMessagerDecoder::ArraySource
+	{
+	public:
+		//.NET type of the array items (check UA_SUPPORTED_TYPE), NULL if the array is not available
+		virtual const char* GetManagedTypeName(int arrayId) = 0;
+
+		//Item size for the arrays of a .NET type, 0 if the type is not known
+		virtual int GetTypeSize(const char* managedTypeName) = 0;
+
+		//Writable access to the array, NULL if it is not available
+		virtual uint8* GetArrayForWrite(int arrayId) = 0;
+	};
+
+	//A message being dispatched, it and its parameters are valid only during the ReceiveMessage call. Parameters are read by
+	//their index and the type they were sent with, not being checked beyond their size, as the C++ side is the one sending them.
+	class Message
+	{
+	public:
+		int GetReceiverId() const { return m_receiverId; } //-1 for messages addressed by the object name
+		int GetMsgId() const { return m_msgId; } //-1 for messages addressed by the method name
+		int GetComponentId() const { return m_componentId; } //-1 if not addressed to a component
+		const std::string& GetComponentTypeName() const; //empty if not addressed to a component
+
+		//Names of the messages addressed by them, directly or by a routing binding, empty otherwise
+		const std::string& GetObjectName() const { return m_objectName; }
+		const std::string& GetMethodName() const { return m_methodName; }
+
+		int GetNOfParams() const { return m_nOfParams; }
+		bool IsParamAnArray(int paramIdx) const { return m_batchRowIdx < 0 && GetDecodedParam(paramIdx).length >= 0; }
+
+		template<typename T> T GetParam(int paramIdx) const;
+
+		//Array parameters point to the queue arrays, returns NULL for arrays not available (as the referenced UnityArrays
+		//when decoding traces) and for the ones not aligned for T, length is set in both cases
+		template<typename T> const T* GetArrayParam(int paramIdx, int& length) const;
+
+		//Reads strings sent as const char* or as UnityMessager::InternedString
+		std::string GetStringParam(int paramIdx) const;
+
+	private:
+		friend class UnityMessagerDispatcher;
+		Message(const UnityMessagerDispatcher& dispatcher)
+			: m_dispatcher(dispatcher), m_receiverId(-1), m_msgId(-1), m_componentId(-1), m_objectName(), m_methodName(),
+			m_nOfParams(0), m_pParams(NULL), m_batchRowIdx(-1) {}
+
+		const UnityMessagerDecoder::Param& GetDecodedParam(int paramIdx) const;
+
+		const UnityMessagerDispatcher& m_dispatcher;
+		int m_receiverId;
+		int m_msgId;
+		int m_componentId;
+		std::string m_objectName;
+		std::string m_methodName;
+		int m_nOfParams;
+		const UnityMessagerDecoder::Param* m_pParams;
+		int m_batchRowIdx; //row of the batch message columns being the parameters, -1 if not a batch message
+	};
+
+	//IMPLEMENT this interface for the native objects receiving messages, as the C# IMessageReceiver
+	class Receiver
+	{
+	public:
+		virtual ~Receiver() {}
+		virtual void ReceiveMessage(const Message& message) = 0;
+	};
+
+	//initFlags, channelId and controlQueueFirstArrayId are arguments and the return of UnityMessager::InstanceAndProvideAwakeInfo,
+	//a dispatcher delivers the messages of a single channel, as a C# UnityMessager instance does
+	UnityMessagerDispatcher(int initFlags, int controlQueueFirstArrayId, SharedArrays& sharedArrays, 
+							int channelId = UM_DEFAULT_CHANNEL);
+
+	//Messages to the receiver id are dispatched to pReceiver, or ignored if it is NULL (also for removing it)
+	void SetReceiver(int receiverId, Receiver* pReceiver);
+
+	//The same, but only for the messages with msgId, taking precedence over the receiver set above
+	void SetReceiver(int receiverId, int msgId, Receiver* pReceiver);
+
+	//Messages addressed by the object name (found by GameObject.Find on the C# side)
+	void SetReceiver(const char* objectName, Receiver* pReceiver);
+
+	//Messages without a receiver set are dispatched to this one, if any
+	void SetDefaultReceiver(Receiver* pReceiver) { m_pDefaultReceiver = pReceiver; }
+
+	//Releases an id given by UnityMessager::NewReceiverId, also removing its receiver, as the C# UnityMessager.ReleaseReceiverId
+	void ReleaseReceiverId(int receiverId);
+
+	//Delivers all the messages sent since the previous delivering, returns false if the message stream was not valid
+	//(nothing that a correct UnityMessager produces), then the messages after the invalid point are not dispatched.
+	bool DeliverMessages();
+
+	//Counters of the last delivering, the bytes are the ones read from the control and parameter queues
+	int GetNOfMessagesDelivered() const { return m_nOfMessagesDelivered; }
+	int GetNOfMessagesWithoutReceiver() const { return m_nOfMessagesWithoutReceiver; }
+	int64 GetNOfBytesDelivered() const { return m_nOfBytesDelivered; }
+
+private:
+	struct RoutingBinding
+	{
+		int componentId;
+		std::string objectName;
+		std::string methodName;
+	};
+
+	virtual void OnControlMessage(int msgId, int nOfParams, const int* pParams, int controlBytes);
+	virtual void OnMessage(const UnityMessagerDecoder::Message& decodedMessage);
+
+	void RegisterQueueFirstArray(int queueId, int firstArrayId, int secondFirstArrayId);
+	void RegisterPayloadType(int typeId, int alignment, int nameLength, const int* pPackedName);
+	void RegisterInternedStringChunk(int id, int length, int offset, const int* pPackedChars, int nOfPackedChars);
+
+	//Handles the messages addressed to the UnityMessager that are not control messages
+	void HandleMessagerMessage(Message& message);
+	void Dispatch(const Message& message);
+
+	UnityMessagerDecoder m_decoder;
+	SharedArrays& m_sharedArrays;
+	int m_channelId;
+	bool m_isDoubleBuffered;
+	bool m_isInterleaved;
+
+	std::vector<int> m_firstArrayIds; //indexed by the queue id, -1 for the ones not registered
+	std::vector<int> m_secondFirstArrayIds; //the same, for the other set of arrays when double buffered
+
+	std::vector<std::string> m_componentTypeNames; //indexed by the component id
+	std::vector<RoutingBinding> m_routingBindings; //indexed by the binding id
+	std::vector<std::string> m_internedStrings; //indexed by the string id
+	std::string m_internedStringChunks; //chars of the interned string being registered, which may come on several chunks
+	int m_internedStringQueueId; //check UMM_SET_INTERNED_STRING_QUEUE, -1 if not set
+
+	std::vector<Receiver*> m_receivers; //indexed by the slot index of the receiver id (check UM_RECEIVER_ID_INDEX)
+	std::vector<int> m_boundReceiverIds; //the same, id each receiver was set for, -1 for the slots without receiver
+	std::unordered_map<uint64, Receiver*> m_msgReceivers; //by the receiver id and the msgId
+	std::unordered_map<std::string, Receiver*> m_namedReceivers; //by the object name
+	Receiver* m_pDefaultReceiver;
+
+	int m_nOfMessagesDelivered;
+	int m_nOfMessagesWithoutReceiver;
+	int64 m_nOfBytesDelivered;
+};
+
+template<typename T>
+inline T UnityMessagerDispatcher::Message::GetParam(int paramIdx) const
+{
+	const UnityMessagerDecoder::Param& param = GetDecodedParam(paramIdx);
+	T value = T();
+
+	//the parameters of a batch message are the items at the row of its columns
+	int itemIdx = m_batchRowIdx >= 0 ? m_batchRowIdx : 0;
+	ASSERT(m_batchRowIdx >= 0 ? param.length > m_batchRowIdx && param.sizeInBytes == param.length * (int)sizeof(T)
+							  : param.length < 0 && param.sizeInBytes == sizeof(T));
+	if (param.pData && (itemIdx + 1) * (int)sizeof(T) <= param.sizeInBytes)
+		memcpy(&value, param.pData + itemIdx * sizeof(T), sizeof(T));
+
+	return value;
+}
+
+template<typename T>
+inline const T* UnityMessagerDispatcher::Message::GetArrayParam(int paramIdx, int& length) const
+{
+	const UnityMessagerDecoder::Param& param = GetDecodedParam(paramIdx);
+	ASSERT(m_batchRowIdx < 0 && param.length >= 0 && param.sizeInBytes == param.length * (int)sizeof(T));
+
+	length = param.length >= 0 ? param.length : 0;
+	return param.pData && (reinterpret_cast<uintptr_t>(param.pData) % alignof(T)) == 0 ? reinterpret_cast<const T*>(param.pData) : NULL;
+}
+
+}; //UnityForCpp
+
+#endif
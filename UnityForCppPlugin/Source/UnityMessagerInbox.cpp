@@ -0,0 +1,232 @@
+//Copyright (c) 2016, Samuel Pollachini (Samuel Polacchini)
+//The UnityForCpp project is licensed under the terms of the MIT license
+
+#include "UnityMessagerInbox.h"
+#include "UnityMessagerWire.h"
+
+//the C# side writes whole messages to an array, so the arrays are at least as long as the ones of the message queues
+#define UMI_MIN_ARRAY_SIZE_IN_BYTES 512
+
+namespace UnityForCpp
+{
+
+const UnityMessagerInbox::Message::Param& UnityMessagerInbox::Message::GetParamInfo(int paramIdx) const
+{
+	ASSERT(paramIdx >= 0 && paramIdx < m_nOfParams);
+	return m_pParams[paramIdx];
+}
+
+const uint8* UnityMessagerInbox::Message::GetParamData(int paramIdx, const char* managedTypeName, int itemSize, bool isArray) const
+{
+	if (paramIdx < 0 || paramIdx >= m_nOfParams)
+	{
+		ERROR_LOGF("[UnityMessagerInbox] Message %d has no parameter %d!", m_msgId, paramIdx);
+		return NULL;
+	}
+
+	const Param& param = m_pParams[paramIdx];
+	const ParamType& type = m_inbox.m_types[param.typeId];
+	if (type.matchedManagedTypeName != managedTypeName)
+	{
+		if (type.size != itemSize || type.managedTypeName != managedTypeName)
+		{
+			ERROR_LOGF("[UnityMessagerInbox] Parameter %d of the message %d is a %s, not a %s!", paramIdx, m_msgId,
+					   type.managedTypeName.c_str(), managedTypeName);
+			return NULL;
+		}
+
+		type.matchedManagedTypeName = managedTypeName;
+	}
+
+	if ((param.length >= 0) != isArray)
+	{
+		ERROR_LOGF("[UnityMessagerInbox] Parameter %d of the message %d %s an array!", paramIdx, m_msgId, isArray ? "is not" : "is");
+		return NULL;
+	}
+
+	return param.pData;
+}
+
+std::string UnityMessagerInbox::Message::GetStringParam(int paramIdx) const
+{
+	int length;
+	const char* pChars = reinterpret_cast<const char*>(GetArrayParam<uint8>(paramIdx, length));
+	return pChars ? std::string(pChars, length) : std::string();
+}
+
+UnityMessagerInbox::UnityMessagerInbox(int arraysSizeInBytes)
+	: m_arrays(), m_currentArrayIdx(0), m_arraysSizeInBytes(AlignPos(arraysSizeInBytes > UMI_MIN_ARRAY_SIZE_IN_BYTES
+																	  ? arraysSizeInBytes : UMI_MIN_ARRAY_SIZE_IN_BYTES, UMI_RECORD_ALIGNMENT)),
+	m_drainSerial(0), m_types(), m_params(), m_receivers(), m_pDefaultReceiver(NULL)
+{
+	m_arrays.push_back(NewArray(m_arraysSizeInBytes));
+
+	ParamType byteType = { UnityArray<uint8>::s_managedTypeName, 1, 1, UnityArray<uint8>::s_managedTypeName };
+	m_types.push_back(byteType); //UMI_BYTE_TYPE_ID
+}
+
+UnityMessagerInbox::~UnityMessagerInbox()
+{
+	for (size_t i = 0; i < m_arrays.size(); ++i)
+		delete m_arrays[i];
+}
+
+void UnityMessagerInbox::SetReceiver(int receiverId, Receiver* pReceiver)
+{
+	ASSERT(receiverId >= 0);
+	if (receiverId >= (int)m_receivers.size())
+		m_receivers.resize(receiverId + 1, NULL);
+
+	m_receivers[receiverId] = pReceiver;
+}
+
+bool UnityMessagerInbox::HasMessagesToDrain() const
+{
+	return m_currentArrayIdx > 0 || ReadInt(m_arrays[0]->GetPtr(), 0) > UMI_ARRAY_HEADER_SIZE;
+}
+
+int UnityMessagerInbox::DrainMessages()
+{
+	int nOfMessages = 0;
+	bool isValid = true;
+
+	//the end positions and m_currentArrayIdx are read again after each message, since its receiver may call C# code sending more
+	for (int arrayIdx = 0; isValid && arrayIdx <= m_currentArrayIdx; ++arrayIdx)
+	{
+		const uint8* pArray = m_arrays[arrayIdx]->GetPtr();
+		int arrayLength = m_arrays[arrayIdx]->GetLength();
+		int pos = UMI_ARRAY_HEADER_SIZE;
+		while (pos < ReadInt(pArray, 0))
+		{
+			int recordLength = ReadInt(pArray, pos);
+			int nOfParams = ReadInt(pArray, pos + 3 * sizeof(int));
+			if (recordLength < UMI_RECORD_HEADER_SIZE || recordLength % UMI_RECORD_ALIGNMENT != 0 || pos + recordLength > arrayLength
+				|| nOfParams < 0 || !ReadParams(pArray, pos, recordLength, nOfParams))
+			{
+				ERROR_LOG("[UnityMessagerInbox] Invalid message written by the C# side, the remaining messages were discarded!");
+				isValid = false;
+				break;
+			}
+
+			Message message(*this);
+			message.m_receiverId = ReadInt(pArray, pos + sizeof(int));
+			message.m_msgId = ReadInt(pArray, pos + 2 * sizeof(int));
+			message.m_nOfParams = nOfParams;
+			message.m_pParams = m_params.empty() ? NULL : &m_params[0];
+
+			Receiver* pReceiver = message.m_receiverId >= 0 && message.m_receiverId < (int)m_receivers.size()
+								  ? m_receivers[message.m_receiverId] : NULL;
+			if (pReceiver == NULL)
+				pReceiver = m_pDefaultReceiver;
+			if (pReceiver)
+				pReceiver->ReceiveMessage(message);
+
+			++nOfMessages;
+			pos += recordLength;
+		}
+	}
+
+	//the C# side writes from the first array again once it sees the new drain serial
+	for (int arrayIdx = 0; arrayIdx <= m_currentArrayIdx; ++arrayIdx)
+		WriteInt(m_arrays[arrayIdx]->GetPtr(), 0, UMI_ARRAY_HEADER_SIZE);
+
+	WriteInt(m_arrays[0]->GetPtr(), sizeof(int), ++m_drainSerial);
+	m_currentArrayIdx = 0;
+	return nOfMessages;
+}
+
+int UnityMessagerInbox::AdvanceToNextArray(int minLengthInBytes)
+{
+	ASSERT(minLengthInBytes > UMI_ARRAY_HEADER_SIZE);
+	++m_currentArrayIdx;
+
+	if (m_currentArrayIdx == (int)m_arrays.size())
+		m_arrays.push_back(NewArray(minLengthInBytes));
+	else if (m_arrays[m_currentArrayIdx]->GetLength() < minLengthInBytes)
+	{
+		delete m_arrays[m_currentArrayIdx];
+		m_arrays[m_currentArrayIdx] = NewArray(minLengthInBytes);
+	}
+
+	return m_arrays[m_currentArrayIdx]->GetId();
+}
+
+void UnityMessagerInbox::ReleaseArraysExceptFirst()
+{
+	if (m_currentArrayIdx > 0)
+		return;
+
+	for (size_t i = 1; i < m_arrays.size(); ++i)
+		delete m_arrays[i];
+
+	m_arrays.resize(1);
+}
+
+bool UnityMessagerInbox::ReadParams(const uint8* pArray, int pos, int recordLength, int nOfParams)
+{
+	m_params.resize(nOfParams);
+
+	int endPos = pos + recordLength;
+	pos += UMI_RECORD_HEADER_SIZE;
+	for (int i = 0; i < nOfParams; ++i)
+	{
+		if (pos + UMI_PARAM_HEADER_SIZE > endPos)
+			return false;
+
+		Message::Param& param = m_params[i];
+		param.typeId = ReadInt(pArray, pos);
+		param.length = ReadInt(pArray, pos + sizeof(int));
+		pos += UMI_PARAM_HEADER_SIZE;
+
+		if ((param.typeId & UMI_NEW_TYPE_FLAG) != 0)
+		{
+			param.typeId &= ~UMI_NEW_TYPE_FLAG;
+			if (pos + 2 * (int)sizeof(int) > endPos)
+				return false;
+
+			int size = ReadInt(pArray, pos);
+			int nameLength = ReadInt(pArray, pos + sizeof(int));
+			pos += 2 * sizeof(int);
+			if (nameLength < 0 || nameLength > endPos - pos
+				|| !RegisterType(param.typeId, size, reinterpret_cast<const char*>(pArray + pos), nameLength))
+				return false;
+
+			pos += AlignPos(nameLength, sizeof(int));
+		}
+
+		if (param.typeId < 0 || param.typeId >= (int)m_types.size() || param.length < -1)
+			return false;
+
+		const ParamType& type = m_types[param.typeId];
+		pos = AlignPos(pos, type.alignment);
+		int64 sizeInBytes = (int64)type.size * (param.length >= 0 ? param.length : 1);
+		if (sizeInBytes > endPos - pos)
+			return false;
+
+		param.pData = pArray + pos;
+		pos += (int)sizeInBytes;
+	}
+
+	return true;
+}
+
+bool UnityMessagerInbox::RegisterType(int typeId, int size, const char* name, int nameLength)
+{
+	ASSERT(typeId == (int)m_types.size()); //the C# side gives the ids in sequence
+	if (typeId != (int)m_types.size() || size <= 0)
+		return false;
+
+	ParamType type = { std::string(name, nameLength), size, GetItemAlignment(size), NULL };
+	m_types.push_back(type);
+	return true;
+}
+
+UnityArray<uint8>* UnityMessagerInbox::NewArray(int lengthInBytes)
+{
+	UnityArray<uint8>* pArray = new UnityArray<uint8>();
+	pArray->Alloc(AlignPos(lengthInBytes > m_arraysSizeInBytes ? lengthInBytes : m_arraysSizeInBytes, UMI_RECORD_ALIGNMENT));
+	WriteInt(pArray->GetPtr(), 0, UMI_ARRAY_HEADER_SIZE);
+	return pArray;
+}
+
+}; //UnityForCpp
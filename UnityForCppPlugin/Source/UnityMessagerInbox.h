@@ -0,0 +1,190 @@
+//Copyright (c) 2016, Samuel Pollachini (Samuel Polacchini)
+//The UnityForCpp project is licensed under the terms of the MIT license
+
+#ifndef UNITY_MESSAGER_INBOX_H
+#define UNITY_MESSAGER_INBOX_H
+
+#include "Shared.h"
+#include "UnityArray.h"
+#include <string>
+#include <string.h>
+#include <vector>
+
+//Layout of the inbox arrays, which MUST BE KEPT IN SYNCH with the UnityMessager.InboxWriter constants on C#. All the values
+//are little endian ints, the positions are in bytes from the start of the array.
+//
+//Array header: (int endPos, int drainSerial). endPos is the end of the last message written by C#, drainSerial is only used
+//on the first array, being incremented by each DrainMessages so the C# side knows it can write from the first array again.
+#define UMI_ARRAY_HEADER_SIZE 8
+//Message record header: (int recordLength, int receiverId, int msgId, int nOfParams), the records start aligned to 8 bytes
+//and their length (header and parameters) is padded to 8 bytes, so the next record starts aligned too.
+#define UMI_RECORD_HEADER_SIZE 16
+#define UMI_RECORD_ALIGNMENT 8
+//Parameter header: (int typeId, int length), length is -1 for single parameters. The parameter items follow it, aligned to
+//their alignment (check GetItemAlignment at UnityMessagerWire.h, the same of the rings) relative to the start of the array.
+#define UMI_PARAM_HEADER_SIZE 8
+//Set on the typeId of the first parameter of each type, being the parameter header followed by (int size, int nameLength) and
+//the .NET type name chars, padded to 4 bytes. Type ids are given by the C# side in sequence, starting from 1.
+#define UMI_NEW_TYPE_FLAG 0x40000000
+//Type id of System.Byte, never registered, strings are sent as byte arrays of it
+#define UMI_BYTE_TYPE_ID 0
+
+namespace UnityForCpp
+{
+
+//Messages sent from C# to C++ (as input, physics or UI events) through shared arrays owned by the C++ side, so the C# code
+//writes them without calling C++ at all, being all of them read by a single DrainMessages call on the C++ update. It is the
+//same queue idea of the UnityMessager, on the reverse direction: the C# UnityMessager.SendMessageToCpp versions write typed
+//messages to the current inbox array, only calling C++ when it gets full (check AdvanceToNextArray), while DrainMessages
+//reads all the arrays written since the previous drain, dispatching each message to the Receiver set for its receiver id.
+//There is an inbox per channel, check UnityMessager::GetInbox. Everything here happens on the main thread.
+//
+class UnityMessagerInbox
+{
+public:
+	//A message being drained, it and its parameters are valid only during the ReceiveMessage call. Parameters are read by their
+	//index and type, which is checked against the .NET type the C# side sent them with (check UA_SUPPORTED_TYPE), so reading
+	//a parameter as a different type logs an error and returns the default value (or NULL for arrays) instead.
+	class Message
+	{
+	public:
+		int GetReceiverId() const { return m_receiverId; }
+		int GetMsgId() const { return m_msgId; }
+
+		int GetNOfParams() const { return m_nOfParams; }
+		bool IsParamAnArray(int paramIdx) const { return GetParamInfo(paramIdx).length >= 0; }
+
+		template<typename T> T GetParam(int paramIdx) const;
+
+		//Array parameters point to the inbox array, returns NULL if the items are not of type T or are not aligned for it,
+		//length is set only when the array is returned (0 otherwise)
+		template<typename T> const T* GetArrayParam(int paramIdx, int& length) const;
+
+		//Reads strings sent by UnityMessager.PushStringParamToCpp (ASCII chars), empty if the parameter is not a string
+		std::string GetStringParam(int paramIdx) const;
+
+	private:
+		friend class UnityMessagerInbox;
+		Message(const UnityMessagerInbox& inbox)
+			: m_inbox(inbox), m_receiverId(0), m_msgId(0), m_nOfParams(0), m_pParams(NULL) {}
+
+		struct Param
+		{
+			int typeId;
+			int length; //-1 for single parameters
+			const uint8* pData;
+		};
+
+		const Param& GetParamInfo(int paramIdx) const;
+
+		//Returns the items of the parameter if it is of the .NET type managedTypeName and of size itemSize, logging an error otherwise
+		const uint8* GetParamData(int paramIdx, const char* managedTypeName, int itemSize, bool isArray) const;
+
+		const UnityMessagerInbox& m_inbox;
+		int m_receiverId;
+		int m_msgId;
+		int m_nOfParams;
+		const Param* m_pParams;
+	};
+
+	//IMPLEMENT this interface for the C++ objects receiving messages from C#, as the C# IMessageReceiver
+	class Receiver
+	{
+	public:
+		virtual ~Receiver() {}
+		virtual void ReceiveMessage(const Message& message) = 0;
+	};
+
+	//Messages to the receiver id are dispatched to pReceiver, or to the default receiver if it is NULL (also for removing it).
+	//The receiver ids are under your control, they have nothing to do with the C# receiver ids given by NewReceiverId.
+	void SetReceiver(int receiverId, Receiver* pReceiver);
+
+	//Messages without a receiver set are dispatched to this one, if any, otherwise they are just ignored
+	void SetDefaultReceiver(Receiver* pReceiver) { m_pDefaultReceiver = pReceiver; }
+
+	//Returns true if the C# side has written messages since the previous drain
+	bool HasMessagesToDrain() const;
+
+	//Dispatches all the messages written by the C# side since the previous drain, on their writing order, returning their number.
+	//Call it at the start of your update, before the logic depending on them. Messages sent by C# code called from the receivers
+	//are drained by the same call. Returns early (logging an error) if a message is not valid, discarding the remaining ones.
+	int DrainMessages();
+
+	//===================== END OF THE PUBLIC INTERFACE TO THE USER ==============================================
+
+	//This method MUST BE USED ONLY by the UnityMessagerPlugin interface implementation.
+	//Returns the id of the first inbox array, the C# side writes its messages from it after each drain.
+	int GetFirstArrayId() const { return m_arrays[0]->GetId(); }
+
+	//This method MUST BE USED ONLY by the UnityMessagerPlugin interface implementation.
+	//Called by the C# side when the message being written doesn't fit the current array, returns the id of the next array,
+	//which has at least minLengthInBytes (the C# side moves the message being written to it). Arrays are kept after the
+	//drain, so the steady state doesn't allocate arrays, check ReleaseArraysExceptFirst.
+	int AdvanceToNextArray(int minLengthInBytes);
+
+	//This method MUST BE USED ONLY by UnityMessager::ReleasePossibleQueueArrays, it does nothing if there are messages to drain
+	void ReleaseArraysExceptFirst();
+
+private:
+	friend class UnityMessager;
+
+	//Only created by UnityMessager::GetInbox, arraysSizeInBytes is the minimum length of the inbox arrays
+	UnityMessagerInbox(int arraysSizeInBytes);
+	~UnityMessagerInbox();
+
+	//Type of the parameters, registered by the first parameter of each type
+	struct ParamType
+	{
+		std::string managedTypeName;
+		int size;
+		int alignment;
+
+		//UnityArray<T>::s_managedTypeName of the last T matching the type, so it is checked by a pointer comparison on the next reads
+		mutable const char* matchedManagedTypeName;
+	};
+
+	//Reads the parameters of the record at pos to m_params, registering the new types, returns false if they are not valid
+	bool ReadParams(const uint8* pArray, int pos, int recordLength, int nOfParams);
+	bool RegisterType(int typeId, int size, const char* name, int nameLength);
+
+	//Allocates an inbox array of at least lengthInBytes, setting its header for a C# side writing from its start
+	UnityArray<uint8>* NewArray(int lengthInBytes);
+
+	static int ReadInt(const uint8* pArray, int pos) { int value; memcpy(&value, pArray + pos, sizeof(int)); return value; }
+	static void WriteInt(uint8* pArray, int pos, int value) { memcpy(pArray + pos, &value, sizeof(int)); }
+
+	std::vector<UnityArray<uint8>*> m_arrays; //the first one is kept for the inbox lifetime
+	int m_currentArrayIdx; //array being written by the C# side since the previous drain
+	int m_arraysSizeInBytes;
+	int m_drainSerial;
+
+	std::vector<ParamType> m_types; //indexed by the type ids, UMI_BYTE_TYPE_ID included
+	std::vector<Message::Param> m_params; //parameters of the message being dispatched
+
+	std::vector<Receiver*> m_receivers; //indexed by the receiver id
+	Receiver* m_pDefaultReceiver;
+};
+
+template<typename T>
+inline T UnityMessagerInbox::Message::GetParam(int paramIdx) const
+{
+	T value = T();
+	const uint8* pData = GetParamData(paramIdx, UnityArray<T>::s_managedTypeName, sizeof(T), false);
+	if (pData)
+		memcpy(&value, pData, sizeof(T));
+
+	return value;
+}
+
+template<typename T>
+inline const T* UnityMessagerInbox::Message::GetArrayParam(int paramIdx, int& length) const
+{
+	const uint8* pData = GetParamData(paramIdx, UnityArray<T>::s_managedTypeName, sizeof(T), true);
+	bool isValid = pData && (reinterpret_cast<uintptr_t>(pData) % alignof(T)) == 0;
+	length = isValid ? GetParamInfo(paramIdx).length : 0;
+	return isValid ? reinterpret_cast<const T*>(pData) : NULL;
+}
+
+}; //UnityForCpp
+
+#endif
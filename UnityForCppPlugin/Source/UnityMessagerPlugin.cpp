@@ -3,35 +3,87 @@
 
 #include "Shared.h"
 #include "UnityMessager.h"
+#include "UnityMessagerInbox.h"
+#include "UnityMessagerRing.h"
 
 using UnityForCpp::UnityMessager;
 
 //This DLL exposed interface just wrap the respective UnityMessager methods used for the C# UnityMessager instance
 //to communicate with the C++ UnityMessager instance. All communication from the C++ instance to the C# instance
-//is made by sending "UnityMessager messages".
+//is made by sending "UnityMessager messages". Each call takes the channel of the C# instance, which addresses the 
+//C++ instance of the same channel (check UnityMessager::GetInstance).
 extern "C"
 {
 	//Check comments for UnityMessager::InstanceAndProvideAwakeInfo
-	int EXPORT_API UM_InitUnityMessagerAndGetControlQueueId(int maxNOfReceiverIds, int maxQueueArraysSizeInBytes)
+	int EXPORT_API UM_InitUnityMessagerAndGetControlQueueId(int channelId, int initialNOfReceiverIds, int maxQueueArraysSizeInBytes, 
+															int initFlags)
 	{
-		return UnityMessager::InstanceAndProvideAwakeInfo(maxNOfReceiverIds, maxQueueArraysSizeInBytes);
+		return UnityMessager::InstanceAndProvideAwakeInfo(initialNOfReceiverIds, maxQueueArraysSizeInBytes, initFlags, channelId);
+	}
+
+	//Check comments for UnityMessager::ReserveReceiverIds, the C# side calls it when the free list of receiver ids is empty
+	void EXPORT_API UM_ReserveReceiverIds(int channelId, int nOfIds)
+	{
+		UnityMessager::GetInstance(channelId).ReserveReceiverIds(nOfIds);
 	}
 
 	//Check comments for UnityMessager::OnStartMessageDelivering
-	void EXPORT_API UM_OnStartMessageDelivering()
+	void EXPORT_API UM_OnStartMessageDelivering(int channelId)
+	{
+		UnityMessager::GetInstance(channelId).OnStartMessageDelivering();
+	}
+
+	//Check comments for UnityMessager::OnFinishMessageDelivering
+	void EXPORT_API UM_OnFinishMessageDelivering(int channelId)
 	{
-		UnityMessager::GetInstance().OnStartMessageDelivering();
+		UnityMessager::GetInstance(channelId).OnFinishMessageDelivering();
+	}
+
+	//Check comments for UnityMessager::HasStagedMessages, returns 1 for true and 0 for false
+	int EXPORT_API UM_HasStagedMessages(int channelId)
+	{
+		return UnityMessager::GetInstance(channelId).HasStagedMessages() ? 1 : 0;
 	}
 
 	//Check comments for UnityMessager::ReleasePossibleQueueArrays
-	void EXPORT_API UM_ReleasePossibleQueueArrays()
+	void EXPORT_API UM_ReleasePossibleQueueArrays(int channelId)
+	{
+		UnityMessager::GetInstance(channelId).ReleasePossibleQueueArrays();
+	}
+
+	//Check comments for UnityMessager::StartCapture, returns 1 for true and 0 for false
+	int EXPORT_API UM_StartCapture(int channelId, const char* traceFilePath)
+	{
+		return UnityMessager::GetInstance(channelId).StartCapture(traceFilePath) ? 1 : 0;
+	}
+
+	//Check comments for UnityMessager::StopCapture
+	void EXPORT_API UM_StopCapture(int channelId)
+	{
+		UnityMessager::GetInstance(channelId).StopCapture();
+	}
+
+	//Check comments for UnityMessagerInbox::GetFirstArrayId, the inbox is created by the first call (check UnityMessager::GetInbox)
+	int EXPORT_API UM_GetInboxFirstArrayId(int channelId)
+	{
+		return UnityMessager::GetInstance(channelId).GetInbox().GetFirstArrayId();
+	}
+
+	//Check comments for UnityMessagerInbox::AdvanceToNextArray
+	int EXPORT_API UM_AdvanceInboxToNextArray(int channelId, int minLengthInBytes)
+	{
+		return UnityMessager::GetInstance(channelId).GetInbox().AdvanceToNextArray(minLengthInBytes);
+	}
+
+	//Check comments for UnityMessagerRing::GetArrayId, the ring is created by the first call if the C++ side hasn't done it yet
+	int EXPORT_API UM_GetRingArrayId(int channelId)
 	{
-		UnityMessager::GetInstance().ReleasePossibleQueueArrays();
+		return UnityMessager::GetInstance(channelId).GetRing().GetArrayId();
 	}
 
 	//Check comments for UnityMessager::DeleteInstance
-	void EXPORT_API UM_OnDestroy()
+	void EXPORT_API UM_OnDestroy(int channelId)
 	{
-		UnityMessager::GetInstance().DeleteInstance();
+		UnityMessager::DeleteInstance(channelId);
 	}
 }
\ No newline at end of file
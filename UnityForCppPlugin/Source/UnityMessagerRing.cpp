@@ -0,0 +1,105 @@
+//Copyright (c) 2016, Samuel Pollachini (Samuel Polacchini)
+//The UnityForCpp project is licensed under the terms of the MIT license
+
+#include "UnityMessagerRing.h"
+#include "UnityMessagerWire.h"
+
+namespace UnityForCpp
+{
+
+UnityMessagerRing::UnityMessagerRing(int capacityInBytes)
+	: m_array(), m_pData(NULL), m_capacityInBytes(UMR_MIN_CAPACITY_IN_BYTES), m_head(0), m_cachedTail(0)
+{
+	while (m_capacityInBytes < capacityInBytes && m_capacityInBytes < (1 << 30))
+		m_capacityInBytes <<= 1;
+
+	m_array.Alloc(UMR_DATA_START_IDX + m_capacityInBytes / (int)sizeof(int64));
+	m_array[UMR_HEAD_IDX] = 0;
+	m_array[UMR_TAIL_IDX] = 0;
+	m_pData = reinterpret_cast<uint8*>(m_array.GetPtr() + UMR_DATA_START_IDX);
+}
+
+int UnityMessagerRing::GetUsedBytes() const
+{
+	int64* pHeader = const_cast<int64*>(m_array.GetPtr());
+	return (int)(m_head - AtomicAt(pHeader + UMR_TAIL_IDX).load(std::memory_order_acquire));
+}
+
+uint8* UnityMessagerRing::ReserveRecord(int64 recordLength)
+{
+	if (recordLength > m_capacityInBytes / 2)
+	{
+		//with half the capacity a record always fits an empty ring, even if it needs a padding record before
+		ERROR_LOGF("[UnityMessagerRing] Message of %d bytes is too long for a ring of %d bytes!", (int)recordLength, m_capacityInBytes);
+		return NULL;
+	}
+
+	int pos = (int)(m_head & (m_capacityInBytes - 1));
+	int paddingLength = pos + recordLength > m_capacityInBytes ? m_capacityInBytes - pos : 0;
+	int64 neededTail = m_head + paddingLength + recordLength - m_capacityInBytes;
+	if (m_cachedTail < neededTail)
+	{
+		//acquiring the tail makes sure the consumer has finished reading the bytes released by it
+		m_cachedTail = AtomicAt(m_array.GetPtr() + UMR_TAIL_IDX).load(std::memory_order_acquire);
+		if (m_cachedTail < neededTail)
+			return NULL;
+	}
+
+	if (paddingLength > 0)
+	{
+		//positions and lengths are multiples of UMR_RECORD_ALIGNMENT, so the padding record header always fits
+		WriteInt(m_pData + pos, 0, paddingLength);
+		WriteInt(m_pData + pos, 3 * sizeof(int), UMR_PADDING_RECORD);
+		m_head += paddingLength;
+		pos = 0;
+	}
+
+	return m_pData + pos;
+}
+
+void UnityMessagerRing::PublishRecord(int recordLength)
+{
+	m_head += recordLength;
+	AtomicAt(m_array.GetPtr() + UMR_HEAD_IDX).store(m_head, std::memory_order_release);
+}
+
+int64 UnityMessagerRing::GetParamEndPos(int64 pos, const char* stringParam)
+{
+	return GetItemsEndPos(pos, 1, (int)strlen(stringParam));
+}
+
+int64 UnityMessagerRing::GetParamEndPos(int64 pos, const UnityMessager::InternedString& stringParam)
+{
+	return GetItemsEndPos(pos, 1, stringParam.GetLength());
+}
+
+int64 UnityMessagerRing::GetItemsEndPos(int64 pos, int itemSize, int length)
+{
+	pos = AlignPos(pos + UMR_PARAM_HEADER_SIZE, GetItemAlignment(itemSize));
+	return pos + (int64)itemSize * (length >= 0 ? length : 1);
+}
+
+int UnityMessagerRing::WriteParam(uint8* pRecord, int pos, const char* stringParam)
+{
+	return WriteItems(pRecord, pos, 1, (int)strlen(stringParam), stringParam);
+}
+
+int UnityMessagerRing::WriteParam(uint8* pRecord, int pos, const UnityMessager::InternedString& stringParam)
+{
+	return WriteItems(pRecord, pos, 1, stringParam.GetLength(), stringParam.GetString());
+}
+
+int UnityMessagerRing::WriteItems(uint8* pRecord, int pos, int itemSize, int length, const void* pItems)
+{
+	WriteInt(pRecord, pos, itemSize);
+	WriteInt(pRecord, pos + sizeof(int), length);
+	pos = AlignPos(pos + UMR_PARAM_HEADER_SIZE, GetItemAlignment(itemSize));
+
+	int sizeInBytes = itemSize * (length >= 0 ? length : 1);
+	if (sizeInBytes > 0)
+		memcpy(pRecord + pos, pItems, sizeInBytes);
+
+	return pos + sizeInBytes;
+}
+
+}; //UnityForCpp
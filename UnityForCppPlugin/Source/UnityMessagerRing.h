@@ -0,0 +1,154 @@
+//Copyright (c) 2016, Samuel Pollachini (Samuel Polacchini)
+//The UnityForCpp project is licensed under the terms of the MIT license
+
+#ifndef UNITY_MESSAGER_RING_H
+#define UNITY_MESSAGER_RING_H
+
+#include "Shared.h"
+#include "UnityArray.h"
+#include "UnityMessager.h"
+#include <string.h>
+
+//Layout of the ring array, an UnityArray<int64> which MUST BE KEPT IN SYNCH with the UnityMessager.RingReader constants on C#.
+//
+//Array header: head and tail, int64 counts of bytes written by the producer and read by the consumer since the ring creation,
+//each one on its own cache line. The ring bytes start at UMR_DATA_START_IDX, a byte position is the count masked by the capacity.
+#define UMR_HEAD_IDX 0
+#define UMR_TAIL_IDX 8
+#define UMR_DATA_START_IDX 16
+//Message record header: (int recordLength, int receiverId, int msgId, int nOfParams), little endian ints as the inbox ones.
+//Records never wrap, their length (header and parameters) is padded to UMR_RECORD_ALIGNMENT, so when a record doesn't fit
+//before the end of the ring a padding record (nOfParams set to UMR_PADDING_RECORD) takes the remaining bytes instead.
+#define UMR_RECORD_HEADER_SIZE 16
+#define UMR_RECORD_ALIGNMENT 16
+#define UMR_PADDING_RECORD -1
+//Parameter header: (int itemSize, int length), length is -1 for single parameters. The parameter items follow it, aligned to
+//their alignment (check GetItemAlignment at UnityMessagerWire.h, the same of the inbox) relative to the start of the record.
+#define UMR_PARAM_HEADER_SIZE 8
+
+//Capacity of the rings created by UnityMessager::GetRing when none is given, it is rounded up to a power of two
+#define UMR_DEFAULT_CAPACITY_IN_BYTES (1 << 20)
+#define UMR_MIN_CAPACITY_IN_BYTES 4096
+
+namespace UnityForCpp
+{
+
+//Alternative transport for messages to C#, a single-producer/single-consumer ring of bytes on a shared array, so a C++ thread
+//(your simulation thread, for instance) writes messages while a C# thread (a job or any worker thread) reads them at the same
+//time, by UnityMessager.RingReader, instead of all of them being delivered by the DeliverMessages burst on the main thread.
+//The producer and the consumer only synchronize through the head and the tail positions on the array header, so neither
+//side locks or calls the other one. There is a ring per channel, check UnityMessager::GetRing.
+//
+//Since the consumer is not on the main thread, ring messages are read by a C# handler you provide instead of being dispatched
+//to receiver objects, the receiver id and the message id are just values for your handler to route them. Parameters are sent
+//as plain items, only their size is checked when reading them on C#, so send them as you read them there.
+//
+//TryWriteMessage may be called from ANY thread, but ONLY FROM ONE THREAD AT A TIME, the same for the C# side reading them.
+//Stop the C# consumer before destroying the UnityMessager, since the ring array is released together with it.
+//
+class UnityMessagerRing
+{
+public:
+	//Writes a message to the ring, returning false without writing anything when the ring has no room for it (the consumer
+	//is behind), so you decide between trying again later, dropping it or sending it by UnityMessager::SendMessage instead.
+	//Parameters may be of any type supported by UnityArray (check UA_SUPPORTED_TYPE), arrays passed by UM_ARRAY_PARAM and C
+	//strings (also InternedString instances, sent as regular strings). Messages longer than half the capacity never fit.
+	template<typename... PARAMS> bool TryWriteMessage(int receiverId, int msgId, const PARAMS&... params);
+
+	//Bytes written and not read yet, only a snapshot since the consumer reads concurrently. Call it from the producer thread.
+	int GetUsedBytes() const;
+
+	int GetCapacityInBytes() const { return m_capacityInBytes; }
+
+	//Id of the ring array, which is how the C# side gets the ring (check UM_GetRingArrayId)
+	int GetArrayId() const { return m_array.GetId(); }
+
+private:
+	friend class UnityMessager;
+
+	//Only created by UnityMessager::GetRing
+	UnityMessagerRing(int capacityInBytes);
+
+	//Returns where a record of recordLength bytes MUST be written, or NULL if the ring has no room for it. When it doesn't fit
+	//before the end of the ring a padding record is written first, which is published together with the record.
+	uint8* ReserveRecord(int64 recordLength);
+
+	//Makes the record written at the space given by ReserveRecord visible to the consumer
+	void PublishRecord(int recordLength);
+
+	//Returns the end position of the parameters starting at pos, relative to the start of the record
+	static int64 GetParamsEndPos(int64 pos) { return pos; }
+	template<typename PARAM1, typename... OTHER_PARAMS>
+	static int64 GetParamsEndPos(int64 pos, const PARAM1& param1, const OTHER_PARAMS&... otherParams);
+
+	template<typename T> static int64 GetParamEndPos(int64 pos, const T& param) { return GetItemsEndPos(pos, sizeof(T), -1); }
+	template<typename T> static int64 GetParamEndPos(int64 pos, const UnityMessager::ArrayParam<T>& arrayParam);
+	static int64 GetParamEndPos(int64 pos, const char* stringParam);
+	static int64 GetParamEndPos(int64 pos, const UnityMessager::InternedString& stringParam);
+	static int64 GetItemsEndPos(int64 pos, int itemSize, int length);
+
+	//Writes the parameters to the record starting at pos, the record MUST have the length given by GetParamsEndPos
+	static void WriteParams(uint8* pRecord, int pos) {}
+	template<typename PARAM1, typename... OTHER_PARAMS>
+	static void WriteParams(uint8* pRecord, int pos, const PARAM1& param1, const OTHER_PARAMS&... otherParams);
+
+	template<typename T> static int WriteParam(uint8* pRecord, int pos, const T& param) { return WriteItems(pRecord, pos, sizeof(T), -1, &param); }
+	template<typename T> static int WriteParam(uint8* pRecord, int pos, const UnityMessager::ArrayParam<T>& arrayParam);
+	static int WriteParam(uint8* pRecord, int pos, const char* stringParam);
+	static int WriteParam(uint8* pRecord, int pos, const UnityMessager::InternedString& stringParam);
+	static int WriteItems(uint8* pRecord, int pos, int itemSize, int length, const void* pItems);
+
+	static void WriteInt(uint8* pRecord, int pos, int value) { memcpy(pRecord + pos, &value, sizeof(int)); }
+
+	UnityArray<int64> m_array;
+	uint8* m_pData; //start of the ring bytes on m_array
+	int m_capacityInBytes; //power of two
+	int64 m_head; //producer copy of the head, being published to the array by PublishRecord
+	int64 m_cachedTail; //last tail read from the array, it is only read again when the ring looks full
+};
+
+template<typename... PARAMS>
+inline bool UnityMessagerRing::TryWriteMessage(int receiverId, int msgId, const PARAMS&... params)
+{
+	int64 recordLength = GetParamsEndPos(UMR_RECORD_HEADER_SIZE, params...);
+	recordLength = (recordLength + UMR_RECORD_ALIGNMENT - 1) & ~(int64)(UMR_RECORD_ALIGNMENT - 1);
+	uint8* pRecord = ReserveRecord(recordLength);
+	if (pRecord == NULL)
+		return false;
+
+	WriteInt(pRecord, 0, (int)recordLength);
+	WriteInt(pRecord, sizeof(int), receiverId);
+	WriteInt(pRecord, 2 * sizeof(int), msgId);
+	WriteInt(pRecord, 3 * sizeof(int), (int)sizeof...(PARAMS));
+	WriteParams(pRecord, UMR_RECORD_HEADER_SIZE, params...);
+	PublishRecord((int)recordLength);
+	return true;
+}
+
+template<typename PARAM1, typename... OTHER_PARAMS>
+inline int64 UnityMessagerRing::GetParamsEndPos(int64 pos, const PARAM1& param1, const OTHER_PARAMS&... otherParams)
+{
+	return GetParamsEndPos(GetParamEndPos(pos, param1), otherParams...);
+}
+
+template<typename T>
+inline int64 UnityMessagerRing::GetParamEndPos(int64 pos, const UnityMessager::ArrayParam<T>& arrayParam)
+{
+	return GetItemsEndPos(pos, sizeof(T), arrayParam.length);
+}
+
+template<typename PARAM1, typename... OTHER_PARAMS>
+inline void UnityMessagerRing::WriteParams(uint8* pRecord, int pos, const PARAM1& param1, const OTHER_PARAMS&... otherParams)
+{
+	WriteParams(pRecord, WriteParam(pRecord, pos, param1), otherParams...);
+}
+
+template<typename T>
+inline int UnityMessagerRing::WriteParam(uint8* pRecord, int pos, const UnityMessager::ArrayParam<T>& arrayParam)
+{
+	return WriteItems(pRecord, pos, sizeof(T), arrayParam.length, arrayParam.pArray);
+}
+
+}; //UnityForCpp
+
+#endif
@@ -0,0 +1,204 @@
+//Copyright (c) 2016, Samuel Pollachini (Samuel Polacchini)
+//The UnityForCpp project is licensed under the terms of the MIT license
+
+#include "UnityMessagerTrace.h"
+#include <string.h>
+
+namespace UnityForCpp
+{
+
+namespace UnityMessagerTrace
+{
+
+Writer::Writer()
+	: m_pFile(NULL), m_frameBuffer(), m_frameIdx(0), m_nOfTypes(0), m_nOfArrays(0)
+{
+}
+
+Writer::~Writer()
+{
+	Close();
+}
+
+bool Writer::Open(const char* filePath, int initFlags, int maxQueueArraysSizeInBytes)
+{
+	Close();
+	m_pFile = fopen(filePath, "wb");
+	if (m_pFile == NULL)
+		return false;
+
+	m_frameIdx = 0;
+	int header[] = { UM_TRACE_MAGIC, UM_TRACE_VERSION, initFlags, maxQueueArraysSizeInBytes };
+	fwrite(header, sizeof(header), 1, m_pFile);
+	return true;
+}
+
+void Writer::Close()
+{
+	if (m_pFile == NULL)
+		return;
+
+	fclose(m_pFile);
+	m_pFile = NULL;
+}
+
+void Writer::BeginFrame()
+{
+	m_frameBuffer.clear();
+	m_nOfTypes = 0;
+	m_nOfArrays = 0;
+}
+
+void Writer::AddType(int typeId, int itemSize, int alignment, const char* name)
+{
+	int nameLength = (int)strlen(name);
+	AppendInt(typeId);
+	AppendInt(itemSize);
+	AppendInt(alignment);
+	AppendInt(nameLength);
+	AppendPadded(name, nameLength);
+	++m_nOfTypes;
+}
+
+void Writer::AddArray(int arrayId, int queueId, const void* pData, int lengthInBytes)
+{
+	AppendInt(arrayId);
+	AppendInt(queueId);
+	AppendInt(lengthInBytes);
+	AppendPadded(pData, lengthInBytes);
+	++m_nOfArrays;
+}
+
+void Writer::EndFrame()
+{
+	ASSERT(m_pFile);
+	int frameHeader[] = { UM_TRACE_FRAME_MAGIC, m_frameIdx++, m_nOfTypes, m_nOfArrays };
+	fwrite(frameHeader, sizeof(frameHeader), 1, m_pFile);
+	if (!m_frameBuffer.empty())
+		fwrite(&m_frameBuffer[0], m_frameBuffer.size(), 1, m_pFile);
+}
+
+void Writer::AppendInt(int value)
+{
+	AppendPadded(&value, sizeof(int));
+}
+
+void Writer::AppendPadded(const void* pData, int length)
+{
+	size_t pos = m_frameBuffer.size();
+	m_frameBuffer.resize(pos + ((length + 3) & ~3), 0);
+	if (length > 0)
+		memcpy(&m_frameBuffer[pos], pData, length);
+}
+
+Reader::Reader()
+	: m_data(), m_pos(0), m_firstFramePos(0), m_initFlags(0), m_maxQueueArraysSizeInBytes(0), m_frameIdx(-1),
+	m_arrays(), m_arrayIdxs(), m_types()
+{
+}
+
+bool Reader::Open(const char* filePath)
+{
+	FILE* pFile = fopen(filePath, "rb");
+	if (pFile == NULL)
+		return false;
+
+	fseek(pFile, 0, SEEK_END);
+	long fileLength = ftell(pFile);
+	fseek(pFile, 0, SEEK_SET);
+
+	m_data.resize(fileLength > 0 ? (size_t)fileLength : 0);
+	bool hasRead = fileLength > 0 && fread(&m_data[0], m_data.size(), 1, pFile) == 1;
+	fclose(pFile);
+
+	m_pos = 0;
+	int magic, version;
+	if (!hasRead || !ReadInt(magic) || !ReadInt(version) || !ReadInt(m_initFlags) || !ReadInt(m_maxQueueArraysSizeInBytes)
+		|| magic != UM_TRACE_MAGIC || version != UM_TRACE_VERSION)
+	{
+		m_data.clear();
+		return false;
+	}
+
+	m_firstFramePos = m_pos;
+	Rewind();
+	return true;
+}
+
+void Reader::Rewind()
+{
+	m_pos = m_firstFramePos;
+	m_frameIdx = -1;
+	m_arrays.clear();
+	m_arrayIdxs.clear();
+	m_types.clear();
+}
+
+bool Reader::ReadNextFrame()
+{
+	m_arrays.clear();
+	m_arrayIdxs.clear();
+
+	int magic, nOfTypes, nOfArrays;
+	if (!ReadInt(magic) || magic != UM_TRACE_FRAME_MAGIC || !ReadInt(m_frameIdx) || !ReadInt(nOfTypes) || !ReadInt(nOfArrays))
+		return false;
+
+	for (int i = 0; i < nOfTypes; ++i)
+	{
+		int typeId, nameLength;
+		Type type;
+		if (!ReadInt(typeId) || !ReadInt(type.itemSize) || !ReadInt(type.alignment) || !ReadInt(nameLength)
+			|| nameLength < 0 || m_pos + nameLength > (int)m_data.size())
+			return false;
+
+		type.name.assign(reinterpret_cast<const char*>(&m_data[m_pos]), nameLength);
+		m_pos += (nameLength + 3) & ~3;
+		m_types[typeId] = type;
+	}
+
+	for (int i = 0; i < nOfArrays; ++i)
+	{
+		Array array;
+		if (!ReadInt(array.arrayId) || !ReadInt(array.queueId) || !ReadInt(array.lengthInBytes)
+			|| array.lengthInBytes < 0 || m_pos + array.lengthInBytes > (int)m_data.size())
+			return false;
+
+		array.pData = array.lengthInBytes > 0 ? &m_data[m_pos] : NULL;
+		m_pos += (array.lengthInBytes + 3) & ~3;
+		m_arrayIdxs[array.arrayId] = (int)m_arrays.size();
+		m_arrays.push_back(array);
+	}
+
+	return true;
+}
+
+const Reader::Array* Reader::FindArray(int arrayId) const
+{
+	std::unordered_map<int, int>::const_iterator it = m_arrayIdxs.find(arrayId);
+	return it != m_arrayIdxs.end() ? &m_arrays[it->second] : NULL;
+}
+
+int Reader::GetFirstArrayId(int queueId) const
+{
+	for (size_t i = 0; i < m_arrays.size(); ++i)
+	{
+		if (m_arrays[i].queueId == queueId)
+			return m_arrays[i].arrayId;
+	}
+
+	return -1;
+}
+
+bool Reader::ReadInt(int& value)
+{
+	if (m_pos + (int)sizeof(int) > (int)m_data.size())
+		return false;
+
+	memcpy(&value, &m_data[m_pos], sizeof(int));
+	m_pos += sizeof(int);
+	return true;
+}
+
+}
+
+}; //UnityForCpp
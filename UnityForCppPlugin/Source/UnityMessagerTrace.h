@@ -0,0 +1,125 @@
+//Copyright (c) 2016, Samuel Pollachini (Samuel Polacchini)
+//The UnityForCpp project is licensed under the terms of the MIT license
+
+#ifndef UNITY_MESSAGER_TRACE_H
+#define UNITY_MESSAGER_TRACE_H
+
+#include "Shared.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//Binary trace of the UnityMessager message stream, written when capturing (check UnityMessager::StartCapture). At each delivering
+//the content the C# side is about to read is dumped as a frame: the used part of the arrays of each message queue (the control
+//queue included, so the control messages are there too) and the spill arrays in use. The UnityArrays referenced by UnityArrayParam
+//parameters are not dumped, only their ids and lengths are known from the control queue. All the values are little endian
+//int32 values, except for the array bytes and the name chars:
+//
+//- File header:  [UM_TRACE_MAGIC] [UM_TRACE_VERSION] [initFlags] [maxQueueArraysSizeInBytes]
+//- Frame:        [UM_TRACE_FRAME_MAGIC] [frameIdx] [nOfTypes] [nOfArrays] [type]... [array]...
+//- Type:         [typeId] [itemSize] [alignment] [nameLength] [name chars, padded to 4 bytes]
+//                the parameter types registered since the previous frame (all the types on the first frame). Type ids are the
+//                queue ids, or the payload type ids when the parameters are interleaved (check UM_INIT_FLAG_INTERLEAVED_PARAMS).
+//- Array:        [arrayId] [queueId] [lengthInBytes] [bytes, padded to 4 bytes]
+//                the arrays of each queue come in their reading order, starting by the first array of the queue for the frame.
+//                Spill arrays have -1 as queueId.
+//
+//Use UnityMessagerDecoder for reading the messages of a frame, Tools/UnityMessagerTraceTool.cpp does that for replaying and
+//analyzing traces.
+
+#define UM_TRACE_MAGIC 0x52544D55 //"UMTR"
+#define UM_TRACE_FRAME_MAGIC 0x46544D55 //"UMTF"
+#define UM_TRACE_VERSION 1
+
+namespace UnityForCpp
+{
+
+namespace UnityMessagerTrace
+{
+	//Writes a trace file, buffering each frame until it is complete so a frame is written by a single file write
+	class Writer
+	{
+	public:
+		Writer();
+		~Writer();
+
+		//Creates (or overwrites) the trace file writing its header, returns false if the file cannot be created
+		bool Open(const char* filePath, int initFlags, int maxQueueArraysSizeInBytes);
+		void Close();
+		bool IsOpen() const { return m_pFile != NULL; }
+
+		//A frame is made by the AddType and AddArray calls between BeginFrame and EndFrame, which writes it to the file
+		void BeginFrame();
+		void AddType(int typeId, int itemSize, int alignment, const char* name);
+		void AddArray(int arrayId, int queueId, const void* pData, int lengthInBytes);
+		void EndFrame();
+
+	private:
+		void AppendInt(int value);
+		void AppendPadded(const void* pData, int length);
+
+		FILE* m_pFile;
+		std::vector<uint8> m_frameBuffer;
+		int m_frameIdx;
+		int m_nOfTypes;
+		int m_nOfArrays;
+	};
+
+	//Reads a trace file, which is loaded to memory at once so the frames can be replayed any number of times (check Rewind)
+	class Reader
+	{
+	public:
+		struct Type
+		{
+			int itemSize;
+			int alignment;
+			std::string name;
+		};
+
+		struct Array
+		{
+			int arrayId;
+			int queueId; //-1 for spill arrays
+			const uint8* pData;
+			int lengthInBytes;
+		};
+
+		Reader();
+
+		//Loads the trace file, returns false if it cannot be read or is not a trace file
+		bool Open(const char* filePath);
+
+		int GetInitFlags() const { return m_initFlags; }
+		int GetMaxQueueArraysSizeInBytes() const { return m_maxQueueArraysSizeInBytes; }
+
+		//Reads the next frame, returning false at the end of the trace (or if it is truncated). The arrays are valid until
+		//the trace is closed, the types are the ones of all the frames read since the last Rewind.
+		bool ReadNextFrame();
+		void Rewind();
+
+		int GetFrameIdx() const { return m_frameIdx; }
+		const std::vector<Array>& GetArrays() const { return m_arrays; }
+		const Array* FindArray(int arrayId) const;
+		const std::unordered_map<int, Type>& GetTypes() const { return m_types; }
+
+		//Id of the first array of the queue on the current frame, -1 if the queue has no arrays on it
+		int GetFirstArrayId(int queueId) const;
+
+	private:
+		bool ReadInt(int& value);
+
+		std::vector<uint8> m_data;
+		int m_pos; //next byte to read from m_data
+		int m_firstFramePos;
+		int m_initFlags;
+		int m_maxQueueArraysSizeInBytes;
+		int m_frameIdx;
+		std::vector<Array> m_arrays;
+		std::unordered_map<int, int> m_arrayIdxs; //indexes of m_arrays by array id
+		std::unordered_map<int, Type> m_types;
+	};
+}
+
+}; //UnityForCpp
+
+#endif
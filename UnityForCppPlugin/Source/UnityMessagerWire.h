@@ -0,0 +1,43 @@
+//Copyright (c) 2016, Samuel Pollachini (Samuel Polacchini)
+//The UnityForCpp project is licensed under the terms of the MIT license
+
+#ifndef UNITY_MESSAGER_WIRE_H
+#define UNITY_MESSAGER_WIRE_H
+
+#include "Shared.h"
+#include <atomic>
+
+//INTERNAL HEADER, included only by the UnityMessager sources. Helpers for the memory layouts shared with the C# side, the
+//receiver ids table, the inbox arrays and the rings, kept in a single place so these layouts can't drift from each other.
+
+//Max alignment of the parameter items on the inbox arrays and on the rings, the same one used by the C# side
+#define UM_MAX_ITEM_ALIGNMENT 8
+
+namespace UnityForCpp
+{
+
+//Values on the shared arrays accessed by both sides at the same time are accessed as atomics on the array memory, done by
+//the Interlocked class on the same memory at the C# side
+inline std::atomic<int>& AtomicAt(int* pValue) { return *reinterpret_cast<std::atomic<int>*>(pValue); }
+inline std::atomic<int64>& AtomicAt(int64* pValue) { return *reinterpret_cast<std::atomic<int64>*>(pValue); }
+
+static_assert(sizeof(std::atomic<int>) == sizeof(int) && sizeof(std::atomic<int64>) == sizeof(int64),
+			  "The shared arrays REQUIRE atomics with the same layout of the values");
+
+//Alignment of the parameter items: the biggest power of two dividing the item size, up to UM_MAX_ITEM_ALIGNMENT
+inline int GetItemAlignment(int itemSize)
+{
+	int alignment = itemSize & -itemSize;
+	return alignment < UM_MAX_ITEM_ALIGNMENT ? alignment : UM_MAX_ITEM_ALIGNMENT;
+}
+
+//alignment MUST be a power of two
+template <typename T>
+inline T AlignPos(T pos, int alignment)
+{
+	return (pos + alignment - 1) & ~(T)(alignment - 1);
+}
+
+}; //UnityForCpp
+
+#endif
@@ -0,0 +1,215 @@
+//Copyright (c) 2016, Samuel Pollachini (Samuel Polacchini)
+//The UnityForCpp project is licensed under the terms of the MIT license
+
+//Standalone benchmark comparing the int and the compact (UM_INIT_FLAG_COMPACT_CONTROL_QUEUE) UnityMessager control queue
+//formats for a synthetic message stream. It reports the bytes per message and the encoding throughput of each format, also
+//checking the compact stream with UnityMessagerCompact::ReferenceDecoder. It does not link the plugin, build it with:
+//
+//   g++ -std=c++11 -O2 -o ControlQueueEncodingBenchmark ControlQueueEncodingBenchmark.cpp
+
+#include "../Source/Shared.h"
+#include "../Source/UnityMessagerCompact.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <chrono>
+
+using namespace UnityForCpp;
+using namespace UnityForCpp::UnityMessagerCompact;
+
+//Shared.cpp outputs through the UnityAdapter, here we just print to the console
+namespace Shared
+{
+char n_outputStrBuffer[OUTPUT_MESSAGE_MAX_STRING_SIZE] = { 0 };
+
+void OutputDebugStr(const char* str) { printf("%s\n", str); }
+void OutputWarningStr(const char* str) { printf("WARNING: %s\n", str); }
+void OutputErrorStr(const char* str) { printf("ERROR: %s\n", str); }
+}
+
+#define N_OF_MESSAGES 200000
+#define N_OF_ITERATIONS 20
+
+struct SyntheticParam
+{
+	int queueId;
+	int arrayLength; //-1 for single parameters
+};
+
+struct SyntheticMessage
+{
+	int receiverId;
+	int msgId;
+	int componentId; //-1 for messages not addressed to a component, smaller for routing bindings
+	int nOfParams;
+	SyntheticParam params[4];
+};
+
+//Typical game traffic: runs of messages to a same receiver, small message ids, few parameters and some arrays
+static void GenerateMessages(std::vector<SyntheticMessage>& messages)
+{
+	srand(12345);
+	messages.resize(N_OF_MESSAGES);
+
+	int receiverId = 1;
+	for (int i = 0; i < N_OF_MESSAGES; ++i)
+	{
+		if (rand() % 4 == 0)
+			receiverId = 1 + rand() % 500;
+
+		SyntheticMessage& message = messages[i];
+		message.receiverId = (rand() % 10 == 0) ? -(1 + rand() % 50) : receiverId; //negative ids are the names
+		message.msgId = rand() % 16;
+		int componentRoll = rand() % 16;
+		message.componentId = componentRoll < 2 ? rand() % 32 : (componentRoll == 2 ? -2 - rand() % 64 : -1);
+		message.nOfParams = rand() % 5;
+		for (int p = 0; p < message.nOfParams; ++p)
+		{
+			message.params[p].queueId = 1 + rand() % 10;
+			message.params[p].arrayLength = (rand() % 6 == 0) ? 1 + rand() % 300 : -1;
+		}
+	}
+}
+
+//Mirrors UnityMessager::ControlQueue for the int format, returning the number of ints written
+static int EncodeInt(const std::vector<SyntheticMessage>& messages, int* pDest)
+{
+	int* pStart = pDest;
+	for (size_t i = 0; i < messages.size(); ++i)
+	{
+		const SyntheticMessage& message = messages[i];
+		*(pDest++) = message.receiverId;
+		*(pDest++) = message.msgId;
+		if (message.componentId != -1)
+		{
+			*(pDest++) = -(message.nOfParams + 1);
+			*(pDest++) = message.componentId;
+		}
+		else
+			*(pDest++) = message.nOfParams;
+
+		for (int p = 0; p < message.nOfParams; ++p)
+		{
+			const SyntheticParam& param = message.params[p];
+			if (param.arrayLength >= 0)
+			{
+				*(pDest++) = -param.queueId;
+				*(pDest++) = param.arrayLength;
+			}
+			else
+				*(pDest++) = param.queueId;
+		}
+	}
+
+	return (int)(pDest - pStart);
+}
+
+//Mirrors UnityMessager::ControlQueue for the compact format, returning the number of bytes written
+static int EncodeCompact(const std::vector<SyntheticMessage>& messages, uint8* pDest)
+{
+	uint8* pStart = pDest;
+	bool hasLastReceiverId = false;
+	int lastReceiverId = 0;
+	for (size_t i = 0; i < messages.size(); ++i)
+	{
+		const SyntheticMessage& message = messages[i];
+		uint8* pTag = pDest++;
+		*pTag = UM_COMPACT_TAG_MESSAGE;
+		if (hasLastReceiverId && lastReceiverId == message.receiverId)
+			*pTag |= UM_COMPACT_TAG_SAME_RECEIVER;
+		else
+			pDest = WriteZigZag(pDest, message.receiverId);
+
+		pDest = WriteZigZag(pDest, message.msgId);
+		if (message.componentId != -1)
+		{
+			*pTag |= UM_COMPACT_TAG_COMPONENT;
+			pDest = WriteZigZag(pDest, message.componentId);
+		}
+
+		*(pDest++) = (uint8)message.nOfParams;
+		hasLastReceiverId = true;
+		lastReceiverId = message.receiverId;
+
+		for (int p = 0; p < message.nOfParams; ++p)
+		{
+			const SyntheticParam& param = message.params[p];
+			pDest = WriteVarint(pDest, ((uint32)param.queueId << 1) | (param.arrayLength >= 0 ? 1 : 0));
+			if (param.arrayLength >= 0)
+				pDest = WriteVarint(pDest, (uint32)param.arrayLength);
+		}
+	}
+
+	return (int)(pDest - pStart);
+}
+
+static bool CheckCompactRoundTrip(const std::vector<SyntheticMessage>& messages, const uint8* pStream, int length)
+{
+	ReferenceDecoder decoder(pStream, length);
+	ReferenceDecoder::Record record;
+	for (size_t i = 0; i < messages.size(); ++i)
+	{
+		const SyntheticMessage& message = messages[i];
+		if (!decoder.ReadNext(record) || record.type != ReferenceDecoder::RT_MESSAGE
+			|| record.receiverId != message.receiverId || record.msgId != message.msgId
+			|| record.componentId != message.componentId || record.nOfParams != message.nOfParams || record.isDiscarded)
+		{
+			printf("Compact round trip failed at message %d\n", (int)i);
+			return false;
+		}
+
+		for (int p = 0; p < message.nOfParams; ++p)
+		{
+			if (!decoder.ReadNext(record) || record.type != ReferenceDecoder::RT_PARAM
+				|| record.queueId != message.params[p].queueId || record.arrayLength != message.params[p].arrayLength)
+			{
+				printf("Compact round trip failed at param %d of message %d\n", p, (int)i);
+				return false;
+			}
+		}
+	}
+
+	return !decoder.ReadNext(record);
+}
+
+template<typename ENCODE_FC>
+static double MeasureMessagesPerSecond(ENCODE_FC encodeFc)
+{
+	int checkSum = 0;
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < N_OF_ITERATIONS; ++i)
+		checkSum += encodeFc();
+
+	std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+	if (checkSum == 0)
+		printf("Nothing was encoded\n");
+
+	return ((double)N_OF_MESSAGES * N_OF_ITERATIONS) / elapsed.count();
+}
+
+int main()
+{
+	std::vector<SyntheticMessage> messages;
+	GenerateMessages(messages);
+
+	//worst case for both formats: component messages with 4 array parameters
+	std::vector<int> intStream(N_OF_MESSAGES * 12);
+	std::vector<uint8> compactStream(N_OF_MESSAGES * (UM_COMPACT_MAX_MESSAGE_LENGTH + 4 * UM_COMPACT_MAX_PARAM_LENGTH));
+
+	int intLength = EncodeInt(messages, &intStream[0]) * (int)sizeof(int);
+	int compactLength = EncodeCompact(messages, &compactStream[0]);
+	if (!CheckCompactRoundTrip(messages, &compactStream[0], compactLength))
+		return 1;
+
+	double intRate = MeasureMessagesPerSecond([&]() { return EncodeInt(messages, &intStream[0]); });
+	double compactRate = MeasureMessagesPerSecond([&]() { return EncodeCompact(messages, &compactStream[0]); });
+
+	printf("%d messages, %d iterations\n", N_OF_MESSAGES, N_OF_ITERATIONS);
+	printf("int format:     %6.2f bytes/message, %8.2f M messages/s\n",
+		(double)intLength / N_OF_MESSAGES, intRate / 1000000.0);
+	printf("compact format: %6.2f bytes/message, %8.2f M messages/s\n",
+		(double)compactLength / N_OF_MESSAGES, compactRate / 1000000.0);
+	printf("compact round trip OK\n");
+	return 0;
+}
@@ -0,0 +1,309 @@
+//Copyright (c) 2016, Samuel Pollachini (Samuel Polacchini)
+//The UnityForCpp project is licensed under the terms of the MIT license
+
+#ifndef NATIVE_UNITY_ADAPTER_STUB_H
+#define NATIVE_UNITY_ADAPTER_STUB_H
+
+//Native replacement for the C# UnityAdapter, so standalone tools can link the plugin sources (UnityAdapter.cpp included) and
+//run them out of Unity. Install sets the UnityAdapter::Internals function pointers to the stub functions bellow, which keep
+//the shared arrays as calloc-backed memory (zeroed, as the C# arrays are) and read and save files from the working directory.
+//Asynchronous file reads are completed by CompleteFileReads, which tools call once per frame as the C# UnityAdapter Update.
+//The arrays are also available to native readers by their ids, so the stub provides the SharedArrays of an UnityMessagerDispatcher
+//playing the C# side of the UnityMessager. Include this header on a single source file of the tool.
+
+#include "../Source/Shared.h"
+#include "../Source/UnityAdapter.h"
+#include "../Source/UnityArray.h"
+#include "../Source/UnityMessager.h"
+#include "../Source/UnityMessagerDispatcher.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace NativeUnityAdapterStub
+{
+	using namespace UnityForCpp;
+
+	struct StubArray
+	{
+		void* pData;
+		int lengthInBytes;
+		const char* managedTypeName;
+	};
+
+	class Arrays : public UnityMessagerDispatcher::SharedArrays
+	{
+	public:
+		static Arrays& GetInstance() { static Arrays c_instance; return c_instance; }
+
+		//Item size for the arrays of a .NET type, the UA_SUPPORTED_TYPE ones are set by Install, custom struct types
+		//(check the UA_SUPPORTED_TYPE comments) MUST BE SET before requesting arrays of them
+		template <typename T> void SetTypeSize() { m_typeSizes[UnityArray<T>::s_managedTypeName] = sizeof(T); }
+
+		virtual int GetTypeSize(const char* managedTypeName)
+		{
+			std::unordered_map<std::string, int>::const_iterator it = m_typeSizes.find(managedTypeName);
+			return it != m_typeSizes.end() ? it->second : 0;
+		}
+
+		int New(const char* managedTypeName, int length)
+		{
+			ASSERT(GetTypeSize(managedTypeName) > 0); //the type size was not set
+			int itemSize = GetTypeSize(managedTypeName) > 0 ? GetTypeSize(managedTypeName) : 16;
+			return Add(calloc(length > 0 ? length : 1, itemSize), length, managedTypeName);
+		}
+
+		//Takes ownership of the memory, which MUST BE malloc-allocated. The array is delivered to the UnityAdapter as the answer
+		//of the current request, unless isRequested is false (as for the asynchronous file reads, delivered with their requests)
+		int Add(void* pData, int length, const char* managedTypeName, bool isRequested = true)
+		{
+			std::unordered_map<std::string, int>::const_iterator it = m_typeSizes.find(managedTypeName);
+			ASSERT(it != m_typeSizes.end());
+			if (it == m_typeSizes.end()) //keeping a name that lives as long as the stub
+				it = m_typeSizes.insert(std::make_pair(std::string(managedTypeName), 16)).first;
+
+			StubArray array = { pData, length * it->second, it->first.c_str() };
+			m_arrays[++m_lastArrayId] = array;
+			m_liveBytes += array.lengthInBytes;
+			m_peakLiveBytes = m_liveBytes > m_peakLiveBytes ? m_liveBytes : m_peakLiveBytes;
+			++m_nOfAllocs;
+
+			if (isRequested)
+				UnityAdapter::Internals::DeliverRequestedManagedArray(m_lastArrayId, pData, length);
+
+			return m_lastArrayId;
+		}
+
+		void Release(int arrayId)
+		{
+			std::unordered_map<int, StubArray>::iterator it = m_arrays.find(arrayId);
+			ASSERT(it != m_arrays.end());
+			m_liveBytes -= it->second.lengthInBytes;
+			free(it->second.pData);
+			m_arrays.erase(it);
+		}
+
+		virtual const uint8* GetArray(int arrayId, int& lengthInBytes)
+		{
+			std::unordered_map<int, StubArray>::const_iterator it = m_arrays.find(arrayId);
+			lengthInBytes = it != m_arrays.end() ? it->second.lengthInBytes : 0;
+			return it != m_arrays.end() ? reinterpret_cast<const uint8*>(it->second.pData) : NULL;
+		}
+
+		virtual const char* GetManagedTypeName(int arrayId)
+		{
+			std::unordered_map<int, StubArray>::const_iterator it = m_arrays.find(arrayId);
+			return it != m_arrays.end() ? it->second.managedTypeName : NULL;
+		}
+
+		virtual uint8* GetArrayForWrite(int arrayId)
+		{
+			std::unordered_map<int, StubArray>::iterator it = m_arrays.find(arrayId);
+			return it != m_arrays.end() ? reinterpret_cast<uint8*>(it->second.pData) : NULL;
+		}
+
+		int GetNOfLiveArrays() const { return (int)m_arrays.size(); }
+		int64 GetLiveBytes() const { return m_liveBytes; }
+		int64 GetNOfAllocs() const { return m_nOfAllocs; }
+
+		//Peak of the live bytes since the last ResetPeak
+		int64 GetPeakLiveBytes() const { return m_peakLiveBytes; }
+		void ResetPeak() { m_peakLiveBytes = m_liveBytes; }
+
+	private:
+		Arrays() : m_typeSizes(), m_arrays(), m_lastArrayId(-1), m_liveBytes(0), m_peakLiveBytes(0), m_nOfAllocs(0) {}
+
+		std::unordered_map<std::string, int> m_typeSizes;
+		std::unordered_map<int, StubArray> m_arrays;
+		int m_lastArrayId;
+		int64 m_liveBytes;
+		int64 m_peakLiveBytes;
+		int64 m_nOfAllocs;
+	};
+
+	static void OutputDebugStr(int logType, const char* str)
+	{
+		static const char* const c_prefixes[] = { "", "WARNING: ", "ERROR: " };
+		fprintf(stderr, "%s%s\n", c_prefixes[logType >= 0 && logType <= 2 ? logType : 0], str);
+	}
+
+	//fseek with 64 bits offsets, since long is 32 bits on Windows (and on 32 bits targets not built with _FILE_OFFSET_BITS=64)
+	static int SeekFile(FILE* pFile, int64 offset, int origin)
+	{
+#ifdef WIN32
+		return _fseeki64(pFile, offset, origin);
+#else
+		return fseeko(pFile, (off_t)offset, origin);
+#endif
+	}
+
+	//Length of an open file, -1 on error, the position is left at the end of the file
+	static int64 GetFileLength(FILE* pFile)
+	{
+		if (SeekFile(pFile, 0, SEEK_END) != 0)
+			return -1;
+
+#ifdef WIN32
+		return _ftelli64(pFile);
+#else
+		return (int64)ftello(pFile);
+#endif
+	}
+
+	//Reads the whole file to a new shared array, returning its id, or -1 if the file was not found
+	static int ReadFileToNewArray(const char* fullFilePath, bool isRequested)
+	{
+		FILE* pFile = fopen(fullFilePath, "rb");
+		if (pFile == NULL)
+			return -1;
+
+		int64 length = GetFileLength(pFile);
+		SeekFile(pFile, 0, SEEK_SET);
+
+		//the arrays have int lengths, as the C# ones
+		if (length > 0x7FFFFFFF)
+			length = 0;
+
+		void* pData = calloc(length > 0 ? (size_t)length : 1, 1);
+		if (length > 0 && fread(pData, (size_t)length, 1, pFile) != 1)
+			length = 0;
+
+		fclose(pFile);
+		return Arrays::GetInstance().Add(pData, (int)length, UnityArray<uint8>::s_managedTypeName, isRequested);
+	}
+
+	static void RequestFileContent(const char* fullFilePath)
+	{
+		ReadFileToNewArray(fullFilePath, true); //nothing delivered if the file was not found
+	}
+
+	//Asynchronous read requested since the previous CompleteFileReads call
+	struct PendingFileRead
+	{
+		int requestId;
+		std::string fullFilePath;
+		bool isRangeRead; //the fields bellow are only set for the range reads
+		int64 fileOffset;
+		int length;
+		int destArrayId;
+		int destOffset;
+	};
+
+	static std::vector<PendingFileRead>& GetPendingFileReads()
+	{
+		static std::vector<PendingFileRead> c_pendingFileReads;
+		return c_pendingFileReads;
+	}
+
+	static void RequestFileContentAsync(int requestId, const char* fullFilePath)
+	{
+		PendingFileRead fileRead = { requestId, fullFilePath, false, 0, 0, -1, 0 };
+		GetPendingFileReads().push_back(fileRead);
+	}
+
+	static void RequestFileRangeAsync(int requestId, const char* fullFilePath, int64 fileOffset, int length, int destArrayId, int destOffset)
+	{
+		PendingFileRead fileRead = { requestId, fullFilePath, true, fileOffset, length, destArrayId, destOffset };
+		GetPendingFileReads().push_back(fileRead);
+	}
+
+	//Reads the range of the file to the destination array, returning the number of bytes read, or -1 if the file was not found
+	static int ReadFileRange(const PendingFileRead& fileRead, int64& fileLength)
+	{
+		fileLength = -1;
+		FILE* pFile = fopen(fileRead.fullFilePath.c_str(), "rb");
+		if (pFile == NULL)
+			return -1;
+
+		fileLength = GetFileLength(pFile);
+
+		int nOfBytesRead = 0;
+		uint8* pDest = Arrays::GetInstance().GetArrayForWrite(fileRead.destArrayId);
+		if (pDest && fileRead.fileOffset < fileLength && SeekFile(pFile, fileRead.fileOffset, SEEK_SET) == 0)
+			nOfBytesRead = (int)fread(pDest + fileRead.destOffset, 1, fileRead.length, pFile);
+
+		fclose(pFile);
+		return nOfBytesRead;
+	}
+
+	//Reads the files requested by UnityAdapter::ReadFileContentAsync and completes their requests, as the C# UnityAdapter does
+	//on its Update. Call it once per frame of the tool, the reads requested by the completion callbacks wait for the next call.
+	//Inline instead of static as the functions above, since only the tools reading files call it.
+	inline void CompleteFileReads()
+	{
+		std::vector<PendingFileRead> fileReads;
+		fileReads.swap(GetPendingFileReads());
+		for (size_t i = 0; i < fileReads.size(); ++i)
+		{
+			if (fileReads[i].isRangeRead)
+			{
+				int64 fileLength;
+				int nOfBytesRead = ReadFileRange(fileReads[i], fileLength);
+				UnityAdapter::Internals::DeliverFileRangeRead(fileReads[i].requestId, nOfBytesRead, fileLength);
+				continue;
+			}
+
+			int arrayId = ReadFileToNewArray(fileReads[i].fullFilePath.c_str(), false);
+			int lengthInBytes = 0;
+			if (arrayId >= 0)
+				Arrays::GetInstance().GetArray(arrayId, lengthInBytes);
+
+			UnityAdapter::Internals::DeliverFileReadContent(fileReads[i].requestId, arrayId, 
+															arrayId >= 0 ? Arrays::GetInstance().GetArrayForWrite(arrayId) : NULL, lengthInBytes);
+		}
+	}
+
+	static void SaveTextFile(const char* fullFilePath, const char* textContent)
+	{
+		if (strncmp(textContent, "DELETE", 6) == 0)
+		{
+			remove(fullFilePath);
+			return;
+		}
+
+		FILE* pFile = fopen(fullFilePath, "wb");
+		if (pFile == NULL)
+			return;
+
+		fwrite(textContent, strlen(textContent), 1, pFile);
+		fclose(pFile);
+	}
+
+	static void RequestManagedArray(const char* managedTypeName, int length)
+	{
+		Arrays::GetInstance().New(managedTypeName, length);
+	}
+
+	static void ReleaseManagedArray(int arrayId)
+	{
+		Arrays::GetInstance().Release(arrayId);
+	}
+
+	//Call it before using any UnityAdapter feature, as the C# UnityAdapter does on its Awake
+	static void Install()
+	{
+		Arrays& arrays = Arrays::GetInstance();
+		arrays.SetTypeSize<uint8>();
+		arrays.SetTypeSize<int8>();
+		arrays.SetTypeSize<int16>();
+		arrays.SetTypeSize<uint16>();
+		arrays.SetTypeSize<int32>();
+		arrays.SetTypeSize<uint32>();
+		arrays.SetTypeSize<int64>();
+		arrays.SetTypeSize<uint64>();
+		arrays.SetTypeSize<float>();
+		arrays.SetTypeSize<double>();
+		arrays.SetTypeSize<UnityMessager::InternedStringRef>();
+
+		UnityAdapter::Internals::SetOutputDebugStrFcPtr(OutputDebugStr);
+		UnityAdapter::Internals::SetFileFcPtrs(RequestFileContent, SaveTextFile);
+		UnityAdapter::Internals::SetFileReadAsyncFcPtrs(RequestFileContentAsync, RequestFileRangeAsync);
+		UnityAdapter::Internals::SetArrayFcPtrs(RequestManagedArray, ReleaseManagedArray);
+	}
+}
+
+#endif
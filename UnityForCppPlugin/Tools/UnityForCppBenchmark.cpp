@@ -0,0 +1,360 @@
+//Copyright (c) 2016, Samuel Pollachini (Samuel Polacchini)
+//The UnityForCpp project is licensed under the terms of the MIT license
+
+//Standalone microbenchmarks for the UnityMessager sending paths and the UnityArray allocation, running the plugin sources
+//against the NativeUnityAdapterStub.h instead of Unity. Each benchmark runs once for each set of UnityMessager init flags
+//and prints a CSV line (header: benchmark,flags,ops,ns_per_op,mops_per_s) to stdout, so results can be tracked over time.
+//Only the sending is measured, the deliverings between frames of UM_BENCHMARK_OPS_PER_FRAME operations are not. Build it with:
+//
+//   g++ -std=c++11 -O2 -pthread -o UnityForCppBenchmark UnityForCppBenchmark.cpp ../Source/Shared.cpp ../Source/UnityAdapter.cpp
+//       ../Source/UnityArray.cpp ../Source/UnityMessager.cpp ../Source/UnityMessagerTrace.cpp ../Source/UnityMessagerDecoder.cpp
+//       ../Source/UnityMessagerInbox.cpp ../Source/UnityMessagerRing.cpp
+//
+//   UnityForCppBenchmark [--filter <substring>] [--flags <flags,flags...>] [--min-time <seconds>]
+//
+//Out of Windows the plugin is always built with _DEBUG (check Shared.h), so the numbers include the ASSERT checks.
+
+#include "NativeUnityAdapterStub.h"
+#include "../Source/UnityMessager.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+using namespace UnityForCpp;
+
+UM_DECLARE_COMPONENT(BenchmarkComponent)
+
+//Queue arrays of 16KB, so the array parameter benchmarks bellow advance or spill as their names say
+#define UM_BENCHMARK_QUEUE_ARRAYS_SIZE_IN_BYTES 16384
+#define UM_BENCHMARK_N_OF_RECEIVER_IDS 1024
+#define UM_BENCHMARK_OPS_PER_FRAME 1000
+
+//Operations sent to receivers 1 to 64, as a game sends to its objects
+#define RECEIVER_ID(op) (1 + ((op) & 63))
+
+static int f_intArray[8192];
+static float f_floatArray[256];
+static uint8 f_byteArray[4096];
+
+typedef void(*BenchmarkFcPtr)(int nOfOps);
+
+struct Benchmark
+{
+	const char* name;
+	BenchmarkFcPtr fcPtr;
+	bool usesMessager; //otherwise it runs only once, not for each set of flags
+};
+
+static void Send0Params(int nOfOps)
+{
+	UnityMessager& unityMessager = UnityMessager::GetInstance();
+	for (int op = 0; op < nOfOps; ++op)
+		unityMessager.SendMessage(RECEIVER_ID(op), 1);
+}
+
+static void Send1Int(int nOfOps)
+{
+	UnityMessager& unityMessager = UnityMessager::GetInstance();
+	for (int op = 0; op < nOfOps; ++op)
+		unityMessager.SendMessage(RECEIVER_ID(op), 1, op);
+}
+
+static void Send1Float(int nOfOps)
+{
+	UnityMessager& unityMessager = UnityMessager::GetInstance();
+	for (int op = 0; op < nOfOps; ++op)
+		unityMessager.SendMessage(RECEIVER_ID(op), 1, (float)op);
+}
+
+static void Send1Double(int nOfOps)
+{
+	UnityMessager& unityMessager = UnityMessager::GetInstance();
+	for (int op = 0; op < nOfOps; ++op)
+		unityMessager.SendMessage(RECEIVER_ID(op), 1, (double)op);
+}
+
+static void Send3Mixed(int nOfOps)
+{
+	UnityMessager& unityMessager = UnityMessager::GetInstance();
+	for (int op = 0; op < nOfOps; ++op)
+		unityMessager.SendMessage(RECEIVER_ID(op), 1, op, (float)op, (double)op);
+}
+
+static void Send6Mixed(int nOfOps)
+{
+	UnityMessager& unityMessager = UnityMessager::GetInstance();
+	for (int op = 0; op < nOfOps; ++op)
+		unityMessager.SendMessage(RECEIVER_ID(op), 1, op, (float)op, (double)op, (uint8)op, (int64)op, (uint16)op);
+}
+
+static void Send6Floats(int nOfOps)
+{
+	UnityMessager& unityMessager = UnityMessager::GetInstance();
+	for (int op = 0; op < nOfOps; ++op)
+	{
+		float value = (float)op;
+		unityMessager.SendMessage(RECEIVER_ID(op), 1, value, value, value, value, value, value);
+	}
+}
+
+static void SendString(int nOfOps)
+{
+	UnityMessager& unityMessager = UnityMessager::GetInstance();
+	for (int op = 0; op < nOfOps; ++op)
+		unityMessager.SendMessage(RECEIVER_ID(op), 1, "a short log line for the benchmark");
+}
+
+static void SendArrayInt16(int nOfOps)
+{
+	UnityMessager& unityMessager = UnityMessager::GetInstance();
+	for (int op = 0; op < nOfOps; ++op)
+		unityMessager.SendMessage(RECEIVER_ID(op), 1, UM_ARRAY_PARAM(f_intArray, 16));
+}
+
+static void SendArrayFloat256(int nOfOps)
+{
+	UnityMessager& unityMessager = UnityMessager::GetInstance();
+	for (int op = 0; op < nOfOps; ++op)
+		unityMessager.SendMessage(RECEIVER_ID(op), 1, UM_ARRAY_PARAM(f_floatArray, 256));
+}
+
+static void SendArrayByte4096(int nOfOps)
+{
+	UnityMessager& unityMessager = UnityMessager::GetInstance();
+	for (int op = 0; op < nOfOps; ++op)
+		unityMessager.SendMessage(RECEIVER_ID(op), 1, UM_ARRAY_PARAM(f_byteArray, 4096));
+}
+
+static void SendArrayToFillFloat256(int nOfOps)
+{
+	UnityMessager& unityMessager = UnityMessager::GetInstance();
+	for (int op = 0; op < nOfOps; ++op)
+	{
+		UnityMessager::ArrayToFillParam<float> arrayToFill = UM_CREATE_ARRAY_TO_FILL_PARAM(float, 256);
+		unityMessager.SendMessage(RECEIVER_ID(op), 1, arrayToFill);
+		for (int i = 0; i < 256; ++i)
+			arrayToFill[i] = (float)i;
+	}
+}
+
+//More than half of the int queue arrays (4096 ints), so every message advances the queue to its next array
+static void SendArrayIntQueueAdvance(int nOfOps)
+{
+	UnityMessager& unityMessager = UnityMessager::GetInstance();
+	for (int op = 0; op < nOfOps; ++op)
+		unityMessager.SendMessage(RECEIVER_ID(op), 1, UM_ARRAY_PARAM(f_intArray, 2049));
+}
+
+//Longer than the int queue arrays, so every message gets a spill array
+static void SendArrayIntSpill(int nOfOps)
+{
+	UnityMessager& unityMessager = UnityMessager::GetInstance();
+	for (int op = 0; op < nOfOps; ++op)
+		unityMessager.SendMessage(RECEIVER_ID(op), 1, UM_ARRAY_PARAM(f_intArray, 8192));
+}
+
+static void SendComponent(int nOfOps)
+{
+	UnityMessager& unityMessager = UnityMessager::GetInstance();
+	for (int op = 0; op < nOfOps; ++op)
+		unityMessager.SendMessage<BenchmarkComponent>(RECEIVER_ID(op), 1, (float)op);
+}
+
+static void SendByMethodName(int nOfOps)
+{
+	UnityMessager& unityMessager = UnityMessager::GetInstance();
+	for (int op = 0; op < nOfOps; ++op)
+		unityMessager.SendMessage<BenchmarkComponent>(RECEIVER_ID(op), "SetSpeed", (float)op);
+}
+
+static void SendByObjectName(int nOfOps)
+{
+	UnityMessager& unityMessager = UnityMessager::GetInstance();
+	for (int op = 0; op < nOfOps; ++op)
+		unityMessager.SendMessage<BenchmarkComponent>("Player", 1, (float)op);
+}
+
+static void SendByObjectAndMethodNames(int nOfOps)
+{
+	UnityMessager& unityMessager = UnityMessager::GetInstance();
+	for (int op = 0; op < nOfOps; ++op)
+		unityMessager.SendMessage<BenchmarkComponent>("Player", "SetSpeed", (float)op);
+}
+
+//The same name based sendings through NamedRoute instances, which cache their routing binding ids
+static void SendByMethodNameRoute(int nOfOps)
+{
+	static const UnityMessager::NamedRoute c_route("SetSpeed");
+	UnityMessager& unityMessager = UnityMessager::GetInstance();
+	for (int op = 0; op < nOfOps; ++op)
+		unityMessager.SendMessage<BenchmarkComponent>(RECEIVER_ID(op), c_route, (float)op);
+}
+
+static void SendByObjectNameRoute(int nOfOps)
+{
+	static const UnityMessager::NamedRoute c_route("Player", 1);
+	UnityMessager& unityMessager = UnityMessager::GetInstance();
+	for (int op = 0; op < nOfOps; ++op)
+		unityMessager.SendMessage<BenchmarkComponent>(c_route, (float)op);
+}
+
+static void SendByObjectAndMethodNamesRoute(int nOfOps)
+{
+	static const UnityMessager::NamedRoute c_route("Player", "SetSpeed");
+	UnityMessager& unityMessager = UnityMessager::GetInstance();
+	for (int op = 0; op < nOfOps; ++op)
+		unityMessager.SendMessage<BenchmarkComponent>(c_route, (float)op);
+}
+
+static void UnityArrayAllocRelease16(int nOfOps)
+{
+	UnityArray<int> unityArray;
+	for (int op = 0; op < nOfOps; ++op)
+	{
+		unityArray.Alloc(16);
+		unityArray.Release();
+	}
+}
+
+static void UnityArrayAllocRelease65536(int nOfOps)
+{
+	UnityArray<float> unityArray;
+	for (int op = 0; op < nOfOps; ++op)
+	{
+		unityArray.Alloc(65536);
+		unityArray.Release();
+	}
+}
+
+static const Benchmark f_benchmarks[] = {
+	{ "send_0_params", Send0Params, true },
+	{ "send_1_int", Send1Int, true },
+	{ "send_1_float", Send1Float, true },
+	{ "send_1_double", Send1Double, true },
+	{ "send_3_mixed", Send3Mixed, true },
+	{ "send_6_mixed", Send6Mixed, true },
+	{ "send_6_floats", Send6Floats, true },
+	{ "send_string", SendString, true },
+	{ "send_array_int_16", SendArrayInt16, true },
+	{ "send_array_float_256", SendArrayFloat256, true },
+	{ "send_array_byte_4096", SendArrayByte4096, true },
+	{ "send_array_to_fill_float_256", SendArrayToFillFloat256, true },
+	{ "send_array_int_queue_advance", SendArrayIntQueueAdvance, true },
+	{ "send_array_int_spill", SendArrayIntSpill, true },
+	{ "send_component", SendComponent, true },
+	{ "send_by_method_name", SendByMethodName, true },
+	{ "send_by_object_name", SendByObjectName, true },
+	{ "send_by_object_and_method_names", SendByObjectAndMethodNames, true },
+	{ "send_by_method_name_route", SendByMethodNameRoute, true },
+	{ "send_by_object_name_route", SendByObjectNameRoute, true },
+	{ "send_by_object_and_method_names_route", SendByObjectAndMethodNamesRoute, true },
+	{ "unity_array_alloc_release_16", UnityArrayAllocRelease16, false },
+	{ "unity_array_alloc_release_65536", UnityArrayAllocRelease65536, false }
+};
+
+//Delivers the messages as the C# side would start and finish doing, without reading them
+static void DeliverMessages()
+{
+	UnityMessager::GetInstance().OnStartMessageDelivering();
+	UnityMessager::GetInstance().OnFinishMessageDelivering();
+}
+
+//Runs frames of the benchmark until minTime seconds of measured time, returning the seconds per operation
+static double Run(const Benchmark& benchmark, double minTime, int64& nOfOps)
+{
+	//a first frame not measured, so the queues get their capacity and the routing bindings are registered
+	benchmark.fcPtr(UM_BENCHMARK_OPS_PER_FRAME);
+	if (benchmark.usesMessager)
+		DeliverMessages();
+
+	nOfOps = 0;
+	std::chrono::duration<double> elapsed(0);
+	while (elapsed.count() < minTime)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		benchmark.fcPtr(UM_BENCHMARK_OPS_PER_FRAME);
+		elapsed += std::chrono::steady_clock::now() - start;
+
+		nOfOps += UM_BENCHMARK_OPS_PER_FRAME;
+		if (benchmark.usesMessager)
+			DeliverMessages();
+	}
+
+	return elapsed.count() / nOfOps;
+}
+
+static void PrintResult(const Benchmark& benchmark, int flags, int64 nOfOps, double secondsPerOp)
+{
+	printf("%s,%d,%lld,%.2f,%.3f\n", benchmark.name, flags, (long long)nOfOps, secondsPerOp * 1e9, 1e-6 / secondsPerOp);
+	fflush(stdout);
+}
+
+int main(int argc, char** argv)
+{
+	const char* filter = NULL;
+	double minTime = 0.25;
+	std::vector<int> flagsSets;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--filter") == 0)
+			filter = argv[i + 1];
+		else if (strcmp(argv[i], "--min-time") == 0)
+			minTime = atof(argv[i + 1]);
+		else if (strcmp(argv[i], "--flags") == 0)
+		{
+			for (const char* pFlags = argv[i + 1]; *pFlags; )
+			{
+				flagsSets.push_back(atoi(pFlags));
+				while (*pFlags && *(pFlags++) != ',') {}
+			}
+		}
+		else
+		{
+			fprintf(stderr, "Usage: %s [--filter <substring>] [--flags <flags,flags...>] [--min-time <seconds>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	//default: plain, compact control queue, interleaved parameters and both
+	if (flagsSets.empty())
+	{
+		int defaultFlagsSets[] = { 0, UM_INIT_FLAG_COMPACT_CONTROL_QUEUE, UM_INIT_FLAG_INTERLEAVED_PARAMS,
+								   UM_INIT_FLAG_COMPACT_CONTROL_QUEUE | UM_INIT_FLAG_INTERLEAVED_PARAMS };
+		flagsSets.assign(defaultFlagsSets, defaultFlagsSets + sizeof(defaultFlagsSets) / sizeof(int));
+	}
+
+	NativeUnityAdapterStub::Install();
+	printf("benchmark,flags,ops,ns_per_op,mops_per_s\n");
+
+	int nOfBenchmarks = sizeof(f_benchmarks) / sizeof(Benchmark);
+	for (size_t flagsIdx = 0; flagsIdx < flagsSets.size(); ++flagsIdx)
+	{
+		int flags = flagsSets[flagsIdx];
+		UnityMessager::InstanceAndProvideAwakeInfo(UM_BENCHMARK_N_OF_RECEIVER_IDS, UM_BENCHMARK_QUEUE_ARRAYS_SIZE_IN_BYTES, flags);
+		for (int i = 0; i < nOfBenchmarks; ++i)
+		{
+			const Benchmark& benchmark = f_benchmarks[i];
+			if ((filter && strstr(benchmark.name, filter) == NULL) || (!benchmark.usesMessager && flagsIdx > 0))
+				continue;
+
+			int64 nOfOps;
+			double secondsPerOp = Run(benchmark, minTime, nOfOps);
+			PrintResult(benchmark, benchmark.usesMessager ? flags : -1, nOfOps, secondsPerOp);
+		}
+
+		UnityMessager::DeleteInstance();
+	}
+
+	//every shared array must have been released by the UnityMessager
+	int nOfLeakedArrays = NativeUnityAdapterStub::Arrays::GetInstance().GetNOfLiveArrays();
+	if (nOfLeakedArrays > 0)
+	{
+		fprintf(stderr, "%d shared arrays were not released\n", nOfLeakedArrays);
+		return 1;
+	}
+
+	return 0;
+}
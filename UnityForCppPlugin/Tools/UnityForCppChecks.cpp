@@ -0,0 +1,2223 @@
+//Copyright (c) 2016, Samuel Pollachini (Samuel Polacchini)
+//The UnityForCpp project is licensed under the terms of the MIT license
+
+//Standalone checks of the plugin features that the Unity demo can't verify by itself, running the plugin sources against
+//the NativeUnityAdapterStub.h instead of Unity. Checks using the UnityMessager run once for each set of UnityMessager init
+//flags, with an UnityMessagerDispatcher playing the C# side. Each run prints a CSV line (header: check,flags,failures) to
+//stdout, each failed condition is reported on stderr with its line, and it returns 1 if any check fails. The file checks write
+//their files to the working directory, removing them at the end. Build it with:
+//
+//   g++ -std=c++11 -O2 -pthread -o UnityForCppChecks UnityForCppChecks.cpp ../Source/Shared.cpp ../Source/UnityAdapter.cpp
+//       ../Source/UnityArray.cpp ../Source/UnityMessager.cpp ../Source/UnityMessagerTrace.cpp ../Source/UnityMessagerDecoder.cpp
+//       ../Source/UnityMessagerDispatcher.cpp ../Source/UnityMessagerInbox.cpp ../Source/UnityMessagerRing.cpp
+//       ../Source/UnityFileStreamReader.cpp
+//
+//   UnityForCppChecks [--filter <substring>] [--flags <flags,flags...>]
+//
+//Out of Windows the plugin is always built with _DEBUG (check Shared.h), so the ASSERT checks of the plugin run as well.
+
+#include "NativeUnityAdapterStub.h"
+#include "../Source/UnityArray.h"
+#include "../Source/UnityFileStreamReader.h"
+#include "../Source/UnityMessager.h"
+#include "../Source/UnityMessagerDispatcher.h"
+#include "../Source/UnityMessagerInbox.h"
+#include "../Source/UnityMessagerRing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace UnityForCpp;
+
+#define UM_CHECKS_QUEUE_ARRAYS_SIZE_IN_BYTES 4096
+#define UM_CHECKS_N_OF_RECEIVER_IDS 64
+
+static int f_nOfFailures = 0;
+
+//Counts and reports a failed condition, without stopping the check
+#define CHECK(exp) if (!(exp)) { ++f_nOfFailures; fprintf(stderr, "CHECK FAILED: %s, line %d: %s\n", __FILE__, __LINE__, #exp); }
+
+typedef void(*CheckFcPtr)(int flags);
+
+struct Check
+{
+	const char* name;
+	CheckFcPtr fcPtr;
+	bool usesMessager; //otherwise it runs only once, not for each set of flags
+};
+
+//------------------ multi-producer ordering
+
+#define PRODUCERS_N_OF_BOUND_THREADS 4
+#define PRODUCERS_N_OF_FRAMES 40
+#define PRODUCERS_MAX_MESSAGES_PER_FRAME 200
+#define PRODUCERS_MAX_ARRAY_LENGTH 300
+
+//producer tags sent as the first parameter, bound threads send their producer index
+#define PRODUCERS_MAIN_THREAD_TAG -1
+#define PRODUCERS_AUTO_BOUND_TAG 1000
+
+#define PRODUCERS_MSG_SEQUENCE 1
+
+//Identifies a delivered (or expected) message of the sequence
+struct SequenceEntry
+{
+	int producerTag;
+	int seq;
+
+	bool operator==(const SequenceEntry& other) const { return producerTag == other.producerTag && seq == other.seq; }
+	bool operator!=(const SequenceEntry& other) const { return !(*this == other); }
+};
+
+//Sends the seq-th message of a producer, its parameters are derived from the seq, so the receiver can verify them. The array
+//parameter alternates between ArrayParam and ArrayToFillParam, the later being filled right after the sending, as it must.
+static void SendSequenceMessage(int receiverId, int producerTag, int frame, int seq)
+{
+	static const char* const c_names[] = { "zero", "one", "two" };
+	int arrayLength = (seq * 37) % PRODUCERS_MAX_ARRAY_LENGTH;
+	if (seq % 2 == 0)
+	{
+		int array[PRODUCERS_MAX_ARRAY_LENGTH];
+		for (int i = 0; i < arrayLength; ++i)
+			array[i] = seq + i;
+
+		UNITY_MESSAGER.SendMessage(receiverId, PRODUCERS_MSG_SEQUENCE, producerTag, frame, seq, seq * 0.5f,
+								   UM_ARRAY_PARAM(array, arrayLength), c_names[seq % 3]);
+	}
+	else
+	{
+		auto arrayToFill = UM_CREATE_ARRAY_TO_FILL_PARAM(int, arrayLength);
+		UNITY_MESSAGER.SendMessage(receiverId, PRODUCERS_MSG_SEQUENCE, producerTag, frame, seq, seq * 0.5f,
+								   arrayToFill, c_names[seq % 3]);
+		for (int i = 0; i < arrayLength; ++i)
+			arrayToFill[i] = seq + i;
+	}
+}
+
+//Records the delivered sequence, checking the parameters of each message
+class SequenceReceiver : public UnityMessagerDispatcher::Receiver
+{
+public:
+	SequenceReceiver() : m_frame(0) {}
+
+	void StartFrame(int frame) { m_frame = frame; m_delivered.clear(); }
+	const std::vector<SequenceEntry>& GetDelivered() const { return m_delivered; }
+
+	virtual void ReceiveMessage(const UnityMessagerDispatcher::Message& message)
+	{
+		static const char* const c_names[] = { "zero", "one", "two" };
+		CHECK(message.GetMsgId() == PRODUCERS_MSG_SEQUENCE && message.GetNOfParams() == 6);
+		if (message.GetMsgId() != PRODUCERS_MSG_SEQUENCE || message.GetNOfParams() != 6)
+			return;
+
+		SequenceEntry entry = { message.GetParam<int>(0), message.GetParam<int>(2) };
+		CHECK(message.GetParam<int>(1) == m_frame);
+		CHECK(message.GetParam<float>(3) == entry.seq * 0.5f);
+
+		int length;
+		const int* pArray = message.GetArrayParam<int>(4, length);
+		CHECK(pArray != NULL && length == (entry.seq * 37) % PRODUCERS_MAX_ARRAY_LENGTH);
+		for (int i = 0; pArray && i < length; ++i)
+		{
+			if (pArray[i] != entry.seq + i)
+			{
+				CHECK(pArray[i] == entry.seq + i);
+				break;
+			}
+		}
+
+		CHECK(message.GetStringParam(5) == c_names[entry.seq % 3]);
+		m_delivered.push_back(entry);
+	}
+
+private:
+	int m_frame;
+	std::vector<SequenceEntry> m_delivered;
+};
+
+//Long-lived worker threads, each one bound once to its producer (or auto bound on its first message) and sending a random
+//number of messages at each frame, from its own seeded generator. The main thread releases them all at the frame start
+//and waits for them before delivering, as a game would do with its job system.
+class ProducerThreads
+{
+public:
+	ProducerThreads(int receiverId) : m_receiverId(receiverId), m_frame(-1), m_nOfBusyThreads(0), m_stop(false)
+	{
+		//bound in the reverse order of the thread creation, the merge order must follow the producer index anyway
+		for (int i = 0; i <= PRODUCERS_N_OF_BOUND_THREADS; ++i)
+		{
+			int producerTag = i < PRODUCERS_N_OF_BOUND_THREADS ? (PRODUCERS_N_OF_BOUND_THREADS - 1 - i) * 10 : PRODUCERS_AUTO_BOUND_TAG;
+			m_producerTags.push_back(producerTag);
+			m_nOfMessagesSent.push_back(0);
+		}
+
+		for (int i = 0; i <= PRODUCERS_N_OF_BOUND_THREADS; ++i)
+			m_threads.push_back(std::thread(&ProducerThreads::Run, this, i));
+	}
+
+	~ProducerThreads()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+
+		m_frameStarted.notify_all();
+		for (size_t i = 0; i < m_threads.size(); ++i)
+			m_threads[i].join();
+	}
+
+	//Runs a frame on all the threads, returning once they are done
+	void RunFrame(int frame)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_frame = frame;
+		m_nOfBusyThreads = (int)m_threads.size();
+		m_frameStarted.notify_all();
+		m_frameDone.wait(lock, [this]() { return m_nOfBusyThreads == 0; });
+	}
+
+	//Sequence the threads sent on the last frame, in the expected merge order: bound producers by their index, then the
+	//auto bound one
+	void AppendExpected(std::vector<SequenceEntry>& expected) const
+	{
+		for (int producerIndex = 0; producerIndex < PRODUCERS_N_OF_BOUND_THREADS; ++producerIndex)
+			AppendExpectedOf(producerIndex * 10, expected);
+
+		AppendExpectedOf(PRODUCERS_AUTO_BOUND_TAG, expected);
+	}
+
+private:
+	void Run(int threadIdx)
+	{
+		int producerTag = m_producerTags[threadIdx];
+		if (producerTag != PRODUCERS_AUTO_BOUND_TAG)
+			UNITY_MESSAGER.BindProducerThread(producerTag);
+
+		std::minstd_rand random(1 + threadIdx);
+		int lastFrame = -1;
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_frameStarted.wait(lock, [this, lastFrame]() { return m_stop || m_frame != lastFrame; });
+				if (m_stop)
+					return;
+
+				lastFrame = m_frame;
+			}
+
+			//some frames have no messages from this producer
+			int nOfMessages = (int)(random() % (PRODUCERS_MAX_MESSAGES_PER_FRAME + 1)) - PRODUCERS_MAX_MESSAGES_PER_FRAME / 4;
+			nOfMessages = nOfMessages > 0 ? nOfMessages : 0;
+			for (int seq = 0; seq < nOfMessages; ++seq)
+				SendSequenceMessage(m_receiverId, producerTag, lastFrame, seq);
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_nOfMessagesSent[threadIdx] = nOfMessages;
+			if (--m_nOfBusyThreads == 0)
+				m_frameDone.notify_one();
+		}
+	}
+
+	void AppendExpectedOf(int producerTag, std::vector<SequenceEntry>& expected) const
+	{
+		for (size_t i = 0; i < m_producerTags.size(); ++i)
+		{
+			if (m_producerTags[i] != producerTag)
+				continue;
+
+			for (int seq = 0; seq < m_nOfMessagesSent[i]; ++seq)
+			{
+				SequenceEntry entry = { producerTag, seq };
+				expected.push_back(entry);
+			}
+		}
+	}
+
+	int m_receiverId;
+	std::vector<std::thread> m_threads;
+	std::vector<int> m_producerTags; //by thread index
+	std::vector<int> m_nOfMessagesSent; //by thread index, on the last frame
+
+	std::mutex m_mutex;
+	std::condition_variable m_frameStarted;
+	std::condition_variable m_frameDone;
+	int m_frame;
+	int m_nOfBusyThreads;
+	bool m_stop;
+};
+
+//Messages from worker threads are merged after the main thread ones, ordered by producer, each producer keeping its own
+//order, and with their parameters intact
+static void CheckProducersOrder(int flags)
+{
+	NativeUnityAdapterStub::Arrays& arrays = NativeUnityAdapterStub::Arrays::GetInstance();
+	int controlQueueFirstArrayId = UnityMessager::InstanceAndProvideAwakeInfo(UM_CHECKS_N_OF_RECEIVER_IDS,
+																			 UM_CHECKS_QUEUE_ARRAYS_SIZE_IN_BYTES, flags);
+	int receiverId = UNITY_MESSAGER.NewReceiverId();
+
+	SequenceReceiver receiver;
+	UnityMessagerDispatcher dispatcher(flags, controlQueueFirstArrayId, arrays);
+	dispatcher.SetReceiver(receiverId, &receiver);
+
+	{
+		ProducerThreads producerThreads(receiverId);
+		std::minstd_rand random(flags + 1);
+		std::vector<SequenceEntry> expected;
+		for (int frame = 0; frame < PRODUCERS_N_OF_FRAMES; ++frame)
+		{
+			expected.clear();
+			receiver.StartFrame(frame);
+
+			//the main thread sends part of its messages while the workers run and part after them, all delivered first
+			int nOfMainMessages = (int)(random() % (PRODUCERS_MAX_MESSAGES_PER_FRAME / 4));
+			for (int seq = 0; seq < nOfMainMessages / 2; ++seq)
+				SendSequenceMessage(receiverId, PRODUCERS_MAIN_THREAD_TAG, frame, seq);
+
+			producerThreads.RunFrame(frame);
+
+			for (int seq = nOfMainMessages / 2; seq < nOfMainMessages; ++seq)
+				SendSequenceMessage(receiverId, PRODUCERS_MAIN_THREAD_TAG, frame, seq);
+
+			for (int seq = 0; seq < nOfMainMessages; ++seq)
+			{
+				SequenceEntry entry = { PRODUCERS_MAIN_THREAD_TAG, seq };
+				expected.push_back(entry);
+			}
+
+			producerThreads.AppendExpected(expected);
+			CHECK(dispatcher.DeliverMessages());
+
+			const std::vector<SequenceEntry>& delivered = receiver.GetDelivered();
+			CHECK(delivered.size() == expected.size());
+			for (size_t i = 0; i < delivered.size() && i < expected.size(); ++i)
+			{
+				if (delivered[i] != expected[i])
+				{
+					CHECK(delivered[i] == expected[i]);
+					fprintf(stderr, "   frame %d, message %d: delivered (%d, %d), expected (%d, %d)\n", frame, (int)i,
+							delivered[i].producerTag, delivered[i].seq, expected[i].producerTag, expected[i].seq);
+					break;
+				}
+			}
+		}
+	}
+
+	UnityMessager::DeleteInstance();
+}
+
+//------------------ parameters sharing a ParamQueue
+
+#define SHARED_QUEUES_N_OF_FRAMES 20
+#define SHARED_QUEUES_MESSAGES_PER_FRAME 100
+#define SHARED_QUEUES_MAX_ARRAY_LENGTH 600
+#define SHARED_QUEUES_UNITY_ARRAY_LENGTH 16
+
+#define SHARED_QUEUES_MSG_ARRAYS 1
+#define SHARED_QUEUES_MSG_UNITY_ARRAY 2
+
+//Lengths of the two array parameters of the seq-th message, their sum exceeding the queue arrays from time to time
+static int GetSharedQueuesArrayLength(int seq, int arrayIdx)
+{
+	return (seq * (arrayIdx == 0 ? 97 : 53)) % SHARED_QUEUES_MAX_ARRAY_LENGTH;
+}
+
+//Checks the messages of CheckSharedParamQueues, each one pushing several parameters to the int and byte ParamQueues
+class SharedQueuesReceiver : public UnityMessagerDispatcher::Receiver
+{
+public:
+	SharedQueuesReceiver() : m_nOfMessages(0) {}
+
+	int GetNOfMessages() const { return m_nOfMessages; }
+
+	virtual void ReceiveMessage(const UnityMessagerDispatcher::Message& message)
+	{
+		int seq = message.GetParam<int>(0);
+		if (message.GetMsgId() == SHARED_QUEUES_MSG_ARRAYS)
+		{
+			CHECK(message.GetNOfParams() == 6);
+			CheckArray(message, 1, seq, GetSharedQueuesArrayLength(seq, 0), 1);
+			CHECK(message.GetParam<int>(2) == seq + 1);
+			CHECK(message.GetStringParam(3) == "first");
+			CheckArray(message, 4, seq, GetSharedQueuesArrayLength(seq, 1), -1);
+			CHECK(message.GetStringParam(5) == "second");
+		}
+		else
+		{
+			CHECK(message.GetMsgId() == SHARED_QUEUES_MSG_UNITY_ARRAY && message.GetNOfParams() == 3);
+			CheckArray(message, 1, 0, SHARED_QUEUES_UNITY_ARRAY_LENGTH, 3);
+			CheckArray(message, 2, seq, GetSharedQueuesArrayLength(seq, 0), 1);
+		}
+
+		++m_nOfMessages;
+	}
+
+private:
+	//the items are first + i * step
+	void CheckArray(const UnityMessagerDispatcher::Message& message, int paramIdx, int first, int length, int step)
+	{
+		int paramLength;
+		const int* pArray = message.GetArrayParam<int>(paramIdx, paramLength);
+		CHECK(pArray != NULL && paramLength == length);
+		for (int i = 0; pArray && i < paramLength; ++i)
+		{
+			if (pArray[i] != first + i * step)
+			{
+				CHECK(pArray[i] == first + i * step);
+				break;
+			}
+		}
+	}
+
+	int m_nOfMessages;
+};
+
+//Parameters sharing a ParamQueue are reserved together, so their queue doesn't advance between them, while the ones not fitting
+//the queue arrays and the UnityArrayParam sharing its queue are registered one by one. Both must be delivered intact.
+static void CheckSharedParamQueues(int flags)
+{
+	NativeUnityAdapterStub::Arrays& arrays = NativeUnityAdapterStub::Arrays::GetInstance();
+	int controlQueueFirstArrayId = UnityMessager::InstanceAndProvideAwakeInfo(UM_CHECKS_N_OF_RECEIVER_IDS,
+																			 UM_CHECKS_QUEUE_ARRAYS_SIZE_IN_BYTES, flags);
+	int receiverId = UNITY_MESSAGER.NewReceiverId();
+
+	SharedQueuesReceiver receiver;
+	UnityMessagerDispatcher dispatcher(flags, controlQueueFirstArrayId, arrays);
+	dispatcher.SetReceiver(receiverId, &receiver);
+
+	UnityArray<int> unityArray;
+	unityArray.Alloc(SHARED_QUEUES_UNITY_ARRAY_LENGTH);
+	for (int i = 0; i < SHARED_QUEUES_UNITY_ARRAY_LENGTH; ++i)
+		unityArray[i] = i * 3;
+
+	int array[SHARED_QUEUES_MAX_ARRAY_LENGTH];
+	int seq = 0;
+	for (int frame = 0; frame < SHARED_QUEUES_N_OF_FRAMES; ++frame)
+	{
+		for (int i = 0; i < SHARED_QUEUES_MESSAGES_PER_FRAME; ++i, ++seq)
+		{
+			int length = GetSharedQueuesArrayLength(seq, 0);
+			for (int j = 0; j < length; ++j)
+				array[j] = seq + j;
+
+			if (seq % 5 == 4)
+			{
+				UNITY_MESSAGER.SendMessage(receiverId, SHARED_QUEUES_MSG_UNITY_ARRAY, seq, UM_UNITY_ARRAY_PARAM(unityArray),
+										   UM_ARRAY_PARAM(array, length));
+				continue;
+			}
+
+			int fillLength = GetSharedQueuesArrayLength(seq, 1);
+			auto arrayToFill = UM_CREATE_ARRAY_TO_FILL_PARAM(int, fillLength);
+			UNITY_MESSAGER.SendMessage(receiverId, SHARED_QUEUES_MSG_ARRAYS, seq, UM_ARRAY_PARAM(array, length), seq + 1, "first",
+									   arrayToFill, "second");
+			for (int j = 0; j < fillLength; ++j)
+				arrayToFill[j] = seq - j;
+		}
+
+		CHECK(dispatcher.DeliverMessages());
+		CHECK(receiver.GetNOfMessages() == seq);
+	}
+
+	unityArray.Release();
+	dispatcher.DeliverMessages(); //the UnityArray is unretained once the messages referencing it are delivered
+	UnityMessager::DeleteInstance();
+}
+
+//------------------ named routes
+
+UM_DECLARE_COMPONENT(RouteComponent)
+
+#define ROUTES_N_OF_FRAMES 10
+#define ROUTES_MESSAGES_PER_FRAME 50
+#define ROUTES_N_OF_KINDS 5
+#define ROUTES_ARRAY_LENGTH 8
+#define ROUTES_WORKER_TAG 1
+
+//Sends the seq-th routed message, each kind addressed by names in a different way. The routes are static, so their cached
+//binding ids are kept from the previous UnityMessager instances, which must be detected as stale.
+static void SendRoutedMessage(int receiverId, const UnityArray<int>& unityArray, int producerTag, int seq)
+{
+	static const UnityMessager::NamedRoute c_objectAndMethodRoute("Player", "SetSpeed");
+	static const UnityMessager::NamedRoute c_objectRoute("Player", 7);
+	static const UnityMessager::NamedRoute c_methodRoute("SetSpeed");
+
+	int array[ROUTES_ARRAY_LENGTH];
+	for (int i = 0; i < ROUTES_ARRAY_LENGTH; ++i)
+		array[i] = seq + i;
+
+	switch (seq % ROUTES_N_OF_KINDS)
+	{
+	case 0:
+		UNITY_MESSAGER.SendMessage<RouteComponent>(c_objectAndMethodRoute, producerTag, seq, seq * 0.5f);
+		break;
+	case 1:
+		UNITY_MESSAGER.SendMessage<RouteComponent>(c_objectRoute, producerTag, seq, "label");
+		break;
+	case 2:
+		UNITY_MESSAGER.SendMessage<RouteComponent>(receiverId, c_methodRoute, producerTag, seq, UM_ARRAY_PARAM(array, ROUTES_ARRAY_LENGTH));
+		break;
+	case 3:
+		UNITY_MESSAGER.SendMessage<RouteComponent>("Player", "SetSpeed", producerTag, seq, seq * 0.5f);
+		break;
+	default: //the UnityArrayParam shares the int queue, so it is registered param by param, through the binding anyway
+		UNITY_MESSAGER.SendMessage<RouteComponent>(c_objectAndMethodRoute, producerTag, seq, UM_UNITY_ARRAY_PARAM(unityArray),
+												   UM_ARRAY_PARAM(array, ROUTES_ARRAY_LENGTH));
+		break;
+	}
+}
+
+//Checks each routed message is delivered to the component with its names, in the sending order
+class RoutesReceiver : public UnityMessagerDispatcher::Receiver
+{
+public:
+	RoutesReceiver(int receiverId) : m_receiverId(receiverId) {}
+
+	void StartFrame() { m_delivered.clear(); }
+	const std::vector<SequenceEntry>& GetDelivered() const { return m_delivered; }
+
+	virtual void ReceiveMessage(const UnityMessagerDispatcher::Message& message)
+	{
+		CHECK(message.GetComponentTypeName() == "RouteComponent" && message.GetNOfParams() >= 3);
+		if (message.GetNOfParams() < 3)
+			return;
+
+		SequenceEntry entry = { message.GetParam<int>(0), message.GetParam<int>(1) };
+		int kind = entry.seq % ROUTES_N_OF_KINDS;
+		CHECK(message.GetObjectName() == (kind == 2 ? "" : "Player"));
+		CHECK(message.GetMethodName() == (kind == 1 ? "" : "SetSpeed"));
+		CHECK(kind == 1 ? message.GetMsgId() == 7 : message.GetMsgId() == -1);
+		CHECK(kind == 2 ? message.GetReceiverId() == m_receiverId : message.GetReceiverId() == -1);
+
+		int length;
+		const int* pArray;
+		switch (kind)
+		{
+		case 0:
+		case 3:
+			CHECK(message.GetNOfParams() == 3 && message.GetParam<float>(2) == entry.seq * 0.5f);
+			break;
+		case 1:
+			CHECK(message.GetNOfParams() == 3 && message.GetStringParam(2) == "label");
+			break;
+		case 2:
+			pArray = message.GetArrayParam<int>(2, length);
+			CHECK(message.GetNOfParams() == 3 && pArray && length == ROUTES_ARRAY_LENGTH && pArray[length - 1] == entry.seq + length - 1);
+			break;
+		default:
+			CHECK(message.GetNOfParams() == 4);
+			pArray = message.GetArrayParam<int>(2, length);
+			CHECK(pArray && length == ROUTES_ARRAY_LENGTH && pArray[length - 1] == 3 * (length - 1));
+			pArray = message.GetArrayParam<int>(3, length);
+			CHECK(pArray && length == ROUTES_ARRAY_LENGTH && pArray[length - 1] == entry.seq + length - 1);
+			break;
+		}
+
+		m_delivered.push_back(entry);
+	}
+
+private:
+	int m_receiverId;
+	std::vector<SequenceEntry> m_delivered;
+};
+
+//Messages sent by NamedRoute instances and by names get to the component with the same names, from the main thread and
+//from a worker thread, for any UnityMessager instance the routes were used before
+static void CheckNamedRoutes(int flags)
+{
+	NativeUnityAdapterStub::Arrays& arrays = NativeUnityAdapterStub::Arrays::GetInstance();
+	int controlQueueFirstArrayId = UnityMessager::InstanceAndProvideAwakeInfo(UM_CHECKS_N_OF_RECEIVER_IDS,
+																			 UM_CHECKS_QUEUE_ARRAYS_SIZE_IN_BYTES, flags);
+	int receiverId = UNITY_MESSAGER.NewReceiverId();
+
+	RoutesReceiver receiver(receiverId);
+	UnityMessagerDispatcher dispatcher(flags, controlQueueFirstArrayId, arrays);
+	dispatcher.SetDefaultReceiver(&receiver);
+
+	UnityArray<int> unityArray;
+	unityArray.Alloc(ROUTES_ARRAY_LENGTH);
+	for (int i = 0; i < ROUTES_ARRAY_LENGTH; ++i)
+		unityArray[i] = i * 3;
+
+	std::vector<SequenceEntry> expected;
+	for (int frame = 0; frame < ROUTES_N_OF_FRAMES; ++frame)
+	{
+		receiver.StartFrame();
+		expected.clear();
+		for (int seq = 0; seq < ROUTES_MESSAGES_PER_FRAME; ++seq)
+		{
+			SendRoutedMessage(receiverId, unityArray, PRODUCERS_MAIN_THREAD_TAG, seq);
+			SequenceEntry entry = { PRODUCERS_MAIN_THREAD_TAG, seq };
+			expected.push_back(entry);
+		}
+
+		//the worker thread messages are staged with the names, resolving their bindings when merged
+		std::thread workerThread([receiverId, &unityArray]() {
+			UNITY_MESSAGER.BindProducerThread(ROUTES_WORKER_TAG);
+			for (int seq = 0; seq < ROUTES_MESSAGES_PER_FRAME; ++seq)
+				SendRoutedMessage(receiverId, unityArray, ROUTES_WORKER_TAG, seq);
+		});
+		workerThread.join();
+
+		for (int seq = 0; seq < ROUTES_MESSAGES_PER_FRAME; ++seq)
+		{
+			SequenceEntry entry = { ROUTES_WORKER_TAG, seq };
+			expected.push_back(entry);
+		}
+
+		CHECK(dispatcher.DeliverMessages());
+		CHECK(receiver.GetDelivered().size() == expected.size() && receiver.GetDelivered() == expected);
+	}
+
+	unityArray.Release();
+	dispatcher.DeliverMessages(); //the UnityArray is unretained once the messages referencing it are delivered
+	UnityMessager::DeleteInstance();
+}
+
+//------------------ tracked arrays
+
+#define TRACKED_ARRAY_LENGTH 100 //not a multiple of 32, so the last bitmap word is partially used
+
+//Same as UnityAdapter.ConsumeDirtyItems at the C# side, returning the dirty items in ascending order
+static std::vector<int> ConsumeDirtyItems(int dirtyBitmapId)
+{
+	std::vector<int> dirtyItems;
+	int lengthInBytes;
+	uint32* pBitmap = reinterpret_cast<uint32*>(const_cast<uint8*>(
+		NativeUnityAdapterStub::Arrays::GetInstance().GetArray(dirtyBitmapId, lengthInBytes)));
+	if (pBitmap == NULL || pBitmap[0] == 0)
+		return dirtyItems;
+
+	for (int word = 1; word < lengthInBytes / (int)sizeof(uint32); ++word)
+	{
+		for (int bit = 0; bit < 32; ++bit)
+		{
+			if ((pBitmap[word] & (1u << bit)) != 0)
+				dirtyItems.push_back(((word - 1) << 5) + bit);
+		}
+
+		pBitmap[word] = 0;
+	}
+
+	pBitmap[0] = 0;
+	return dirtyItems;
+}
+
+static std::vector<int> ItemsRange(int first, int length)
+{
+	std::vector<int> items;
+	for (int i = first; i < first + length; ++i)
+		items.push_back(i);
+
+	return items;
+}
+
+static void CheckTrackedArray(int flags)
+{
+	TrackedUnityArray<int> trackedArray;
+	trackedArray.Alloc(TRACKED_ARRAY_LENGTH);
+	CHECK(trackedArray.GetId() >= 0 && trackedArray.GetDirtyBitmapId() >= 0 && trackedArray.GetLength() == TRACKED_ARRAY_LENGTH);
+
+	//all the items start dirty, none after being consumed
+	CHECK(ConsumeDirtyItems(trackedArray.GetDirtyBitmapId()) == ItemsRange(0, TRACKED_ARRAY_LENGTH));
+	CHECK(ConsumeDirtyItems(trackedArray.GetDirtyBitmapId()).empty());
+
+	int expectedItems[] = { 0, 31, 32, TRACKED_ARRAY_LENGTH - 1 };
+	trackedArray.Set(32, 7);
+	trackedArray.Set(0, 5);
+	trackedArray.GetForWrite(TRACKED_ARRAY_LENGTH - 1) = 9;
+	trackedArray.MarkDirty(31);
+	trackedArray.MarkDirty(32); //redundant
+	CHECK(ConsumeDirtyItems(trackedArray.GetDirtyBitmapId()) == std::vector<int>(expectedItems, expectedItems + 4));
+	CHECK(trackedArray[0] == 5 && trackedArray.Get(32) == 7 && trackedArray.GetArray()[TRACKED_ARRAY_LENGTH - 1] == 9);
+
+	//ranges within a single word, across two words, covering whole words and up to the last item
+	int ranges[][2] = { { 3, 5 }, { 0, 32 }, { 30, 4 }, { 20, 70 }, { 64, TRACKED_ARRAY_LENGTH - 64 }, { 50, 0 } };
+	for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); ++r)
+	{
+		trackedArray.MarkDirtyRange(ranges[r][0], ranges[r][1]);
+		CHECK(ConsumeDirtyItems(trackedArray.GetDirtyBitmapId()) == ItemsRange(ranges[r][0], ranges[r][1]));
+	}
+
+	trackedArray.MarkAllDirty();
+	CHECK(ConsumeDirtyItems(trackedArray.GetDirtyBitmapId()) == ItemsRange(0, TRACKED_ARRAY_LENGTH));
+
+	//released together with its dirty bitmap, and it can be allocated again
+	trackedArray.Release();
+	CHECK(trackedArray.GetId() < 0 && trackedArray.GetDirtyBitmapId() < 0);
+	trackedArray.Alloc(1);
+	CHECK(ConsumeDirtyItems(trackedArray.GetDirtyBitmapId()) == ItemsRange(0, 1));
+	trackedArray.Release();
+}
+
+//------------------ asynchronous file reads
+
+#define FILE_READS_FILE_PATH "UnityForCppChecks_file_reads.tmp"
+#define FILE_READS_MISSING_FILE_PATH "UnityForCppChecks_missing_file.tmp"
+#define FILE_READS_FILE_LENGTH 5000
+
+//Writes a file with pseudo-random content to the working directory, returning its content
+static std::vector<uint8> WriteCheckFile(const char* fullFilePath, int length, unsigned int seed)
+{
+	std::mt19937 random(seed);
+	std::vector<uint8> content(length);
+	for (int i = 0; i < length; ++i)
+		content[i] = (uint8)random();
+
+	FILE* pFile = fopen(fullFilePath, "wb");
+	CHECK(pFile != NULL);
+	if (pFile)
+	{
+		CHECK(length == 0 || fwrite(&content[0], length, 1, pFile) == 1);
+		fclose(pFile);
+	}
+
+	return content;
+}
+
+static bool HasContent(const UnityArray<uint8>& unityArray, const std::vector<uint8>& content)
+{
+	return unityArray.GetId() >= 0 && unityArray.GetLength() == (int)content.size()
+		&& (content.empty() || memcmp(unityArray.GetPtr(), &content[0], content.size()) == 0);
+}
+
+//Completion callback records, pUserData of the reads
+struct FileReadCompletion
+{
+	int nOfCalls;
+	int requestId;
+	bool wasFound;
+	UnityArray<uint8> content; //moved from the delivered content
+	const char* fullFilePathToReadNext; //read from the callback, if not NULL
+	int nextRequestId;
+};
+
+static void OnFileReadCompleted(int requestId, UnityArray<uint8>* pContent, void* pUserData)
+{
+	FileReadCompletion& completion = *reinterpret_cast<FileReadCompletion*>(pUserData);
+	++completion.nOfCalls;
+	completion.requestId = requestId;
+	completion.wasFound = pContent != NULL;
+	if (pContent)
+		completion.content = std::move(*pContent);
+
+	//already forgotten, so new reads may be started from here
+	CHECK(UnityAdapter::GetFileReadStatus(requestId) == UA_FILE_READ_INVALID_REQUEST);
+	if (completion.fullFilePathToReadNext)
+		completion.nextRequestId = UnityAdapter::ReadFileContentAsync(completion.fullFilePathToReadNext, OnFileReadCompleted, pUserData);
+}
+
+static void CheckFileReads(int flags)
+{
+	NativeUnityAdapterStub::Arrays& arrays = NativeUnityAdapterStub::Arrays::GetInstance();
+	int nOfLiveArrays = arrays.GetNOfLiveArrays();
+	std::vector<uint8> content = WriteCheckFile(FILE_READS_FILE_PATH, FILE_READS_FILE_LENGTH, 1);
+	remove(FILE_READS_MISSING_FILE_PATH);
+
+	//completion callback, starting another read from it, which waits for the next CompleteFileReads
+	FileReadCompletion completion = { 0, 0, false, UnityArray<uint8>(), FILE_READS_FILE_PATH, 0 };
+	int requestId = UnityAdapter::ReadFileContentAsync(FILE_READS_FILE_PATH, OnFileReadCompleted, &completion);
+	CHECK(requestId != 0 && UnityAdapter::GetFileReadStatus(requestId) == UA_FILE_READ_PENDING);
+	NativeUnityAdapterStub::CompleteFileReads();
+	CHECK(completion.nOfCalls == 1 && completion.requestId == requestId && completion.wasFound);
+	CHECK(HasContent(completion.content, content));
+	CHECK(completion.nextRequestId != 0 && completion.nextRequestId != requestId);
+	CHECK(UnityAdapter::GetFileReadStatus(completion.nextRequestId) == UA_FILE_READ_PENDING);
+
+	completion.content.Release();
+	completion.fullFilePathToReadNext = NULL;
+	NativeUnityAdapterStub::CompleteFileReads();
+	CHECK(completion.nOfCalls == 2 && completion.requestId == completion.nextRequestId && HasContent(completion.content, content));
+	completion.content.Release();
+
+	//completion callback of a missing file
+	completion.nOfCalls = 0;
+	requestId = UnityAdapter::ReadFileContentAsync(FILE_READS_MISSING_FILE_PATH, OnFileReadCompleted, &completion);
+	NativeUnityAdapterStub::CompleteFileReads();
+	CHECK(completion.nOfCalls == 1 && completion.requestId == requestId && !completion.wasFound && completion.content.GetId() < 0);
+
+	//polling, the request is forgotten once it is taken
+	UnityArray<uint8> takenContent;
+	requestId = UnityAdapter::ReadFileContentAsync(FILE_READS_FILE_PATH);
+	CHECK(!UnityAdapter::TakeFileReadContent(requestId, &takenContent) && takenContent.GetId() < 0);
+	CHECK(UnityAdapter::GetFileReadStatus(requestId) == UA_FILE_READ_PENDING);
+	NativeUnityAdapterStub::CompleteFileReads();
+	CHECK(UnityAdapter::GetFileReadStatus(requestId) == UA_FILE_READ_DONE);
+	CHECK(UnityAdapter::TakeFileReadContent(requestId, &takenContent) && HasContent(takenContent, content));
+	CHECK(UnityAdapter::GetFileReadStatus(requestId) == UA_FILE_READ_INVALID_REQUEST);
+	takenContent.Release();
+	CHECK(!UnityAdapter::TakeFileReadContent(requestId, &takenContent) && takenContent.GetId() < 0);
+
+	//polling a missing file
+	requestId = UnityAdapter::ReadFileContentAsync(FILE_READS_MISSING_FILE_PATH);
+	NativeUnityAdapterStub::CompleteFileReads();
+	CHECK(UnityAdapter::GetFileReadStatus(requestId) == UA_FILE_READ_NOT_FOUND);
+	CHECK(!UnityAdapter::TakeFileReadContent(requestId, &takenContent) && takenContent.GetId() < 0);
+	CHECK(UnityAdapter::GetFileReadStatus(requestId) == UA_FILE_READ_INVALID_REQUEST);
+
+	//canceled while pending, the callback is not called and the content is released once delivered
+	completion.nOfCalls = 0;
+	requestId = UnityAdapter::ReadFileContentAsync(FILE_READS_FILE_PATH, OnFileReadCompleted, &completion);
+	int polledRequestId = UnityAdapter::ReadFileContentAsync(FILE_READS_FILE_PATH);
+	UnityAdapter::CancelFileRead(requestId);
+	UnityAdapter::CancelFileRead(polledRequestId);
+	CHECK(UnityAdapter::GetFileReadStatus(requestId) == UA_FILE_READ_INVALID_REQUEST);
+	CHECK(UnityAdapter::GetFileReadStatus(polledRequestId) == UA_FILE_READ_INVALID_REQUEST);
+	NativeUnityAdapterStub::CompleteFileReads();
+	CHECK(completion.nOfCalls == 0 && arrays.GetNOfLiveArrays() == nOfLiveArrays);
+
+	//canceled after being completed, the content is released right away
+	requestId = UnityAdapter::ReadFileContentAsync(FILE_READS_FILE_PATH);
+	NativeUnityAdapterStub::CompleteFileReads();
+	CHECK(UnityAdapter::GetFileReadStatus(requestId) == UA_FILE_READ_DONE && arrays.GetNOfLiveArrays() == nOfLiveArrays + 1);
+	UnityAdapter::CancelFileRead(requestId);
+	CHECK(UnityAdapter::GetFileReadStatus(requestId) == UA_FILE_READ_INVALID_REQUEST);
+	CHECK(arrays.GetNOfLiveArrays() == nOfLiveArrays);
+
+	//unknown request ids
+	UnityAdapter::CancelFileRead(requestId);
+	CHECK(UnityAdapter::GetFileReadStatus(0) == UA_FILE_READ_INVALID_REQUEST);
+
+	remove(FILE_READS_FILE_PATH);
+}
+
+//------------------ file stream reader
+
+#define STREAM_FILE_PATH "UnityForCppChecks_stream.tmp"
+#define STREAM_OTHER_FILE_PATH "UnityForCppChecks_other_stream.tmp"
+#define STREAM_CHUNK_SIZE 256
+#define STREAM_N_OF_CHUNKS 4
+#define STREAM_FILE_LENGTH (10 * STREAM_CHUNK_SIZE + 123)
+#define STREAM_MAX_N_OF_FRAMES 1000
+
+//The reads in flight MUST NOT write to the same window bytes, otherwise a chunk was requested again before its previous read
+//completed, and the late bytes of that read would overwrite the new ones
+static void CheckPendingReadsAreDisjoint(int windowId)
+{
+	std::vector<NativeUnityAdapterStub::PendingFileRead>& fileReads = NativeUnityAdapterStub::GetPendingFileReads();
+	for (size_t i = 0; i < fileReads.size(); ++i)
+	{
+		for (size_t j = i + 1; j < fileReads.size(); ++j)
+		{
+			CHECK(fileReads[i].destArrayId != windowId || fileReads[j].destArrayId != windowId
+				  || fileReads[i].destOffset + fileReads[i].length <= fileReads[j].destOffset
+				  || fileReads[j].destOffset + fileReads[j].length <= fileReads[i].destOffset);
+		}
+	}
+}
+
+//Completes the reads frame by frame, as the C# UnityAdapter Update, reading the stream by GetNextChunk (byChunks) or by Read,
+//the latter crossing chunk boundaries, until the end or the failure of the stream. Returns the bytes read.
+static std::vector<uint8> ReadStreamToEnd(UnityFileStreamReader& reader, int windowId, bool byChunks)
+{
+	static const int c_readLengths[] = { 1, 37, STREAM_CHUNK_SIZE - 1, STREAM_CHUNK_SIZE, STREAM_CHUNK_SIZE + 1, 3 * STREAM_CHUNK_SIZE };
+	std::vector<uint8> bytes;
+	std::vector<uint8> readBuffer(3 * STREAM_CHUNK_SIZE);
+	int64 startPosition = reader.GetPosition();
+	int nOfReads = 0;
+	for (int frame = 0; frame < STREAM_MAX_N_OF_FRAMES && !reader.IsAtEnd() && !reader.HasFailed(); ++frame)
+	{
+		NativeUnityAdapterStub::CompleteFileReads();
+		CheckPendingReadsAreDisjoint(windowId);
+		if (byChunks)
+		{
+			int length;
+			const uint8* pChunk;
+			while ((pChunk = reader.GetNextChunk(length)) != NULL)
+			{
+				CHECK(length > 0 && length <= STREAM_CHUNK_SIZE);
+				bytes.insert(bytes.end(), pChunk, pChunk + length);
+			}
+
+			CHECK(length == 0);
+		}
+		else
+		{
+			int readLength = c_readLengths[nOfReads++ % (sizeof(c_readLengths) / sizeof(int))];
+			int nOfBytesRead;
+			while ((nOfBytesRead = reader.Read(&readBuffer[0], readLength)) > 0)
+			{
+				CHECK(nOfBytesRead <= readLength);
+				bytes.insert(bytes.end(), readBuffer.begin(), readBuffer.begin() + nOfBytesRead);
+				readLength = c_readLengths[nOfReads++ % (sizeof(c_readLengths) / sizeof(int))];
+			}
+		}
+
+		CheckPendingReadsAreDisjoint(windowId);
+		CHECK(reader.GetPosition() == startPosition + (int64)bytes.size());
+	}
+
+	return bytes;
+}
+
+static std::vector<uint8> Bytes(const std::vector<uint8>& content, int64 first)
+{
+	return std::vector<uint8>(content.begin() + (size_t)first, content.end());
+}
+
+static void CheckFileStreamReader(int flags)
+{
+	NativeUnityAdapterStub::Arrays& arrays = NativeUnityAdapterStub::Arrays::GetInstance();
+	int nOfLiveArrays = arrays.GetNOfLiveArrays();
+	std::vector<uint8> content = WriteCheckFile(STREAM_FILE_PATH, STREAM_FILE_LENGTH, 2);
+	std::vector<uint8> otherContent = WriteCheckFile(STREAM_OTHER_FILE_PATH, STREAM_FILE_LENGTH / 2, 3);
+	remove(FILE_READS_MISSING_FILE_PATH);
+
+	UnityArray<uint8> window;
+	window.Alloc(STREAM_N_OF_CHUNKS * STREAM_CHUNK_SIZE + STREAM_N_OF_CHUNKS - 1); //the remaining bytes are not used
+	{
+		UnityFileStreamReader reader(&window, STREAM_N_OF_CHUNKS);
+
+		//nothing is returned until the first reads complete
+		reader.Open(STREAM_FILE_PATH);
+		int length;
+		CHECK(reader.IsOpen() && reader.IsWaiting() && reader.GetNextChunk(length) == NULL && length == 0);
+		CHECK(reader.GetFileLength() == -1);
+		CHECK((int)NativeUnityAdapterStub::GetPendingFileReads().size() == STREAM_N_OF_CHUNKS);
+		CHECK(ReadStreamToEnd(reader, window.GetId(), true) == content);
+		CHECK(reader.IsAtEnd() && !reader.IsWaiting() && reader.GetFileLength() == STREAM_FILE_LENGTH);
+		CHECK(reader.GetNextChunk(length) == NULL && length == 0);
+
+		//reading across chunk boundaries, reopening the same file
+		reader.Open(STREAM_FILE_PATH);
+		CHECK(ReadStreamToEnd(reader, window.GetId(), false) == content);
+		CHECK(reader.IsAtEnd() && reader.GetPosition() == STREAM_FILE_LENGTH);
+		char byte;
+		CHECK(reader.Read(&byte, 1) == 0);
+
+		//forward seek within the chunks read ahead, the bytes are there already
+		reader.Open(STREAM_FILE_PATH);
+		NativeUnityAdapterStub::CompleteFileReads();
+		int64 position = 2 * STREAM_CHUNK_SIZE + 10;
+		reader.Seek(position);
+		CheckPendingReadsAreDisjoint(window.GetId());
+		const uint8* pChunk = reader.GetNextChunk(length);
+		CHECK(pChunk != NULL && length == STREAM_CHUNK_SIZE - 10);
+		CHECK(pChunk && memcmp(pChunk, &content[(size_t)position], length) == 0);
+		CHECK(ReadStreamToEnd(reader, window.GetId(), true) == Bytes(content, position + length));
+
+		//backward seek, reading restarts from there
+		position = 50;
+		reader.Seek(position);
+		CHECK(reader.GetPosition() == position && reader.IsWaiting() && reader.GetNextChunk(length) == NULL);
+		CHECK(ReadStreamToEnd(reader, window.GetId(), false) == Bytes(content, position));
+
+		//seek past the end, with the file length known and before knowing it
+		reader.Seek(STREAM_FILE_LENGTH + 1000);
+		CHECK(reader.IsAtEnd() && !reader.IsWaiting() && reader.GetNextChunk(length) == NULL && reader.Read(&byte, 1) == 0);
+		CHECK(NativeUnityAdapterStub::GetPendingFileReads().empty());
+		position = STREAM_FILE_LENGTH - 10;
+		reader.Seek(position);
+		CHECK(ReadStreamToEnd(reader, window.GetId(), true) == Bytes(content, position));
+
+		reader.Open(STREAM_FILE_PATH);
+		reader.Seek(STREAM_FILE_LENGTH + 1000);
+		CheckPendingReadsAreDisjoint(window.GetId());
+		CHECK(ReadStreamToEnd(reader, window.GetId(), true).empty());
+		CHECK(reader.IsAtEnd() && reader.GetFileLength() == STREAM_FILE_LENGTH);
+
+		//closed with reads in flight, their chunks are only read again once these reads complete
+		reader.Open(STREAM_FILE_PATH);
+		reader.Close();
+		CHECK(!reader.IsOpen() && !reader.IsWaiting() && reader.GetNextChunk(length) == NULL);
+		reader.Open(STREAM_OTHER_FILE_PATH);
+		CHECK((int)NativeUnityAdapterStub::GetPendingFileReads().size() == STREAM_N_OF_CHUNKS); //only the discarded ones
+		CheckPendingReadsAreDisjoint(window.GetId());
+		CHECK(ReadStreamToEnd(reader, window.GetId(), false) == otherContent);
+
+		//seek with reads in flight, as closing
+		reader.Open(STREAM_FILE_PATH);
+		reader.Seek(3 * STREAM_CHUNK_SIZE + 5);
+		reader.Seek(1);
+		CheckPendingReadsAreDisjoint(window.GetId());
+		CHECK(ReadStreamToEnd(reader, window.GetId(), true) == Bytes(content, 1));
+
+		//missing file, the failure is reported as an error log
+		reader.Open(FILE_READS_MISSING_FILE_PATH);
+		CHECK(ReadStreamToEnd(reader, window.GetId(), true).empty());
+		CHECK(reader.HasFailed() && !reader.IsWaiting() && !reader.IsAtEnd());
+		CHECK(reader.GetNextChunk(length) == NULL && reader.Read(&byte, 1) == 0);
+		reader.Open(STREAM_OTHER_FILE_PATH);
+		CHECK(!reader.HasFailed() && ReadStreamToEnd(reader, window.GetId(), false) == otherContent);
+
+		//destroyed with reads in flight, their completions must not get to it
+		reader.Open(STREAM_FILE_PATH);
+	}
+
+	NativeUnityAdapterStub::CompleteFileReads();
+	CHECK(NativeUnityAdapterStub::GetPendingFileReads().empty());
+	window.Release();
+	CHECK(arrays.GetNOfLiveArrays() == nOfLiveArrays);
+
+	remove(STREAM_FILE_PATH);
+	remove(STREAM_OTHER_FILE_PATH);
+}
+
+//------------------ receiver ids released concurrently
+
+#define RECEIVER_IDS_N_OF_THREADS 4
+#define RECEIVER_IDS_N_OF_IDS (3 * UM_RECEIVER_IDS_CHUNK_LENGTH + 4 * RECEIVER_IDS_N_OF_THREADS) //multiple of the threads
+
+static std::atomic<int> f_nOfLogs(0);
+
+//Counts the warnings and errors instead of printing them, for the checks expecting many of them
+static void CountLog(int logType, const char* str)
+{
+	++f_nOfLogs;
+}
+
+//Runs fc(threadIdx) on nOfThreads threads, starting them together as much as possible so their operations overlap
+template <typename FC>
+static void RunOnThreads(int nOfThreads, FC fc)
+{
+	std::atomic<int> nOfStarted(0);
+	std::vector<std::thread> threads;
+	for (int i = 0; i < nOfThreads; ++i)
+	{
+		threads.push_back(std::thread([&nOfStarted, &fc, nOfThreads, i]() {
+			++nOfStarted;
+			while (nOfStarted.load() < nOfThreads)
+				std::this_thread::yield();
+			fc(i);
+		}));
+	}
+
+	for (size_t i = 0; i < threads.size(); ++i)
+		threads[i].join();
+}
+
+//Records the (receiverId, msgId) of the delivered messages
+class MessageLog : public UnityMessagerDispatcher::Receiver
+{
+public:
+	std::vector<std::pair<int, int>> delivered;
+
+	virtual void ReceiveMessage(const UnityMessagerDispatcher::Message& message)
+	{
+		delivered.push_back(std::make_pair(message.GetReceiverId(), message.GetMsgId()));
+	}
+};
+
+static int CountDistinctIndexes(const std::vector<int>& receiverIds)
+{
+	std::vector<bool> isUsed(UM_MAX_N_OF_RECEIVER_IDS, false);
+	int nOfDistinct = 0;
+	for (size_t i = 0; i < receiverIds.size(); ++i)
+	{
+		if (receiverIds[i] <= 0 || isUsed[UM_RECEIVER_ID_INDEX(receiverIds[i])])
+			continue;
+
+		isUsed[UM_RECEIVER_ID_INDEX(receiverIds[i])] = true;
+		++nOfDistinct;
+	}
+
+	return nOfDistinct;
+}
+
+//More ids than a chunk of the table given by worker threads, each id released by two threads at the same time (as the
+//C++ and the C# sides may do), which must release it only once, so the free list never gets a slot twice
+static void CheckReceiverIdsReleases(int flags)
+{
+	NativeUnityAdapterStub::Arrays& arrays = NativeUnityAdapterStub::Arrays::GetInstance();
+	int controlQueueFirstArrayId = UnityMessager::InstanceAndProvideAwakeInfo(UM_CHECKS_N_OF_RECEIVER_IDS,
+																			 UM_CHECKS_QUEUE_ARRAYS_SIZE_IN_BYTES, flags);
+	UnityMessagerDispatcher dispatcher(flags, controlQueueFirstArrayId, arrays);
+	UnityAdapter::Internals::SetOutputDebugStrFcPtr(CountLog);
+	f_nOfLogs = 0;
+
+	//worker threads don't grow the table
+	UNITY_MESSAGER.ReserveReceiverIds(RECEIVER_IDS_N_OF_IDS);
+	std::vector<int> ids[RECEIVER_IDS_N_OF_THREADS];
+	RunOnThreads(RECEIVER_IDS_N_OF_THREADS, [&ids](int threadIdx) {
+		for (int i = 0; i < RECEIVER_IDS_N_OF_IDS / RECEIVER_IDS_N_OF_THREADS; ++i)
+			ids[threadIdx].push_back(UNITY_MESSAGER.NewReceiverId());
+	});
+
+	std::vector<int> oldIds;
+	for (int t = 0; t < RECEIVER_IDS_N_OF_THREADS; ++t)
+		oldIds.insert(oldIds.end(), ids[t].begin(), ids[t].end());
+
+	CHECK(CountDistinctIndexes(oldIds) == RECEIVER_IDS_N_OF_IDS && f_nOfLogs == 0);
+
+	//all the threads release each id at the same time, waiting for each other before each release
+	std::vector<std::atomic<int>> nOfReleasesPerId(RECEIVER_IDS_N_OF_IDS);
+	std::atomic<int> nOfArrivals(0);
+	RunOnThreads(RECEIVER_IDS_N_OF_THREADS, [&oldIds, &nOfReleasesPerId, &nOfArrivals](int threadIdx) {
+		for (int i = 0; i < RECEIVER_IDS_N_OF_IDS; ++i)
+		{
+			++nOfArrivals;
+			while (nOfArrivals.load() < (i + 1) * RECEIVER_IDS_N_OF_THREADS)
+				std::this_thread::yield();
+			nOfReleasesPerId[i] += UNITY_MESSAGER.ReleaseReceiverId(oldIds[i]) ? 1 : 0;
+		}
+	});
+
+	int nOfWrongReleases = 0;
+	for (int i = 0; i < RECEIVER_IDS_N_OF_IDS; ++i)
+		nOfWrongReleases += nOfReleasesPerId[i] != 1 ? 1 : 0;
+
+	CHECK(nOfWrongReleases == 0);
+	CHECK(f_nOfLogs == (RECEIVER_IDS_N_OF_THREADS - 1) * RECEIVER_IDS_N_OF_IDS); //a warning for each release not done
+
+	//all the slots are given again, once each, with new ids
+	std::vector<int> newIds[RECEIVER_IDS_N_OF_THREADS];
+	RunOnThreads(RECEIVER_IDS_N_OF_THREADS, [&newIds](int threadIdx) {
+		for (int i = 0; i < RECEIVER_IDS_N_OF_IDS / RECEIVER_IDS_N_OF_THREADS; ++i)
+			newIds[threadIdx].push_back(UNITY_MESSAGER.NewReceiverId());
+	});
+
+	std::vector<int> allNewIds;
+	for (int t = 0; t < RECEIVER_IDS_N_OF_THREADS; ++t)
+		allNewIds.insert(allNewIds.end(), newIds[t].begin(), newIds[t].end());
+
+	std::vector<int> oldAndNewIds(oldIds);
+	oldAndNewIds.insert(oldAndNewIds.end(), allNewIds.begin(), allNewIds.end());
+	std::sort(oldAndNewIds.begin(), oldAndNewIds.end());
+	CHECK(CountDistinctIndexes(allNewIds) == RECEIVER_IDS_N_OF_IDS);
+	CHECK(std::unique(oldAndNewIds.begin(), oldAndNewIds.end()) == oldAndNewIds.end());
+
+	//stale ids are rejected, while the current ids of the same slots are released at the same time
+	f_nOfLogs = 0;
+	std::atomic<int> nOfStaleReleases(0), nOfReleases(0);
+	RunOnThreads(RECEIVER_IDS_N_OF_THREADS, [&oldIds, &allNewIds, &nOfStaleReleases, &nOfReleases](int threadIdx) {
+		const std::vector<int>& toRelease = threadIdx % 2 == 0 ? oldIds : allNewIds;
+		std::atomic<int>& nOfReleased = threadIdx % 2 == 0 ? nOfStaleReleases : nOfReleases;
+		for (size_t i = threadIdx / 2; i < toRelease.size(); i += RECEIVER_IDS_N_OF_THREADS / 2)
+			nOfReleased += UNITY_MESSAGER.ReleaseReceiverId(toRelease[i]) ? 1 : 0;
+	});
+
+	CHECK(nOfStaleReleases == 0 && nOfReleases == RECEIVER_IDS_N_OF_IDS && f_nOfLogs == RECEIVER_IDS_N_OF_IDS);
+
+	//messages to a stale id don't get to the receiver of the current id of its slot
+	int staleId = UNITY_MESSAGER.NewReceiverId();
+	CHECK(UNITY_MESSAGER.ReleaseReceiverId(staleId));
+	int receiverId = UNITY_MESSAGER.NewReceiverId();
+	CHECK(UM_RECEIVER_ID_INDEX(receiverId) == UM_RECEIVER_ID_INDEX(staleId) && receiverId != staleId);
+	CHECK(!UNITY_MESSAGER.ReleaseReceiverId(staleId));
+
+	MessageLog log;
+	dispatcher.SetReceiver(receiverId, &log);
+	UNITY_MESSAGER.SendMessage(staleId, 1);
+	UNITY_MESSAGER.SendMessage(receiverId, 2);
+	CHECK(dispatcher.DeliverMessages());
+	CHECK(log.delivered.size() == 1 && log.delivered[0] == std::make_pair(receiverId, 2));
+
+	UnityAdapter::Internals::SetOutputDebugStrFcPtr(NativeUnityAdapterStub::OutputDebugStr);
+	UnityMessager::DeleteInstance();
+}
+
+//------------------ ring producer and consumer
+
+#define RING_N_OF_MESSAGES 20000
+#define RING_MAX_ARRAY_LENGTH 100 //records up to 432 bytes, so the ring wraps at many positions
+
+#define RING_MSG_LONGEST 1
+#define RING_MSG_VALUES 2
+
+//Reads the parameter header at pos checking its item size, returning the position of its items and advancing pos past them
+static int ReadRingParam(const uint8* pRecord, int& pos, int itemSize, int& length, bool& isValid)
+{
+	int recordItemSize;
+	memcpy(&recordItemSize, pRecord + pos, sizeof(int));
+	memcpy(&length, pRecord + pos + sizeof(int), sizeof(int));
+	isValid = isValid && recordItemSize == itemSize;
+
+	//the alignment of the items as done by UnityMessager.RingReader on C#
+	int alignment = itemSize & -itemSize;
+	alignment = alignment < 8 ? alignment : 8;
+	int itemsPos = (pos + UMR_PARAM_HEADER_SIZE + alignment - 1) & ~(alignment - 1);
+	pos = itemsPos + itemSize * (length >= 0 ? length : 1);
+	return itemsPos;
+}
+
+//Plays the UnityMessager.RingReader on C#, reading the ring records on its own thread and checking their content
+class RingConsumer
+{
+public:
+	std::atomic<int> nOfInvalidRecords;
+	int nOfPaddingRecords;
+	int nOfMessages;
+
+	RingConsumer(uint8* pRingArray, int capacityInBytes)
+		: nOfInvalidRecords(0), nOfPaddingRecords(0), nOfMessages(0), m_pHeader(reinterpret_cast<int64*>(pRingArray)),
+		  m_pData(pRingArray + UMR_DATA_START_IDX * sizeof(int64)), m_capacityInBytes(capacityInBytes) {}
+
+	//Reads until getting the RING_MSG_VALUES message of the last sequence number, or until the producer is done with nothing
+	//more to read, when the records are not valid
+	void Run(const std::atomic<bool>& isProducerDone)
+	{
+		std::atomic<int64>& head = *reinterpret_cast<std::atomic<int64>*>(m_pHeader + UMR_HEAD_IDX);
+		std::atomic<int64>& tail = *reinterpret_cast<std::atomic<int64>*>(m_pHeader + UMR_TAIL_IDX);
+		int64 tailPos = tail.load(std::memory_order_relaxed);
+		bool isDone = false;
+		int seq = 0;
+		while (!isDone)
+		{
+			bool wasProducerDone = isProducerDone.load();
+			int64 headPos = head.load(std::memory_order_acquire);
+			if (headPos == tailPos)
+			{
+				isDone = wasProducerDone;
+				std::this_thread::yield();
+				continue;
+			}
+
+			while (tailPos < headPos && !isDone)
+			{
+				int pos = (int)(tailPos & (m_capacityInBytes - 1));
+				int header[4]; //(recordLength, receiverId, msgId, nOfParams)
+				memcpy(header, m_pData + pos, sizeof(header));
+				if (header[0] <= 0 || header[0] % UMR_RECORD_ALIGNMENT != 0 || pos + header[0] > m_capacityInBytes)
+				{
+					++nOfInvalidRecords; //the next records can't be found, skipping all the written ones
+					tailPos = headPos;
+					break;
+				}
+
+				if (header[3] == UMR_PADDING_RECORD)
+				{
+					nOfPaddingRecords += pos + header[0] == m_capacityInBytes ? 1 : 0;
+					nOfInvalidRecords += pos + header[0] == m_capacityInBytes ? 0 : 1;
+				}
+				else
+				{
+					nOfInvalidRecords += IsValidRecord(m_pData + pos, header, seq) ? 0 : 1;
+					isDone = header[2] == RING_MSG_VALUES && seq++ == RING_N_OF_MESSAGES - 1;
+					++nOfMessages;
+				}
+
+				tailPos += header[0];
+			}
+
+			//releasing the tail only after reading the records, since the producer overwrites them after acquiring it
+			tail.store(tailPos, std::memory_order_release);
+		}
+	}
+
+private:
+	bool IsValidRecord(const uint8* pRecord, const int* header, int expectedSeq)
+	{
+		bool isValid = true;
+		int pos = UMR_RECORD_HEADER_SIZE;
+		int length;
+		if (header[2] == RING_MSG_LONGEST)
+		{
+			ReadRingParam(pRecord, pos, sizeof(uint8), length, isValid);
+			return isValid && header[3] == 1 && length == m_capacityInBytes / 2 - UMR_RECORD_HEADER_SIZE - UMR_PARAM_HEADER_SIZE;
+		}
+
+		//(int seq, int[] values, double), seq being the receiver id as well
+		int seq;
+		memcpy(&seq, pRecord + ReadRingParam(pRecord, pos, sizeof(int), length, isValid), sizeof(int));
+		isValid = isValid && header[2] == RING_MSG_VALUES && header[3] == 3 && length == -1 && seq == expectedSeq && header[1] == seq;
+
+		const uint8* pValues = pRecord + ReadRingParam(pRecord, pos, sizeof(int), length, isValid);
+		isValid = isValid && length == seq % (RING_MAX_ARRAY_LENGTH + 1);
+		for (int i = 0; isValid && i < length; ++i)
+		{
+			int value;
+			memcpy(&value, pValues + i * sizeof(int), sizeof(int));
+			isValid = value == seq + i;
+		}
+
+		double value;
+		memcpy(&value, pRecord + ReadRingParam(pRecord, pos, sizeof(double), length, isValid), sizeof(double));
+		return isValid && length == -1 && value == seq * 0.5 && AlignPos(pos, UMR_RECORD_ALIGNMENT) == header[0];
+	}
+
+	static int AlignPos(int pos, int alignment) { return (pos + alignment - 1) & ~(alignment - 1); }
+
+	int64* m_pHeader;
+	uint8* m_pData;
+	int m_capacityInBytes;
+};
+
+static bool TryWriteRingValues(UnityMessagerRing& ring, int seq, std::vector<int>& values)
+{
+	int length = seq % (RING_MAX_ARRAY_LENGTH + 1);
+	for (int i = 0; i < length; ++i)
+		values[i] = seq + i;
+
+	return ring.TryWriteMessage(seq, RING_MSG_VALUES, seq, UM_ARRAY_PARAM(&values[0], length), seq * 0.5);
+}
+
+//A producer thread writing to the smallest ring while a consumer thread reads it, the ring getting full and wrapping around
+//with padding records many times, plus the messages too long for it
+static void CheckRingProducerConsumer(int flags)
+{
+	UnityMessager::InstanceAndProvideAwakeInfo(UM_CHECKS_N_OF_RECEIVER_IDS, UM_CHECKS_QUEUE_ARRAYS_SIZE_IN_BYTES, flags);
+	UnityMessagerRing& ring = UNITY_MESSAGER.GetRing(UMR_MIN_CAPACITY_IN_BYTES);
+	int capacityInBytes = ring.GetCapacityInBytes();
+	CHECK(capacityInBytes == UMR_MIN_CAPACITY_IN_BYTES && ring.GetUsedBytes() == 0);
+
+	//messages longer than half the capacity are rejected even by an empty ring, the longest one fits
+	UnityAdapter::Internals::SetOutputDebugStrFcPtr(CountLog);
+	f_nOfLogs = 0;
+	std::vector<uint8> bytes(capacityInBytes / 2, 1);
+	int longestLength = capacityInBytes / 2 - UMR_RECORD_HEADER_SIZE - UMR_PARAM_HEADER_SIZE;
+	CHECK(!ring.TryWriteMessage(0, RING_MSG_LONGEST, UM_ARRAY_PARAM(&bytes[0], longestLength + 1)));
+	CHECK(ring.GetUsedBytes() == 0 && f_nOfLogs == 1);
+	CHECK(ring.TryWriteMessage(0, RING_MSG_LONGEST, UM_ARRAY_PARAM(&bytes[0], longestLength)));
+	CHECK(ring.GetUsedBytes() == capacityInBytes / 2 && f_nOfLogs == 1);
+	UnityAdapter::Internals::SetOutputDebugStrFcPtr(NativeUnityAdapterStub::OutputDebugStr);
+
+	//a full ring rejects the messages until the consumer reads them, without writing anything
+	std::vector<int> values(RING_MAX_ARRAY_LENGTH);
+	int seq = 0;
+	while (seq < RING_N_OF_MESSAGES && TryWriteRingValues(ring, seq, values))
+		++seq;
+
+	int usedBytes = ring.GetUsedBytes();
+	CHECK(seq > 0 && usedBytes <= capacityInBytes && usedBytes > capacityInBytes - 2 * (int)sizeof(int) * RING_MAX_ARRAY_LENGTH);
+	CHECK(!TryWriteRingValues(ring, seq, values) && ring.GetUsedBytes() == usedBytes);
+
+	RingConsumer consumer(NativeUnityAdapterStub::Arrays::GetInstance().GetArrayForWrite(ring.GetArrayId()), capacityInBytes);
+	std::atomic<bool> isProducerDone(false);
+	std::thread consumerThread([&consumer, &isProducerDone]() { consumer.Run(isProducerDone); });
+	std::thread producerThread([&ring, &values, &isProducerDone, seq]() {
+		for (int i = seq; i < RING_N_OF_MESSAGES; ++i)
+		{
+			while (!TryWriteRingValues(ring, i, values))
+				std::this_thread::yield();
+		}
+
+		isProducerDone = true;
+	});
+
+	producerThread.join();
+	consumerThread.join();
+	CHECK(consumer.nOfInvalidRecords == 0 && consumer.nOfMessages == RING_N_OF_MESSAGES + 1);
+	CHECK(consumer.nOfPaddingRecords > 0 && ring.GetUsedBytes() == 0);
+
+	UnityMessager::DeleteInstance();
+}
+
+//------------------ batch messages
+
+#define BATCH_N_OF_RECEIVERS 50
+#define BATCH_N_OF_WORKER_RECEIVERS 20
+#define BATCH_N_OF_SINGLE_MESSAGES 3
+
+#define BATCH_MSG_MAIN 1 //(int, float, double, uint8, int64) columns
+#define BATCH_MSG_WORKER 2 //(int, double) columns
+#define BATCH_MSG_SINGLE 3 //(int)
+
+//Checks the columns of each batch row as it is delivered, the rows of a batch being delivered in order
+class BatchReceiver : public UnityMessagerDispatcher::Receiver
+{
+public:
+	std::vector<int> receiverIds;
+	int nOfRows[4];
+	int nOfInvalidMessages;
+
+	BatchReceiver() : receiverIds(), nOfInvalidMessages(0) { memset(nOfRows, 0, sizeof(nOfRows)); }
+
+	virtual void ReceiveMessage(const UnityMessagerDispatcher::Message& message)
+	{
+		int msgId = message.GetMsgId();
+		int row = msgId >= 0 && msgId < 4 ? nOfRows[msgId]++ : -1;
+		bool isValid = row >= 0 && row < (int)receiverIds.size() && message.GetReceiverId() == receiverIds[row];
+		if (isValid && msgId == BATCH_MSG_MAIN)
+		{
+			isValid = message.GetNOfParams() == 5 && !message.IsParamAnArray(0) && message.GetParam<int>(0) == row * 3 + 1
+				&& message.GetParam<float>(1) == row * 0.25f && message.GetParam<double>(2) == row * 1.5
+				&& message.GetParam<uint8>(3) == (uint8)(row * 7) && message.GetParam<int64>(4) == ((int64)row << 33);
+		}
+		else if (isValid && msgId == BATCH_MSG_WORKER)
+		{
+			isValid = row < BATCH_N_OF_WORKER_RECEIVERS && message.GetNOfParams() == 2 && message.GetParam<int>(0) == -row
+				&& message.GetParam<double>(1) == row * 2.0;
+		}
+		else if (isValid)
+		{
+			isValid = msgId == BATCH_MSG_SINGLE && message.GetNOfParams() == 1 && message.GetParam<int>(0) == row;
+		}
+
+		nOfInvalidMessages += isValid ? 0 : 1;
+	}
+};
+
+//Batch messages with columns of every kind of array parameter and of different types, sent from the main thread and from a
+//worker thread, each row delivered as a message and counted as one by the statistics
+static void CheckBatchMessages(int flags)
+{
+	NativeUnityAdapterStub::Arrays& arrays = NativeUnityAdapterStub::Arrays::GetInstance();
+	flags |= UM_INIT_FLAG_STATISTICS;
+	int controlQueueFirstArrayId = UnityMessager::InstanceAndProvideAwakeInfo(UM_CHECKS_N_OF_RECEIVER_IDS,
+																			 UM_CHECKS_QUEUE_ARRAYS_SIZE_IN_BYTES, flags);
+	UnityMessagerDispatcher dispatcher(flags, controlQueueFirstArrayId, arrays);
+	BatchReceiver receiver;
+	for (int i = 0; i < BATCH_N_OF_RECEIVERS; ++i)
+	{
+		receiver.receiverIds.push_back(UNITY_MESSAGER.NewReceiverId());
+		dispatcher.SetReceiver(receiver.receiverIds.back(), &receiver);
+	}
+
+	int ints[BATCH_N_OF_RECEIVERS];
+	float floats[BATCH_N_OF_RECEIVERS];
+	uint8 bytes[BATCH_N_OF_RECEIVERS];
+	UnityArray<int64> unityArray;
+	unityArray.Alloc(BATCH_N_OF_RECEIVERS);
+	for (int i = 0; i < BATCH_N_OF_RECEIVERS; ++i)
+	{
+		ints[i] = i * 3 + 1;
+		floats[i] = i * 0.25f;
+		bytes[i] = (uint8)(i * 7);
+		unityArray[i] = (int64)i << 33;
+	}
+
+	const int* receiverIds = &receiver.receiverIds[0];
+	for (int frame = 0; frame < 2; ++frame)
+	{
+		auto doubles = UM_CREATE_ARRAY_TO_FILL_PARAM(double, BATCH_N_OF_RECEIVERS);
+		UNITY_MESSAGER.SendBatchMessage(receiverIds, BATCH_N_OF_RECEIVERS, BATCH_MSG_MAIN, UM_ARRAY_PARAM(ints, BATCH_N_OF_RECEIVERS),
+										UM_ARRAY_PARAM(floats, BATCH_N_OF_RECEIVERS), doubles, UM_ARRAY_PARAM(bytes, BATCH_N_OF_RECEIVERS),
+										UM_UNITY_ARRAY_PARAM(unityArray));
+		for (int i = 0; i < BATCH_N_OF_RECEIVERS; ++i)
+			doubles[i] = i * 1.5;
+
+		std::thread worker([receiverIds]() {
+			int workerInts[BATCH_N_OF_WORKER_RECEIVERS];
+			for (int i = 0; i < BATCH_N_OF_WORKER_RECEIVERS; ++i)
+				workerInts[i] = -i;
+
+			auto workerDoubles = UM_CREATE_ARRAY_TO_FILL_PARAM(double, BATCH_N_OF_WORKER_RECEIVERS);
+			UNITY_MESSAGER.SendBatchMessage(receiverIds, BATCH_N_OF_WORKER_RECEIVERS, BATCH_MSG_WORKER,
+											UM_ARRAY_PARAM(workerInts, BATCH_N_OF_WORKER_RECEIVERS), workerDoubles);
+			for (int i = 0; i < BATCH_N_OF_WORKER_RECEIVERS; ++i)
+				workerDoubles[i] = i * 2.0;
+		});
+		worker.join();
+
+		for (int i = 0; i < BATCH_N_OF_SINGLE_MESSAGES; ++i)
+			UNITY_MESSAGER.SendMessage(receiverIds[i], BATCH_MSG_SINGLE, i);
+
+		memset(receiver.nOfRows, 0, sizeof(receiver.nOfRows));
+		CHECK(dispatcher.DeliverMessages());
+		CHECK(receiver.nOfInvalidMessages == 0 && receiver.nOfRows[BATCH_MSG_MAIN] == BATCH_N_OF_RECEIVERS);
+		CHECK(receiver.nOfRows[BATCH_MSG_WORKER] == BATCH_N_OF_WORKER_RECEIVERS);
+		CHECK(receiver.nOfRows[BATCH_MSG_SINGLE] == BATCH_N_OF_SINGLE_MESSAGES);
+
+		//each row is a message for the statistics, the batch messages themselves being the C# UnityMessager ones
+		CHECK(UNITY_MESSAGER.GetStatistic(UM_STATISTIC_DELIVERING_SERIAL) == frame + 1);
+		CHECK(UNITY_MESSAGER.GetStatistic(UM_STATISTIC_N_OF_MESSAGES)
+			  == BATCH_N_OF_RECEIVERS + BATCH_N_OF_WORKER_RECEIVERS + BATCH_N_OF_SINGLE_MESSAGES);
+		CHECK(UNITY_MESSAGER.GetStatistic(UM_STATISTIC_N_OF_CONTROL_MESSAGES) >= 2);
+		const int expectedTopMsgIds[] = { BATCH_MSG_MAIN, BATCH_N_OF_RECEIVERS, BATCH_MSG_WORKER, BATCH_N_OF_WORKER_RECEIVERS,
+										  BATCH_MSG_SINGLE, BATCH_N_OF_SINGLE_MESSAGES, -1, 0 };
+		for (int i = 0; i < (int)(sizeof(expectedTopMsgIds) / sizeof(int)); ++i)
+			CHECK(UNITY_MESSAGER.GetStatistic(UM_STATISTIC_FIRST_TOP_MSG_ID + i) == expectedTopMsgIds[i]);
+	}
+
+	unityArray.Release();
+	UnityMessager::DeleteInstance();
+}
+
+//------------------ coalesced messages
+
+#define COALESCED_N_OF_RECEIVERS 4
+
+#define COALESCED_MSG_STATE 1 //(int, float[])
+#define COALESCED_MSG_SHAPE 2 //(int), (int, double) or (float[]), changing between the sendings
+#define COALESCED_MSG_FILL 3 //(int, int[]) the array filled after sending
+#define COALESCED_MSG_WORKER 4 //(int, int[]) sent from a worker thread
+#define COALESCED_MSG_PLAIN 5 //(int) sent by SendMessage
+
+//Formats a parameter of the coalesced messages, the float ones are the ones of COALESCED_MSG_STATE and COALESCED_MSG_SHAPE
+static std::string FormatCoalescedParam(const UnityMessagerDispatcher::Message& message, int paramIdx)
+{
+	bool isFloat = message.GetMsgId() == COALESCED_MSG_STATE || message.GetMsgId() == COALESCED_MSG_SHAPE;
+	char text[32];
+	if (!message.IsParamAnArray(paramIdx))
+	{
+		if (isFloat && paramIdx == 1)
+			snprintf(text, sizeof(text), "%g", message.GetParam<double>(paramIdx));
+		else
+			snprintf(text, sizeof(text), "%d", message.GetParam<int>(paramIdx));
+
+		return text;
+	}
+
+	std::string values = "[";
+	int length;
+	const float* pFloats = isFloat ? message.GetArrayParam<float>(paramIdx, length) : NULL;
+	const int* pInts = isFloat ? NULL : message.GetArrayParam<int>(paramIdx, length);
+	for (int i = 0; (pFloats || pInts) && i < length; ++i)
+	{
+		if (pFloats)
+			snprintf(text, sizeof(text), i > 0 ? ",%g" : "%g", pFloats[i]);
+		else
+			snprintf(text, sizeof(text), i > 0 ? ",%d" : "%d", pInts[i]);
+
+		values += text;
+	}
+
+	return values + "]";
+}
+
+//Records each delivered message as "r<receiver index> m<msgId> <params...>"
+class CoalescedReceiver : public UnityMessagerDispatcher::Receiver
+{
+public:
+	std::vector<int> receiverIds;
+	std::vector<std::string> delivered;
+
+	virtual void ReceiveMessage(const UnityMessagerDispatcher::Message& message)
+	{
+		int receiverIdx = (int)(std::find(receiverIds.begin(), receiverIds.end(), message.GetReceiverId()) - receiverIds.begin());
+		std::string text = "r" + std::to_string(receiverIdx) + " m" + std::to_string(message.GetMsgId());
+		for (int i = 0; i < message.GetNOfParams(); ++i)
+			text += " " + FormatCoalescedParam(message, i);
+
+		delivered.push_back(text);
+	}
+};
+
+//Coalesced messages overwritten in place (keeping their position), discarded and sent again when their parameters don't
+//match the previous ones, overwritten through an ArrayToFillParam and sent from a worker thread (merged after the ones from
+//the main thread), a single message being delivered for each (receiverId, msgId) with the last values sent
+static void CheckCoalescedMessages(int flags)
+{
+	NativeUnityAdapterStub::Arrays& arrays = NativeUnityAdapterStub::Arrays::GetInstance();
+	int controlQueueFirstArrayId = UnityMessager::InstanceAndProvideAwakeInfo(UM_CHECKS_N_OF_RECEIVER_IDS,
+																			 UM_CHECKS_QUEUE_ARRAYS_SIZE_IN_BYTES, flags);
+	UnityMessagerDispatcher dispatcher(flags, controlQueueFirstArrayId, arrays);
+	CoalescedReceiver receiver;
+	for (int i = 0; i < COALESCED_N_OF_RECEIVERS; ++i)
+	{
+		receiver.receiverIds.push_back(UNITY_MESSAGER.NewReceiverId());
+		dispatcher.SetReceiver(receiver.receiverIds.back(), &receiver);
+	}
+
+	const int* r = &receiver.receiverIds[0];
+	const char* const expected[] = {
+		"r0 m1 4 [4,4.5,5]", //the first sending position, the last values sent by the worker thread
+		"r1 m5 100",
+		"r1 m5 101", //r1 m1 was discarded by the worker thread one
+		"r0 m2 [9,9.5,10]", //the position of the last shape change
+		"r2 m3 21 [210,211,212,213]",
+		"r3 m4 31 [310,311]",
+		"r1 m1 5 [5,5.5]",
+	};
+
+	//the coalesced messages of a delivering are not overwritten by the ones sent after it
+	for (int frame = 0; frame < 2; ++frame)
+	{
+		const float states[][3] = { { 1.0f, 1.5f, 2.0f }, { 2.0f, 2.5f, 3.0f }, { 3.0f, 3.5f, 4.0f } };
+		UNITY_MESSAGER.SendCoalescedMessage(r[0], COALESCED_MSG_STATE, 1, UM_ARRAY_PARAM(states[0], 3));
+		UNITY_MESSAGER.SendMessage(r[1], COALESCED_MSG_PLAIN, 100);
+		UNITY_MESSAGER.SendCoalescedMessage(r[1], COALESCED_MSG_STATE, 2, UM_ARRAY_PARAM(states[1], 3));
+		UNITY_MESSAGER.SendCoalescedMessage(r[0], COALESCED_MSG_STATE, 3, UM_ARRAY_PARAM(states[2], 3));
+
+		//a different number of parameters, a different type and a different array length, then a match
+		const float shapes[][3] = { { 8.0f, 8.5f }, { 6.0f, 6.5f, 7.0f }, { 9.0f, 9.5f, 10.0f } };
+		UNITY_MESSAGER.SendCoalescedMessage(r[0], COALESCED_MSG_SHAPE, 10);
+		UNITY_MESSAGER.SendCoalescedMessage(r[0], COALESCED_MSG_SHAPE, 11, 1.5);
+		UNITY_MESSAGER.SendMessage(r[1], COALESCED_MSG_PLAIN, 101);
+		UNITY_MESSAGER.SendCoalescedMessage(r[0], COALESCED_MSG_SHAPE, UM_ARRAY_PARAM(shapes[0], 2));
+		UNITY_MESSAGER.SendCoalescedMessage(r[0], COALESCED_MSG_SHAPE, UM_ARRAY_PARAM(shapes[1], 3));
+		UNITY_MESSAGER.SendCoalescedMessage(r[0], COALESCED_MSG_SHAPE, UM_ARRAY_PARAM(shapes[2], 3));
+
+		//the second array to fill points the values of the first one
+		auto firstFill = UM_CREATE_ARRAY_TO_FILL_PARAM(int, 4);
+		UNITY_MESSAGER.SendCoalescedMessage(r[2], COALESCED_MSG_FILL, 20, firstFill);
+		for (int i = 0; i < 4; ++i)
+			firstFill[i] = 200 + i;
+
+		auto secondFill = UM_CREATE_ARRAY_TO_FILL_PARAM(int, 4);
+		UNITY_MESSAGER.SendCoalescedMessage(r[2], COALESCED_MSG_FILL, 21, secondFill);
+		for (int i = 0; i < 4; ++i)
+			secondFill[i] = 210 + i;
+
+		std::thread worker([r]() {
+			const int values[][2] = { { 300, 301 }, { 310, 311 } };
+			UNITY_MESSAGER.SendCoalescedMessage(r[3], COALESCED_MSG_WORKER, 30, UM_ARRAY_PARAM(values[0], 2));
+			UNITY_MESSAGER.SendCoalescedMessage(r[3], COALESCED_MSG_WORKER, 31, UM_ARRAY_PARAM(values[1], 2));
+
+			//overwriting and discarding the ones sent from the main thread
+			const float states[][3] = { { 4.0f, 4.5f, 5.0f }, { 5.0f, 5.5f } };
+			UNITY_MESSAGER.SendCoalescedMessage(r[0], COALESCED_MSG_STATE, 4, UM_ARRAY_PARAM(states[0], 3));
+			UNITY_MESSAGER.SendCoalescedMessage(r[1], COALESCED_MSG_STATE, 5, UM_ARRAY_PARAM(states[1], 2));
+		});
+		worker.join();
+
+		receiver.delivered.clear();
+		CHECK(dispatcher.DeliverMessages());
+		CHECK(receiver.delivered == std::vector<std::string>(expected, expected + sizeof(expected) / sizeof(expected[0])));
+		CHECK(dispatcher.GetNOfMessagesDelivered() == (int)receiver.delivered.size());
+	}
+
+	UnityMessager::DeleteInstance();
+}
+
+//------------------ statistics
+
+#define STATISTICS_N_OF_TYPES 32 //besides the control queue, so the last types get queues beyond the first 32 ones
+
+//A parameter type for each queue, all of them with the same size
+template <int N> struct StatisticsItem { int value; };
+
+#define STATISTICS_ITEM_TYPE(n) UA_SUPPORTED_TYPE(StatisticsItem<n>, "StatisticsItem" #n)
+STATISTICS_ITEM_TYPE(0) STATISTICS_ITEM_TYPE(1) STATISTICS_ITEM_TYPE(2) STATISTICS_ITEM_TYPE(3)
+STATISTICS_ITEM_TYPE(4) STATISTICS_ITEM_TYPE(5) STATISTICS_ITEM_TYPE(6) STATISTICS_ITEM_TYPE(7)
+STATISTICS_ITEM_TYPE(8) STATISTICS_ITEM_TYPE(9) STATISTICS_ITEM_TYPE(10) STATISTICS_ITEM_TYPE(11)
+STATISTICS_ITEM_TYPE(12) STATISTICS_ITEM_TYPE(13) STATISTICS_ITEM_TYPE(14) STATISTICS_ITEM_TYPE(15)
+STATISTICS_ITEM_TYPE(16) STATISTICS_ITEM_TYPE(17) STATISTICS_ITEM_TYPE(18) STATISTICS_ITEM_TYPE(19)
+STATISTICS_ITEM_TYPE(20) STATISTICS_ITEM_TYPE(21) STATISTICS_ITEM_TYPE(22) STATISTICS_ITEM_TYPE(23)
+STATISTICS_ITEM_TYPE(24) STATISTICS_ITEM_TYPE(25) STATISTICS_ITEM_TYPE(26) STATISTICS_ITEM_TYPE(27)
+STATISTICS_ITEM_TYPE(28) STATISTICS_ITEM_TYPE(29) STATISTICS_ITEM_TYPE(30) STATISTICS_ITEM_TYPE(31)
+
+template <int N> struct StatisticsItems
+{
+	static void SetTypeSizes(NativeUnityAdapterStub::Arrays& arrays)
+	{
+		arrays.SetTypeSize< StatisticsItem<N> >();
+		StatisticsItems<N - 1>::SetTypeSizes(arrays);
+	}
+
+	//Sends N + 1 messages with msgId N and a StatisticsItem<N> parameter, after the ones of the types before it
+	static void Send(int receiverId)
+	{
+		StatisticsItems<N - 1>::Send(receiverId);
+		StatisticsItem<N> item = { N };
+		for (int i = 0; i <= N; ++i)
+			UNITY_MESSAGER.SendMessage(receiverId, N, item);
+	}
+};
+
+template <> struct StatisticsItems<-1>
+{
+	static void SetTypeSizes(NativeUnityAdapterStub::Arrays& arrays) {}
+	static void Send(int receiverId) {}
+};
+
+static bool IsStatisticPair(int pairPos, int64 key, int64 value)
+{
+	return UNITY_MESSAGER.GetStatistic(pairPos) == key && UNITY_MESSAGER.GetStatistic(pairPos + 1) == value;
+}
+
+//Statistics published for a known load, with more queues than the first 32 ones, and for a delivering without messages
+static void CheckStatistics(int flags)
+{
+	NativeUnityAdapterStub::Arrays& arrays = NativeUnityAdapterStub::Arrays::GetInstance();
+	StatisticsItems<STATISTICS_N_OF_TYPES - 1>::SetTypeSizes(arrays);
+	flags |= UM_INIT_FLAG_STATISTICS;
+	int controlQueueFirstArrayId = UnityMessager::InstanceAndProvideAwakeInfo(UM_CHECKS_N_OF_RECEIVER_IDS,
+																			 UM_CHECKS_QUEUE_ARRAYS_SIZE_IN_BYTES, flags);
+	UnityMessagerDispatcher dispatcher(flags, controlQueueFirstArrayId, arrays);
+	int receiverId = UNITY_MESSAGER.NewReceiverId();
+
+	StatisticsItems<STATISTICS_N_OF_TYPES - 1>::Send(receiverId);
+	CHECK(UNITY_MESSAGER.GetStatistic(UM_STATISTIC_DELIVERING_SERIAL) == 0); //nothing published yet
+	CHECK(dispatcher.DeliverMessages());
+	CHECK(UNITY_MESSAGER.GetStatistic(UM_STATISTIC_DELIVERING_SERIAL) == 1);
+	CHECK(UNITY_MESSAGER.GetStatistic(UM_STATISTIC_N_OF_MESSAGES) == STATISTICS_N_OF_TYPES * (STATISTICS_N_OF_TYPES + 1) / 2);
+	CHECK(UNITY_MESSAGER.GetStatistic(UM_STATISTIC_N_OF_SPILLED_PARAMS) == 0);
+
+	//the type N has N + 1 messages
+	for (int i = 0; i < UM_STATISTIC_N_OF_TOP_MSG_IDS; ++i)
+		CHECK(IsStatisticPair(UM_STATISTIC_FIRST_TOP_MSG_ID + 2 * i, STATISTICS_N_OF_TYPES - 1 - i, STATISTICS_N_OF_TYPES - i));
+
+	//the control queue has the most bytes, followed by the queues of the last types in descending order
+	int64 itemSize = sizeof(StatisticsItem<0>);
+	CHECK(UNITY_MESSAGER.GetStatistic(UM_STATISTIC_FIRST_TOP_QUEUE) == UM_CONTROL_QUEUE_ID);
+	CHECK(UNITY_MESSAGER.GetStatistic(UM_STATISTIC_FIRST_TOP_QUEUE + 1) > STATISTICS_N_OF_TYPES * itemSize);
+	if ((flags & UM_INIT_FLAG_INTERLEAVED_PARAMS) != 0)
+	{
+		//all the items on the payload queue
+		CHECK(UNITY_MESSAGER.GetStatistic(UM_STATISTIC_FIRST_TOP_QUEUE + 2) == 1);
+		CHECK(UNITY_MESSAGER.GetStatistic(UM_STATISTIC_FIRST_TOP_QUEUE + 3)
+			  >= itemSize * STATISTICS_N_OF_TYPES * (STATISTICS_N_OF_TYPES + 1) / 2);
+		CHECK(IsStatisticPair(UM_STATISTIC_FIRST_TOP_QUEUE + 4, -1, 0));
+	}
+	else
+	{
+		int64 lastQueueId = UNITY_MESSAGER.GetStatistic(UM_STATISTIC_FIRST_TOP_QUEUE + 2);
+		CHECK(lastQueueId >= STATISTICS_N_OF_TYPES);
+		for (int i = 1; i < UM_STATISTIC_N_OF_TOP_QUEUES; ++i)
+			CHECK(IsStatisticPair(UM_STATISTIC_FIRST_TOP_QUEUE + 2 * i, lastQueueId + 1 - i, (STATISTICS_N_OF_TYPES + 1 - i) * itemSize));
+	}
+
+	//only the control message finishing the delivering
+	CHECK(dispatcher.DeliverMessages());
+	CHECK(UNITY_MESSAGER.GetStatistic(UM_STATISTIC_DELIVERING_SERIAL) == 2);
+	CHECK(UNITY_MESSAGER.GetStatistic(UM_STATISTIC_N_OF_MESSAGES) == 0);
+	CHECK(IsStatisticPair(UM_STATISTIC_FIRST_TOP_MSG_ID, -1, 0));
+	CHECK(UNITY_MESSAGER.GetStatistic(UM_STATISTIC_FIRST_TOP_QUEUE) == UM_CONTROL_QUEUE_ID);
+	CHECK(IsStatisticPair(UM_STATISTIC_FIRST_TOP_QUEUE + 2, -1, 0));
+
+	UnityMessager::DeleteInstance();
+}
+
+//------------------ independent channels
+
+UM_DECLARE_COMPONENT(ChannelComponentA)
+UM_DECLARE_COMPONENT(ChannelComponentB)
+
+#define CHANNELS_OTHER_CHANNEL 1
+#define CHANNELS_N_OF_FRAMES 3
+
+#define CHANNELS_MSG_INT 1 //(int) to ChannelComponentA
+#define CHANNELS_MSG_FLOAT 2 //(float) to ChannelComponentA
+#define CHANNELS_MSG_ARRAY 3 //(double[2]) to ChannelComponentB
+#define CHANNELS_MSG_WORKER 4 //(int, uint8[3]) sent from a worker thread
+
+//Records each delivered message as "<component> m<msgId> <params...>", counting the ones not sent to receiverId
+class ChannelReceiver : public UnityMessagerDispatcher::Receiver
+{
+public:
+	int receiverId;
+	std::vector<std::string> delivered;
+	int nOfWrongReceiverIds;
+
+	ChannelReceiver() : receiverId(-1), delivered(), nOfWrongReceiverIds(0) {}
+
+	virtual void ReceiveMessage(const UnityMessagerDispatcher::Message& message)
+	{
+		nOfWrongReceiverIds += message.GetReceiverId() == receiverId ? 0 : 1;
+
+		char text[64] = "";
+		int length;
+		const double* pDoubles = message.GetMsgId() == CHANNELS_MSG_ARRAY ? message.GetArrayParam<double>(0, length) : NULL;
+		const uint8* pBytes = message.GetMsgId() == CHANNELS_MSG_WORKER ? message.GetArrayParam<uint8>(1, length) : NULL;
+		if (message.GetMsgId() == CHANNELS_MSG_INT)
+			snprintf(text, sizeof(text), "%d", message.GetParam<int>(0));
+		else if (message.GetMsgId() == CHANNELS_MSG_FLOAT)
+			snprintf(text, sizeof(text), "%g", message.GetParam<float>(0));
+		else if (pDoubles && length == 2)
+			snprintf(text, sizeof(text), "%g,%g", pDoubles[0], pDoubles[1]);
+		else if (pBytes && length == 3)
+			snprintf(text, sizeof(text), "%d %d,%d,%d", message.GetParam<int>(0), pBytes[0], pBytes[1], pBytes[2]);
+
+		delivered.push_back(message.GetComponentTypeName() + " m" + std::to_string(message.GetMsgId()) + " " + text);
+	}
+};
+
+//Sends the main thread messages of a frame to a channel, the components and the parameter types getting registered in the
+//reverse order when isReversed, returning them as recorded by ChannelReceiver
+static std::vector<std::string> SendChannelMessages(int channelId, int receiverId, int frame, bool isReversed)
+{
+	UnityMessager& unityMessager = UNITY_MESSAGER_CHANNEL(channelId);
+	int value = 100 * channelId + frame;
+	const double doubles[2] = { value + 0.25, value + 0.75 };
+	char text[64];
+	std::vector<std::string> sent;
+	for (int i = 0; i < 2; ++i)
+	{
+		if ((i == 0) != isReversed)
+		{
+			unityMessager.SendMessage<ChannelComponentA>(receiverId, CHANNELS_MSG_INT, value);
+			unityMessager.SendMessage<ChannelComponentA>(receiverId, CHANNELS_MSG_FLOAT, value + 0.5f);
+			sent.push_back("ChannelComponentA m1 " + std::to_string(value));
+			snprintf(text, sizeof(text), "ChannelComponentA m2 %g", value + 0.5f);
+			sent.push_back(text);
+		}
+		else
+		{
+			unityMessager.SendMessage<ChannelComponentB>(receiverId, CHANNELS_MSG_ARRAY, UM_ARRAY_PARAM(doubles, 2));
+			snprintf(text, sizeof(text), "ChannelComponentB m3 %g,%g", doubles[0], doubles[1]);
+			sent.push_back(text);
+		}
+	}
+
+	return sent;
+}
+
+static std::string GetChannelWorkerMessage(int channelId, int frame)
+{
+	char text[64];
+	snprintf(text, sizeof(text), " m%d %d %d,%d,%d", CHANNELS_MSG_WORKER, 100 * channelId + frame, channelId, frame, 7);
+	return text;
+}
+
+//Two channels with the same components and parameter types registered in different orders, so their ids differ, each one
+//delivered by its own dispatcher. Only the default channel is delivered at each frame, while the messages of the other one
+//(the ones staged by worker threads included) and its receiver id are kept untouched until it gets delivered at the end.
+static void CheckIndependentChannels(int flags)
+{
+	NativeUnityAdapterStub::Arrays& arrays = NativeUnityAdapterStub::Arrays::GetInstance();
+	int firstArrayIds[2];
+	UnityMessagerDispatcher* pDispatchers[2];
+	ChannelReceiver receivers[2];
+	for (int channelId = 0; channelId < 2; ++channelId)
+	{
+		firstArrayIds[channelId] = UnityMessager::InstanceAndProvideAwakeInfo(UM_CHECKS_N_OF_RECEIVER_IDS,
+																			  UM_CHECKS_QUEUE_ARRAYS_SIZE_IN_BYTES, flags, channelId);
+		pDispatchers[channelId] = new UnityMessagerDispatcher(flags, firstArrayIds[channelId], arrays, channelId);
+	}
+
+	receivers[CHANNELS_OTHER_CHANNEL].receiverId = UNITY_MESSAGER_CHANNEL(CHANNELS_OTHER_CHANNEL).NewReceiverId();
+	pDispatchers[CHANNELS_OTHER_CHANNEL]->SetReceiver(receivers[CHANNELS_OTHER_CHANNEL].receiverId, &receivers[CHANNELS_OTHER_CHANNEL]);
+
+	std::vector<std::string> otherChannelSent;
+	std::vector<std::string> otherChannelWorkerSent;
+	for (int frame = 0; frame < CHANNELS_N_OF_FRAMES; ++frame)
+	{
+		//a new receiver id each frame, its slot getting a new generation on the default channel only
+		ChannelReceiver& receiver = receivers[UM_DEFAULT_CHANNEL];
+		if (frame > 0)
+			CHECK(UNITY_MESSAGER.ReleaseReceiverId(receiver.receiverId));
+
+		receiver.receiverId = UNITY_MESSAGER.NewReceiverId();
+		pDispatchers[UM_DEFAULT_CHANNEL]->SetReceiver(receiver.receiverId, &receiver);
+
+		std::vector<std::string> sent = SendChannelMessages(UM_DEFAULT_CHANNEL, receiver.receiverId, frame, false);
+		std::vector<std::string> otherSent = SendChannelMessages(CHANNELS_OTHER_CHANNEL, receivers[CHANNELS_OTHER_CHANNEL].receiverId,
+																 frame, true);
+		otherChannelSent.insert(otherChannelSent.end(), otherSent.begin(), otherSent.end());
+
+		//staged on both channels by the same thread
+		int receiverIds[2] = { receiver.receiverId, receivers[CHANNELS_OTHER_CHANNEL].receiverId };
+		std::thread worker([&receiverIds, frame]() {
+			for (int channelId = 1; channelId >= 0; --channelId)
+			{
+				const uint8 bytes[3] = { (uint8)channelId, (uint8)frame, 7 };
+				UNITY_MESSAGER_CHANNEL(channelId).SendMessage(receiverIds[channelId], CHANNELS_MSG_WORKER, 100 * channelId + frame,
+															  UM_ARRAY_PARAM(bytes, 3));
+			}
+		});
+		worker.join();
+		sent.push_back(GetChannelWorkerMessage(UM_DEFAULT_CHANNEL, frame));
+		otherChannelWorkerSent.push_back(GetChannelWorkerMessage(CHANNELS_OTHER_CHANNEL, frame));
+
+		receiver.delivered.clear();
+		CHECK(pDispatchers[UM_DEFAULT_CHANNEL]->DeliverMessages());
+		CHECK(receiver.delivered == sent && receiver.nOfWrongReceiverIds == 0);
+		CHECK(receivers[CHANNELS_OTHER_CHANNEL].delivered.empty());
+	}
+
+	//the worker thread messages are merged when delivering, after the ones sent from the main thread
+	ChannelReceiver& otherReceiver = receivers[CHANNELS_OTHER_CHANNEL];
+	otherChannelSent.insert(otherChannelSent.end(), otherChannelWorkerSent.begin(), otherChannelWorkerSent.end());
+	CHECK(pDispatchers[CHANNELS_OTHER_CHANNEL]->DeliverMessages());
+	CHECK(otherReceiver.delivered == otherChannelSent && otherReceiver.nOfWrongReceiverIds == 0);
+	CHECK(UNITY_MESSAGER_CHANNEL(CHANNELS_OTHER_CHANNEL).ReleaseReceiverId(otherReceiver.receiverId));
+
+	for (int channelId = 0; channelId < 2; ++channelId)
+	{
+		delete pDispatchers[channelId];
+		UnityMessager::DeleteInstance(channelId);
+	}
+}
+
+//------------------ inbox drains
+
+#define INBOX_N_OF_MESSAGES 200
+#define INBOX_LONG_ARRAY_LENGTH 1500 //longer than the inbox arrays
+#define INBOX_RECEIVER_ID 3
+#define INBOX_UNSET_RECEIVER_ID 40
+
+//Writes messages to the inbox of the default channel as the C# UnityMessager.InboxWriter does
+class StubInboxWriter
+{
+public:
+	StubInboxWriter(UnityMessagerInbox& inbox)
+		: m_inbox(inbox), m_pFirstArray(NULL), m_firstArrayLength(0), m_pArray(NULL), m_arrayLength(0), m_pos(0), m_recordStart(-1), m_nOfParams(0),
+		m_drainSerial(0), m_nOfArrayAdvances(0), m_typeIds()
+	{
+		m_typeIds[UnityArray<uint8>::s_managedTypeName] = UMI_BYTE_TYPE_ID;
+		m_pFirstArray = GetArray(inbox.GetFirstArrayId(), m_firstArrayLength);
+	}
+
+	void StartMessage(int receiverId, int msgId)
+	{
+		if (m_pArray == NULL || ReadInt(m_pFirstArray, sizeof(int)) != m_drainSerial)
+		{
+			m_drainSerial = ReadInt(m_pFirstArray, sizeof(int));
+			m_pArray = m_pFirstArray;
+			m_arrayLength = m_firstArrayLength;
+			m_pos = UMI_ARRAY_HEADER_SIZE;
+		}
+
+		m_recordStart = m_pos;
+		Reserve(UMI_RECORD_HEADER_SIZE);
+		WriteInt(m_recordStart + sizeof(int), receiverId);
+		WriteInt(m_recordStart + 2 * sizeof(int), msgId);
+		m_pos = m_recordStart + UMI_RECORD_HEADER_SIZE;
+		m_nOfParams = 0;
+	}
+
+	//the parameter header may move the message to the next array, so m_pArray is read after it
+	template <typename T>
+	void PushParam(T value)
+	{
+		int dataPos = WriteParamHeader<T>(-1);
+		memcpy(m_pArray + dataPos, &value, sizeof(T));
+	}
+
+	template <typename T>
+	void PushArrayParam(const T* pItems, int length)
+	{
+		int dataPos = WriteParamHeader<T>(length);
+		if (length > 0)
+			memcpy(m_pArray + dataPos, pItems, length * sizeof(T));
+	}
+
+	void EndMessage()
+	{
+		int endPos = (m_pos + UMI_RECORD_ALIGNMENT - 1) & ~(UMI_RECORD_ALIGNMENT - 1);
+		WriteInt(m_recordStart, endPos - m_recordStart);
+		WriteInt(m_recordStart + 3 * sizeof(int), m_nOfParams);
+		WriteInt(0, endPos);
+
+		m_pos = endPos;
+		m_recordStart = -1;
+	}
+
+	//Ends the message being written with an invalid record length, as a C# side writing a wrong layout
+	void EndInvalidMessage()
+	{
+		int recordStart = m_recordStart;
+		EndMessage();
+		WriteInt(recordStart, UMI_RECORD_HEADER_SIZE - 4);
+	}
+
+	int GetNOfArrayAdvances() const { return m_nOfArrayAdvances; }
+	int GetDrainSerial() const { return ReadInt(m_pFirstArray, sizeof(int)); }
+
+private:
+	template <typename T>
+	int WriteParamHeader(int length)
+	{
+		const char* typeName = UnityArray<T>::s_managedTypeName;
+		bool isNewType = m_typeIds.find(typeName) == m_typeIds.end();
+		if (isNewType)
+		{
+			int typeId = (int)m_typeIds.size();
+			m_typeIds[typeName] = typeId;
+		}
+
+		int typeId = m_typeIds[typeName];
+		int nameLength = (int)strlen(typeName);
+		int alignment = (int)(sizeof(T) & -sizeof(T)) < UMI_RECORD_ALIGNMENT ? (int)(sizeof(T) & -sizeof(T)) : UMI_RECORD_ALIGNMENT;
+		int dataSize = (int)sizeof(T) * (length >= 0 ? length : 1);
+		Reserve(UMI_PARAM_HEADER_SIZE + (isNewType ? 8 + ((nameLength + 3) & ~3) : 0) + alignment - 1 + dataSize);
+
+		WriteInt(m_pos, isNewType ? typeId | UMI_NEW_TYPE_FLAG : typeId);
+		WriteInt(m_pos + sizeof(int), length);
+		m_pos += UMI_PARAM_HEADER_SIZE;
+		if (isNewType)
+		{
+			WriteInt(m_pos, sizeof(T));
+			WriteInt(m_pos + sizeof(int), nameLength);
+			memcpy(m_pArray + m_pos + 8, typeName, nameLength);
+			m_pos = (m_pos + 8 + nameLength + 3) & ~3;
+		}
+
+		int dataPos = (m_pos + alignment - 1) & ~(alignment - 1);
+		m_pos = dataPos + dataSize;
+		++m_nOfParams;
+		return dataPos;
+	}
+
+	//Moves the message being written to the next array if the current one doesn't have nOfBytes free bytes
+	void Reserve(int nOfBytes)
+	{
+		if (m_pos + nOfBytes <= m_arrayLength)
+			return;
+
+		int writtenLength = m_pos - m_recordStart;
+		uint8* pNextArray = GetArray(m_inbox.AdvanceToNextArray(UMI_ARRAY_HEADER_SIZE + writtenLength + nOfBytes), m_arrayLength);
+		memcpy(pNextArray + UMI_ARRAY_HEADER_SIZE, m_pArray + m_recordStart, writtenLength);
+		++m_nOfArrayAdvances;
+
+		m_pArray = pNextArray;
+		m_recordStart = UMI_ARRAY_HEADER_SIZE;
+		m_pos = m_recordStart + writtenLength;
+	}
+
+	static uint8* GetArray(int arrayId, int& lengthInBytes)
+	{
+		NativeUnityAdapterStub::Arrays& arrays = NativeUnityAdapterStub::Arrays::GetInstance();
+		arrays.GetArray(arrayId, lengthInBytes);
+		return arrays.GetArrayForWrite(arrayId);
+	}
+
+	void WriteInt(int pos, int value) { memcpy(m_pArray + pos, &value, sizeof(int)); }
+	static int ReadInt(const uint8* pArray, int pos) { int value; memcpy(&value, pArray + pos, sizeof(int)); return value; }
+
+	UnityMessagerInbox& m_inbox;
+	uint8* m_pFirstArray;
+	int m_firstArrayLength;
+	uint8* m_pArray;
+	int m_arrayLength;
+	int m_pos;
+	int m_recordStart;
+	int m_nOfParams;
+	int m_drainSerial;
+	int m_nOfArrayAdvances;
+	std::map<std::string, int> m_typeIds;
+};
+
+//Records each drained message as "r<receiverId> m<msgId> <params...>"
+class InboxLog : public UnityMessagerInbox::Receiver
+{
+public:
+	std::vector<std::string> drained;
+
+	virtual void ReceiveMessage(const UnityMessagerInbox::Message& message)
+	{
+		std::string str = "r" + std::to_string(message.GetReceiverId()) + " m" + std::to_string(message.GetMsgId());
+		char text[64];
+		int length;
+		for (int i = 0; i < message.GetNOfParams(); ++i)
+		{
+			//(int, double[], string) parameters, check WriteInboxMessage
+			if (i == 0)
+				snprintf(text, sizeof(text), " %d", message.GetParam<int>(i));
+			else if (i == 1)
+			{
+				const double* pDoubles = message.GetArrayParam<double>(i, length);
+				snprintf(text, sizeof(text), " %g*%d", pDoubles && length > 0 ? pDoubles[length - 1] : 0.0, length);
+			}
+			else
+				snprintf(text, sizeof(text), " %s", message.GetStringParam(i).c_str());
+
+			str += text;
+		}
+
+		drained.push_back(str);
+	}
+};
+
+//Writes a message with an int, a double array and a string, returning it as recorded by InboxLog
+static std::string WriteInboxMessage(StubInboxWriter& writer, int receiverId, int msgId, int value, int nOfDoubles)
+{
+	std::vector<double> doubles(nOfDoubles, value + 0.5);
+	std::string str = "s" + std::to_string(value);
+	writer.StartMessage(receiverId, msgId);
+	writer.PushParam<int>(value);
+	writer.PushArrayParam<double>(doubles.data(), nOfDoubles);
+	writer.PushArrayParam<uint8>(reinterpret_cast<const uint8*>(str.data()), (int)str.size());
+	writer.EndMessage();
+
+	char text[64];
+	snprintf(text, sizeof(text), "r%d m%d %d %g*%d %s", receiverId, msgId, value, nOfDoubles > 0 ? value + 0.5 : 0.0, nOfDoubles,
+			 str.c_str());
+	return text;
+}
+
+//The stub writes the inbox as the C# side, with the first-use type headers, more messages than the first array holds and
+//a message longer than the inbox arrays, all of them drained in order. The next frames write from the first array again,
+//without new arrays, and an invalid record makes the drain discard the remaining messages of the frame only.
+static void CheckInboxDrains(int flags)
+{
+	NativeUnityAdapterStub::Arrays& arrays = NativeUnityAdapterStub::Arrays::GetInstance();
+	UnityMessager::InstanceAndProvideAwakeInfo(UM_CHECKS_N_OF_RECEIVER_IDS, UM_CHECKS_QUEUE_ARRAYS_SIZE_IN_BYTES, flags);
+	UnityMessagerInbox& inbox = UNITY_MESSAGER.GetInbox();
+	InboxLog log;
+	InboxLog defaultLog;
+	inbox.SetReceiver(INBOX_RECEIVER_ID, &log);
+	inbox.SetDefaultReceiver(&defaultLog);
+	StubInboxWriter writer(inbox);
+	CHECK(!inbox.HasMessagesToDrain());
+
+	for (int frame = 0; frame < 3; ++frame)
+	{
+		int64 nOfAllocs = arrays.GetNOfAllocs();
+		int nOfArrayAdvances = writer.GetNOfArrayAdvances();
+		std::vector<std::string> written;
+		for (int i = 0; i < INBOX_N_OF_MESSAGES; ++i)
+			written.push_back(WriteInboxMessage(writer, INBOX_RECEIVER_ID, i, frame * 1000 + i, i % 4));
+
+		written.push_back(WriteInboxMessage(writer, INBOX_RECEIVER_ID, INBOX_N_OF_MESSAGES, frame, INBOX_LONG_ARRAY_LENGTH));
+		std::string toDefault = WriteInboxMessage(writer, INBOX_UNSET_RECEIVER_ID, 0, frame, 1);
+		CHECK(inbox.HasMessagesToDrain() && writer.GetNOfArrayAdvances() > nOfArrayAdvances + 1);
+
+		log.drained.clear();
+		defaultLog.drained.clear();
+		CHECK(inbox.DrainMessages() == INBOX_N_OF_MESSAGES + 2);
+		CHECK(log.drained == written && defaultLog.drained == std::vector<std::string>(1, toDefault));
+		CHECK(writer.GetDrainSerial() == frame + 1 && !inbox.HasMessagesToDrain());
+		//the arrays are kept, so a frame writing the same bytes of the previous one doesn't allocate
+		CHECK(frame < 2 || arrays.GetNOfAllocs() == nOfAllocs);
+	}
+
+	UnityAdapter::Internals::SetOutputDebugStrFcPtr(CountLog);
+	f_nOfLogs = 0;
+	log.drained.clear();
+	std::string valid = WriteInboxMessage(writer, INBOX_RECEIVER_ID, 1, 1, 1);
+	writer.StartMessage(INBOX_RECEIVER_ID, 2);
+	writer.PushParam<int>(2);
+	writer.EndInvalidMessage();
+	WriteInboxMessage(writer, INBOX_RECEIVER_ID, 3, 3, 1);
+	CHECK(inbox.DrainMessages() == 1 && f_nOfLogs == 1);
+	CHECK(log.drained == std::vector<std::string>(1, valid));
+	CHECK(writer.GetDrainSerial() == 4 && !inbox.HasMessagesToDrain());
+	UnityAdapter::Internals::SetOutputDebugStrFcPtr(NativeUnityAdapterStub::OutputDebugStr);
+
+	//the next frame is written and drained as usual
+	log.drained.clear();
+	valid = WriteInboxMessage(writer, INBOX_RECEIVER_ID, 4, 4, 2);
+	CHECK(inbox.DrainMessages() == 1 && log.drained == std::vector<std::string>(1, valid));
+	CHECK(writer.GetDrainSerial() == 5);
+
+	UnityMessager::DeleteInstance();
+}
+
+//------------------ queue capacity
+
+#define CAPACITY_N_OF_MESSAGES 40
+#define CAPACITY_SPIKE_FACTOR 10
+#define CAPACITY_ARRAY_LENGTH 100 //ints on each message, several queue arrays for the whole frame but not spilled
+
+static void SendCapacityMessages(int receiverId, int nOfMessages)
+{
+	int ints[CAPACITY_ARRAY_LENGTH] = {};
+	for (int i = 0; i < nOfMessages; ++i)
+		UNITY_MESSAGER.SendMessage(receiverId, i, UM_ARRAY_PARAM(ints, CAPACITY_ARRAY_LENGTH));
+}
+
+//After a warm-up delivering the queues have the capacity a steady load needs, so sending it allocates no array. A spike
+//gets arrays for itself, which are kept while it is within the capacity window and released once it gets out of it.
+static void CheckQueueCapacity(int flags)
+{
+	NativeUnityAdapterStub::Arrays& arrays = NativeUnityAdapterStub::Arrays::GetInstance();
+	flags |= UM_INIT_FLAG_STATISTICS;
+	int controlQueueFirstArrayId = UnityMessager::InstanceAndProvideAwakeInfo(UM_CHECKS_N_OF_RECEIVER_IDS,
+																			 UM_CHECKS_QUEUE_ARRAYS_SIZE_IN_BYTES, flags);
+	UnityMessagerDispatcher dispatcher(flags, controlQueueFirstArrayId, arrays);
+	int receiverId = UNITY_MESSAGER.NewReceiverId();
+
+	//the first delivering measures the load, which then gets the arrays it needs (on both sets when double buffered)
+	for (int i = 0; i < 2; ++i)
+	{
+		SendCapacityMessages(receiverId, CAPACITY_N_OF_MESSAGES);
+		CHECK(dispatcher.DeliverMessages());
+	}
+
+	int64 nOfAllocs = arrays.GetNOfAllocs();
+	SendCapacityMessages(receiverId, CAPACITY_N_OF_MESSAGES);
+	CHECK(arrays.GetNOfAllocs() == nOfAllocs);
+	CHECK(dispatcher.DeliverMessages());
+	CHECK(UNITY_MESSAGER.GetStatistic(UM_STATISTIC_N_OF_ARRAY_ADVANCES) > 0);
+	CHECK(UNITY_MESSAGER.GetStatistic(UM_STATISTIC_N_OF_ARRAY_ALLOCS) == 0);
+	int64 steadyLiveBytes = arrays.GetLiveBytes();
+
+	SendCapacityMessages(receiverId, CAPACITY_SPIKE_FACTOR * CAPACITY_N_OF_MESSAGES);
+	CHECK(dispatcher.DeliverMessages());
+	CHECK(UNITY_MESSAGER.GetStatistic(UM_STATISTIC_N_OF_ARRAY_ALLOCS) > 0);
+
+	//the spike is the peak of the current window for the remaining deliverings of it, then of the last window for a whole one.
+	//When double buffered the other set of arrays gets the capacity for it on the next delivering.
+	int64 spikeLiveBytes = 0;
+	int nOfAllocsOnSteadyLoad = 0;
+	for (int i = 1; i < UM_QUEUE_CAPACITY_WINDOW_N_OF_DELIVERINGS; ++i)
+	{
+		nOfAllocs = arrays.GetNOfAllocs();
+		SendCapacityMessages(receiverId, CAPACITY_N_OF_MESSAGES);
+		nOfAllocsOnSteadyLoad += (int)(arrays.GetNOfAllocs() - nOfAllocs);
+		CHECK(dispatcher.DeliverMessages());
+		spikeLiveBytes = i == 1 ? arrays.GetLiveBytes() : spikeLiveBytes;
+	}
+
+	CHECK(spikeLiveBytes > steadyLiveBytes);
+	CHECK(nOfAllocsOnSteadyLoad == 0 && arrays.GetLiveBytes() == spikeLiveBytes);
+
+	for (int i = 0; i < UM_QUEUE_CAPACITY_WINDOW_N_OF_DELIVERINGS; ++i)
+	{
+		nOfAllocs = arrays.GetNOfAllocs();
+		SendCapacityMessages(receiverId, CAPACITY_N_OF_MESSAGES);
+		nOfAllocsOnSteadyLoad += (int)(arrays.GetNOfAllocs() - nOfAllocs);
+		CHECK(dispatcher.DeliverMessages());
+	}
+
+	CHECK(nOfAllocsOnSteadyLoad == 0 && arrays.GetLiveBytes() == steadyLiveBytes);
+
+	UnityMessager::DeleteInstance();
+}
+
+//------------------
+
+static const Check f_checks[] = {
+	{ "producers_order", CheckProducersOrder, true },
+	{ "shared_param_queues", CheckSharedParamQueues, true },
+	{ "named_routes", CheckNamedRoutes, true },
+	{ "receiver_ids_releases", CheckReceiverIdsReleases, true },
+	{ "ring_producer_consumer", CheckRingProducerConsumer, true },
+	{ "batch_messages", CheckBatchMessages, true },
+	{ "coalesced_messages", CheckCoalescedMessages, true },
+	{ "statistics", CheckStatistics, true },
+	{ "queue_capacity", CheckQueueCapacity, true },
+	{ "independent_channels", CheckIndependentChannels, true },
+	{ "inbox_drains", CheckInboxDrains, true },
+	{ "tracked_array", CheckTrackedArray, false },
+	{ "file_reads", CheckFileReads, false },
+	{ "file_stream_reader", CheckFileStreamReader, false },
+};
+
+int main(int argc, char** argv)
+{
+	const char* filter = NULL;
+	std::vector<int> flagsSets;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--filter") == 0)
+			filter = argv[i + 1];
+		else if (strcmp(argv[i], "--flags") == 0)
+		{
+			for (const char* pFlags = argv[i + 1]; *pFlags; )
+			{
+				flagsSets.push_back(atoi(pFlags));
+				while (*pFlags && *(pFlags++) != ',') {}
+			}
+		}
+		else
+		{
+			fprintf(stderr, "Usage: %s [--filter <substring>] [--flags <flags,flags...>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	//default: plain, double buffered, compact control queue, interleaved parameters and all of them
+	if (flagsSets.empty())
+	{
+		int defaultFlagsSets[] = { 0, UM_INIT_FLAG_DOUBLE_BUFFERED, UM_INIT_FLAG_COMPACT_CONTROL_QUEUE, UM_INIT_FLAG_INTERLEAVED_PARAMS,
+								   UM_INIT_FLAG_DOUBLE_BUFFERED | UM_INIT_FLAG_COMPACT_CONTROL_QUEUE | UM_INIT_FLAG_INTERLEAVED_PARAMS };
+		flagsSets.assign(defaultFlagsSets, defaultFlagsSets + sizeof(defaultFlagsSets) / sizeof(int));
+	}
+
+	NativeUnityAdapterStub::Install();
+	printf("check,flags,failures\n");
+
+	int nOfChecks = sizeof(f_checks) / sizeof(Check);
+	int nOfFailedChecks = 0;
+	for (int i = 0; i < nOfChecks; ++i)
+	{
+		const Check& check = f_checks[i];
+		if (filter && strstr(check.name, filter) == NULL)
+			continue;
+
+		for (size_t flagsIdx = 0; flagsIdx < (check.usesMessager ? flagsSets.size() : 1); ++flagsIdx)
+		{
+			int flags = check.usesMessager ? flagsSets[flagsIdx] : -1;
+			int nOfPreviousFailures = f_nOfFailures;
+			check.fcPtr(flags);
+
+			int nOfFailures = f_nOfFailures - nOfPreviousFailures;
+			nOfFailedChecks += nOfFailures > 0 ? 1 : 0;
+			printf("%s,%d,%d\n", check.name, flags, nOfFailures);
+		}
+	}
+
+	//every shared array must have been released
+	int nOfLeakedArrays = NativeUnityAdapterStub::Arrays::GetInstance().GetNOfLiveArrays();
+	if (nOfLeakedArrays > 0)
+	{
+		fprintf(stderr, "%d shared arrays were not released\n", nOfLeakedArrays);
+		return 1;
+	}
+
+	return nOfFailedChecks > 0 ? 1 : 0;
+}
@@ -0,0 +1,567 @@
+//Copyright (c) 2016, Samuel Pollachini (Samuel Polacchini)
+//The UnityForCpp project is licensed under the terms of the MIT license
+
+//Headless end-to-end benchmark of the UnityForCppTest scenario (check Test.cpp) at game scale: N game objects moving on the
+//shared positions array, producer threads sending random rotation and color updates to a fraction of them each frame, and the
+//log related messages once per second (60 frames). The C# side is played by an UnityMessagerDispatcher over the stub arrays,
+//which delivers every message of each frame to a native copy of the scene, so each measured frame is the whole
+//update plus the whole delivering. For each run (each combination of --objects and --flags) it prints a CSV line:
+//
+//   objects,rate,producers,flags,frames,setup_ms,p50_ms,p90_ms,p99_ms,max_ms,mean_bytes_per_frame,max_bytes_per_frame,peak_queue_bytes
+//
+//where the bytes per frame are the ones read from the control and parameter queues, and peak_queue_bytes is the peak of the
+//shared arrays allocated by the UnityMessager (queue, spill and receiver ids arrays) during the measured frames. The setup
+//frame, instancing all the game objects, is measured apart. The --max-* thresholds make it return 2 if any run exceeds them,
+//so it can guard against regressions. Build it with:
+//
+//   g++ -std=c++11 -O2 -pthread -o UnityForCppScenarioBenchmark UnityForCppScenarioBenchmark.cpp ../Source/Shared.cpp
+//       ../Source/UnityAdapter.cpp ../Source/UnityArray.cpp ../Source/UnityMessager.cpp ../Source/UnityMessagerTrace.cpp
+//       ../Source/UnityMessagerDecoder.cpp ../Source/UnityMessagerDispatcher.cpp ../Source/UnityMessagerInbox.cpp
+//       ../Source/UnityMessagerRing.cpp
+//
+//   UnityForCppScenarioBenchmark [--objects <n,n...>] [--rate <fraction>] [--producers <n>] [--flags <flags,flags...>]
+//       [--frames <n>] [--queue-array-size <bytes>] [--max-p99-ms <ms>] [--max-bytes-per-frame <bytes>] [--max-peak-queue-mb <mb>]
+//
+//Out of Windows the plugin is always built with _DEBUG (check Shared.h), so the numbers include the ASSERT checks.
+
+#include "NativeUnityAdapterStub.h"
+#include "../Source/Test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace UnityForCpp;
+
+typedef UnityForCppTest::Vec2 Vec2;
+
+//Test.cpp is not linked, since its constructor tests the file features, so the type and components it declares are declared here
+UA_SUPPORTED_TYPE(UnityForCppTest::Vec2, "UnityForCppTest+Vec2");
+UM_DECLARE_COMPONENT(ReceiverComponentTest);
+UM_DECLARE_COMPONENT_AS(UnityForCppTest, UnityForCppTestComp);
+
+#define SB_N_OF_RECEIVER_IDS 1024
+#define SB_N_OF_GAME_OBJECT_ADAPTER_USAGES 10 //corresponds to NUMBER_OF_GAME_OBJECT_ADAPTER_USAGES on Test.cpp
+#define SB_MAX_N_OF_PRODUCERS 64
+#define SB_FRAMES_PER_SECOND 60
+#define SB_N_OF_WARM_UP_FRAMES 10
+
+//Thread safe replacement for the rand() calls of the test, since each producer thread has its own generator
+struct Random
+{
+	uint32 state;
+
+	explicit Random(uint32 seed) : state(seed * 2654435761u + 1u) {}
+
+	uint32 Next() { state ^= state << 13; state ^= state >> 17; state ^= state << 5; return state; }
+	float Next01() { return (float)(Next() & 0xFFFFFF) / (float)0xFFFFFF; }
+	float NextNegPos1() { return 2.0f * Next01() - 1.0f; }
+};
+
+struct Options
+{
+	std::vector<int> nOfObjectsSet;
+	std::vector<int> flagsSets;
+	float rate; //fraction of the game objects visited by the random updates each frame
+	int nOfProducers;
+	int nOfFrames;
+	int queueArraysSizeInBytes;
+	double maxP99Ms; //thresholds, not checked if negative
+	double maxBytesPerFrame;
+	double maxPeakQueueMb;
+};
+
+struct RunResult
+{
+	double setupMs;
+	double p50Ms;
+	double p90Ms;
+	double p99Ms;
+	double maxMs;
+	double meanBytesPerFrame;
+	int64 maxBytesPerFrame;
+	int64 peakQueueBytes;
+};
+
+//The UnityForCppTest update and messages, sent by the same UnityForCppTest::TestReceiverMessages ids
+class Scenario
+{
+public:
+	Scenario(int testReceiverId, int nOfGameObjects, float rate, int nOfProducers)
+		: m_receiverId(testReceiverId), m_nOfGameObjects(nOfGameObjects), m_rate(rate), m_nOfProducers(nOfProducers),
+		m_positions(), m_velocities(nOfGameObjects), m_nextGameObjectToUpdate(0), m_frame(0), m_receiverIdForReflectionTest(-1)
+	{
+		Random random(1);
+		m_positions.Alloc(nOfGameObjects);
+		UNITY_MESSAGER.SendMessage(m_receiverId, UnityForCppTest::TRM_SET_POSITIONS_ARRAY, m_positions.GetId(),
+								   m_positions.GetDirtyBitmapId());
+
+		for (int i = 0; i < nOfGameObjects; ++i)
+		{
+			int receiverId = i < SB_N_OF_GAME_OBJECT_ADAPTER_USAGES ? UNITY_MESSAGER.NewReceiverId() : -1;
+			m_positions.Set(i, Vec2(random.NextNegPos1(), random.NextNegPos1()));
+			m_velocities[i] = Vec2(0.01f * random.NextNegPos1(), 0.01f * random.NextNegPos1());
+
+			UNITY_MESSAGER.SendMessage(m_receiverId, UnityForCppTest::TRM_INSTANCE_GAME_OBJECT, i, receiverId);
+			if (i < SB_N_OF_GAME_OBJECT_ADAPTER_USAGES)
+			{
+				if (m_receiverIdForReflectionTest < 0)
+					m_receiverIdForReflectionTest = receiverId;
+
+				Vec2 scale(3.0f + 6.0f * random.Next01(), 3.0f + 6.0f * random.Next01());
+				UNITY_MESSAGER.SendMessage<ReceiverComponentTest>(receiverId, 0, scale);
+			}
+		}
+	}
+
+	~Scenario() { m_positions.Release(); }
+
+	int GetPositionsArrayId() const { return m_positions.GetId(); }
+
+	void Update()
+	{
+		//1. positions, read by the C# side from the shared array
+		for (int i = 0; i < m_nOfGameObjects; ++i)
+		{
+			Vec2 newPos = m_positions[i] + m_velocities[i];
+			if (CheckAndSolveWallCollision(newPos.x, -1.0f) || CheckAndSolveWallCollision(newPos.x, 1.0f))
+				m_velocities[i].x = -m_velocities[i].x;
+
+			if (CheckAndSolveWallCollision(newPos.y, -1.0f) || CheckAndSolveWallCollision(newPos.y, 1.0f))
+				m_velocities[i].y = -m_velocities[i].y;
+
+			m_positions.Set(i, newPos);
+		}
+
+		//2. random updates, the rate going round the game objects frame after frame
+		int nOfGameObjectsToUpdate = std::min(m_nOfGameObjects, (int)(m_rate * m_nOfGameObjects + 0.5f));
+		if (nOfGameObjectsToUpdate > 0)
+		{
+			if (m_nOfProducers > 0)
+			{
+				std::thread producerThreads[SB_MAX_N_OF_PRODUCERS];
+				int sliceLength = (nOfGameObjectsToUpdate + m_nOfProducers - 1) / m_nOfProducers;
+				for (int i = 0; i < m_nOfProducers; ++i)
+				{
+					int first = i * sliceLength;
+					int length = std::max(0, std::min(sliceLength, nOfGameObjectsToUpdate - first));
+					producerThreads[i] = std::thread(&Scenario::SendRandomUpdates, this, i, m_nextGameObjectToUpdate + first, length);
+				}
+
+				for (int i = 0; i < m_nOfProducers; ++i)
+					producerThreads[i].join();
+			}
+			else
+				SendRandomUpdates(-1, m_nextGameObjectToUpdate, nOfGameObjectsToUpdate);
+
+			m_nextGameObjectToUpdate = (m_nextGameObjectToUpdate + nOfGameObjectsToUpdate) % m_nOfGameObjects;
+		}
+
+		//3. the log related messages, once per second
+		if (++m_frame % SB_FRAMES_PER_SECOND == 0)
+			SendLogRelatedMessage((m_frame / SB_FRAMES_PER_SECOND) % 7);
+	}
+
+private:
+	static inline bool CheckAndSolveWallCollision(float& pos, float dir)
+	{
+		if (pos*dir > 1.0f)
+		{
+			pos = dir*(2.0f - pos*dir);
+			return true;
+		}
+
+		return false;
+	}
+
+	//game object ids past the last one wrap around
+	void SendRandomUpdates(int producerIndex, int firstGameObjectId, int nOfGameObjects)
+	{
+		if (producerIndex >= 0)
+			UNITY_MESSAGER.BindProducerThread(producerIndex);
+
+		Random random(m_frame * SB_MAX_N_OF_PRODUCERS + producerIndex + 2);
+		for (int i = 0; i < nOfGameObjects; ++i)
+		{
+			int gameObjectId = (firstGameObjectId + i) % m_nOfGameObjects;
+			float randomValue = random.Next01();
+			if (randomValue < 0.33f)
+				UNITY_MESSAGER.SendMessage(m_receiverId, UnityForCppTest::TRM_SET_GAME_OBJECT_ROTATION, gameObjectId,
+										   random.NextNegPos1() * 180.0f);
+			else if (randomValue < 0.66f)
+			{
+				float color[3] = { random.Next01(), random.Next01(), random.Next01() };
+				if (random.Next() % 2 == 0)
+					UNITY_MESSAGER.SendMessage(m_receiverId, UnityForCppTest::TRM_SET_GAME_OBJECT_COLOR, gameObjectId,
+											   color[0], color[1], color[2]);
+				else
+					UNITY_MESSAGER.SendMessage(m_receiverId, UnityForCppTest::TRM_SET_GAME_OBJECT_COLOR, gameObjectId,
+											   UM_ARRAY_PARAM(color, 3));
+			}
+		}
+	}
+
+	void SendLogRelatedMessage(int messageCase)
+	{
+		switch (messageCase)
+		{
+		case 0:
+			UNITY_MESSAGER.SendMessage(m_receiverId, UnityForCppTest::TRM_LOG_PARAM_TYPES, 8u, 37873218932819823232.3232, 3ll, "Hey", 1.2f);
+			break;
+		case 1:
+		{
+			uint64 testArray[9] = { 829, 89873929992311, 232, 32322, 23, 87, 1, 2, 3 };
+			UNITY_MESSAGER.SendMessage(m_receiverId, UnityForCppTest::TRM_LOG_PARAM_TYPES, UM_ARRAY_PARAM(testArray, 9), "string", 3);
+			break;
+		}
+		case 2:
+		{
+			auto arrayToFill = UM_CREATE_ARRAY_TO_FILL_PARAM(int, 10);
+			UNITY_MESSAGER.SendMessage(m_receiverId, UnityForCppTest::TRM_LOG_PARAM_TYPES, 2.3f, "arrayToFill Test", arrayToFill, 23, "hi");
+			for (int i = 0; i < 10; ++i)
+				arrayToFill[i] = i;
+			break;
+		}
+		case 3:
+			UNITY_MESSAGER.SendMessage(m_receiverId, UnityForCppTest::TRM_DEBUG_LOG_MESSAGE, "Just test sending an string message!!", 0);
+			break;
+		case 4:
+		{
+			int iArray[5] = { 1, 2, 5, 9, 2 };
+			UNITY_MESSAGER.SendMessage<UnityForCppTestComp>("UnityForCppTest", "TestReflectionBasedMessage",
+															7, 0.2f, UM_ARRAY_PARAM(iArray, 5), "String Value", 1.1);
+			break;
+		}
+		case 5:
+		{
+			float fArray[3] = { 1.2f, 3.1f, 9.2f };
+			UNITY_MESSAGER.SendMessage<UnityForCppTestComp>("UnityForCppTest", UnityForCppTest::TRM_LOG_PARAM_TYPES,
+															"String param", UM_ARRAY_PARAM(fArray, 3), 5);
+			break;
+		}
+		case 6:
+		{
+			uint8 bArray[5] = { 1, 2, 5, 9, 2 };
+			UNITY_MESSAGER.SendMessage<ReceiverComponentTest>(m_receiverIdForReflectionTest, "TestReflectionBasedMessage",
+															  5, 9.1f, UM_ARRAY_PARAM(bArray, 5), "Samuel");
+			break;
+		}
+		}
+	}
+
+	int m_receiverId;
+	int m_nOfGameObjects;
+	float m_rate;
+	int m_nOfProducers;
+	TrackedUnityArray<Vec2> m_positions;
+	std::vector<Vec2> m_velocities;
+	int m_nextGameObjectToUpdate;
+	int m_frame;
+	int m_receiverIdForReflectionTest;
+};
+
+//Native copy of the C# scene: applies the messages to the test receiver as UnityForCppTest.cs does, reading the positions
+//from the shared array at the end of each delivering, as the C# game objects do on their update
+class SceneReceiver : public UnityMessagerDispatcher::Receiver
+{
+public:
+	SceneReceiver(int nOfGameObjects)
+		: m_rotations(nOfGameObjects, 0.0f), m_colors(3 * nOfGameObjects, 1.0f), m_nOfInstancedGameObjects(0),
+		m_positionsArrayId(-1), m_positionsDirtyBitmapId(-1), m_positionsSum(0.0f, 0.0f), m_isValid(true) {}
+
+	virtual void ReceiveMessage(const UnityMessagerDispatcher::Message& message)
+	{
+		switch (message.GetMsgId())
+		{
+		case UnityForCppTest::TRM_SET_GAME_OBJECT_ROTATION:
+			if (message.GetNOfParams() == 2 && IsValidGameObjectId(message))
+				m_rotations[message.GetParam<int>(0)] = message.GetParam<float>(1);
+			break;
+		case UnityForCppTest::TRM_SET_GAME_OBJECT_COLOR:
+			if (message.GetNOfParams() == 4 && IsValidGameObjectId(message))
+			{
+				for (int c = 0; c < 3; ++c)
+					m_colors[3 * message.GetParam<int>(0) + c] = message.GetParam<float>(1 + c);
+			}
+			else if (message.GetNOfParams() == 2 && IsValidGameObjectId(message))
+			{
+				int length;
+				const float* pColor = message.GetArrayParam<float>(1, length);
+				m_isValid = m_isValid && pColor && length == 3;
+				for (int c = 0; pColor && c < length && c < 3; ++c)
+					m_colors[3 * message.GetParam<int>(0) + c] = pColor[c];
+			}
+			else
+				m_isValid = false;
+			break;
+		case UnityForCppTest::TRM_SET_POSITIONS_ARRAY:
+			m_positionsArrayId = message.GetParam<int>(0);
+			m_positionsDirtyBitmapId = message.GetParam<int>(1);
+			break;
+		case UnityForCppTest::TRM_INSTANCE_GAME_OBJECT:
+			m_nOfInstancedGameObjects += IsValidGameObjectId(message) ? 1 : 0;
+			break;
+		case UnityForCppTest::TRM_DEBUG_LOG_MESSAGE:
+			m_isValid = m_isValid && !message.GetStringParam(0).empty();
+			break;
+		}
+	}
+
+	//reads only the dirty positions, clearing the dirty bitmap as UnityAdapter.ConsumeDirtyItems does
+	void ReadPositions()
+	{
+		int lengthInBytes, bitmapLengthInBytes;
+		const Vec2* pPositions = reinterpret_cast<const Vec2*>(NativeUnityAdapterStub::Arrays::GetInstance().GetArray(m_positionsArrayId,
+																												   lengthInBytes));
+		//the C# side writes the shared arrays too, so we write through the stub memory as it does
+		uint32* pDirtyBitmap = reinterpret_cast<uint32*>(const_cast<uint8*>(
+			NativeUnityAdapterStub::Arrays::GetInstance().GetArray(m_positionsDirtyBitmapId, bitmapLengthInBytes)));
+		if (!pPositions || !pDirtyBitmap || pDirtyBitmap[0] == 0)
+			return;
+
+		for (int word = 1; word < bitmapLengthInBytes / (int)sizeof(uint32); ++word)
+		{
+			uint32 bits = pDirtyBitmap[word];
+			pDirtyBitmap[word] = 0;
+			for (int bit = 0; bits != 0; ++bit, bits >>= 1)
+			{
+				int i = ((word - 1) << 5) + bit;
+				if ((bits & 1) != 0 && i < lengthInBytes / (int)sizeof(Vec2))
+				{
+					m_positionsSum.x += pPositions[i].x;
+					m_positionsSum.y += pPositions[i].y;
+				}
+			}
+		}
+
+		pDirtyBitmap[0] = 0;
+	}
+
+	int GetNOfInstancedGameObjects() const { return m_nOfInstancedGameObjects; }
+	int GetPositionsArrayId() const { return m_positionsArrayId; }
+	bool IsValid() const { return m_isValid; }
+
+private:
+	//the game object id is the first parameter of the game object messages
+	bool IsValidGameObjectId(const UnityMessagerDispatcher::Message& message)
+	{
+		int gameObjectId = message.IsParamAnArray(0) ? -1 : message.GetParam<int>(0);
+		m_isValid = m_isValid && gameObjectId >= 0 && gameObjectId < (int)m_rotations.size();
+		return gameObjectId >= 0 && gameObjectId < (int)m_rotations.size();
+	}
+
+	std::vector<float> m_rotations;
+	std::vector<float> m_colors;
+	int m_nOfInstancedGameObjects;
+	int m_positionsArrayId;
+	int m_positionsDirtyBitmapId;
+	Vec2 m_positionsSum; //so reading the positions is not optimized away
+	bool m_isValid;
+};
+
+static double ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+//nearest rank percentile of sorted values
+static double Percentile(const std::vector<double>& sortedValues, double percentile)
+{
+	int rank = (int)(percentile / 100.0 * sortedValues.size() + 0.999999);
+	return sortedValues[std::max(1, std::min(rank, (int)sortedValues.size())) - 1];
+}
+
+//Returns false if the delivered messages didn't result in the expected scene
+static bool Run(const Options& options, int nOfGameObjects, int flags, RunResult& result)
+{
+	NativeUnityAdapterStub::Arrays& arrays = NativeUnityAdapterStub::Arrays::GetInstance();
+	int controlQueueFirstArrayId = UnityMessager::InstanceAndProvideAwakeInfo(SB_N_OF_RECEIVER_IDS, options.queueArraysSizeInBytes, flags);
+	int testReceiverId = UNITY_MESSAGER.NewReceiverId();
+
+	SceneReceiver sceneReceiver(nOfGameObjects);
+	UnityMessagerDispatcher dispatcher(flags, controlQueueFirstArrayId, arrays);
+	dispatcher.SetReceiver(testReceiverId, &sceneReceiver);
+	bool isValid = true;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	Scenario* pScenario = new Scenario(testReceiverId, nOfGameObjects, options.rate, options.nOfProducers);
+	isValid = dispatcher.DeliverMessages() && isValid;
+	result.setupMs = ElapsedMs(start);
+
+	isValid = isValid && sceneReceiver.GetNOfInstancedGameObjects() == nOfGameObjects
+			  && sceneReceiver.GetPositionsArrayId() == pScenario->GetPositionsArrayId();
+
+	//positions are not queue memory
+	int64 positionsBytes = (int64)nOfGameObjects * sizeof(Vec2) + (1 + (nOfGameObjects + 31) / 32) * sizeof(uint32);
+	std::vector<double> frameMs;
+	frameMs.reserve(options.nOfFrames);
+	int64 nOfBytes = 0;
+	result.maxBytesPerFrame = 0;
+
+	for (int frame = -SB_N_OF_WARM_UP_FRAMES; frame < options.nOfFrames && isValid; ++frame)
+	{
+		if (frame == 0)
+			arrays.ResetPeak();
+
+		start = std::chrono::steady_clock::now();
+		pScenario->Update();
+		isValid = dispatcher.DeliverMessages();
+		sceneReceiver.ReadPositions();
+		double ms = ElapsedMs(start);
+
+		if (frame >= 0)
+		{
+			frameMs.push_back(ms);
+			int64 nOfFrameBytes = dispatcher.GetNOfBytesDelivered();
+			nOfBytes += nOfFrameBytes;
+			result.maxBytesPerFrame = std::max(result.maxBytesPerFrame, nOfFrameBytes);
+		}
+	}
+
+	result.peakQueueBytes = arrays.GetPeakLiveBytes() - positionsBytes;
+	isValid = isValid && sceneReceiver.IsValid() && !frameMs.empty();
+
+	delete pScenario;
+	dispatcher.DeliverMessages(); //the positions array is released once the messages referencing it are delivered
+	UnityMessager::DeleteInstance();
+
+	if (!isValid)
+		return false;
+
+	std::sort(frameMs.begin(), frameMs.end());
+	result.p50Ms = Percentile(frameMs, 50.0);
+	result.p90Ms = Percentile(frameMs, 90.0);
+	result.p99Ms = Percentile(frameMs, 99.0);
+	result.maxMs = frameMs.back();
+	result.meanBytesPerFrame = (double)nOfBytes / frameMs.size();
+	return true;
+}
+
+//Prints the thresholds the result exceeds, returning true if any
+static bool CheckThresholds(const Options& options, int nOfGameObjects, int flags, const RunResult& result)
+{
+	bool hasRegressed = false;
+	if (options.maxP99Ms >= 0.0 && result.p99Ms > options.maxP99Ms)
+	{
+		fprintf(stderr, "REGRESSION: objects=%d flags=%d p99 frame time %.3fms > %.3fms\n",
+				nOfGameObjects, flags, result.p99Ms, options.maxP99Ms);
+		hasRegressed = true;
+	}
+
+	if (options.maxBytesPerFrame >= 0.0 && result.meanBytesPerFrame > options.maxBytesPerFrame)
+	{
+		fprintf(stderr, "REGRESSION: objects=%d flags=%d mean bytes per frame %.0f > %.0f\n",
+				nOfGameObjects, flags, result.meanBytesPerFrame, options.maxBytesPerFrame);
+		hasRegressed = true;
+	}
+
+	if (options.maxPeakQueueMb >= 0.0 && result.peakQueueBytes > options.maxPeakQueueMb * 1024.0 * 1024.0)
+	{
+		fprintf(stderr, "REGRESSION: objects=%d flags=%d peak queue memory %.2fMB > %.2fMB\n",
+				nOfGameObjects, flags, result.peakQueueBytes / (1024.0 * 1024.0), options.maxPeakQueueMb);
+		hasRegressed = true;
+	}
+
+	return hasRegressed;
+}
+
+static void ParseList(const char* str, std::vector<int>& values)
+{
+	values.clear();
+	while (*str)
+	{
+		values.push_back(atoi(str));
+		while (*str && *(str++) != ',') {}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	options.rate = 0.1f;
+	options.nOfProducers = 4; //corresponds to NUMBER_OF_PRODUCER_THREADS on Test.cpp
+	options.nOfFrames = 300;
+	options.queueArraysSizeInBytes = 65536;
+	options.maxP99Ms = options.maxBytesPerFrame = options.maxPeakQueueMb = -1.0;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--objects") == 0)
+			ParseList(argv[i + 1], options.nOfObjectsSet);
+		else if (strcmp(argv[i], "--flags") == 0)
+			ParseList(argv[i + 1], options.flagsSets);
+		else if (strcmp(argv[i], "--rate") == 0)
+			options.rate = (float)atof(argv[i + 1]);
+		else if (strcmp(argv[i], "--producers") == 0)
+			options.nOfProducers = std::max(0, std::min(atoi(argv[i + 1]), SB_MAX_N_OF_PRODUCERS));
+		else if (strcmp(argv[i], "--frames") == 0)
+			options.nOfFrames = std::max(1, atoi(argv[i + 1]));
+		else if (strcmp(argv[i], "--queue-array-size") == 0)
+			options.queueArraysSizeInBytes = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--max-p99-ms") == 0)
+			options.maxP99Ms = atof(argv[i + 1]);
+		else if (strcmp(argv[i], "--max-bytes-per-frame") == 0)
+			options.maxBytesPerFrame = atof(argv[i + 1]);
+		else if (strcmp(argv[i], "--max-peak-queue-mb") == 0)
+			options.maxPeakQueueMb = atof(argv[i + 1]);
+		else
+		{
+			fprintf(stderr, "Usage: %s [--objects <n,n...>] [--rate <fraction>] [--producers <n>] [--flags <flags,flags...>] "
+							"[--frames <n>] [--queue-array-size <bytes>] [--max-p99-ms <ms>] [--max-bytes-per-frame <bytes>] "
+							"[--max-peak-queue-mb <mb>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (options.nOfObjectsSet.empty())
+	{
+		int defaultNOfObjectsSet[] = { 1000, 10000, 100000 };
+		options.nOfObjectsSet.assign(defaultNOfObjectsSet, defaultNOfObjectsSet + sizeof(defaultNOfObjectsSet) / sizeof(int));
+	}
+
+	if (options.flagsSets.empty())
+		options.flagsSets.push_back(0);
+
+	NativeUnityAdapterStub::Install();
+	NativeUnityAdapterStub::Arrays::GetInstance().SetTypeSize<Vec2>();
+	printf("objects,rate,producers,flags,frames,setup_ms,p50_ms,p90_ms,p99_ms,max_ms,"
+		   "mean_bytes_per_frame,max_bytes_per_frame,peak_queue_bytes\n");
+
+	bool hasRegressed = false;
+	for (size_t objectsIdx = 0; objectsIdx < options.nOfObjectsSet.size(); ++objectsIdx)
+	{
+		for (size_t flagsIdx = 0; flagsIdx < options.flagsSets.size(); ++flagsIdx)
+		{
+			int nOfGameObjects = std::max(1, options.nOfObjectsSet[objectsIdx]);
+			int flags = options.flagsSets[flagsIdx];
+
+			RunResult result = RunResult();
+			if (!Run(options, nOfGameObjects, flags, result))
+			{
+				fprintf(stderr, "objects=%d flags=%d: the delivered messages didn't result in the expected scene\n", nOfGameObjects, flags);
+				return 1;
+			}
+
+			printf("%d,%.3f,%d,%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.0f,%lld,%lld\n", nOfGameObjects, options.rate, options.nOfProducers,
+				   flags, options.nOfFrames, result.setupMs, result.p50Ms, result.p90Ms, result.p99Ms, result.maxMs,
+				   result.meanBytesPerFrame, (long long)result.maxBytesPerFrame, (long long)result.peakQueueBytes);
+			fflush(stdout);
+
+			hasRegressed = CheckThresholds(options, nOfGameObjects, flags, result) || hasRegressed;
+		}
+	}
+
+	//every shared array must have been released
+	int nOfLeakedArrays = NativeUnityAdapterStub::Arrays::GetInstance().GetNOfLiveArrays();
+	if (nOfLeakedArrays > 0)
+	{
+		fprintf(stderr, "%d shared arrays were not released\n", nOfLeakedArrays);
+		return 1;
+	}
+
+	return hasRegressed ? 2 : 0;
+}
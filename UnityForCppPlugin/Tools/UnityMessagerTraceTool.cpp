@@ -0,0 +1,294 @@
+//Copyright (c) 2016, Samuel Pollachini (Samuel Polacchini)
+//The UnityForCpp project is licensed under the terms of the MIT license
+
+//Standalone tool for the traces written by UnityMessager::StartCapture (check UnityMessagerTrace.h), reading them with the
+//UnityMessagerDecoder. It does not link the plugin, build it with:
+//
+//   g++ -std=c++11 -O2 -o UnityMessagerTraceTool UnityMessagerTraceTool.cpp ../Source/UnityMessagerTrace.cpp ../Source/UnityMessagerDecoder.cpp
+//
+//   UnityMessagerTraceTool analyze <traceFile>
+//      reports the messages and bytes per msgId, per receiver and per parameter type, plus the control messages
+//   UnityMessagerTraceTool replay <traceFile> [nOfIterations]
+//      decodes all the frames of the trace at max speed, touching every parameter byte, and reports the throughput
+
+#include "../Source/Shared.h"
+#include "../Source/UnityMessagerTrace.h"
+#include "../Source/UnityMessagerDecoder.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <vector>
+
+using namespace UnityForCpp;
+
+//Shared.cpp outputs through the UnityAdapter, here we just print to the console
+namespace Shared
+{
+char n_outputStrBuffer[OUTPUT_MESSAGE_MAX_STRING_SIZE] = { 0 };
+
+void OutputDebugStr(const char* str) { printf("%s\n", str); }
+void OutputWarningStr(const char* str) { printf("WARNING: %s\n", str); }
+void OutputErrorStr(const char* str) { printf("ERROR: %s\n", str); }
+}
+
+#define N_OF_TOP_ENTRIES 20
+
+//Gives the arrays of the current frame of the trace to the decoder
+class TraceArraySource : public UnityMessagerDecoder::ArraySource
+{
+public:
+	TraceArraySource(const UnityMessagerTrace::Reader& reader) : m_reader(reader) {}
+
+	virtual const uint8* GetArray(int arrayId, int& lengthInBytes)
+	{
+		const UnityMessagerTrace::Reader::Array* pArray = m_reader.FindArray(arrayId);
+		lengthInBytes = pArray ? pArray->lengthInBytes : 0;
+		return pArray ? pArray->pData : NULL;
+	}
+
+private:
+	const UnityMessagerTrace::Reader& m_reader;
+};
+
+//Messages and bytes counted for a key (msgId, receiver, type...)
+struct Usage
+{
+	int64 nOfMessages;
+	int64 nOfBytes;
+	int64 nOfControlBytes;
+
+	Usage() : nOfMessages(0), nOfBytes(0), nOfControlBytes(0) {}
+};
+
+class AnalyzeHandler : public UnityMessagerDecoder::Handler
+{
+public:
+	AnalyzeHandler() : m_byMsgId(), m_byReceiverId(), m_byTypeId(), m_byControlMsgId(), m_nOfDiscarded(0), m_nOfUnavailableParams(0) {}
+
+	virtual void OnControlMessage(int msgId, int nOfParams, const int* pParams, int controlBytes)
+	{
+		Usage& usage = m_byControlMsgId[msgId];
+		++usage.nOfMessages;
+		usage.nOfControlBytes += controlBytes;
+	}
+
+	virtual void OnMessage(const UnityMessagerDecoder::Message& message)
+	{
+		if (message.isDiscarded)
+		{
+			++m_nOfDiscarded;
+			return;
+		}
+
+		int64 nOfBytes = 0;
+		for (int i = 0; i < message.nOfParams; ++i)
+		{
+			const UnityMessagerDecoder::Param& param = message.pParams[i];
+			Usage& typeUsage = m_byTypeId[param.typeId];
+			++typeUsage.nOfMessages; //parameters, for the types
+			typeUsage.nOfBytes += param.sizeInBytes;
+			nOfBytes += param.sizeInBytes;
+			if (param.pData == NULL)
+				++m_nOfUnavailableParams;
+		}
+
+		//names are counted as bytes of the message too, messages addressed by the method name are counted under the msgId -1
+		if (message.objectName)
+			nOfBytes -= message.receiverId;
+		if (message.methodName)
+			nOfBytes -= message.msgId;
+
+		Usage* usages[] = { &m_byMsgId[message.methodName ? -1 : message.msgId], &m_byReceiverId[message.receiverId] };
+		for (int i = 0; i < 2; ++i)
+		{
+			++usages[i]->nOfMessages;
+			usages[i]->nOfBytes += nOfBytes;
+			usages[i]->nOfControlBytes += message.controlBytes;
+		}
+	}
+
+	std::map<int, Usage> m_byMsgId;
+	std::map<int, Usage> m_byReceiverId; //negative ids are the lengths of the object names
+	std::map<int, Usage> m_byTypeId;
+	std::map<int, Usage> m_byControlMsgId;
+	int64 m_nOfDiscarded;
+	int64 m_nOfUnavailableParams; //UnityArrayParam parameters, whose arrays are not on traces
+};
+
+//Touches every parameter byte, as a consumer copying them out would do
+class ReplayHandler : public UnityMessagerDecoder::Handler
+{
+public:
+	ReplayHandler() : m_nOfMessages(0), m_nOfBytes(0), m_checkSum(0) {}
+
+	virtual void OnMessage(const UnityMessagerDecoder::Message& message)
+	{
+		++m_nOfMessages;
+		m_checkSum += message.receiverId + message.msgId;
+		for (int i = 0; i < message.nOfParams; ++i)
+		{
+			const UnityMessagerDecoder::Param& param = message.pParams[i];
+			if (param.pData == NULL)
+				continue;
+
+			for (int b = 0; b < param.sizeInBytes; ++b)
+				m_checkSum += param.pData[b];
+
+			m_nOfBytes += param.sizeInBytes;
+		}
+	}
+
+	int64 m_nOfMessages;
+	int64 m_nOfBytes;
+	uint32 m_checkSum;
+};
+
+static void SetTypes(const UnityMessagerTrace::Reader& reader, UnityMessagerDecoder& decoder)
+{
+	const std::unordered_map<int, UnityMessagerTrace::Reader::Type>& types = reader.GetTypes();
+	for (std::unordered_map<int, UnityMessagerTrace::Reader::Type>::const_iterator it = types.begin(); it != types.end(); ++it)
+		decoder.SetType(it->first, it->second.itemSize, it->second.alignment, it->second.name.c_str());
+}
+
+//Decodes the current frame of the trace, returning false if it is not valid
+static bool DecodeFrame(const UnityMessagerTrace::Reader& reader, UnityMessagerDecoder& decoder,
+						UnityMessagerDecoder::Handler& handler)
+{
+	//there is no maximum number of queues, the frame has arrays for all the queues that may be read on it
+	int nOfQueues = UM_CONTROL_QUEUE_ID + 1;
+	const std::vector<UnityMessagerTrace::Reader::Array>& arrays = reader.GetArrays();
+	for (size_t i = 0; i < arrays.size(); ++i)
+		nOfQueues = std::max(nOfQueues, arrays[i].queueId + 1);
+
+	//the same as Reader::GetFirstArrayId for all of them, on a single pass
+	std::vector<int> firstArrayIds(nOfQueues, -1);
+	for (size_t i = arrays.size(); i-- > 0;)
+	{
+		if (arrays[i].queueId >= 0)
+			firstArrayIds[arrays[i].queueId] = arrays[i].arrayId;
+	}
+
+	TraceArraySource arraySource(reader);
+	if (decoder.DecodeDelivering(arraySource, &firstArrayIds[0], nOfQueues, handler))
+		return true;
+
+	printf("Invalid message stream at frame %d\n", reader.GetFrameIdx());
+	return false;
+}
+
+static void PrintTopUsages(const char* title, const char* keyName, const std::map<int, Usage>& usages,
+						   const std::unordered_map<int, UnityMessagerTrace::Reader::Type>* pTypes)
+{
+	std::vector< std::pair<int64, int> > sorted; //by bytes, including the control ones
+	for (std::map<int, Usage>::const_iterator it = usages.begin(); it != usages.end(); ++it)
+		sorted.push_back(std::make_pair(-(it->second.nOfBytes + it->second.nOfControlBytes), it->first));
+
+	std::sort(sorted.begin(), sorted.end());
+
+	printf("\n%s (%d, top %d by bytes)\n", title, (int)usages.size(), N_OF_TOP_ENTRIES);
+	printf("%12s %12s %14s %14s\n", keyName, "messages", "param bytes", "control bytes");
+	for (size_t i = 0; i < sorted.size() && i < N_OF_TOP_ENTRIES; ++i)
+	{
+		const Usage& usage = usages.find(sorted[i].second)->second;
+		printf("%12d %12lld %14lld %14lld", sorted[i].second, (long long)usage.nOfMessages, (long long)usage.nOfBytes,
+			   (long long)usage.nOfControlBytes);
+
+		if (pTypes && pTypes->count(sorted[i].second))
+			printf("  %s", pTypes->find(sorted[i].second)->second.name.c_str());
+
+		printf("\n");
+	}
+}
+
+static int Analyze(UnityMessagerTrace::Reader& reader)
+{
+	UnityMessagerDecoder decoder(reader.GetInitFlags());
+	AnalyzeHandler handler;
+	int nOfFrames = 0;
+	int64 nOfTraceBytes = 0;
+	while (reader.ReadNextFrame())
+	{
+		SetTypes(reader, decoder);
+		if (!DecodeFrame(reader, decoder, handler))
+			return 1;
+
+		const std::vector<UnityMessagerTrace::Reader::Array>& arrays = reader.GetArrays();
+		for (size_t i = 0; i < arrays.size(); ++i)
+			nOfTraceBytes += arrays[i].lengthInBytes;
+
+		++nOfFrames;
+	}
+
+	int64 nOfMessages = 0;
+	for (std::map<int, Usage>::const_iterator it = handler.m_byMsgId.begin(); it != handler.m_byMsgId.end(); ++it)
+		nOfMessages += it->second.nOfMessages;
+
+	printf("%d frames, init flags %d, %lld messages (%.1f per frame), %lld queue bytes (%.1f per frame)\n", nOfFrames,
+		   reader.GetInitFlags(), (long long)nOfMessages, nOfFrames > 0 ? (double)nOfMessages / nOfFrames : 0.0,
+		   (long long)nOfTraceBytes, nOfFrames > 0 ? (double)nOfTraceBytes / nOfFrames : 0.0);
+	printf("%lld discarded coalesced messages, %lld UnityArrayParam parameters (not on the trace)\n",
+		   (long long)handler.m_nOfDiscarded, (long long)handler.m_nOfUnavailableParams);
+
+	PrintTopUsages("Messages per msgId (-1: by method name)", "msgId", handler.m_byMsgId, NULL);
+	PrintTopUsages("Messages per receiver (negative: by object name)", "receiverId", handler.m_byReceiverId, NULL);
+	PrintTopUsages("Parameters per type", "typeId", handler.m_byTypeId, &reader.GetTypes());
+	PrintTopUsages("Control messages per UMM msgId", "msgId", handler.m_byControlMsgId, NULL);
+	return 0;
+}
+
+static int Replay(UnityMessagerTrace::Reader& reader, int nOfIterations)
+{
+	UnityMessagerDecoder decoder(reader.GetInitFlags());
+	ReplayHandler handler;
+	int nOfFrames = 0;
+	std::chrono::duration<double> elapsed(0);
+	for (int i = 0; i < nOfIterations; ++i)
+	{
+		reader.Rewind();
+		while (reader.ReadNextFrame())
+		{
+			//only the decoding is measured, the frames are already in memory
+			SetTypes(reader, decoder);
+			std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+			bool isValid = DecodeFrame(reader, decoder, handler);
+			elapsed += std::chrono::high_resolution_clock::now() - start;
+			if (!isValid)
+				return 1;
+
+			++nOfFrames;
+		}
+	}
+
+	double seconds = elapsed.count() > 0.0 ? elapsed.count() : 1e-9;
+	printf("%d frames replayed (%d iterations), %lld messages, %lld param bytes, checksum %u\n", nOfFrames, nOfIterations,
+		   (long long)handler.m_nOfMessages, (long long)handler.m_nOfBytes, handler.m_checkSum);
+	printf("%.2f M messages/s, %.2f MB/s, %.2f us per frame\n", handler.m_nOfMessages / seconds / 1000000.0,
+		   handler.m_nOfBytes / seconds / (1024.0 * 1024.0), nOfFrames > 0 ? seconds * 1000000.0 / nOfFrames : 0.0);
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3 || (strcmp(argv[1], "analyze") != 0 && strcmp(argv[1], "replay") != 0))
+	{
+		printf("Usage: %s analyze <traceFile>\n       %s replay <traceFile> [nOfIterations]\n", argv[0], argv[0]);
+		return 1;
+	}
+
+	UnityMessagerTrace::Reader reader;
+	if (!reader.Open(argv[2]))
+	{
+		printf("Could not read the trace file %s\n", argv[2]);
+		return 1;
+	}
+
+	if (strcmp(argv[1], "analyze") == 0)
+		return Analyze(reader);
+
+	int nOfIterations = argc > 3 ? atoi(argv[3]) : 10;
+	return Replay(reader, nOfIterations > 0 ? nOfIterations : 1);
+}